@@ -0,0 +1,46 @@
+// benchmark.cpp : Defines the entry point for the console application.
+//
+
+#include "stdafx.h"
+#include <functional>
+#include <map>
+#include "benchmark.h"
+
+int main(int argc, char** argv)
+{
+	const std::map<std::string, std::function<void(void)>> benchmarks = {
+		{ "dither", dukat::run_dither_benchmark },
+		{ "particles", dukat::run_particle_benchmark }
+	};
+
+	try
+	{
+		std::string name = "all";
+		if (argc > 1)
+		{
+			name = argv[1];
+		}
+
+		auto found = false;
+		for (const auto& it : benchmarks)
+		{
+			if (name == "all" || name == it.first)
+			{
+				dukat::log->info("Running benchmark: {}", it.first);
+				it.second();
+				found = true;
+			}
+		}
+		if (!found)
+		{
+			dukat::log->error("Unknown benchmark: {}", name);
+			return 1;
+		}
+		return 0;
+	}
+	catch (const std::exception& e)
+	{
+		dukat::log->error("Application failed with error: {}", e.what());
+		return -1;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <chrono>
+#include <dukat/dukat.h>
+
+namespace dukat
+{
+	// Calls fn a number of times and returns the average duration of a call in milliseconds.
+	template<typename Fn>
+	double measure(int iterations, Fn fn)
+	{
+		const auto start = std::chrono::high_resolution_clock::now();
+		for (auto i = 0; i < iterations; i++)
+			fn();
+		const auto end = std::chrono::high_resolution_clock::now();
+		return std::chrono::duration<double, std::milli>(end - start).count() / static_cast<double>(iterations);
+	}
+
+	// Compares scalar and SIMD particle kernels.
+	void run_particle_benchmark(void);
+	// Compares serial and parallel error diffusion dithering.
+	void run_dither_benchmark(void);
+}
\ No newline at end of file
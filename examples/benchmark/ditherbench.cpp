@@ -0,0 +1,100 @@
+#include "stdafx.h"
+#include "benchmark.h"
+
+namespace dukat
+{
+	static constexpr auto surface_size = 2048;
+	static constexpr auto iterations = 3;
+
+	// Fills surface with a gradient and some noise, so that errors spread across the image.
+	static void fill_surface(Surface& surface)
+	{
+		rand::seed(0x1234);
+		auto rect = surface.pixels<uint32_t>();
+		for (auto y = 0; y < rect.height; y++)
+		{
+			auto row = rect.row(y);
+			for (auto x = 0; x < rect.width; x++)
+			{
+				auto v = static_cast<float>(x + y) / static_cast<float>(rect.width + rect.height) + random(-0.1f, 0.1f);
+				clamp(v, 0.0f, 1.0f);
+				const auto c = static_cast<uint8_t>(255.0f * v);
+				row[x] = surface.raw_color(c, c, c);
+			}
+		}
+	}
+
+	// Returns true if two surfaces of the same size have identical pixels.
+	static bool is_identical(const Surface& a, const Surface& b)
+	{
+		for (auto y = 0; y < a.height(); y++)
+		{
+			for (auto x = 0; x < a.width(); x++)
+			{
+				if (a.get_pixel(x, y) != b.get_pixel(x, y))
+					return false;
+			}
+		}
+		return true;
+	}
+
+	// Dithers a freshly filled surface a number of times and returns the average duration in milliseconds.
+	static double measure_dither(Surface& surface, const DiffusionKernel& kernel, const std::array<Color, 2>& palette, JobScheduler* scheduler)
+	{
+		auto res = 0.0;
+		for (auto i = 0; i < iterations; i++)
+		{
+			fill_surface(surface);
+			res += measure(1, [&]() { dither(surface, kernel, palette, scheduler); });
+		}
+		return res / static_cast<double>(iterations);
+	}
+
+	void run_dither_benchmark(void)
+	{
+		const std::array<Color, 2> palette{ Color{ 0.0f, 0.0f, 0.0f, 1.0f }, Color{ 1.0f, 1.0f, 1.0f, 1.0f } };
+		const std::pair<const char*, const DiffusionKernel*> kernels[] = {
+			{ "floyd-steinberg", &DiffusionKernel::floyd_steinberg },
+			{ "sierra", &DiffusionKernel::sierra },
+			{ "sierra-lite", &DiffusionKernel::sierra_lite },
+			{ "sierra3", &DiffusionKernel::sierra3 },
+			{ "atkinson", &DiffusionKernel::atkinson },
+			{ "burkes", &DiffusionKernel::burkes },
+			{ "jjn", &DiffusionKernel::jarvis_judice_ninke },
+			{ "stucki", &DiffusionKernel::stucki },
+		};
+
+		JobScheduler scheduler;
+		const auto megapixels = static_cast<double>(surface_size) * static_cast<double>(surface_size) / 1.0e6;
+		log->info("{}x{} pixels, {} iterations, {} threads", surface_size, surface_size, iterations, scheduler.get_concurrency());
+
+		// Results of the existing algorithms dedicated to a kernel
+		Surface floyd_steinberg(surface_size, surface_size, SDL_PIXELFORMAT_RGBA8888);
+		fill_surface(floyd_steinberg);
+		dither(floyd_steinberg, FloydSteinbergDitherAlgorithm<float>{ surface_size, surface_size }, palette);
+		Surface sierra(surface_size, surface_size, SDL_PIXELFORMAT_RGBA8888);
+		fill_surface(sierra);
+		dither(sierra, SierraDitherAlgorithm<float>{ surface_size, surface_size }, palette);
+
+		Surface reference(surface_size, surface_size, SDL_PIXELFORMAT_RGBA8888);
+		Surface serial(surface_size, surface_size, SDL_PIXELFORMAT_RGBA8888);
+		Surface parallel(surface_size, surface_size, SDL_PIXELFORMAT_RGBA8888);
+		for (const auto& it : kernels)
+		{
+			// Reference result of the serial per-pixel algorithm
+			fill_surface(reference);
+			dither(reference, KernelDitherAlgorithm<float>{ surface_size, surface_size, *it.second }, palette);
+
+			const auto serial_ms = measure_dither(serial, *it.second, palette, nullptr);
+			const auto parallel_ms = measure_dither(parallel, *it.second, palette, &scheduler);
+			auto identical = is_identical(reference, serial) && is_identical(reference, parallel);
+			if (it.second == &DiffusionKernel::floyd_steinberg)
+				identical = identical && is_identical(floyd_steinberg, reference);
+			else if (it.second == &DiffusionKernel::sierra)
+				identical = identical && is_identical(sierra, reference);
+
+			log->info("{:>16}: serial {:.1f} MP/s, parallel {:.1f} MP/s, {:.2f}x, identical: {}", it.first,
+				megapixels * 1000.0 / serial_ms, megapixels * 1000.0 / parallel_ms, serial_ms / parallel_ms, identical);
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,87 @@
+#include "stdafx.h"
+#include "benchmark.h"
+
+namespace dukat
+{
+	static constexpr auto particle_count = 100000;
+	static constexpr auto iterations = 200;
+
+	// Fills store with particles which have non-trivial motion so that all
+	// code paths of the gravitational kernel are exercised.
+	static void fill_store(ParticleStore& store)
+	{
+		rand::seed(0x1234);
+		store.clear();
+		store.reserve(particle_count);
+		Particle p;
+		for (auto i = 0; i < particle_count; i++)
+		{
+			p.pos = Vector2{ random(-100.0f, 100.0f), random(-100.0f, 100.0f) };
+			p.dp = Vector2{ random(-10.0f, 10.0f), random(-10.0f, 10.0f) };
+			p.ref = Vector2{ 0.0f, random(50.0f, 100.0f) };
+			p.color = Color{ random(0.0f, 1.0f), random(0.0f, 1.0f), random(0.0f, 1.0f), 1.0f };
+			p.dc = Color{ random(-0.1f, 0.1f), random(-0.1f, 0.1f), random(-0.1f, 0.1f), -0.05f };
+			p.size = random(1.0f, 4.0f);
+			p.dsize = random(-0.5f, 0.5f);
+			p.ttl = 100.0f;
+			p.flags = Particle::Alive | store.motion;
+			store.push_back(p, static_cast<uint32_t>(i));
+		}
+	}
+
+	// Returns largest absolute difference between the positions of two stores.
+	static float max_error(const ParticleStore& a, const ParticleStore& b)
+	{
+		auto res = 0.0f;
+		for (auto i = 0u; i < a.count(); i++)
+		{
+			res = std::max(res, std::abs(a.pos[i].x - b.pos[i].x));
+			res = std::max(res, std::abs(a.pos[i].y - b.pos[i].y));
+			res = std::max(res, std::abs(a.color[i].a - b.color[i].a));
+			res = std::max(res, std::abs(a.size[i] - b.size[i]));
+		}
+		return res;
+	}
+
+	void run_particle_benchmark(void)
+	{
+		const ParticleStep step{ 1.0f / 60.0f, 60.0f, 0.99f };
+		const uint8_t motions[] = {
+			Particle::Linear,
+			Particle::Linear | Particle::Dampened,
+			Particle::Linear | Particle::Gravitational | Particle::Dampened,
+			Particle::Linear | Particle::AntiGravitational,
+		};
+		const ParticleKernel kernels[] = { ParticleKernel::Scalar, ParticleKernel::SSE2, ParticleKernel::AVX };
+
+		log->info("{} particles, {} iterations, best kernel: {}", particle_count, iterations,
+			kernel_name(detect_particle_kernel()));
+		for (auto motion : motions)
+		{
+			ParticleStore reference(nullptr, motion);
+			fill_store(reference);
+			for (auto i = 0; i < iterations; i++)
+				integrate_particles(ParticleKernel::Scalar, motion, reference, 0, reference.count(), step);
+
+			double scalar_ms = 0.0;
+			for (auto kernel : kernels)
+			{
+				if (!is_supported(kernel))
+				{
+					log->info("flags {:#04x} {:>6}: not supported", static_cast<int>(motion), kernel_name(kernel));
+					continue;
+				}
+
+				ParticleStore store(nullptr, motion);
+				fill_store(store);
+				const auto ms = measure(iterations, [&]() {
+					integrate_particles(kernel, motion, store, 0, store.count(), step);
+				});
+				if (kernel == ParticleKernel::Scalar)
+					scalar_ms = ms;
+				log->info("flags {:#04x} {:>6}: {:.3f} ms/update, {:.2f}x, max error {}", static_cast<int>(motion), kernel_name(kernel),
+					ms, scalar_ms / ms, max_error(reference, store));
+			}
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,25 @@
+// stdafx.h : include file for standard system include files,
+// or project specific include files that are used frequently, but
+// are changed infrequently
+//
+
+#pragma once
+
+#ifdef _WIN32
+
+#include "targetver.h"
+
+#include <stdio.h>
+#include <tchar.h>
+
+#endif 
+
+// STL
+#include <assert.h>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <sstream>
+
+// SDL
+#include <SDL2/SDL.h>
@@ -6,7 +6,7 @@
 
 namespace dukat
 {
-	CollisionScene::CollisionScene(Game2* game2) : Scene2(game2), animate(true), show_grid(true)
+	CollisionScene::CollisionScene(Game2* game2) : Scene2(game2), animate(true), show_grid(true), broadphase_mode(0)
 	{
 		auto cm = game->add_manager<CollisionManager2>();
 		cm->set_world_size(2000.0f);
@@ -49,11 +49,9 @@ namespace dukat
 			auto ctrl = game->get_devices()->active;
 			auto pos = Vector2{ ctrl->rxa, ctrl->rya } - screen_dim;
 			auto cm = game->get<CollisionManager2>();
-			auto res = cm->find(pos);
-			for (auto b : res)
-			{
+			cm->visit(pos, [](CollisionManager2::Body* b) {
 				log->info("Click on {}", b->id);
-			}
+			});
 		});
 
 		// Set up info text
@@ -70,6 +68,7 @@ namespace dukat
 				<< "Tests: " << perfc.avg(PerformanceCounter::BB_CHECKS) << std::endl
 				<< "<Space> Pause movement" << std::endl
 				<< "<g> Toggle grid" << std::endl
+				<< "<b> Cycle broadphase" << std::endl
 				<< "<-,+> Remove / Add object" << std::endl;
 			info_text->set_text(ss.str());
 			info_text->update();
@@ -124,6 +123,10 @@ namespace dukat
 			update_objects(1.0f / 60.0f);
 			break;
 
+		case SDLK_b:
+			cycle_broadphase();
+			break;
+
 		case SDLK_g:
 			show_grid = !show_grid;
 			if (show_grid)
@@ -159,6 +162,28 @@ namespace dukat
 		objects.push_back(std::make_unique<GameObject>(dir, body));
 	}
 
+	void CollisionScene::cycle_broadphase(void)
+	{
+		auto cm = game->get<CollisionManager2>();
+		broadphase_mode = (broadphase_mode + 1) % 3;
+		switch (broadphase_mode)
+		{
+		case 0:
+			log->info("Using quad tree broadphase.");
+			cm->set_broadphase(std::make_unique<QuadTreeBroadphase2<CollisionManager2::Body>>(
+				Vector2{ -1000.0f, -1000.0f }, Vector2{ 1000.0f, 1000.0f }, 4));
+			break;
+		case 1:
+			log->info("Using grid broadphase.");
+			cm->set_broadphase(std::make_unique<GridBroadphase2<CollisionManager2::Body>>(64.0f));
+			break;
+		case 2:
+			log->info("Using sweep and prune broadphase.");
+			cm->set_broadphase(std::make_unique<SweepPruneBroadphase2<CollisionManager2::Body>>());
+			break;
+		}
+	}
+
 	void CollisionScene::update_objects(float delta)
 	{
 		for (auto& o : objects)
@@ -37,10 +37,13 @@ namespace dukat
 		std::vector<std::unique_ptr<GameObject>> objects;
 		bool animate;
 		bool show_grid;
+		// Index of broadphase used by collision manager
+		int broadphase_mode;
 
 		void remove_object(void);
 		void add_object(void);
 		void update_objects(float delta);
+		void cycle_broadphase(void);
 
 	public:
 		CollisionScene(Game2* game);
@@ -9,11 +9,16 @@ namespace dukat
 		float max_speed; // max speed
 		float max_force; // max steering force
 		bool predator;
-		Particle* p;
+		ParticleHandle handle;
+		// Accessor for the boid's particle, refreshed once per frame.
+		ParticleRef p;
 
-		Boid(Particle* p, bool predator = false);
+		Boid(ParticleManager* pm, const ParticleHandle& handle, bool predator = false);
 		~Boid(void) { }
 
+		// Re-acquires particle accessor. Returns false if the particle no longer exists.
+		bool refresh(ParticleManager* pm) { p = pm->get(handle); return p.is_valid(); }
+
 		void update(const std::vector<Boid>& boids);
 		// Steer away from nearby boids.
 		virtual Vector2 seperate(const std::vector<Boid>& boids) const;
@@ -82,22 +82,22 @@ namespace dukat
 
 	void FlockingScene::add_boid(const Vector2& pos, bool predator)
 	{
-		auto p = game->get<ParticleManager>()->create_particle();
-		p->pos = pos;
+		auto pm = game->get<ParticleManager>();
+		Particle p;
+		p.pos = pos;
 		if (predator)
 		{
-			p->color = { 1.0f, 0.0f, 0.0f, random(0.5f, 1.0f) };
+			p.color = { 1.0f, 0.0f, 0.0f, random(0.5f, 1.0f) };
 		}
 		else
 		{
-			p->color = { 1.0f, 1.0f, 1.0f, random(0.5f, 1.0f) };
+			p.color = { 1.0f, 1.0f, 1.0f, random(0.5f, 1.0f) };
 		}
-		p->size = 4.0f;
-		p->dp = Vector2{ 1.0f, 0.0f };
-		p->dc = { 0.0f, 0.0f, 0.0f, 0.0f };
-		p->ttl = 1800.0f;
-		particle_layer->add(p);
-		boids.push_back(Boid{ p, predator });
+		p.size = 4.0f;
+		p.dp = Vector2{ 1.0f, 0.0f };
+		p.dc = { 0.0f, 0.0f, 0.0f, 0.0f };
+		p.ttl = 1800.0f;
+		boids.push_back(Boid{ pm, pm->add_particle(p, particle_layer), predator });
 	}
 
 	void FlockingScene::handle_keyboard(const SDL_Event & e)
@@ -121,20 +121,24 @@ namespace dukat
 		cursor->p.x = dev->rxa - 0.5f * window_width;
 		cursor->p.y = dev->rya - 0.5f * window_height;
 
+		// Particles may have moved in packed storage since last frame
+		auto pm = game->get<ParticleManager>();
+		boids.erase(std::remove_if(boids.begin(), boids.end(), [pm](Boid& b) { return !b.refresh(pm); }), boids.end());
+
 		std::for_each(boids.begin(), boids.end(), [&](Boid& b) { b.update(boids);  });
 		
 		Scene2::update(delta);
 
 		// wrap around
 		std::for_each(boids.begin(), boids.end(), [](Boid& b) {
-			if (b.p->pos.x < 0.0f)
-				b.p->pos.x += window_width;
-			else if (b.p->pos.x > window_width)
-				b.p->pos.x -= window_width;
-			if (b.p->pos.y < 0.0f)
-				b.p->pos.y += window_height;
-			else if (b.p->pos.y > window_height)
-				b.p->pos.y -= window_height;
+			if (b.p.pos().x < 0.0f)
+				b.p.pos().x += window_width;
+			else if (b.p.pos().x > window_width)
+				b.p.pos().x -= window_width;
+			if (b.p.pos().y < 0.0f)
+				b.p.pos().y += window_height;
+			else if (b.p.pos().y > window_height)
+				b.p.pos().y -= window_height;
 		});
 	}
 }
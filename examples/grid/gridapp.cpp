@@ -46,7 +46,7 @@ namespace dukat
 		// Generate array containing textures used for splatting
 		auto terrain_texture = std::make_unique<Texture>(texture_size, texture_size);
 		terrain_texture->target = GL_TEXTURE_2D_ARRAY;
-		glBindTexture(GL_TEXTURE_2D_ARRAY, terrain_texture->id);
+		glstate.bind_texture(GL_TEXTURE_2D_ARRAY, terrain_texture->id);
 		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
 		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
@@ -72,7 +72,7 @@ namespace dukat
 #else
 		// Generate texture atlas containing textures used for splatting
 		auto terrain_texture = std::make_unique<Texture>(2 * texture_size, 2 * texture_size);
-		glBindTexture(GL_TEXTURE_2D, terrain_texture->id);
+		glstate.bind_texture(GL_TEXTURE_2D, terrain_texture->id);
 		glTexParameteri(GL_TEXTURE_2D, GL_GENERATE_MIPMAP, GL_TRUE);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
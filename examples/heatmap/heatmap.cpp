@@ -28,14 +28,14 @@ namespace dukat
 
         // Create elevation texture
         heightmap_texture = std::make_unique<Texture>(map_size, map_size, ProfileNearest);
-        glBindTexture(GL_TEXTURE_2D, heightmap_texture->id);
+        glstate.bind_texture(GL_TEXTURE_2D, heightmap_texture->id);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
         glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, map_size, map_size, 0, GL_RED, GL_FLOAT, nullptr);
         
         // Create heatmap texture
         heatmap_texture = std::make_unique<Texture>(map_size, map_size, ProfileNearest);
-        glBindTexture(GL_TEXTURE_2D, heatmap_texture->id);
+        glstate.bind_texture(GL_TEXTURE_2D, heatmap_texture->id);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
         glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, map_size, map_size, 0, GL_RGB, GL_FLOAT, nullptr);
@@ -44,7 +44,7 @@ namespace dukat
         const auto nm_size = 2 * map_size;
         auto fb_normal = std::make_unique<FrameBuffer>(nm_size, nm_size, true, false);
         normal_texture = fb_normal->texture.get();
-        glBindTexture(GL_TEXTURE_2D, normal_texture->id);
+        glstate.bind_texture(GL_TEXTURE_2D, normal_texture->id);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
         // 2-channel GL_RG16F texture for normal data
@@ -74,7 +74,7 @@ namespace dukat
 		int texture_size = 1024;
 		terrain_texture = std::make_unique<Texture>(texture_size, texture_size);
 		terrain_texture->target = GL_TEXTURE_2D_ARRAY;
-		glBindTexture(GL_TEXTURE_2D_ARRAY, terrain_texture->id);
+		glstate.bind_texture(GL_TEXTURE_2D_ARRAY, terrain_texture->id);
 		// TODO: anisotropic
 		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
 		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -311,7 +311,7 @@ namespace dukat
         model.m[4] = model.m[5] = 1.0f / (float)map_size;
         // ZScale of height map 
         model.m[13] = heightmap->get_scale_factor() * (float)tile_spacing; 
-        glUniformMatrix4fv(program->attr(Renderer::uf_model), 1, false, model.m);
+        program->set_matrix4(Renderer::uf_model, model.m);
 
         grid_mesh->render(program);
 
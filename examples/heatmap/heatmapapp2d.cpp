@@ -113,13 +113,13 @@ namespace dukat
 
 		GLenum format, type;
 		surface->query_pixel_format(format, type);
-		glBindTexture(GL_TEXTURE_2D, texture->id);
+		glstate.bind_texture(GL_TEXTURE_2D, texture->id);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, surface->get_width(), surface->get_height(), 0,
 			format, type, surface->get_surface()->pixels);
 #ifdef _DEBUG
-		glBindTexture(GL_TEXTURE_2D, 0);
+		glstate.bind_texture(GL_TEXTURE_2D, 0);
 #endif
 	}
 
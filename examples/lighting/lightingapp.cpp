@@ -51,21 +51,37 @@ namespace dukat
 		object_meshes.stage = RenderStage::Scene;
 		object_meshes.visible = true;
 
-		// Generate some meshes
+		// Generate some meshes. The batch program draws instances sharing mesh data, 
+		// textures and material in a single call.
 		MeshBuilder3 mb3;
+		auto program = game->get_shaders()->get_program("sc_lighting_batch.vsh", "sc_lighting.fsh");
 		auto box_mesh = object_meshes.create_instance();
 		box_mesh->set_mesh(game->get_meshes()->put("box", mb3.build_cube()));
-		box_mesh->set_program(game->get_shaders()->get_program("sc_lighting.vsh", "sc_lighting.fsh"));
+		box_mesh->set_program(program);
 		box_mesh->set_texture(game->get_textures()->get_or_load("white.png"));
 		box_mesh->set_material(mat_white_rubber);
 		box_mesh->transform.position.x = 2.5f;
 		
 		auto sphere_mesh = object_meshes.create_instance();
 		sphere_mesh->set_mesh(game->get_meshes()->put("sphere", mb3.build_sphere(32, 32)));
-		sphere_mesh->set_program(game->get_shaders()->get_program("sc_lighting.vsh", "sc_lighting.fsh"));
+		sphere_mesh->set_program(program);
 		sphere_mesh->set_texture(game->get_textures()->get_or_load("white.png"));
 		sphere_mesh->set_material(mat_gold);
 		sphere_mesh->transform.position.x = -2.5f;
+
+		// Ring of small boxes
+		const auto ring_size = 16;
+		for (auto i = 0; i < ring_size; i++)
+		{
+			auto mi = object_meshes.create_instance();
+			mi->set_mesh(game->get_meshes()->get("box"));
+			mi->set_program(program);
+			mi->set_texture(game->get_textures()->get_or_load("white.png"));
+			mi->set_material(mat_white_rubber);
+			const auto angle = two_pi * (float)i / (float)ring_size;
+			mi->transform.position = { 6.0f * std::cos(angle), -1.0f, 6.0f * std::sin(angle) };
+			mi->transform.scale = { 0.4f, 0.4f, 0.4f };
+		}
 		
 		overlay_meshes.stage = RenderStage::Overlay;
 		overlay_meshes.visible = true;
@@ -147,6 +163,9 @@ int main(int argc, char** argv)
 			config = argv[1];
 		}
 		dukat::Settings settings(config);
+		// Optional number of frames to run before writing a frame report and exiting
+		if (argc > 2)
+			settings.set(dukat::settings::report_frames, std::atoi(argv[2]));
 		dukat::Game3 app(settings);
 		app.add_scene("main", std::make_unique<dukat::LightingScene>(&app));
 		app.push_scene("main");
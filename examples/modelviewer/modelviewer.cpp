@@ -6,6 +6,42 @@
 
 namespace dukat
 {
+	// Reads a model in the dukat or MS3D format.
+	static std::unique_ptr<Model3> read_model(const std::string& filename)
+	{
+		auto is = std::fstream(filename, std::fstream::in | std::fstream::binary);
+		if (!is)
+		{
+			throw std::runtime_error("Could not open file.");
+		}
+
+		const auto ext = file_extension(filename);
+		if (ext == "ms3d")
+		{
+			MS3DModel ms3d;
+			is >> ms3d;
+			return ms3d.convert();
+		}
+		else
+		{
+			// Load dukat native model
+			auto model = std::make_unique<Model3>();
+			is >> *model;
+			return model;
+		}
+	}
+
+	// Converts a model to the packed layout, which can be loaded through ModelLoader.
+	static void pack_model(const std::string& input, const std::string& output)
+	{
+		log->info("Packing model {} as: {}", input, output);
+		auto model = read_model(input);
+		auto os = std::fstream(output, std::fstream::out | std::fstream::binary);
+		if (!os)
+			throw std::runtime_error("Could not open file");
+		model->write_packed(os);
+	}
+
 	ModelviewerScene::ModelviewerScene(Game3* game) : game(game), light(25.0f), enable_lighting(false), selected_mesh(-1)
 	{
 		// White Directional Light
@@ -38,12 +74,16 @@ namespace dukat
 			<< "<[]> Change scale" << std::endl
 			<< "<F1> Toggle Wirframe" << std::endl
 			<< "<F2> Toggle Lighting" << std::endl
+			<< "<F7> Save packed model" << std::endl
 			<< "<F11> Toggle Info" << std::endl
 			<< std::endl;
 		info_text->set_text(ss.str());
 		info_text->update();
 		info_mesh = overlay_meshes.add_instance(std::move(info_text));
 
+		object_meshes = std::make_unique<MeshGroup>();
+		loader = std::make_unique<ModelLoader>(game);
+
 		game->set_controller(this);
 	}
 
@@ -51,34 +91,33 @@ namespace dukat
 	{
 		std::stringstream ss; 
 		ss << game->get_settings().get_string(settings::resources_models) << "/" << filename;
-	
-		auto is = std::fstream(ss.str(), std::fstream::in | std::fstream::binary);
-		if (!is)
-		{
-			throw std::runtime_error("Could not open file.");
-		}
 
-		const auto ext = file_extension(filename);
-		if (ext == "ms3d")
-		{
-			MS3DModel ms3d;
-			is >> ms3d;
-			model = ms3d.convert();
-		}
-		else
+		auto on_loaded = [this](std::unique_ptr<MeshGroup> meshes) {
+			object_meshes = std::move(meshes);
+			object_meshes->stage = RenderStage::Scene;
+			object_meshes->visible = true;
+			selected_mesh = -1;
+		};
+
+		// Packed models are mapped on a worker thread and uploaded during update
+		if (MappedModel3::is_packed(ss.str()))
 		{
-			// Load dukat native model
-			model = std::make_unique<Model3>();
-			is >> *model;
+			model = nullptr;
+			loader->load(ss.str(), on_loaded);
+			return;
 		}
 
-		object_meshes = build_mesh_group(game, *model);
-		object_meshes->stage = RenderStage::Scene;
-		object_meshes->visible = true;
+		model = read_model(ss.str());
+		on_loaded(build_mesh_group(game, *model));
 	}
 
 	void ModelviewerScene::save_model(const std::string& filename)
 	{
+		if (model == nullptr)
+		{
+			log->warn("Packed models cannot be saved.");
+			return;
+		}
 		log->info("Saving model as: {}", filename);
 		auto os = std::fstream(filename, std::fstream::out | std::fstream::binary);
 		if (!os)
@@ -87,6 +126,21 @@ namespace dukat
 		os.close();
 	}
 
+	void ModelviewerScene::save_packed_model(const std::string& filename)
+	{
+		if (model == nullptr)
+		{
+			log->warn("Model is already packed.");
+			return;
+		}
+		log->info("Saving packed model as: {}", filename);
+		auto os = std::fstream(filename, std::fstream::out | std::fstream::binary);
+		if (!os)
+			throw std::runtime_error("Could not open file");
+		model->write_packed(os);
+		os.close();
+	}
+
 	void ModelviewerScene::handle_event(const SDL_Event& e)
 	{
 		switch (e.type)
@@ -133,6 +187,9 @@ namespace dukat
 		case SDLK_F6: // reload from assets path
 			load_model("sloop.mod");
 			break;
+		case SDLK_F7: // save current model in packed layout
+			save_packed_model("model_packed.mod");
+			break;
 		case SDLK_F11:
 			info_mesh->visible = !info_mesh->visible;
 			break;
@@ -195,6 +252,7 @@ namespace dukat
 
 	void ModelviewerScene::update(float delta)
 	{
+		loader->update();
 		object_meshes->update(delta);
 		overlay_meshes.update(delta);
 		light.update(delta, *game->get_renderer()->get_light(Renderer3::dir_light_idx));
@@ -214,6 +272,13 @@ int main(int argc, char** argv)
 {
 	try
 	{
+		// Convert model to packed layout without starting the viewer
+		if (argc == 4 && std::string(argv[1]) == "--pack")
+		{
+			dukat::pack_model(argv[2], argv[3]);
+			return 0;
+		}
+
 		std::string config = "../assets/modelviewer.ini";
 		dukat::Settings settings(config);
 		dukat::Game3 app(settings);
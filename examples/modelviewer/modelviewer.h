@@ -7,6 +7,7 @@ namespace dukat
 {
 	class Player;
 	class Model3;
+	class ModelLoader;
 
 	class ModelviewerScene : public Scene, public Controller
 	{
@@ -17,6 +18,8 @@ namespace dukat
 		MeshInstance* info_mesh;
 
 		std::unique_ptr<Model3> model;
+		// Loads models in the packed layout in the background
+		std::unique_ptr<ModelLoader> loader;
 		int selected_mesh; // currently highlighted mesh 
 
 		Vector3 camera_target;
@@ -34,5 +37,6 @@ namespace dukat
 
 		void load_model(const std::string& filename);
 		void save_model(const std::string& filename);
+		void save_packed_model(const std::string& filename);
 	};
 }
\ No newline at end of file
@@ -170,11 +170,11 @@ namespace dukat
 	{
 		GLenum format, type;
 		surface->query_pixel_format(format, type);
-		glBindTexture(GL_TEXTURE_2D, texture->id);
+		glstate.bind_texture(GL_TEXTURE_2D, texture->id);
 		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, surface->width(), surface->height(),
 			format, type, surface->get_surface()->pixels);
 #ifdef _DEBUG
-		glBindTexture(GL_TEXTURE_2D, 0);
+		glstate.bind_texture(GL_TEXTURE_2D, 0);
 #endif
 	}
 
@@ -10,6 +10,10 @@ namespace dukat
 	{
 		auto settings = game->get_settings();
 		particle_layer = game->get_renderer()->create_composite_layer("main", 1.0f);
+		// Keep emitted particles in contiguous per-layer arrays
+		game->get<ParticleManager>()->set_storage_mode(ParticleManager::Packed);
+		// Packed particles are integrated across cores; emitters touch render layers, 
+		// so the manager itself is updated on the main thread
 
 		// Set up default camera centered around origin
 		auto camera = std::make_unique<Camera2>(game);
@@ -331,6 +335,9 @@ int main(int argc, char** argv)
 			config = argv[1];
 		}
 		dukat::Settings settings(config);
+		// Optional number of frames to run before writing a frame report and exiting
+		if (argc > 2)
+			settings.set(dukat::settings::report_frames, std::atoi(argv[2]));
 		dukat::Game2 app(settings);
 		app.add_scene("main", std::make_unique<dukat::ParticlesScene>(&app));
 		app.push_scene("main");
@@ -146,6 +146,9 @@ int main(int argc, char** argv)
 			config = argv[1];
 		}
 		dukat::Settings settings(config);
+		// Optional number of frames to run before writing a frame report and exiting
+		if (argc > 2)
+			settings.set(dukat::settings::report_frames, std::atoi(argv[2]));
 		dukat::Game2 app(settings);
 		app.add_scene("main", std::make_unique<dukat::SpritesScene>(&app));
 		app.push_scene("main");
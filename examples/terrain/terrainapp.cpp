@@ -6,6 +6,41 @@
 
 namespace dukat
 {
+	// Converts a height map to the tiled layout, and checks that the tiles contain the
+	// same elevation as the PNG. Returns false if any level differs.
+	static bool tile_height_map(const std::string& png_file, const std::string& filename, int num_levels)
+	{
+		HeightMapTiles::convert(png_file, filename, num_levels);
+
+		HeightMap png_map(num_levels);
+		png_map.load(png_file);
+		HeightMap tiled_map(num_levels);
+		tiled_map.load_tiled(filename);
+
+		// Level 0 stores the 16-bit samples of the PNG and has to match exactly. Coarser 
+		// levels are averaged, so quantizing them may be off by one step.
+		auto result = true;
+		std::vector<GLfloat> expected, actual;
+		for (auto i = 0; i < num_levels; i++)
+		{
+			const auto size = png_map.get_level(i).size;
+			const Rect rect{ 0, 0, size, size };
+			expected.resize(size * size);
+			actual.resize(size * size);
+			png_map.get_data(i, rect, expected);
+			tiled_map.get_data(i, rect, actual);
+
+			auto max_error = 0.0f;
+			for (auto j = 0u; j < expected.size(); j++)
+				max_error = std::max(max_error, std::abs(expected[j] - actual[j]));
+			const auto tolerance = i == 0 ? 0.0f : 1.0f / 65535.0f;
+			log->info("Level {}: max error {}", i, max_error);
+			if (max_error > tolerance)
+				result = false;
+		}
+		return result;
+	}
+
 	TerrainScene::TerrainScene(Game3* game) : game(game)
 	{
 		MeshBuilder2 builder2;
@@ -73,7 +108,7 @@ namespace dukat
 		info_text->transform.position = { -1.6f, -0.3f, 0.0f };
 
 		const auto info =
-			"<1-4> Switch Terain\n"
+			"<1-5> Switch Terain\n"
 			"<C> Switch Camera View\n"
 			"<WASD> Move Camera\n"
 			"<QE> Change Altitude\n"
@@ -150,12 +185,21 @@ namespace dukat
 		palette[palette_size - 1] = Color{ 1.0f, 1.0f, 1.0f, 1.0f };
 	}
 
+	void TerrainScene::create_height_map(float scale_factor)
+	{
+		clip_map = nullptr; // wait for pending updates before releasing height map
+		height_map = std::make_unique<HeightMap>(max_levels, scale_factor);
+		// Downsample rows on the workers, and coarse levels only once the clip map reaches them
+		height_map->set_scheduler(game->get_scheduler());
+		height_map->set_lazy_levels(true);
+	}
+
 	void TerrainScene::load_mtrainier(void)
 	{
 		// Mt Rainier data set is 10m horizontal resolution, 102.4m vertical for every 0.1f.
 		// Note: the data source acknowledges that the data is "squised" when the max range > 1024, so we 
 		// stretch it by a factor of 2.
-		height_map = std::make_unique<HeightMap>(max_levels, 2.0f * 102.4f);
+		create_height_map(2.0f * 102.4f);
 		height_map->load("../assets/heightmaps/mt_rainier_1k.png");
 		clip_map = std::make_unique<ClipMap>(game, max_levels, level_size, height_map.get());
 		clip_map->set_program(game->get_shaders()->get_program("sc_clipmap.vsh", "sc_clipmap.fsh"));
@@ -164,10 +208,25 @@ namespace dukat
 		switch_camera_mode(Terrain);
 	}
 
+	void TerrainScene::load_mtrainier_tiled(void)
+	{
+		// Same data set as load_mtrainier, paged in from tiles which are converted on first use
+		const std::string filename = "mt_rainier_1k.hmt";
+		if (!std::ifstream(filename))
+			HeightMapTiles::convert("../assets/heightmaps/mt_rainier_1k.png", filename, max_levels);
+		create_height_map(2.0f * 102.4f);
+		height_map->load_tiled(filename);
+		clip_map = std::make_unique<ClipMap>(game, max_levels, level_size, height_map.get());
+		clip_map->set_program(game->get_shaders()->get_program("sc_clipmap.vsh", "sc_clipmap.fsh"));
+		clip_map->set_palette(palette);
+
+		switch_camera_mode(Terrain);
+	}
+
 	void TerrainScene::load_pugetsound(void)
 	{
 		// Puget sound data set: 160m horizontal resolution, 0.1m vertical for every 1/65536
-		height_map = std::make_unique<HeightMap>(max_levels, 0.1f * 65536.0f / 160.0f);
+		create_height_map(0.1f * 65536.0f / 160.0f);
 		height_map->load("../assets/heightmaps/ps_elevation_1k.png");
 		//height_map->load("../assets/heightmaps/ps_elevation_4k.png", 0.1f * 65536.0f / 40.0f);
 		clip_map = std::make_unique<ClipMap>(game, max_levels, level_size, height_map.get());
@@ -179,7 +238,7 @@ namespace dukat
 
 	void TerrainScene::load_blank(void)
 	{
-		height_map = std::make_unique<HeightMap>(max_levels, 0.1f * 65536.0f / 160.0f);
+		create_height_map(0.1f * 65536.0f / 160.0f);
 		height_map->load("../assets/heightmaps/blank_1k.png");
 		clip_map = std::make_unique<ClipMap>(game, max_levels, level_size, height_map.get());
 		clip_map->set_program(game->get_shaders()->get_program("sc_clipmap.vsh", "sc_clipmap.fsh"));
@@ -190,7 +249,7 @@ namespace dukat
 
 	void TerrainScene::generate_terrain(void)
 	{
-		height_map = std::make_unique<HeightMap>(max_levels, 100.0f);
+		create_height_map(100.0f);
 		DiamondSquareGenerator gen(42);
 		gen.set_roughness(250.0f);
 		height_map->generate(513, gen);
@@ -325,6 +384,9 @@ namespace dukat
 		case SDLK_4:
 			generate_terrain();
 			break;
+		case SDLK_5:
+			load_mtrainier_tiled();
+			break;
 
 		case SDLK_h: // show heightmap texture
 			texture->id = clip_map->get_elevation_map()->id;
@@ -442,11 +504,22 @@ int main(int argc, char** argv)
 	try
 	{
 		std::string config = "../assets/terrain.ini";
+		// Convert height map to tiled layout and verify it without starting the app
+		if (argc == 4 && std::string(argv[1]) == "--tile")
+		{
+			dukat::Settings settings(config);
+			auto levels = settings.get_int("renderer.terrain.levels");
+			return dukat::tile_height_map(argv[2], argv[3], levels) ? 0 : 1;
+		}
+
 		if (argc > 1)
 		{
 			config = argv[1];
 		}
 		dukat::Settings settings(config);
+		// Optional number of frames to run before writing a frame report and exiting
+		if (argc > 2)
+			settings.set(dukat::settings::report_frames, std::atoi(argv[2]));
 		dukat::Game3 app(settings);
 		app.add_scene("main", std::make_unique<dukat::TerrainScene>(&app));
 		app.push_scene("main");
@@ -44,11 +44,14 @@ namespace dukat
 		CameraMode camera_mode;
 		bool direct_camera_control;
 
-		std::unique_ptr<ClipMap> clip_map;
+		// Height map must outlive the clip map, which reads it from worker threads
 		std::unique_ptr<HeightMap> height_map;
+		std::unique_ptr<ClipMap> clip_map;
 
 		void build_palette(void);
+		void create_height_map(float scale_factor);
 		void load_mtrainier(void);
+		void load_mtrainier_tiled(void);
 		void load_pugetsound(void);
 		void load_blank(void);
 		void generate_terrain(void);
@@ -0,0 +1,407 @@
+#pragma once
+
+#include <algorithm>
+#include <vector>
+#include <robin_hood.h>
+#include "aabb3.h"
+#include "frustum.h"
+
+namespace dukat
+{
+	// Dynamic bounding volume hierarchy of values with a bounding box. Leaves store boxes
+	// enlarged by a margin, so that values which move a little do not have to be
+	// reinserted. The tree is kept balanced through rotations, so that queries visit a
+	// logarithmic number of nodes.
+	template<class T>
+	class AABBTree3
+	{
+	private:
+		static constexpr int null_node = -1;
+
+		struct Node
+		{
+			AABB3 bb;
+			T* value;		// Set for leaves
+			int parent;		// Next free node if node is not in use
+			int left;
+			int right;
+			int height;		// 0 for leaves
+		};
+
+		const float margin;
+		std::vector<Node> nodes;
+		int root;
+		int free_list;
+		robin_hood::unordered_map<T*, int> leaves;
+		// Nodes left to visit during a query
+		mutable std::vector<int> stack;
+
+		static float area(const AABB3& bb);
+		static AABB3 merge(const AABB3& a, const AABB3& b);
+		bool is_leaf(int node) const { return nodes[node].left == null_node; }
+		int allocate_node(void);
+		void free_node(int node);
+		void insert_leaf(int leaf);
+		void remove_leaf(int leaf);
+		// Performs a left or right rotation if node is imbalanced. Returns the new root of the subtree.
+		int balance(int node);
+		// Appends values of all leaves below node to res.
+		void collect(int node, std::vector<T*>& res) const;
+
+	public:
+		AABBTree3(float margin = 0.1f) : margin(margin), root(null_node), free_list(null_node) { }
+		~AABBTree3(void) { }
+
+		std::size_t size(void) const { return leaves.size(); }
+		bool empty(void) const { return leaves.empty(); }
+		bool contains(T* value) const { return leaves.count(value) > 0; }
+		// Returns the height of the tree, which is 0 for an empty tree or a single leaf.
+		int height(void) const { return root == null_node ? 0 : nodes[root].height; }
+
+		// Adds a value or updates the bounding box of an existing value. The value is only
+		// reinserted if its box is no longer contained by the enlarged box in the tree.
+		// Values with an empty box are removed.
+		void insert(T* value, const AABB3& bb);
+		void remove(T* value);
+		void clear(void);
+		// Appends all values whose enlarged box overlaps with bb to res.
+		void query(const AABB3& bb, std::vector<T*>& res) const;
+		// Appends all values whose enlarged box is at least partially inside of the frustum
+		// to res. Subtrees which are completely inside are collected without further tests.
+		void query(const Frustum& frustum, std::vector<T*>& res) const;
+	};
+
+	template<class T>
+	constexpr int AABBTree3<T>::null_node;
+
+	template<class T>
+	float AABBTree3<T>::area(const AABB3& bb)
+	{
+		const auto s = bb.max - bb.min;
+		return 2.0f * (s.x * s.y + s.y * s.z + s.z * s.x);
+	}
+
+	template<class T>
+	AABB3 AABBTree3<T>::merge(const AABB3& a, const AABB3& b)
+	{
+		return AABB3{ Vector3{ std::min(a.min.x, b.min.x), std::min(a.min.y, b.min.y), std::min(a.min.z, b.min.z) },
+			Vector3{ std::max(a.max.x, b.max.x), std::max(a.max.y, b.max.y), std::max(a.max.z, b.max.z) } };
+	}
+
+	template<class T>
+	int AABBTree3<T>::allocate_node(void)
+	{
+		int node;
+		if (free_list != null_node)
+		{
+			node = free_list;
+			free_list = nodes[node].parent;
+		}
+		else
+		{
+			node = static_cast<int>(nodes.size());
+			nodes.push_back(Node{});
+		}
+		auto& n = nodes[node];
+		n.value = nullptr;
+		n.parent = n.left = n.right = null_node;
+		n.height = 0;
+		return node;
+	}
+
+	template<class T>
+	void AABBTree3<T>::free_node(int node)
+	{
+		nodes[node].value = nullptr;
+		nodes[node].parent = free_list;
+		nodes[node].height = -1;
+		free_list = node;
+	}
+
+	template<class T>
+	void AABBTree3<T>::insert_leaf(int leaf)
+	{
+		if (root == null_node)
+		{
+			root = leaf;
+			nodes[root].parent = null_node;
+			return;
+		}
+
+		// Find the best sibling by the increase of surface area along the path
+		const auto leaf_bb = nodes[leaf].bb;
+		auto index = root;
+		while (!is_leaf(index))
+		{
+			const auto& node = nodes[index];
+			const auto node_area = area(node.bb);
+			const auto combined_area = area(merge(node.bb, leaf_bb));
+			// Cost of creating a new parent for this node and the new leaf
+			const auto cost = 2.0f * combined_area;
+			// Minimum cost of pushing the leaf further down the tree
+			const auto inheritance_cost = 2.0f * (combined_area - node_area);
+
+			float child_cost[2];
+			const int children[2] = { node.left, node.right };
+			for (auto i = 0; i < 2; i++)
+			{
+				const auto& child = nodes[children[i]];
+				child_cost[i] = area(merge(leaf_bb, child.bb)) + inheritance_cost;
+				if (!is_leaf(children[i]))
+					child_cost[i] -= area(child.bb);
+			}
+
+			if (cost < child_cost[0] && cost < child_cost[1])
+				break;
+			index = child_cost[0] < child_cost[1] ? children[0] : children[1];
+		}
+
+		// Create a new parent for the sibling and the leaf
+		const auto sibling = index;
+		const auto old_parent = nodes[sibling].parent;
+		const auto new_parent = allocate_node();
+		nodes[new_parent].parent = old_parent;
+		nodes[new_parent].bb = merge(leaf_bb, nodes[sibling].bb);
+		nodes[new_parent].height = nodes[sibling].height + 1;
+		nodes[new_parent].left = sibling;
+		nodes[new_parent].right = leaf;
+		nodes[sibling].parent = new_parent;
+		nodes[leaf].parent = new_parent;
+		if (old_parent == null_node)
+			root = new_parent;
+		else if (nodes[old_parent].left == sibling)
+			nodes[old_parent].left = new_parent;
+		else
+			nodes[old_parent].right = new_parent;
+
+		// Walk back up the tree fixing heights and boxes
+		index = nodes[leaf].parent;
+		while (index != null_node)
+		{
+			index = balance(index);
+			auto& node = nodes[index];
+			node.height = 1 + std::max(nodes[node.left].height, nodes[node.right].height);
+			node.bb = merge(nodes[node.left].bb, nodes[node.right].bb);
+			index = node.parent;
+		}
+	}
+
+	template<class T>
+	void AABBTree3<T>::remove_leaf(int leaf)
+	{
+		if (leaf == root)
+		{
+			root = null_node;
+			return;
+		}
+
+		const auto parent = nodes[leaf].parent;
+		const auto grand_parent = nodes[parent].parent;
+		const auto sibling = nodes[parent].left == leaf ? nodes[parent].right : nodes[parent].left;
+
+		if (grand_parent == null_node)
+		{
+			root = sibling;
+			nodes[sibling].parent = null_node;
+			free_node(parent);
+			return;
+		}
+
+		// Replace parent with sibling and fix up ancestors
+		if (nodes[grand_parent].left == parent)
+			nodes[grand_parent].left = sibling;
+		else
+			nodes[grand_parent].right = sibling;
+		nodes[sibling].parent = grand_parent;
+		free_node(parent);
+
+		auto index = grand_parent;
+		while (index != null_node)
+		{
+			index = balance(index);
+			auto& node = nodes[index];
+			node.height = 1 + std::max(nodes[node.left].height, nodes[node.right].height);
+			node.bb = merge(nodes[node.left].bb, nodes[node.right].bb);
+			index = node.parent;
+		}
+	}
+
+	template<class T>
+	int AABBTree3<T>::balance(int a)
+	{
+		if (is_leaf(a) || nodes[a].height < 2)
+			return a;
+
+		const auto b = nodes[a].left;
+		const auto c = nodes[a].right;
+		const auto diff = nodes[c].height - nodes[b].height;
+
+		// Rotates child up, moving its taller child into its place
+		auto rotate = [this, a](int child, int other, bool child_is_right) {
+			const auto f = nodes[child].left;
+			const auto g = nodes[child].right;
+
+			// Swap a and child
+			nodes[child].left = a;
+			nodes[child].parent = nodes[a].parent;
+			nodes[a].parent = child;
+			if (nodes[child].parent == null_node)
+				root = child;
+			else if (nodes[nodes[child].parent].left == a)
+				nodes[nodes[child].parent].left = child;
+			else
+				nodes[nodes[child].parent].right = child;
+
+			// Keep the taller grandchild on child, move the other one to a
+			const auto keep = nodes[f].height > nodes[g].height ? f : g;
+			const auto move = keep == f ? g : f;
+			nodes[child].right = keep;
+			if (child_is_right)
+				nodes[a].right = move;
+			else
+				nodes[a].left = move;
+			nodes[move].parent = a;
+
+			nodes[a].bb = merge(nodes[other].bb, nodes[move].bb);
+			nodes[child].bb = merge(nodes[a].bb, nodes[keep].bb);
+			nodes[a].height = 1 + std::max(nodes[other].height, nodes[move].height);
+			nodes[child].height = 1 + std::max(nodes[a].height, nodes[keep].height);
+			return child;
+		};
+
+		if (diff > 1)
+			return rotate(c, b, true);
+		else if (diff < -1)
+			return rotate(b, c, false);
+		else
+			return a;
+	}
+
+	template<class T>
+	void AABBTree3<T>::insert(T* value, const AABB3& bb)
+	{
+		if (bb.empty())
+		{
+			remove(value);
+			return;
+		}
+
+		auto it = leaves.find(value);
+		if (it != leaves.end())
+		{
+			const auto& fat = nodes[it->second].bb;
+			if (fat.min.x <= bb.min.x && fat.min.y <= bb.min.y && fat.min.z <= bb.min.z
+				&& bb.max.x <= fat.max.x && bb.max.y <= fat.max.y && bb.max.z <= fat.max.z)
+				return; // still contained by enlarged box
+			remove_leaf(it->second);
+		}
+		else
+		{
+			const auto leaf = allocate_node();
+			nodes[leaf].value = value;
+			it = leaves.emplace(value, leaf).first;
+		}
+
+		const auto leaf = it->second;
+		const Vector3 d{ margin, margin, margin };
+		nodes[leaf].bb = AABB3{ bb.min - d, bb.max + d };
+		insert_leaf(leaf);
+	}
+
+	template<class T>
+	void AABBTree3<T>::remove(T* value)
+	{
+		auto it = leaves.find(value);
+		if (it == leaves.end())
+			return;
+		remove_leaf(it->second);
+		free_node(it->second);
+		leaves.erase(it);
+	}
+
+	template<class T>
+	void AABBTree3<T>::clear(void)
+	{
+		nodes.clear();
+		leaves.clear();
+		root = null_node;
+		free_list = null_node;
+	}
+
+	template<class T>
+	void AABBTree3<T>::collect(int node, std::vector<T*>& res) const
+	{
+		const auto base = stack.size();
+		stack.push_back(node);
+		while (stack.size() > base)
+		{
+			const auto index = stack.back();
+			stack.pop_back();
+			const auto& n = nodes[index];
+			if (n.left == null_node)
+			{
+				res.push_back(n.value);
+			}
+			else
+			{
+				stack.push_back(n.left);
+				stack.push_back(n.right);
+			}
+		}
+	}
+
+	template<class T>
+	void AABBTree3<T>::query(const AABB3& bb, std::vector<T*>& res) const
+	{
+		if (root == null_node)
+			return;
+
+		stack.clear();
+		stack.push_back(root);
+		while (!stack.empty())
+		{
+			const auto index = stack.back();
+			stack.pop_back();
+			const auto& n = nodes[index];
+			if (!n.bb.intersect_aabb(bb))
+				continue;
+			if (n.left == null_node)
+			{
+				res.push_back(n.value);
+			}
+			else
+			{
+				stack.push_back(n.left);
+				stack.push_back(n.right);
+			}
+		}
+	}
+
+	template<class T>
+	void AABBTree3<T>::query(const Frustum& frustum, std::vector<T*>& res) const
+	{
+		if (root == null_node)
+			return;
+
+		stack.clear();
+		stack.push_back(root);
+		while (!stack.empty())
+		{
+			const auto index = stack.back();
+			stack.pop_back();
+			const auto& n = nodes[index];
+			const auto c = frustum.classify(n.bb);
+			if (c < 0)
+				continue;
+			if (c > 0 || n.left == null_node)
+			{
+				collect(index, res);
+			}
+			else
+			{
+				stack.push_back(n.left);
+				stack.push_back(n.right);
+			}
+		}
+	}
+}
\ No newline at end of file
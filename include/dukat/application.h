@@ -9,6 +9,7 @@ namespace dukat
 	class Window;
 	class AudioManager;
 	class DeviceManager;
+	class JobScheduler;
 	class Settings;
 
 	class Application : public Messenger
@@ -35,6 +36,7 @@ namespace dukat
 		std::unique_ptr<AudioManager> audio_manager;
 #endif
 		std::unique_ptr<DeviceManager> device_manager;
+		std::unique_ptr<JobScheduler> scheduler;
 
 		// Called to process input events.
 		virtual void handle_event(const SDL_Event& e);
@@ -72,6 +74,7 @@ namespace dukat
 		AudioManager* get_audio(void) const { return audio_manager.get(); }
 #endif
 		DeviceManager* get_devices(void) const { return device_manager.get(); }
+		JobScheduler* get_scheduler(void) const { return scheduler.get(); }
 		Settings& get_settings(void) const { return settings; }
 	};
 }
\ No newline at end of file
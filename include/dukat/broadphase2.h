@@ -0,0 +1,68 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+#include "aabb2.h"
+#include "ray2.h"
+
+namespace dukat
+{
+	// Interface of a broadphase which determines pairs of values that can potentially
+	// collide. Values of type T need to expose a bounding box (bb) and an active flag.
+	template<class T>
+	class Broadphase2
+	{
+	public:
+		typedef std::pair<T*, T*> Pair;
+
+		Broadphase2(void) { }
+		virtual ~Broadphase2(void) { }
+
+		// Adds a value. Value will take part in queries after the next update.
+		virtual void insert(T* value) = 0;
+		// Removes a value.
+		virtual void remove(T* value) = 0;
+		// Removes all values.
+		virtual void clear(void) = 0;
+		// Synchronizes the broadphase with the current bounding box and active flag of each value.
+		virtual void update(void) = 0;
+
+		// Appends pairs of active values with overlapping bounding boxes. A pair may be
+		// reported more than once, in either order, and pairs may be reported in any order.
+		virtual void collect_pairs(std::vector<Pair>& pairs) const = 0;
+		// Appends active values whose bounding box may overlap a box.
+		virtual void query(const AABB2& bb, std::vector<T*>& res) const = 0;
+		// Appends active values whose bounding box may be intersected by a ray.
+		virtual void query(const Ray2& ray, float min_t, float max_t, std::vector<T*>& res) const = 0;
+		// Appends regions which partition space within a box (used for debug output).
+		virtual void collect_regions(const AABB2& bb, std::vector<AABB2>& res) const { }
+	};
+
+	// Inclusive overlap check, so that boxes which touch or have no extent are reported
+	// to the narrow phase.
+	inline bool bb_touches(const AABB2& a, const AABB2& b)
+	{
+		return a.min().x <= b.max().x && a.max().x >= b.min().x
+			&& a.min().y <= b.max().y && a.max().y >= b.min().y;
+	}
+
+	// Returns true if two boxes have identical bounds.
+	inline bool bb_equal(const AABB2& a, const AABB2& b)
+	{
+		return a.min().x == b.min().x && a.min().y == b.min().y
+			&& a.max().x == b.max().x && a.max().y == b.max().y;
+	}
+
+	// Returns box covering a ray segment, or false if segment is unbounded.
+	inline bool ray_bounds(const Ray2& ray, float min_t, float max_t, AABB2& bb)
+	{
+		const auto p0 = ray.point_at(min_t);
+		const auto p1 = ray.point_at(max_t);
+		if (!std::isfinite(p0.x) || !std::isfinite(p0.y) || !std::isfinite(p1.x) || !std::isfinite(p1.y))
+			return false;
+		bb = AABB2{ Vector2{ std::min(p0.x, p1.x), std::min(p0.y, p1.y) }, Vector2{ std::max(p0.x, p1.x), std::max(p0.y, p1.y) } };
+		return true;
+	}
+}
\ No newline at end of file
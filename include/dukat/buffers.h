@@ -1,9 +1,12 @@
 #pragma once
 
+#include <vector>
+
 #ifndef OPENGL_VERSION
 #include "version.h"
 #endif // !OPENGL_VERSION
 
+#include "glstate.h"
 #include "perfcounter.h"
 #include "texture.h"
 
@@ -24,7 +27,7 @@ namespace dukat
 
 		~GenericBuffer(void)
 		{
-			glDeleteBuffers(count, buffers);
+			glstate.delete_buffers(count, buffers);
 			delete[] buffers;
 			perfc.inc(PerformanceCounter::BUFFER_FREE);
 		}
@@ -47,7 +50,7 @@ namespace dukat
 		{
 #if OPENGL_VERSION >= 30
 			glGenVertexArrays(1, &vao);
-			glBindVertexArray(vao);
+			glstate.bind_vertex_array(vao);
 #endif
 			buffers = new GLuint[buffer_count];
 			glGenBuffers(buffer_count, buffers);
@@ -57,9 +60,9 @@ namespace dukat
 
 		~VertexBuffer(void)
 		{
-			glDeleteBuffers(buffer_count, buffers);
+			glstate.delete_buffers(buffer_count, buffers);
 #if OPENGL_VERSION >= 30
-			glDeleteVertexArrays(1, &vao);
+			glstate.delete_vertex_array(vao);
 #endif
 			delete[] buffers;
 			delete[] counts;
@@ -70,6 +73,52 @@ namespace dukat
 		void load_data(int buffer_index, GLenum target, int count, GLsizei stride, const GLvoid* data, GLenum usage);
 	};
 
+	// Ring buffer for vertex data that is rewritten every frame. The buffer is split
+	// into one region per frame in flight, and callers write directly into mapped memory.
+	// Uses persistent mapping where available, otherwise maps fenced sub-ranges of the
+	// current region. Regions grow on demand.
+	struct StreamBuffer
+	{
+		// Number of frames that can be in flight before the CPU has to wait
+		static constexpr int max_frames = 3;
+
+#if OPENGL_VERSION >= 30
+		GLuint vao; // Vertex Array Object
+#endif
+		GLuint buffer;
+		const GLsizei stride;
+		// Number of elements per region
+		int capacity;
+		// Index of region written to during current frame
+		int frame;
+		// Number of elements written to current region
+		int offset;
+		// Address of mapped buffer if persistently mapped
+		uint8_t* persistent_data;
+		// Staging memory if buffer cannot be mapped
+		std::vector<uint8_t> staging;
+#if OPENGL_VERSION >= 30
+		GLsync fences[max_frames];
+#endif
+
+		// Creates stream buffer with space for a number of elements of a given size per frame.
+		StreamBuffer(GLsizei stride, int capacity);
+		~StreamBuffer(void);
+
+		// Returns address to write up to count elements to. Has to be followed by call to unmap.
+		void* map(int count);
+		// Completes write of count elements and returns the index of the first element
+		// written, which can be passed to glDrawArrays.
+		GLint unmap(int count);
+		// Advances to the next region. Has to be called once at the end of each frame.
+		void next_frame(void);
+
+	private:
+		void allocate(int capacity);
+		void release(void);
+		bool is_persistent(void) const { return persistent_data != nullptr; }
+	};
+
 	struct FrameBuffer
 	{
 		// Framebuffer
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "aabb3.h"
+#include "frustum.h"
 #include "matrix4.h"
 #include "plane.h"
 #include "recipient.h"
@@ -42,8 +43,11 @@ namespace dukat
 
 		// Clip planes
 		Plane left_clip_plane, right_clip_plane;
+		// View frustum in world space
+		Frustum frustum;
 
 		void compute_horizontal_fov(void);
+		void update_frustum(void) { frustum.extract(transform.mat_proj_pers * transform.mat_view); }
 
 	public:
 		CameraTransform3 transform;
@@ -60,10 +64,11 @@ namespace dukat
 		const Plane& get_right_clip_plane(void) const { return right_clip_plane; }
 		float get_near_clip(void) const { return near_clip; }
 		float get_far_clip(void) const { return far_clip; }
+		const Frustum& get_frustum(void) const { return frustum; }
 		void refresh(void) { resize(window->get_width(), window->get_height()); }
 
 		// Returns true if a AABB3 is not visible to this camera.
-		inline bool is_clipped(const AABB3& bb) const { return (bb.classify_plane(left_clip_plane) < 0 || bb.classify_plane(right_clip_plane) < 0); }
+		inline bool is_clipped(const AABB3& bb) const { return frustum.is_clipped(bb); }
 
 		// Updates the camera's view matrix. Subclasses of camera should update
 		// the camera axes and call this method to update the view matrix.
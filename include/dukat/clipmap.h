@@ -1,14 +1,17 @@
 #pragma once
 
 #include <array>
+#include <deque>
 #include <memory>
 #include <vector>
 #include "aabb3.h"
 #include "buffers.h"
 #include "color.h"
 #include "game3.h"
+#include "jobscheduler.h"
 #include "plane.h"
 #include "mesh.h"
+#include "rect.h"
 #include "texturecache.h"
 #include "vector2.h"
 
@@ -48,6 +51,8 @@ namespace dukat
 
         // Shifts origin and attached bounding boxes
         void translate(const Vector2& offset);
+        // Copies origin, last shift, orientation and bounding boxes of another level.
+        void set_placement(const ClipMapLevel& level);
 
 		// Orientation helpers
 		inline bool is_left(void) const { return (orientation & 0x2) == 0x2; }
@@ -59,14 +64,42 @@ namespace dukat
     class ClipMap : public Mesh
     {
     private:
+        // Elevation data for the regions of a level which have changed
+        struct LevelUpdate
+        {
+            ClipMapLevel state; // placement of level once update has been applied
+            int num_regions;
+            std::array<Rect, 2> regions; // regions in world space; full level or x and y strips
+            std::array<std::vector<GLfloat>, 2> data;
+        };
+
+        // Updates of all levels which have moved during a frame. Data is filled in by a 
+        // job and batches are applied as a whole, so that levels remain nested.
+        struct UpdateBatch
+        {
+            std::vector<LevelUpdate> updates;
+            std::size_t bytes;
+            JobCounter counter;
+
+            UpdateBatch(void) : bytes(0) { }
+        };
+
+		static constexpr std::size_t default_upload_budget = 1024 * 1024;
+
 		const int num_levels;
 		const int level_size;
 		const int texture_size;
 		Game3* game;
-		HeightMap* height_map; // Height map data
-		std::vector<ClipMapLevel> levels;
+		HeightMap* height_map; // Height map data, not owned
+		std::vector<ClipMapLevel> levels; // levels as currently uploaded and rendered
+		std::vector<ClipMapLevel> targets; // levels following the observer
 		int min_level; // min level to render - based on height of observer
 
+		std::deque<std::unique_ptr<UpdateBatch>> batches; // batches waiting to be applied
+		std::vector<std::vector<GLfloat>> spare_buffers; // staging buffers for reuse
+		std::size_t upload_budget; // bytes to upload per frame
+		int level_budget; // levels to update per frame
+
 		// Clipmap meshes
         std::unique_ptr<MeshData> inner_mesh;
         std::unique_ptr<MeshData> block_mesh;
@@ -82,7 +115,6 @@ namespace dukat
 		std::unique_ptr<Texture> color_map; // 1-dimensional RGB texture used to color terrain
 
         ShaderProgram* update_program; // used to update elevation sampler 
-		std::vector<GLfloat> buffer; // Buffer used to update elevation samplers.
         std::unique_ptr<FrameBuffer> fb_update; // frame buffer to update elevation sampler 
         std::unique_ptr<MeshData> quad_update; // quad mesh used to update elevation sampler
 		std::unique_ptr<Texture> update_texture; // 1-channel GL_R32F texture used to update elevation maps.
@@ -98,9 +130,19 @@ namespace dukat
         void build_fill_buffer(int block_size);
         void build_perimeter_buffer(void);
 
+        // Margin around each level within which height map tiles are kept resident.
+        int prefetch_margin(void) const { return texture_size / 4; }
+        // Grows the tile cache of a tiled height map to hold the prefetched tiles of all levels.
+        void reserve_tiles(void);
         void update_levels(void);
-        // Updates elevation samplers and returns index of coarsest level that was updated.
-        int update_elevation_maps(void);
+        // Queues a batch for levels which have moved and starts a job to read their data 
+        // from the height map.
+        void queue_updates(void);
+        // Applies prepared batches within the upload budget, or all batches if flush is 
+        // set. Returns index of coarsest level that was updated.
+        int update_elevation_maps(bool flush);
+        // Uploads data of an update into the elevation sampler of a level.
+        void apply_update(ClipMapLevel& level, const LevelUpdate& update);
         // Updates normal samplers starting at max_index to finest grained level.
         void update_normal_maps(int max_index);
         void render_level(const Camera3& cam, int i);
@@ -113,15 +155,21 @@ namespace dukat
         // Observer (i.e., camera) position in world space
 		Vector3 observer_pos;
         
-        // Creates a new clipmap.
+        // Creates a new clipmap. Jobs read the height map after update has returned, 
+        // so the height map must outlive the clipmap.
         ClipMap(Game3* game, int num_levels, int level_size, HeightMap* height_map);
-        ~ClipMap(void) { }
+        ~ClipMap(void);
 
 		// Sets clipmap shader.
 		void set_program(ShaderProgram* program) { this->program = program; }
 		// Sets the color palette used to shade the terrain.
         void set_palette(const std::vector<Color>& palette);
 		void update(float delta);
+		// Limits the elevation data uploaded per frame. At least one batch of level 
+		// updates is applied each frame regardless.
+		void set_upload_budget(std::size_t bytes, int levels) { upload_budget = bytes; level_budget = levels; }
+		// Returns the number of batches of level updates not yet applied.
+		std::size_t get_pending_updates(void) const { return batches.size(); }
         void render(Renderer* renderer);
         
         // Testing
@@ -4,11 +4,14 @@
 #include <memory>
 #include <robin_hood.h>
 
+#include "broadphase2.h"
+#include "boundingcircle.h"
 #include "game2.h"
+#include "jobscheduler.h"
 #include "manager.h"
+#include "mathutil.h"
 #include "memorypool.h"
 #include "messenger.h"
-#include "quadtree.h"
 
 namespace dukat
 {
@@ -17,17 +20,27 @@ namespace dukat
 	class CollisionManager2 : public Manager, public Messenger
 	{
 	public:	
+		// Body ids combine the index of a slot, which is recycled once a body is destroyed,
+		// with a generation that is incremented each time the slot is reused.
+		static constexpr uint32_t id_index_bits = 22;
+		static constexpr uint32_t id_index_mask = (1u << id_index_bits) - 1u;
+		static constexpr uint32_t max_bodies = 1u << id_index_bits;
+
 		struct Body
 		{
-			const uint16_t id;
+			const uint32_t id;
 			bool dynamic;	// dynamic bodies can be moved as part of collision resolution
 			bool solid;		// if true, will cause this body to take part in collision resolution
 			bool active;	// if false, will cause this body to be ignored by collision manager
 			float mass;		// Mass factor of this body use during collision resolution with other bodies
 			AABB2 bb;
 			Messenger* owner;
+			// Bodies this body has a contact with; maintained by collision manager
+			std::vector<Body*> neighbors;
+			// Position in list of bodies; maintained by collision manager
+			std::size_t index;
 
-			Body(uint16_t id) : id(id), dynamic(true), solid(true), active(true), mass(1.0f), owner(nullptr) { }
+			Body(uint32_t id) : id(id), dynamic(true), solid(true), active(true), mass(1.0f), owner(nullptr), index(0) { }
 
 			// Custom memory allocation
 			static MemoryPool<Body> _pool;
@@ -44,6 +57,12 @@ namespace dukat
 			uint32_t age;
 		};
 
+		// Default filter of allocation-free queries, matches active bodies
+		struct ActiveFilter
+		{
+			bool operator()(const Body* b) const { return b->active; }
+		};
+
 		// Filter predicates
 		typedef std::function<bool(Body*)> predicate;
 		static const predicate pred_active;
@@ -59,27 +78,54 @@ namespace dukat
 		// Used to determine which collisions have been resolved.
 		uint8_t generation;
 
-		std::unique_ptr<QuadTree<Body>> tree;
-		std::list<std::unique_ptr<Body>> bodies;
-		robin_hood::unordered_map<uint32_t, Contact> contacts;
+		std::unique_ptr<Broadphase2<Body>> broadphase;
+		// Potential collisions reported by broadphase
+		std::vector<Broadphase2<Body>::Pair> pairs;
+		std::vector<std::unique_ptr<Body>> bodies;
+		robin_hood::unordered_map<uint64_t, Contact> contacts;
+		// Body by id slot, and current generation of each slot
+		std::vector<Body*> slots;
+		std::vector<uint32_t> generations;
+		std::vector<uint32_t> free_slots;
 
 		friend class DebugEffect2;
 
-		// (Re)creates the quad tree.
+		// Buffer for broadphase candidates, borrowed from a per-thread pool so that
+		// queries can be nested and run on several threads at once.
+		class CandidateBuffer
+		{
+		private:
+			std::vector<Body*>* buffer;
+		public:
+			CandidateBuffer(void);
+			~CandidateBuffer(void);
+			std::vector<Body*>& get(void) { return *buffer; }
+		};
+
+		static AABB2 query_bounds(const Vector2& pos) { return AABB2{ pos, pos }; }
+		static AABB2 query_bounds(const AABB2& bb) { return bb; }
+		static AABB2 query_bounds(const BoundingCircle& bc) { return AABB2{ bc.center - Vector2{ bc.radius, bc.radius }, bc.center + Vector2{ bc.radius, bc.radius } }; }
+		static bool query_test(const Body* b, const Vector2& pos) { return b->bb.contains(pos); }
+		static bool query_test(const Body* b, const AABB2& bb) { return b->bb.overlaps(bb); }
+		static bool query_test(const Body* b, const BoundingCircle& bc) { return b->bb.intersect_circle(bc); }
+
+		// (Re)creates the quad tree if it is used as broadphase.
 		void create_tree(void);
-		// Collect all entities which are at equal or higher level in the tree as a given body.
-		void collect_collisions(const QuadTree<Body>& t, Body* body, std::vector<Body*>& res) const;
+		// Adds / removes a pair of bodies to / from each other's neighbors.
+		static void link_contact(Body* b1, Body* b2);
+		static void unlink_contact(Body* b1, Body* b2);
 		// Tests that a collision between two bodies is valie and if so tracks it.
 		void test_collision(Body* this_body, Body* other_body);
 		// Attempts to resolve active collisions and notifies at the end of collisions.
 		void resolve_collisions(void);
 
-		// Collects ray collisions
-		void find(QuadTree<Body>* tree, const Ray2& ray, float min_t, float max_t, std::list<Body*>& list, const predicate& p = pred_active) const;
-		Body* find_closest(QuadTree<Body>* tree, const Ray2& ray, float min_t, float max_t, float& t, const predicate& p) const;
+		// Returns a new body id.
+		uint32_t allocate_id(void);
+		// Releases id of a destroyed body.
+		void release_id(uint32_t id);
 
 		// Generate a hash for a contact between two bodies.
-		inline uint32_t hash(const Body* b1, const Body* b2) const { return 65536u * static_cast<uint32_t>(std::min(b1->id, b2->id)) + static_cast<uint32_t>(std::max(b1->id, b2->id)); }
+		inline uint64_t hash(const Body* b1, const Body* b2) const { return (static_cast<uint64_t>(std::min(b1->id, b2->id)) << 32) | static_cast<uint64_t>(std::max(b1->id, b2->id)); }
 
 	public:
 		CollisionManager2(GameBase* game);
@@ -91,12 +137,20 @@ namespace dukat
 		void set_world_size(float world_size) { this->world_size = world_size; create_tree(); }
 		// Sets the depth of the world collision tree. 
 		void set_world_depth(int world_depth) { this->world_depth = world_depth; create_tree(); }
+		// Replaces the broadphase used to find potential collisions (default: quad tree 
+		// bounded by world settings). Existing bodies are moved to the new broadphase.
+		void set_broadphase(std::unique_ptr<Broadphase2<Body>> broadphase);
+		Broadphase2<Body>* get_broadphase(void) const { return broadphase.get(); }
 
 		Body* create_body(bool dynamic = true);
 		void destroy_body(Body* body);
+		// Destroys a number of bodies. Same as calling destroy_body for each.
+		void destroy_bodies(const std::vector<Body*>& bodies);
 		void invalidate_contacts(Body* body);
 		void update(float delta);
 
+		// Returns body for an id, or nullptr if the body has been destroyed.
+		Body* get_body(uint32_t id) const;
 		// Returns the number of collision bodies.
 		int body_count(void) const { return static_cast<int>(bodies.size()); }
 		// Returns the number of contacts.
@@ -104,7 +158,7 @@ namespace dukat
 		// Returns true if there exists a contact between two bodies.
 		bool has_contact(Body* b1, Body* b2) const { return contacts.count(hash(b1, b2)) > 0; }
 		// Returns true if there exists at least one contact that includes a given body.
-		bool has_contact(Body* b) const;
+		bool has_contact(Body* b) const { return !b->neighbors.empty(); }
 		// Returns all contacts for a given body.
 		std::list<Contact*> get_contacts(Body* b) const;
 
@@ -120,5 +174,129 @@ namespace dukat
 		std::list<Body*> find(const Ray2& ray, float min_t, float max_t, const predicate& p = pred_active) const;
 		// Returns closest body intersected by a given ray.
 		Body* find_closest(const Ray2& ray, float min_t, float max_t, float& t, const predicate& p = pred_active) const;
+
+		// Allocation-free spatial queries. A query is a point (Vector2), box (AABB2) or circle
+		// (BoundingCircle). Predicates are passed by type so that they can be inlined. Queries
+		// may run on several threads at once, but not while bodies are created, destroyed or
+		// the manager is updated.
+
+		// Calls visitor(body) for each body matched by a query.
+		template<class Q, class V, class P = ActiveFilter>
+		void visit(const Q& query, V visitor, P p = P()) const;
+		// Calls visitor(body) for each body intersected by a ray.
+		template<class V, class P = ActiveFilter>
+		void visit(const Ray2& ray, float min_t, float max_t, V visitor, P p = P()) const;
+		// Appends bodies matched by a query to res and returns their number.
+		template<class Q, class P = ActiveFilter>
+		std::size_t find(const Q& query, std::vector<Body*>& res, P p = P()) const;
+		// Appends bodies intersected by a ray to res and returns their number.
+		template<class P = ActiveFilter>
+		std::size_t find(const Ray2& ray, float min_t, float max_t, std::vector<Body*>& res, P p = P()) const;
+		// Returns closest body intersected by a ray.
+		template<class P>
+		Body* find_closest(const Ray2& ray, float min_t, float max_t, float& t, P p) const;
+
+		// Batched queries
+		
+		// Calls visitor(index, body) for each body matched by one of count queries. If a
+		// scheduler is provided, queries are spread across threads and the visitor may be
+		// called concurrently for different queries.
+		template<class Q, class V, class P = ActiveFilter>
+		void visit_batch(const Q* queries, std::size_t count, V visitor, P p = P(), JobScheduler* scheduler = nullptr) const;
+		// Appends bodies matched by count queries to res. Matches of query i are stored
+		// in range [offsets[i], offsets[i + 1]).
+		template<class Q, class P = ActiveFilter>
+		void find_batch(const Q* queries, std::size_t count, std::vector<Body*>& res, std::vector<std::size_t>& offsets, P p = P()) const;
 	};
+
+	template<class Q, class V, class P>
+	void CollisionManager2::visit(const Q& query, V visitor, P p) const
+	{
+		CandidateBuffer candidates;
+		auto& buffer = candidates.get();
+		broadphase->query(query_bounds(query), buffer);
+		for (auto b : buffer)
+		{
+			if (p(b) && query_test(b, query))
+				visitor(b);
+		}
+	}
+
+	template<class V, class P>
+	void CollisionManager2::visit(const Ray2& ray, float min_t, float max_t, V visitor, P p) const
+	{
+		CandidateBuffer candidates;
+		auto& buffer = candidates.get();
+		broadphase->query(ray, min_t, max_t, buffer);
+		for (auto b : buffer)
+		{
+			if (p(b) && b->bb.intersect_ray(ray, min_t, max_t) != no_intersection)
+				visitor(b);
+		}
+	}
+
+	template<class Q, class P>
+	std::size_t CollisionManager2::find(const Q& query, std::vector<Body*>& res, P p) const
+	{
+		const auto size = res.size();
+		visit(query, [&res](Body* b) { res.push_back(b); }, p);
+		return res.size() - size;
+	}
+
+	template<class P>
+	std::size_t CollisionManager2::find(const Ray2& ray, float min_t, float max_t, std::vector<Body*>& res, P p) const
+	{
+		const auto size = res.size();
+		visit(ray, min_t, max_t, [&res](Body* b) { res.push_back(b); }, p);
+		return res.size() - size;
+	}
+
+	template<class P>
+	CollisionManager2::Body* CollisionManager2::find_closest(const Ray2& ray, float min_t, float max_t, float& t, P p) const
+	{
+		CandidateBuffer candidates;
+		auto& buffer = candidates.get();
+		broadphase->query(ray, min_t, max_t, buffer);
+
+		t = max_t;
+		Body* best_body = nullptr;
+		for (auto b : buffer)
+		{
+			if (p(b))
+			{
+				const auto body_t = b->bb.intersect_ray(ray, min_t, max_t);
+				if (body_t < t)
+				{
+					t = body_t;
+					best_body = b;
+				}
+			}
+		}
+		return best_body;
+	}
+
+	template<class Q, class V, class P>
+	void CollisionManager2::visit_batch(const Q* queries, std::size_t count, V visitor, P p, JobScheduler* scheduler) const
+	{
+		auto run = [&](std::size_t begin, std::size_t end) {
+			for (auto i = begin; i < end; i++)
+				visit(queries[i], [&visitor, i](Body* b) { visitor(i, b); }, p);
+		};
+		if (scheduler != nullptr)
+			scheduler->parallel_for(0, count, 16, run);
+		else
+			run(0, count);
+	}
+
+	template<class Q, class P>
+	void CollisionManager2::find_batch(const Q* queries, std::size_t count, std::vector<Body*>& res, std::vector<std::size_t>& offsets, P p) const
+	{
+		offsets.resize(count + 1);
+		for (auto i = 0u; i < count; i++)
+		{
+			offsets[i] = res.size();
+			visit(queries[i], [&res](Body* b) { res.push_back(b); }, p);
+		}
+		offsets[count] = res.size();
+	}
 }
\ No newline at end of file
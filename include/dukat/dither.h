@@ -26,7 +26,8 @@ namespace dukat
 	/// <param name="surface">The surface.</param>
 	/// <param name="n">Determines the size of the Bayer matrix, size being 2^n</param>
 	/// <param name="palette">Colors to apply for the monochrome min and max values</param>
-	void dither_ordered(Surface& surface, int n, const std::array<Color, 2>& palette);
+	/// <param name="scheduler">Optional scheduler used to process tiles of rows in parallel</param>
+	void dither_ordered(Surface& surface, int n, const std::array<Color, 2>& palette, JobScheduler* scheduler = nullptr);
 
 	/// <summary>
 	/// Applies dithering algorithm to a monochrome surface.
@@ -38,6 +39,39 @@ namespace dukat
 	template<class Algorithm>
 	void dither(Surface& surface, Algorithm algorithm, const std::array<Color, 2>& palette)
 	{
+		// 32 bit surfaces are converted to luminance a row at a time
+		const auto fmt = surface.get_surface()->format;
+		const auto color0 = surface.raw_color(palette[0]);
+		const auto color1 = surface.raw_color(palette[1]);
+		std::vector<float> lum(surface.width());
+		const auto bulk = dispatch_pixel_layout(fmt->BytesPerPixel, fmt->Rmask, fmt->Gmask, fmt->Bmask, [&](auto layout) {
+			const auto rect = surface.pixels<uint32_t>();
+			for (auto y = 0; y < rect.height; y++)
+			{
+				algorithm.next_row();
+				auto row = rect.row(y);
+				luminance_row<decltype(layout)>(row, lum.data(), rect.width);
+				for (auto x = 0; x < rect.width; x++)
+				{
+					auto color = lum[x] + algorithm.get_error(x, y);
+					float error;
+					if (color < 0.5f)
+					{
+						error = color;
+						row[x] = color0;
+					}
+					else
+					{
+						error = color - 1.0f;
+						row[x] = color1;
+					}
+					algorithm.distribute_error(x, y, error);
+				}
+			}
+		});
+		if (bulk)
+			return;
+
 		for (auto y = 0; y < surface.height(); y++)
 		{
 			algorithm.next_row();
@@ -61,8 +95,96 @@ namespace dukat
 		}
 	}
 
+	/// <summary>
+	/// Error diffusion kernel. Each entry passes weight / divisor of the error of a pixel on to
+	/// the pixel at offset dx, dy. Entries may only point to pixels which are processed later, 
+	/// i.e. dy > 0, or dy == 0 and dx > 0.
+	/// </summary>
+	struct DiffusionKernel
+	{
+		struct Entry
+		{
+			int dx;
+			int dy;
+			float weight;
+		};
+
+		std::vector<Entry> entries;
+		float divisor;
+
+		static const DiffusionKernel floyd_steinberg;
+		static const DiffusionKernel sierra; // Two-row Sierra, same as SierraDitherAlgorithm
+		static const DiffusionKernel sierra_lite;
+		static const DiffusionKernel sierra3;
+		static const DiffusionKernel atkinson;
+		static const DiffusionKernel burkes;
+		static const DiffusionKernel jarvis_judice_ninke;
+		static const DiffusionKernel stucki;
+
+		// Returns the number of rows below the current one which receive errors.
+		int max_dy(void) const;
+	};
+
+	/// <summary>
+	/// Applies error diffusion dithering with a kernel to a monochrome surface. If a scheduler 
+	/// is provided, rows are processed in parallel, each row trailing the one above it by the 
+	/// reach of the kernel. The result is identical to dither with a KernelDitherAlgorithm.
+	/// </summary>
+	/// <param name="surface">The surface</param>
+	/// <param name="kernel">The error diffusion kernel</param>
+	/// <param name="palette">Colors to apply for the monochrome min and max values</param>
+	/// <param name="scheduler">Optional scheduler used to process rows in parallel</param>
+	void dither(Surface& surface, const DiffusionKernel& kernel, const std::array<Color, 2>& palette, JobScheduler* scheduler = nullptr);
+
 	#pragma region Distributing dithering algorithms
 
+	// Distributes errors according to a diffusion kernel.
+	template<typename T>
+	class KernelDitherAlgorithm
+	{
+	private:
+		const int width, height; // image dimensions
+		const DiffusionKernel kernel;
+		const int rows; // number of rows which receive errors
+		std::vector<T> errors;
+		int row;
+
+		T* row_errors(int y) { return errors.data() + (y % rows) * width; }
+
+	public:
+		KernelDitherAlgorithm(int width, int height, const DiffusionKernel& kernel) : width(width), height(height), 
+			kernel(kernel), rows(kernel.max_dy() + 1), errors(rows * width), row(-1)
+		{
+			std::fill(errors.begin(), errors.end(), static_cast<T>(0));
+		}
+
+		T get_error(int x, int y) const
+		{
+			return errors[(y % rows) * width + x];
+		}
+
+		void next_row(void)
+		{
+			// The row which moves into view replaces the previous one
+			if (++row > 0)
+			{
+				auto e = row_errors(row + rows - 1);
+				std::fill(e, e + width, static_cast<T>(0));
+			}
+		}
+
+		void distribute_error(int x, int y, const T& error)
+		{
+			for (const auto& e : kernel.entries)
+			{
+				const auto tx = x + e.dx;
+				const auto ty = y + e.dy;
+				if (tx >= 0 && tx < width && ty < height)
+					row_errors(ty)[tx] += error * e.weight / kernel.divisor;
+			}
+		}
+	};
+
 	template<typename T>
 	class FloydSteinbergDitherAlgorithm
 	{
@@ -58,16 +58,23 @@
 // Collision
 #include "aabb2.h"
 #include "aabb3.h"
+#include "aabbtree3.h"
 #include "boundingbody2.h"
 #include "boundingbody3.h"
 #include "boundingcircle.h"
 #include "boundingsphere.h"
+#include "broadphase2.h"
 #ifndef __ANDROID__
 #include "box2dmanager.h"
 #endif
 #include "collisionmanager2.h"
+#include "frustum.h"
+#include "gridbroadphase2.h"
+#include "loosegrid2.h"
 #include "obb2.h"
 #include "quadtree.h"
+#include "quadtreebroadphase2.h"
+#include "sweepprunebroadphase2.h"
 
 // System
 #include "animation.h"
@@ -78,8 +85,12 @@
 #include "bytestream.h"
 #include "deferred.h"
 #include "executor.h"
+#include "framereport.h"
+#include "jobscheduler.h"
 #include "log.h"
+#include "mappedfile.h"
 #include "perfcounter.h"
+#include "profiler.h"
 #include "settings.h"
 #include "sdlutil.h"
 #include "sysutil.h"
@@ -99,13 +110,17 @@
 #ifndef __ANDROID__
 #include "heightmap.h"
 #include "heightmapgenerator.h"
+#include "heightmaptiles.h"
 #include "mapgraph.h"
 #include "mapshape.h"
+#include "memorypool.h"
 #include "model3.h"
+#include "modelloader.h"
 #include "modelconverter.h"
 #include "ms3dmodel.h"
 #include "octreenode.h"
 #endif
+#include "radixsort.h"
 #include "shape.h"
 #include "string.h"
 #include "textureatlas.h"
@@ -143,7 +158,9 @@
 #include "followercamera2.h"
 #include "followercamera3.h"
 #include "fullscreeneffect2.h"
+#include "glstate.h"
 #include "gridmesh.h"
+#include "layerslot.h"
 #include "light.h"
 #include "material.h"
 #include "mesh.h"
@@ -154,16 +171,21 @@
 #include "meshgroup.h"
 #include "meshinstance.h"
 #include "mirroreffect2.h"
+#include "nullgl.h"
 #include "orbitallight.h"
 #include "orbitcamera3.h"
 #include "particle.h"
 #include "particleemitter.h"
+#include "particlekernels.h"
 #include "particlemanager.h"
 #include "particlerecipe.h"
+#include "particlestore.h"
+#include "pixelops.h"
 #include "renderer.h"
 #include "renderer2.h"
 #include "renderer3.h"
 #include "renderlayer2.h"
+#include "renderqueue3.h"
 #include "shakycameraeffect.h"
 #include "shadercache.h"
 #include "shaderprogram.h"
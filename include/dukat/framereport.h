@@ -0,0 +1,64 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace dukat
+{
+	// Collects per-frame timings, engine counters and OpenGL statistics for a fixed number
+	// of frames and writes them to a JSON file. Used to benchmark the render path, typically 
+	// in combination with the null OpenGL backend.
+	class FrameReport
+	{
+	public:
+		enum Metric
+		{
+			FrameTime,			// CPU time of frame in ms
+			RenderTime,			// CPU time spent rendering in ms
+			GLCalls,			// No# of OpenGL calls
+			DrawCalls,			// No# of draw calls
+			Instances,			// No# of instances drawn
+			Vertices,			// No# of vertices drawn
+			StateChanges,		// No# of OpenGL state changes
+			RedundantChanges,	// No# of OpenGL state changes which did not change anything
+			AvoidedChanges,		// No# of OpenGL state changes skipped by the state cache
+			ProgramBinds,		// No# of program binds
+			TextureBinds,		// No# of texture binds
+			BufferBinds,		// No# of buffer binds
+			VertexArrayBinds,	// No# of vertex array binds
+			FramebufferBinds,	// No# of framebuffer binds
+			UniformUpdates,		// No# of uniform updates
+			UploadedBytes,		// No# of bytes uploaded to buffers and textures
+			Sprites,			// No# of sprites rendered
+			Particles,			// No# of particles rendered
+			Meshes,				// No# of meshes rendered
+			MeshesCulled,		// No# of meshes culled against the view frustum
+			MeshesSubmitted,	// No# of meshes submitted to the render queue
+			_count
+		};
+
+	private:
+		static const char* metric_names[Metric::_count];
+
+		const std::size_t frames;
+		const std::string filename;
+		std::vector<std::array<double, Metric::_count>> samples;
+		uint64_t frame_start;
+		uint64_t render_start;
+
+	public:
+		FrameReport(int frames, const std::string& filename);
+		~FrameReport(void) { }
+
+		// Marks start of the frame, start of rendering and end of the frame. 
+		// Called by the application; end_frame has to be called before performance counters are reset.
+		void begin_frame(void);
+		void begin_render(void);
+		void end_frame(void);
+		bool is_complete(void) const { return samples.size() >= frames; }
+		// Writes summary and individual frames to file.
+		void write(void) const;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace dukat
+{
+	class AABB3;
+	class Matrix4;
+
+	// View frustum bounded by six planes with normals pointing inwards. Planes are stored
+	// as structure of arrays, padded with planes that contain everything, so that boxes
+	// can be tested against four planes at a time.
+	class Frustum
+	{
+	public:
+		enum PlaneIndex { Left, Right, Bottom, Top, Near, Far };
+		static constexpr int num_planes = 6;
+
+	private:
+		static constexpr int padded_planes = 8;
+		// Plane coefficients; a point p is inside a plane if n * p + d >= 0
+		float nx[padded_planes];
+		float ny[padded_planes];
+		float nz[padded_planes];
+		float d[padded_planes];
+
+	public:
+		Frustum(void);
+		~Frustum(void) { }
+
+		// Extracts planes from a combined projection and view matrix. Passing the product
+		// with a model matrix yields the frustum in model space.
+		void extract(const Matrix4& clip);
+
+		// Classify box as being outside, inside or intersecting the frustum.
+		// Will return < 0 if box is completely outside of the frustum
+		// Will return > 0 if box is completely inside of the frustum
+		// Will return 0 if the box intersects the frustum
+		int classify(const AABB3& bb) const;
+		// Returns true if a box is completely outside of the frustum.
+		bool is_clipped(const AABB3& bb) const { return classify(bb) < 0; }
+		// Tests an array of boxes, four at a time. Sets visible[i] to 1 for boxes which are
+		// at least partially inside of the frustum, and 0 otherwise. Returns the number of
+		// visible boxes.
+		std::size_t cull(const AABB3* boxes, std::size_t count, uint8_t* visible) const;
+	};
+}
\ No newline at end of file
@@ -11,6 +11,7 @@
 #include "animationmanager.h"
 #include "application.h"
 #include "fontcache.h"
+#include "jobscheduler.h"
 #include "meshcache.h"
 #include "messenger.h"
 #include "textmeshinstance.h"
@@ -38,6 +39,8 @@ namespace dukat
 		std::unique_ptr<MeshCache> mesh_cache;
 		std::unique_ptr<FontCache> font_cache;
 		std::map<std::type_index, std::unique_ptr<Manager>> managers;
+		// Updates of concurrent managers
+		TaskGraph manager_tasks;
 		std::unordered_map<std::string, std::unique_ptr<Scene>> scenes;
 		std::stack<Scene*> scene_stack;
 		std::queue<std::function<void(void)>> delayed_actions;
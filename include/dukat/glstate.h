@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstdint>
+
+#ifndef OPENGL_VERSION
+#include "version.h"
+#endif // !OPENGL_VERSION
+
+#include "perfcounter.h"
+
+namespace dukat
+{
+	// Shadow copy of OpenGL state which changes frequently while rendering. Engine code
+	// binds objects and toggles capabilities through this cache, which skips changes to
+	// the current value and counts them as PerformanceCounter::STATE_AVOIDED. Code which
+	// changes the same state through GL directly has to call invalidate() afterwards.
+	class GLState
+	{
+	public:
+		static constexpr int max_texture_units = 16;
+		static constexpr int max_buffer_bases = 8;
+
+	private:
+		// Value of state which has not been set through the cache yet
+		static constexpr GLuint unknown = 0xffffffff;
+
+		enum TextureTarget { Texture2D, TextureCube, Texture2DArray, Texture3D, _target_count };
+		enum Capability { Blend, DepthTest, CullFace, ScissorTest, _capability_count };
+
+		GLuint program;
+		GLuint active_unit;
+		GLuint textures[max_texture_units][_target_count];
+		GLuint vertex_array;
+		GLuint array_buffer;
+		GLuint uniform_buffer;
+		GLuint uniform_bases[max_buffer_bases];
+		GLuint draw_framebuffer;
+		GLuint read_framebuffer;
+		GLuint capabilities[_capability_count];
+		GLenum blend_src;
+		GLenum blend_dst;
+
+		static int target_index(GLenum target);
+		static int capability_index(GLenum cap);
+		// Returns true if value needs to change, otherwise counts avoided change.
+		static bool update(GLuint& current, GLuint value)
+		{
+			if (current == value)
+			{
+				perfc.inc(PerformanceCounter::STATE_AVOIDED);
+				return false;
+			}
+			current = value;
+			return true;
+		}
+		void set_capability(GLenum cap, bool enabled);
+
+	public:
+		GLState(void) { invalidate(); }
+		~GLState(void) { }
+
+		// Forgets all state, so that the next change of each value is passed on to GL.
+		void invalidate(void);
+
+		void use_program(GLuint id) { if (update(program, id)) glUseProgram(id); }
+		// Selects texture unit, with unit being an index rather than GL_TEXTUREi.
+		void active_texture(GLuint unit);
+		// Binds texture to the active texture unit.
+		void bind_texture(GLenum target, GLuint id);
+		// Binds texture to a texture unit.
+		void bind_texture(GLuint unit, GLenum target, GLuint id) { active_texture(unit); bind_texture(target, id); }
+		// Vertex arrays capture the element array binding, which is therefore not tracked.
+		void bind_vertex_array(GLuint id);
+		void bind_buffer(GLenum target, GLuint id);
+		void bind_buffer_base(GLenum target, GLuint index, GLuint id);
+		void bind_framebuffer(GLenum target, GLuint id);
+		void enable(GLenum cap) { set_capability(cap, true); }
+		void disable(GLenum cap) { set_capability(cap, false); }
+		void blend_func(GLenum src, GLenum dst);
+
+		// Deleting an object resets bindings to it, so objects have to be deleted
+		// through the cache as well.
+		void delete_texture(GLuint id);
+		void delete_vertex_array(GLuint id);
+		void delete_buffers(GLsizei count, const GLuint* ids);
+		void delete_framebuffer(GLuint id);
+	};
+
+	extern GLState glstate;
+}
\ No newline at end of file
@@ -0,0 +1,324 @@
+#pragma once
+
+#include <cstdint>
+#include <robin_hood.h>
+#include "broadphase2.h"
+
+namespace dukat
+{
+	// Broadphase which hashes values into a uniform grid of cells. Only values which moved
+	// to a different set of cells since the last update are rehashed. Values that would
+	// cover more than max_cells cells are kept in a separate list and tested against all others.
+	template<class T>
+	class GridBroadphase2 : public Broadphase2<T>
+	{
+	public:
+		typedef typename Broadphase2<T>::Pair Pair;
+
+	private:
+		// Limit for cell coordinates to avoid overflows for very distant values
+		static constexpr int max_coord = 1 << 30;
+
+		struct Proxy
+		{
+			T* value;
+			AABB2 bb; // bounding box as of last update
+			int x0, y0, x1, y1; // range of cells covered
+			bool in_grid;
+			bool oversized;
+		};
+
+		const float cell_size;
+		const int max_cells;
+		std::vector<Proxy> proxies;
+		std::vector<int> free_proxies;
+		robin_hood::unordered_map<T*, int> index;
+		robin_hood::unordered_map<uint64_t, std::vector<int>> cells;
+		std::vector<int> oversized;
+
+		static uint64_t cell_key(int x, int y) { return (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) | static_cast<uint32_t>(y); }
+		static int cell_x(uint64_t key) { return static_cast<int32_t>(key >> 32); }
+		static int cell_y(uint64_t key) { return static_cast<int32_t>(key & 0xffffffff); }
+		int to_cell(float v) const;
+		// Returns number of cells in a range.
+		static int64_t cell_count(int x0, int y0, int x1, int y1) { return static_cast<int64_t>(x1 - x0 + 1) * static_cast<int64_t>(y1 - y0 + 1); }
+		// Adds / removes proxy to / from cells in its range.
+		void link(int idx);
+		void unlink(int idx);
+
+	public:
+		GridBroadphase2(float cell_size, int max_cells = 64) : cell_size(cell_size), max_cells(max_cells) { }
+		~GridBroadphase2(void) { }
+
+		float get_cell_size(void) const { return cell_size; }
+
+		void insert(T* value);
+		void remove(T* value);
+		void clear(void);
+		void update(void);
+
+		void collect_pairs(std::vector<Pair>& pairs) const;
+		void query(const AABB2& bb, std::vector<T*>& res) const;
+		void query(const Ray2& ray, float min_t, float max_t, std::vector<T*>& res) const;
+		void collect_regions(const AABB2& bb, std::vector<AABB2>& res) const;
+	};
+
+	template<class T>
+	constexpr int GridBroadphase2<T>::max_coord;
+
+	template<class T>
+	int GridBroadphase2<T>::to_cell(float v) const
+	{
+		const auto c = std::floor(v / cell_size);
+		if (!(c > static_cast<float>(-max_coord)))
+			return -max_coord;
+		if (c > static_cast<float>(max_coord))
+			return max_coord;
+		return static_cast<int>(c);
+	}
+
+	template<class T>
+	void GridBroadphase2<T>::link(int idx)
+	{
+		auto& p = proxies[idx];
+		p.x0 = to_cell(p.bb.min().x);
+		p.y0 = to_cell(p.bb.min().y);
+		p.x1 = to_cell(p.bb.max().x);
+		p.y1 = to_cell(p.bb.max().y);
+		p.in_grid = true;
+		// Proxies with an empty box do not cover any cells
+		p.oversized = p.x0 <= p.x1 && p.y0 <= p.y1 && cell_count(p.x0, p.y0, p.x1, p.y1) > max_cells;
+		if (p.oversized)
+		{
+			oversized.push_back(idx);
+			return;
+		}
+		for (auto y = p.y0; y <= p.y1; y++)
+		{
+			for (auto x = p.x0; x <= p.x1; x++)
+				cells[cell_key(x, y)].push_back(idx);
+		}
+	}
+
+	template<class T>
+	void GridBroadphase2<T>::unlink(int idx)
+	{
+		auto& p = proxies[idx];
+		if (!p.in_grid)
+			return;
+		p.in_grid = false;
+		if (p.oversized)
+		{
+			oversized.erase(std::find(oversized.begin(), oversized.end(), idx));
+			return;
+		}
+		for (auto y = p.y0; y <= p.y1; y++)
+		{
+			for (auto x = p.x0; x <= p.x1; x++)
+			{
+				auto it = cells.find(cell_key(x, y));
+				auto& cell = it->second;
+				*std::find(cell.begin(), cell.end(), idx) = cell.back();
+				cell.pop_back();
+				if (cell.empty())
+					cells.erase(it);
+			}
+		}
+	}
+
+	template<class T>
+	void GridBroadphase2<T>::insert(T* value)
+	{
+		int idx;
+		if (free_proxies.empty())
+		{
+			idx = static_cast<int>(proxies.size());
+			proxies.emplace_back();
+		}
+		else
+		{
+			idx = free_proxies.back();
+			free_proxies.pop_back();
+		}
+		auto& p = proxies[idx];
+		p.value = value;
+		p.in_grid = false;
+		p.oversized = false;
+		index[value] = idx;
+	}
+
+	template<class T>
+	void GridBroadphase2<T>::remove(T* value)
+	{
+		auto it = index.find(value);
+		if (it == index.end())
+			return;
+		const auto idx = it->second;
+		index.erase(it);
+		unlink(idx);
+		proxies[idx].value = nullptr;
+		free_proxies.push_back(idx);
+	}
+
+	template<class T>
+	void GridBroadphase2<T>::clear(void)
+	{
+		proxies.clear();
+		free_proxies.clear();
+		index.clear();
+		cells.clear();
+		oversized.clear();
+	}
+
+	template<class T>
+	void GridBroadphase2<T>::update(void)
+	{
+		const auto count = static_cast<int>(proxies.size());
+		for (auto i = 0; i < count; i++)
+		{
+			auto& p = proxies[i];
+			if (p.value == nullptr)
+				continue;
+
+			if (!p.value->active)
+			{
+				unlink(i);
+				continue;
+			}
+			if (p.in_grid && bb_equal(p.bb, p.value->bb))
+				continue; // has not moved
+
+			const auto& bb = p.value->bb;
+			if (p.in_grid && !p.oversized && to_cell(bb.min().x) == p.x0 && to_cell(bb.min().y) == p.y0
+				&& to_cell(bb.max().x) == p.x1 && to_cell(bb.max().y) == p.y1)
+			{
+				p.bb = bb; // still covers the same cells
+				continue;
+			}
+
+			unlink(i);
+			p.bb = bb;
+			link(i);
+		}
+	}
+
+	template<class T>
+	void GridBroadphase2<T>::collect_pairs(std::vector<Pair>& pairs) const
+	{
+		for (const auto& it : cells)
+		{
+			const auto& cell = it.second;
+			const auto n = cell.size();
+			if (n < 2)
+				continue;
+
+			const auto cx = cell_x(it.first);
+			const auto cy = cell_y(it.first);
+			for (auto i = 0u; i < n; i++)
+			{
+				const auto& a = proxies[cell[i]];
+				for (auto j = i + 1; j < n; j++)
+				{
+					const auto& b = proxies[cell[j]];
+					// Only report pair in the first cell shared by both proxies
+					if (std::max(a.x0, b.x0) != cx || std::max(a.y0, b.y0) != cy)
+						continue;
+					if (bb_touches(a.bb, b.bb))
+						pairs.emplace_back(a.value, b.value);
+				}
+			}
+		}
+
+		// Test oversized proxies against all others
+		for (auto i = 0u; i < oversized.size(); i++)
+		{
+			const auto& a = proxies[oversized[i]];
+			for (const auto& b : proxies)
+			{
+				if (!b.in_grid || (b.oversized && &b <= &a))
+					continue;
+				if (bb_touches(a.bb, b.bb))
+					pairs.emplace_back(a.value, b.value);
+			}
+		}
+	}
+
+	template<class T>
+	void GridBroadphase2<T>::query(const AABB2& bb, std::vector<T*>& res) const
+	{
+		const auto x0 = to_cell(bb.min().x);
+		const auto y0 = to_cell(bb.min().y);
+		const auto x1 = to_cell(bb.max().x);
+		const auto y1 = to_cell(bb.max().y);
+
+		// Only report proxy in the first cell it shares with the query
+		auto visit = [&](int cx, int cy, const std::vector<int>& cell) {
+			for (auto idx : cell)
+			{
+				const auto& p = proxies[idx];
+				if (std::max(p.x0, x0) == cx && std::max(p.y0, y0) == cy && bb_touches(p.bb, bb))
+					res.push_back(p.value);
+			}
+		};
+
+		if (cell_count(x0, y0, x1, y1) > static_cast<int64_t>(cells.size()))
+		{
+			// Cheaper to visit occupied cells than to look up every cell in range
+			for (const auto& it : cells)
+			{
+				const auto cx = cell_x(it.first);
+				const auto cy = cell_y(it.first);
+				if (cx >= x0 && cx <= x1 && cy >= y0 && cy <= y1)
+					visit(cx, cy, it.second);
+			}
+		}
+		else
+		{
+			for (auto y = y0; y <= y1; y++)
+			{
+				for (auto x = x0; x <= x1; x++)
+				{
+					auto it = cells.find(cell_key(x, y));
+					if (it != cells.end())
+						visit(x, y, it->second);
+				}
+			}
+		}
+
+		for (auto idx : oversized)
+		{
+			if (bb_touches(proxies[idx].bb, bb))
+				res.push_back(proxies[idx].value);
+		}
+	}
+
+	template<class T>
+	void GridBroadphase2<T>::query(const Ray2& ray, float min_t, float max_t, std::vector<T*>& res) const
+	{
+		AABB2 bb;
+		if (ray_bounds(ray, min_t, max_t, bb))
+		{
+			query(bb, res);
+			return;
+		}
+
+		// Unbounded ray, report all proxies
+		for (const auto& p : proxies)
+		{
+			if (p.in_grid)
+				res.push_back(p.value);
+		}
+	}
+
+	template<class T>
+	void GridBroadphase2<T>::collect_regions(const AABB2& bb, std::vector<AABB2>& res) const
+	{
+		for (const auto& it : cells)
+		{
+			const Vector2 min_v{ static_cast<float>(cell_x(it.first)) * cell_size, static_cast<float>(cell_y(it.first)) * cell_size };
+			const AABB2 cell_bb{ min_v, min_v + Vector2{ cell_size, cell_size } };
+			if (bb.overlaps(cell_bb))
+				res.push_back(cell_bb);
+		}
+	}
+}
\ No newline at end of file
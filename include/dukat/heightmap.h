@@ -1,5 +1,8 @@
 #pragma once
 
+#include <atomic>
+#include <memory>
+#include <mutex>
 #include <vector>
 
 namespace dukat
@@ -7,11 +10,20 @@ namespace dukat
     struct Rect;
     class Surface;
 	class HeightMapGenerator;
+	class HeightMapTiles;
+	class JobScheduler;
     struct Ray3;
 
     class HeightMap
     {
     public:
+        // Storage format of tiles
+        enum class TileFormat : uint32_t
+        {
+            Float32, // normalized elevation
+            UInt16 // elevation quantized to 16 bits
+        };
+
         struct Level
         {
             int index; // level index
@@ -31,20 +43,35 @@ namespace dukat
         const int num_levels; // number of terrain levels contained in this map
         int level_size; // width / height of each level
 		float scale_factor; // Scale factor used to compute grid height from normalized elevation data. 
-        std::vector<Level> levels; // height level data
+        // Height level data. Coarse levels may be generated on first access.
+        mutable std::vector<Level> levels;
+        mutable std::atomic<int> generated_levels; // number of levels which contain data
+        mutable std::mutex level_mutex; // guards publication of generated levels
+        bool lazy_levels; // if true, coarse levels are generated on first access
+        JobScheduler* scheduler; // optional scheduler to process rows in parallel
+        std::unique_ptr<HeightMapTiles> tiles; // if set, data is read from tiles instead of levels
+        std::size_t tile_cache_size; // number of resident tiles, or 0 for the default
 
-        // Generates levels 1..n based on level 0
+        // Prepares levels 1..n and generates them unless lazy_levels is set
         void generate_levels(void);
+        // Generates data of a level by downsampling the previous one.
+        void generate_level(int level, std::vector<GLfloat>& data) const;
+        // Makes sure that all levels up to and including level contain data.
+        void ensure_level(int level) const;
 
     public:
-        HeightMap(int num_levels, float scale_factor = 1.0f) 
-            : num_levels(num_levels), level_size(0), scale_factor(scale_factor) { }
-        ~HeightMap(void) { }
+        HeightMap(int num_levels, float scale_factor = 1.0f);
+        ~HeightMap(void);
 
 		// Loads height data from a 16-bit grayscale PNG file.
 		void load(const std::string& filename);
 		// Saves height data as 16-bit grayscale PNG file.
 		void save(const std::string& filename) const;
+		// Opens height data in the tiled layout. Tiles are paged in on demand, and levels
+		// cannot be accessed directly.
+		void load_tiled(const std::string& filename);
+		// Saves height data in the tiled layout.
+		void save_tiled(const std::string& filename, int tile_size = 256, TileFormat format = TileFormat::Float32) const;
         // Allocates a blank heightmap of a given size.
         void allocate(int level_size);
 		// Generates random fractal terrain.
@@ -52,10 +79,11 @@ namespace dukat
 
         // Copies data at a given level within a rect into a provided buffer. If the
         // buffer is not large enough to contain the requested rect, partial data
-        // will be returned.
+        // will be returned. Areas outside of the level are set to 0.
         void get_data(int level, const Rect& rect, std::vector<GLfloat>& buffer) const;
         // Returns reference to a level for direct access.
-        Level& get_level(int level) { return levels[level]; }
+        Level& get_level(int level);
+        const Level& get_level(int level) const;
 
 		// Returns the normalized elevation at a given set of coordinates and level.
 		float get_elevation(int x, int y, int level) const;
@@ -66,11 +94,28 @@ namespace dukat
 		// bilinear sampling if necessary.
 		float sample(int level, float x, float y) const;
 
+		// Makes tiles overlapping a rect of a level resident. Has no effect unless 
+		// the height map is tiled.
+		void prefetch(int level, const Rect& rect) const;
+
 		// Tests for intersection with a ray. Will return the distance of intersection or no_intersection.
 		float intersect_ray(const Ray3& ray, float min_t = 0.0f, float max_t = 1000.0f) const;
 
         // Getters and setters
         float get_scale_factor(void) const { return scale_factor; }
         void set_scale_factor(float factor) { this->scale_factor = factor; }
+        // If set, coarse levels are only generated once they are accessed. Applies to 
+        // levels created by subsequent calls to load, allocate or generate.
+        void set_lazy_levels(bool lazy_levels) { this->lazy_levels = lazy_levels; }
+        bool is_lazy_levels(void) const { return lazy_levels; }
+        // Sets scheduler used to normalize and downsample rows in parallel.
+        void set_scheduler(JobScheduler* scheduler) { this->scheduler = scheduler; }
+        bool is_tiled(void) const { return tiles != nullptr; }
+        // Sets the number of tiles which are kept resident.
+        void set_tile_cache_size(std::size_t size);
+        // Returns the number of tiles which are kept resident.
+        std::size_t get_tile_cache_size(void) const;
+        // Returns the size of tiles, or 0 if the height map is not tiled.
+        int get_tile_size(void) const;
 	};
 }
\ No newline at end of file
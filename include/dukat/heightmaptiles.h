@@ -0,0 +1,98 @@
+#pragma once
+
+#include <list>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <robin_hood.h>
+#include "heightmap.h"
+#include "mappedfile.h"
+
+namespace dukat
+{
+	struct Rect;
+
+	// Height map levels split into square tiles, used in place from a mapped file. Tiles 
+	// are decoded into an LRU cache on first access, so that only the area around the 
+	// observer has to be resident.
+	class HeightMapTiles
+	{
+	public:
+		static constexpr uint32_t file_id = 0x544d4844; // DHMT
+		static constexpr uint32_t file_version = 1;
+		// Alignment of level data in the file
+		static constexpr uint32_t page_alignment = 4096;
+		// Default number of resident tiles
+		static constexpr std::size_t default_capacity = 256;
+		// Max number of levels; level sizes are derived by shifting the size of level 0
+		static constexpr uint32_t max_levels = 31;
+
+		struct Header
+		{
+			uint32_t id;
+			uint32_t version;
+			uint32_t level_size; // width / height of level 0
+			uint32_t num_levels;
+			uint32_t tile_size; // width / height of each tile
+			uint32_t format; // HeightMap::TileFormat
+			uint32_t reserved[2];
+		};
+
+		// Follows the header once for each level
+		struct LevelEntry
+		{
+			uint32_t size; // width / height of this level
+			uint32_t tiles; // number of tiles per row and column
+			uint64_t offset; // offset of first tile; tiles are stored row by row
+		};
+
+	private:
+		struct Tile
+		{
+			uint64_t key;
+			std::vector<GLfloat> data;
+		};
+
+		MappedFile file;
+		const Header* header;
+		const LevelEntry* entries;
+		std::size_t tile_bytes; // size of a tile in the file
+
+		std::size_t capacity; // max number of resident tiles
+		std::list<Tile> tiles; // resident tiles, most recently used first
+		robin_hood::unordered_map<uint64_t, std::list<Tile>::iterator> index;
+		mutable std::mutex mtx;
+
+		static uint64_t tile_key(int level, int tx, int ty);
+		// Returns data of a tile, decoding it if necessary. Caller has to hold mtx.
+		const GLfloat* fetch(int level, int tx, int ty);
+
+	public:
+		// Maps a file and validates its layout. Throws if the file is not a valid tiled height map.
+		HeightMapTiles(const std::string& filename, std::size_t capacity = default_capacity);
+		~HeightMapTiles(void) { }
+
+		// Writes levels of a height map in the tiled layout.
+		static void write(const std::string& filename, const HeightMap& map, int num_levels,
+			int tile_size, HeightMap::TileFormat format);
+		// Converts a 16-bit grayscale PNG file to the tiled layout.
+		static void convert(const std::string& png_file, const std::string& filename, int num_levels,
+			int tile_size = 256, HeightMap::TileFormat format = HeightMap::TileFormat::UInt16);
+
+		int get_level_size(void) const { return static_cast<int>(header->level_size); }
+		int get_num_levels(void) const { return static_cast<int>(header->num_levels); }
+		int get_tile_size(void) const { return static_cast<int>(header->tile_size); }
+
+		// Returns the elevation at a coordinate and level, or 0 if outside of the map.
+		float get_elevation(int level, int x, int y);
+		// Copies data at a given level within a rect into a buffer. If the buffer is smaller
+		// than the rect, partial data is returned. Areas outside of the map are set to 0.
+		void get_data(int level, const Rect& rect, std::vector<GLfloat>& buffer);
+		// Makes tiles overlapping a rect resident, and marks them as most recently used.
+		void prefetch(int level, const Rect& rect);
+
+		void set_capacity(std::size_t capacity);
+		std::size_t get_capacity(void) const { return capacity; }
+		std::size_t resident_count(void) const;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,152 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace dukat
+{
+	class JobScheduler;
+
+	// Tracks completion of a group of jobs.
+	class JobCounter
+	{
+	private:
+		std::atomic<int> pending;
+		std::mutex mutex;
+		// First exception thrown by any of the jobs
+		std::exception_ptr error;
+
+		friend class JobScheduler;
+
+	public:
+		JobCounter(void) : pending(0) { }
+		~JobCounter(void) { }
+
+		bool is_done(void) const { return pending.load(std::memory_order_acquire) == 0; }
+	};
+
+	// Set of tasks with dependencies between them. A task is started as soon as
+	// all tasks it depends on have completed.
+	class TaskGraph
+	{
+	public:
+		typedef int TaskId;
+
+	private:
+		struct Task
+		{
+			std::function<void(void)> fn;
+			std::vector<TaskId> successors;
+			int dependencies;
+			std::atomic<int> remaining;
+			// Actions deferred by this task
+			std::vector<std::function<void(void)>> deferred;
+
+			Task(const std::function<void(void)>& fn) : fn(fn), dependencies(0), remaining(0) { }
+		};
+
+		std::deque<Task> tasks;
+		JobCounter counter;
+
+		friend class JobScheduler;
+
+	public:
+		TaskGraph(void) { }
+		~TaskGraph(void) { }
+
+		// Adds a task and returns its id.
+		TaskId add(const std::function<void(void)>& fn);
+		// Ensures that task does not start before prerequisite has completed.
+		void depend(TaskId task, TaskId prerequisite);
+		std::size_t size(void) const { return tasks.size(); }
+		bool empty(void) const { return tasks.empty(); }
+		// Removes all tasks. Must not be called while the graph is running.
+		void clear(void) { tasks.clear(); }
+	};
+
+	// Work-stealing job scheduler. Each worker owns a queue which it processes in LIFO order,
+	// and steals from the other queues in FIFO order once its own queue runs dry. Threads
+	// which wait for jobs to complete help out with pending jobs in the meantime.
+	//
+	// Jobs started through parallel_for or a task graph can defer actions with side effects,
+	// such as Messenger::trigger. Deferred actions are replayed on the waiting thread once
+	// all jobs have completed, ordered by chunk or task id rather than by completion time,
+	// so that the outcome does not depend on scheduling.
+	class JobScheduler
+	{
+	private:
+		typedef std::vector<std::function<void(void)>> DeferredQueue;
+
+		struct Job
+		{
+			std::function<void(void)> fn;
+			JobCounter* counter;
+			DeferredQueue* deferred;
+		};
+
+		struct JobQueue
+		{
+			std::mutex mutex;
+			std::deque<Job> jobs;
+		};
+
+		// Queue 0 is shared by all threads that are not workers of this scheduler
+		std::vector<std::unique_ptr<JobQueue>> queues;
+		std::vector<std::thread> threads;
+		std::mutex wake_mutex;
+		std::condition_variable wake;
+		std::atomic<int> queued;
+		std::atomic<bool> done;
+
+		void worker_loop(int index);
+		int queue_index(void) const;
+		void push(Job&& job);
+		bool pop(int index, Job& job);
+		void execute(Job& job);
+		// Runs a task of a graph and queues successors which no longer have to wait.
+		void run_task(TaskGraph& graph, TaskGraph::TaskId id);
+		void release_successors(TaskGraph& graph, TaskGraph::TaskId id);
+		// Runs deferred actions in order.
+		static void flush(DeferredQueue& queue);
+
+	public:
+		// Creates scheduler with a number of worker threads. If negative, will
+		// create one worker per CPU core besides the calling thread.
+		JobScheduler(int worker_count = -1);
+		~JobScheduler(void);
+
+		// Returns number of threads which execute jobs, including the calling thread.
+		int get_concurrency(void) const { return static_cast<int>(threads.size()) + 1; }
+
+		// Queues a job and associates it with a counter.
+		void submit(const std::function<void(void)>& fn, JobCounter& counter);
+		// Blocks until all jobs associated with counter have completed, executing queued
+		// jobs in the meantime. Rethrows the first exception thrown by any of the jobs.
+		void wait(JobCounter& counter);
+
+		// Calls fn(chunk_begin, chunk_end) for consecutive chunks of at least grain elements
+		// in [begin, end) and blocks until all of them have completed.
+		void parallel_for(std::size_t begin, std::size_t end, std::size_t grain,
+			const std::function<void(std::size_t, std::size_t)>& fn);
+
+		// Starts executing a task graph.
+		void start(TaskGraph& graph);
+		// Blocks until all tasks of a graph have completed, then replays their deferred actions.
+		void finish(TaskGraph& graph);
+		// Executes a task graph and blocks until it has completed.
+		void run(TaskGraph& graph) { start(graph); finish(graph); }
+
+		// Returns true if the calling thread executes a job whose side effects are deferred.
+		static bool is_deferring(void);
+		// Defers an action until the current job has been awaited. Runs action immediately
+		// if called outside of a job.
+		static void defer(const std::function<void(void)>& action);
+	};
+}
\ No newline at end of file
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+
+namespace dukat
+{
+	class RenderLayer2;
+
+	// Membership of a renderable in a render layer. Stored with the renderable itself,
+	// so that a layer can look up and remove it in constant time. Copies of a renderable
+	// do not inherit its membership.
+	struct LayerSlot
+	{
+		// Index of renderables which are not stored in the layer's list
+		static constexpr uint32_t no_index = 0xffffffff;
+
+		RenderLayer2* layer;	// Layer the renderable was added to
+		uint32_t index;			// Position in the layer's list
+		uint32_t order;			// Sequence number assigned when added, used to keep draw order stable
+
+		LayerSlot(void) : layer(nullptr), index(no_index), order(0) { }
+		LayerSlot(const LayerSlot&) : LayerSlot() { }
+		LayerSlot& operator=(const LayerSlot&) { return *this; }
+
+		bool is_in(const RenderLayer2* l) const { return layer == l; }
+		void reset(void) { layer = nullptr; index = no_index; order = 0; }
+	};
+}
\ No newline at end of file
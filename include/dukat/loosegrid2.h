@@ -0,0 +1,188 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <robin_hood.h>
+#include "aabb2.h"
+
+namespace dukat
+{
+	// Loose grid of values with a bounding box. Each value is stored in the cell
+	// containing the center of its box, so that moving a value only touches two cells.
+	// Queries extend their range by the largest half extent of any stored value.
+	template<class T>
+	class LooseGrid2
+	{
+	private:
+		// Limit for cell coordinates to avoid overflows for very distant values
+		static constexpr int max_coord = 1 << 30;
+
+		struct Entry
+		{
+			T* value;
+			AABB2 bb;
+		};
+
+		struct Location
+		{
+			uint64_t cell;
+			std::size_t index;
+		};
+
+		const float cell_size;
+		robin_hood::unordered_map<uint64_t, std::vector<Entry>> cells;
+		robin_hood::unordered_map<T*, Location> locations;
+		// Largest half extent of any value inserted since last clear
+		Vector2 max_half_extent;
+
+		static uint64_t cell_key(int x, int y) { return (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) | static_cast<uint32_t>(y); }
+		static int cell_x(uint64_t key) { return static_cast<int32_t>(key >> 32); }
+		static int cell_y(uint64_t key) { return static_cast<int32_t>(key & 0xffffffff); }
+		int to_cell(float v) const;
+		void unlink(const Location& loc);
+
+	public:
+		LooseGrid2(float cell_size) : cell_size(cell_size), max_half_extent(0.0f, 0.0f) { }
+		~LooseGrid2(void) { }
+
+		float get_cell_size(void) const { return cell_size; }
+		std::size_t size(void) const { return locations.size(); }
+		bool empty(void) const { return locations.empty(); }
+		bool contains(T* value) const { return locations.count(value) > 0; }
+
+		// Adds a value or updates the bounding box of an existing value.
+		void insert(T* value, const AABB2& bb);
+		void remove(T* value);
+		void clear(void);
+		// Appends all values whose box overlaps with bb to res.
+		void query(const AABB2& bb, std::vector<T*>& res) const;
+		// Appends all values to res.
+		void collect(std::vector<T*>& res) const;
+	};
+
+	template<class T>
+	constexpr int LooseGrid2<T>::max_coord;
+
+	template<class T>
+	int LooseGrid2<T>::to_cell(float v) const
+	{
+		const auto c = std::floor(v / cell_size);
+		if (!(c > static_cast<float>(-max_coord)))
+			return -max_coord;
+		if (c > static_cast<float>(max_coord))
+			return max_coord;
+		return static_cast<int>(c);
+	}
+
+	template<class T>
+	void LooseGrid2<T>::unlink(const Location& loc)
+	{
+		auto it = cells.find(loc.cell);
+		auto& cell = it->second;
+		if (loc.index + 1 < cell.size())
+		{
+			cell[loc.index] = cell.back();
+			locations[cell[loc.index].value].index = loc.index;
+		}
+		cell.pop_back();
+		if (cell.empty())
+			cells.erase(it);
+	}
+
+	template<class T>
+	void LooseGrid2<T>::insert(T* value, const AABB2& bb)
+	{
+		const auto& center = bb.center();
+		const auto key = cell_key(to_cell(center.x), to_cell(center.y));
+		max_half_extent.x = std::max(max_half_extent.x, 0.5f * bb.width());
+		max_half_extent.y = std::max(max_half_extent.y, 0.5f * bb.height());
+
+		auto it = locations.find(value);
+		if (it != locations.end())
+		{
+			if (it->second.cell == key)
+			{
+				cells[key][it->second.index].bb = bb;
+				return; // still in the same cell
+			}
+			const auto loc = it->second;
+			unlink(loc);
+		}
+
+		auto& cell = cells[key];
+		locations[value] = Location{ key, cell.size() };
+		cell.push_back(Entry{ value, bb });
+	}
+
+	template<class T>
+	void LooseGrid2<T>::remove(T* value)
+	{
+		auto it = locations.find(value);
+		if (it == locations.end())
+			return;
+		const auto loc = it->second;
+		locations.erase(it);
+		unlink(loc);
+	}
+
+	template<class T>
+	void LooseGrid2<T>::clear(void)
+	{
+		cells.clear();
+		locations.clear();
+		max_half_extent = Vector2{ 0.0f, 0.0f };
+	}
+
+	template<class T>
+	void LooseGrid2<T>::query(const AABB2& bb, std::vector<T*>& res) const
+	{
+		// Values in neighboring cells may reach into the query
+		const auto x0 = to_cell(bb.min().x - max_half_extent.x);
+		const auto y0 = to_cell(bb.min().y - max_half_extent.y);
+		const auto x1 = to_cell(bb.max().x + max_half_extent.x);
+		const auto y1 = to_cell(bb.max().y + max_half_extent.y);
+
+		auto visit = [&](const std::vector<Entry>& cell) {
+			for (const auto& e : cell)
+			{
+				if (bb.overlaps(e.bb))
+					res.push_back(e.value);
+			}
+		};
+
+		const auto cell_count = static_cast<int64_t>(x1 - x0 + 1) * static_cast<int64_t>(y1 - y0 + 1);
+		if (cell_count > static_cast<int64_t>(cells.size()))
+		{
+			// Cheaper to visit occupied cells than to look up every cell in range
+			for (const auto& it : cells)
+			{
+				const auto cx = cell_x(it.first);
+				const auto cy = cell_y(it.first);
+				if (cx >= x0 && cx <= x1 && cy >= y0 && cy <= y1)
+					visit(it.second);
+			}
+		}
+		else
+		{
+			for (auto y = y0; y <= y1; y++)
+			{
+				for (auto x = x0; x <= x1; x++)
+				{
+					auto it = cells.find(cell_key(x, y));
+					if (it != cells.end())
+						visit(it->second);
+				}
+			}
+		}
+	}
+
+	template<class T>
+	void LooseGrid2<T>::collect(std::vector<T*>& res) const
+	{
+		for (const auto& it : cells)
+		{
+			for (const auto& e : it.second)
+				res.push_back(e.value);
+		}
+	}
+}
\ No newline at end of file
@@ -10,9 +10,10 @@ namespace dukat
 	protected:
 		GameBase* game;
 		bool enabled;
+		bool concurrent;
 
 	public:
-		Manager(GameBase* game) : game(game), enabled(true) { }
+		Manager(GameBase* game) : game(game), enabled(true), concurrent(false) { }
 		virtual ~Manager(void) { }
 
 		// Called once per frame to update internal state.
@@ -20,5 +21,12 @@ namespace dukat
 
 		virtual void set_enabled(bool enabled) { this->enabled = enabled; }
 		bool is_enabled(void) const { return enabled; }
+		// If set, the manager is updated on a worker thread alongside the other managers.
+		// Only set this if no other manager or callback touches the manager's state during
+		// the update, and the update does not touch shared state either, such as render 
+		// layers, performance counters or the global random number generator. Messages 
+		// triggered during the update are delivered once all managers have been updated.
+		void set_concurrent(bool concurrent) { this->concurrent = concurrent; }
+		bool is_concurrent(void) const { return concurrent; }
 	};
 }
\ No newline at end of file
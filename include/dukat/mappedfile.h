@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace dukat
+{
+	// Read-only memory mapping of a file. The contents are paged in on first access,
+	// so that data can be used in place without being copied into buffers first.
+	class MappedFile
+	{
+	private:
+		const uint8_t* ptr;
+		std::size_t length;
+#ifdef _WIN32
+		void* file_handle;
+		void* map_handle;
+#else
+		int fd;
+#endif
+
+	public:
+		MappedFile(void);
+		// Maps a file. Throws if the file cannot be opened or mapped.
+		MappedFile(const std::string& filename);
+		~MappedFile(void);
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		void open(const std::string& filename);
+		void close(void);
+		bool is_open(void) const { return ptr != nullptr; }
+
+		const uint8_t* data(void) const { return ptr; }
+		std::size_t size(void) const { return length; }
+		// Touches every page of a range so that later reads do not fault. Meant to be
+		// called on a worker thread.
+		void prefetch(std::size_t offset, std::size_t count) const;
+	};
+}
\ No newline at end of file
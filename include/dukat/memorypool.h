@@ -1,10 +1,74 @@
 #pragma once
 
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+#include <vector>
+
 namespace dukat
 {
+	// Usage statistics of a memory pool.
+	struct MemoryPoolStats
+	{
+		std::size_t capacity;		// No# of objects the pool can hold without growing
+		std::size_t live;			// No# of objects currently allocated
+		std::size_t high_water;		// Highest no# of objects allocated at once
+		std::size_t allocations;	// Total no# of allocations
+	};
+
+	// Registry of all memory pools, used to report their statistics.
+	class MemoryPoolBase
+	{
+	private:
+		const char* name;
+		// Serial number which identifies this pool in the registry
+		const uint32_t serial;
+		// Allocations at time of last report
+		std::size_t reported_allocations;
+
+		static std::mutex& registry_mutex(void);
+		static std::vector<MemoryPoolBase*>& registry(void);
+
+	protected:
+		MemoryPoolBase(const char* name);
+
+		// Returns true if a pool is still alive.
+		static bool is_registered(const MemoryPoolBase* pool, uint32_t serial);
+		uint32_t get_serial(void) const { return serial; }
+
+	public:
+		virtual ~MemoryPoolBase(void);
+
+		const char* get_name(void) const { return name; }
+		virtual MemoryPoolStats get_stats(void) const = 0;
+
+		// Publishes statistics of all named pools to the global performance counter. Pool i uses
+		// counters POOLS + 3 * i (live objects), + 1 (high-water mark) and + 2 (allocations per frame).
+		// Should be called once per frame from the main thread.
+		static void report_stats(void);
+		// Writes statistics of all named pools to the log.
+		static void log_stats(void);
+	};
+
+	// Pool of objects of type T which allocates memory in slabs. By default, the pool grows
+	// by another slab when it runs out of memory; it can be restricted to a single slab instead.
+	//
+	// A pool is not thread-safe unless created with the ThreadCache flag. In that case, each
+	// thread allocates from a small cache of its own, which is refilled from / returned to the
+	// shared free list in batches.
 	template<typename T>
-	class MemoryPool
+	class MemoryPool : public MemoryPoolBase
 	{
+	public:
+		enum Flags
+		{
+			Growable = 1,	// allocate additional slabs when exhausted
+			ThreadCache = 2	// keep per-thread caches so that multiple threads can allocate
+		};
+
 	private:
 		// Chunk holding metadata for unallocated objects.
 		struct Chunk
@@ -12,38 +76,172 @@ namespace dukat
 			Chunk* next;
 		};
 
+		// Chunks owned by a single thread.
+		struct Cache
+		{
+			const MemoryPool* pool;
+			uint32_t serial;
+			Chunk* free_list;
+			std::size_t count;
+
+			Cache(const MemoryPool* pool, uint32_t serial) : pool(pool), serial(serial), free_list(nullptr), count(0) { }
+		};
+
+		// Per-thread caches, returned to their pools when the thread exits.
+		struct ThreadCaches
+		{
+			std::vector<Cache> caches;
+
+			~ThreadCaches(void)
+			{
+				for (auto& c : caches)
+				{
+					if (c.count > 0 && is_registered(c.pool, c.serial))
+						const_cast<MemoryPool*>(c.pool)->release_batch(c, c.count);
+				}
+			}
+		};
+
+		// Number of chunks a thread cache holds at most
+		static constexpr std::size_t cache_size = 64;
+
+		// Number of objects per slab
 		const std::size_t capacity;
-		Chunk* base;
+		const int flags;
+		std::vector<void*> slabs;
+		std::atomic<std::size_t> slab_count;
 		Chunk* free_list;
+		// Guards slabs and shared free list if thread caches are used
+		std::mutex mutex;
 
-	public:
-		/// <summary>
-		/// Creates a new memory pool with a fixed capacity.
-		/// </summary>
-		/// <param name="capacity">The max number of objects the pool can hold</param>
-		MemoryPool(std::size_t capacity) : capacity(capacity)
+		std::atomic<std::size_t> live;
+		std::atomic<std::size_t> high_water;
+		std::atomic<std::size_t> allocations;
+
+		bool is_thread_cached(void) const { return (flags & ThreadCache) == ThreadCache; }
+
+		// Allocates a slab of memory and adds its chunks to the free list.
+		void add_slab(void)
 		{
-			// allocate memory
-			base = reinterpret_cast<Chunk*>(malloc(capacity * sizeof(T)));
-			free_list = base;
+			static_assert(sizeof(T) >= sizeof(Chunk), "Pooled type is too small.");
+			auto base = reinterpret_cast<Chunk*>(malloc(capacity * sizeof(T)));
+			if (base == nullptr)
+				throw std::bad_alloc();
+			slabs.push_back(base);
+			slab_count.store(slabs.size(), std::memory_order_relaxed);
 
 			// chain up free chunks
-			auto ptr = free_list;
+			auto ptr = base;
 			for (auto i = 0u; i < capacity - 1; i++)
 			{
 				ptr->next = reinterpret_cast<Chunk*>(reinterpret_cast<char*>(ptr) + sizeof(T));
 				ptr = ptr->next;
 			}
-			ptr->next = nullptr;
+			ptr->next = free_list;
+			free_list = base;
+		}
+
+		// Pops chunk from shared free list.
+		Chunk* pop_chunk(void)
+		{
+			if (free_list == nullptr)
+			{
+				assert((flags & Growable) == Growable);
+				if ((flags & Growable) != Growable)
+					throw std::bad_alloc();
+				add_slab();
+			}
+			auto res = free_list;
+			free_list = free_list->next;
+			return res;
 		}
-		
-		~MemoryPool(void) 
+
+		// Returns cache of the calling thread.
+		Cache& thread_cache(void)
 		{
-			::free(base);
-			base = nullptr;
+			static thread_local ThreadCaches thread_caches;
+			for (auto& c : thread_caches.caches)
+			{
+				if (c.pool == this && c.serial == get_serial())
+					return c;
+			}
+			thread_caches.caches.emplace_back(this, get_serial());
+			return thread_caches.caches.back();
+		}
+
+		// Moves a number of chunks from cache to shared free list.
+		void release_batch(Cache& cache, std::size_t count)
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			for (auto i = 0u; i < count; i++)
+			{
+				auto chunk = cache.free_list;
+				cache.free_list = chunk->next;
+				chunk->next = free_list;
+				free_list = chunk;
+			}
+			cache.count -= count;
+		}
+
+		void track_allocation(void)
+		{
+			if (is_thread_cached())
+			{
+				allocations.fetch_add(1, std::memory_order_relaxed);
+				const auto n = live.fetch_add(1, std::memory_order_relaxed) + 1;
+				auto hwm = high_water.load(std::memory_order_relaxed);
+				while (n > hwm && !high_water.compare_exchange_weak(hwm, n, std::memory_order_relaxed)) { }
+			}
+			else
+			{
+				// single-threaded pool, avoid atomic read-modify-write
+				allocations.store(allocations.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+				const auto n = live.load(std::memory_order_relaxed) + 1;
+				live.store(n, std::memory_order_relaxed);
+				if (n > high_water.load(std::memory_order_relaxed))
+					high_water.store(n, std::memory_order_relaxed);
+			}
+		}
+
+		void track_free(void)
+		{
+			if (is_thread_cached())
+				live.fetch_sub(1, std::memory_order_relaxed);
+			else
+				live.store(live.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed);
+		}
+
+	public:
+		/// <summary>
+		/// Creates a new memory pool.
+		/// </summary>
+		/// <param name="capacity">The number of objects per slab</param>
+		/// <param name="name">Name used to report statistics, or nullptr to not report statistics</param>
+		/// <param name="flags">Combination of Flags</param>
+		MemoryPool(std::size_t capacity, const char* name = nullptr, int flags = Growable)
+			: MemoryPoolBase(name), capacity(capacity), flags(flags), slab_count(0), free_list(nullptr), live(0), high_water(0), allocations(0)
+		{
+			add_slab();
+		}
+
+		~MemoryPool(void)
+		{
+			for (auto slab : slabs)
+				::free(slab);
+			slabs.clear();
 			free_list = nullptr;
 		}
 
+		MemoryPoolStats get_stats(void) const
+		{
+			MemoryPoolStats stats;
+			stats.capacity = capacity * slab_count.load(std::memory_order_relaxed);
+			stats.live = live.load(std::memory_order_relaxed);
+			stats.high_water = high_water.load(std::memory_order_relaxed);
+			stats.allocations = allocations.load(std::memory_order_relaxed);
+			return stats;
+		}
+
 		/// <summary>
 		/// Allocates a new object from the pool
 		/// </summary>
@@ -53,11 +251,32 @@ namespace dukat
 		{
 			if (size != sizeof(T))
 				return ::operator new(size);
-			assert(free_list != nullptr);
-			if (free_list == nullptr)
-				throw std::bad_alloc();
-			auto res = free_list;
-			free_list = free_list->next;
+
+			Chunk* res;
+			if (is_thread_cached())
+			{
+				auto& cache = thread_cache();
+				if (cache.free_list == nullptr)
+				{
+					// refill half of the cache
+					std::lock_guard<std::mutex> lock(mutex);
+					for (auto i = 0u; i < cache_size / 2; i++)
+					{
+						auto chunk = pop_chunk();
+						chunk->next = cache.free_list;
+						cache.free_list = chunk;
+					}
+					cache.count = cache_size / 2;
+				}
+				res = cache.free_list;
+				cache.free_list = res->next;
+				cache.count--;
+			}
+			else
+			{
+				res = pop_chunk();
+			}
+			track_allocation();
 			return reinterpret_cast<void*>(res);
 		}
 
@@ -71,13 +290,27 @@ namespace dukat
 			if (size != sizeof(T))
 			{
 				::operator delete(ptr, size);
+				return;
+			}
+
+			auto chunk = reinterpret_cast<Chunk*>(ptr);
+			if (is_thread_cached())
+			{
+				auto& cache = thread_cache();
+				chunk->next = cache.free_list;
+				cache.free_list = chunk;
+				if (++cache.count > cache_size)
+					release_batch(cache, cache_size / 2);
 			}
 			else
 			{
-				auto chunk = reinterpret_cast<Chunk*>(ptr);
 				chunk->next = free_list;
 				free_list = chunk;
 			}
+			track_free();
 		}
 	};
+
+	template<typename T>
+	constexpr std::size_t MemoryPool<T>::cache_size;
 }
\ No newline at end of file
@@ -6,6 +6,8 @@
 
 namespace dukat
 {
+	class RenderQueue3;
+
     // Abstract base class for objects that can be rendered.
     class Mesh
     {
@@ -22,5 +24,8 @@ namespace dukat
         virtual void update(float delta) = 0;
         // Renders this mesh. 
         virtual void render(Renderer* renderer) = 0;
+        // Adds draw items for this mesh to a render queue. Returns false if the mesh
+        // has to be rendered by calling render instead.
+        virtual bool enqueue(RenderQueue3& queue) { return false; }
     };
 }
\ No newline at end of file
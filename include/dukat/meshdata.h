@@ -8,6 +8,7 @@
 #include "version.h"
 #endif // !OPENGL_VERSION
 
+#include "aabb3.h"
 #include "buffers.h"
 
 namespace dukat
@@ -36,6 +37,11 @@ namespace dukat
 		std::vector<VertexAttribute> attributes;
 		// Buffer containing vertex data at index 0, and optionally index data at index 1.
 		std::unique_ptr<VertexBuffer> buffer;
+		// Bounding box of vertex positions
+		AABB3 bb;
+
+		void update_bounds(const GLvoid* vertices);
+		void upload_vertices(const GLvoid* vertices);
 
 	public:
 		// Creates a new mesh with given attributes.
@@ -48,12 +54,22 @@ namespace dukat
 		void set_vertices(const std::vector<GLfloat>& vertices, int vertex_count = -1);
 		void set_vertices(const std::vector<GLshort>& vertices, int vertex_count = -1);
 		void set_vertices(const GLvoid* vertices, int vertex_count = -1);
+		// Sets vertices with a precomputed bounding box, which saves a pass over the data.
+		void set_vertices(const GLvoid* vertices, int vertex_count, const AABB3& bounds);
 		void set_indices(const std::vector<GLushort>& indicies, int index_count = -1);
 		void set_indices(const GLvoid* indices, int index_count = -1);
 		int vertex_count(void) const { return buffer->counts[0]; }
 		void set_vertex_count(int count) { buffer->counts[0] = count; }
+		// Returns the bounding box of the last vertices set. The box is empty if the
+		// mesh does not have a position attribute made of floats.
+		const AABB3& get_bounds(void) const { return bb; }
 
 		// Renders this mesh.
 		void render(ShaderProgram* program);
+		// Steps of render, which allow callers to bind additional attributes, such as 
+		// per-instance data, before drawing. Instanced draws require GL 3.3 / GLES 3.0.
+		void bind(ShaderProgram* program);
+		void draw(int instances = 1);
+		void unbind(ShaderProgram* program);
 	};
 }
\ No newline at end of file
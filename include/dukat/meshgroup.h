@@ -7,6 +7,7 @@
 #include "mesh.h"
 #include "renderer.h"
 #include "aabb3.h"
+#include "aabbtree3.h"
 
 namespace dukat
 {
@@ -14,6 +15,16 @@ namespace dukat
 	{
 	private:
 		std::vector<std::unique_ptr<MeshInstance>> instances;
+		// Instances with bounds, in group space
+		AABBTree3<MeshInstance> tree;
+		// Instances without bounds, which are never culled
+		std::vector<MeshInstance*> unbounded;
+		// Set when instances have been added or removed since bounds were last updated
+		bool bounds_changed;
+		// Instances returned by last frustum query
+		std::vector<MeshInstance*> visible_instances;
+
+		void update_bounds(void);
 
 	public:
         AABB3 bb;
@@ -21,15 +32,17 @@ namespace dukat
 		MeshGroup(void);
 		~MeshGroup(void) { }
 
-		MeshInstance* create_instance(void) { instances.push_back(std::make_unique<MeshInstance>()); return instances.back().get(); }
+		MeshInstance* create_instance(void) { instances.push_back(std::make_unique<MeshInstance>()); bounds_changed = true; return instances.back().get(); }
 		MeshInstance* add_instance(std::unique_ptr<MeshInstance> instance);
         void remove_instance(MeshInstance* instance);
 		MeshInstance* get_instance(int index) const { return instances[index].get(); }
 		int size(void) { return static_cast<int>(instances.size()); }
-		void clear(void) { instances.clear(); }
+		void clear(void) { instances.clear(); tree.clear(); unbounded.clear(); }
 
 		void update(float delta);
-		// TODO: revisit - we may want to batch these calls
+		// Adds visible instances to a render queue, which batches them with other meshes.
+		// Instances of the scene stage are culled through a bounding volume hierarchy.
+		bool enqueue(RenderQueue3& queue);
 		void render(Renderer* renderer);
 	};
 }
\ No newline at end of file
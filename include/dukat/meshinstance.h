@@ -41,7 +41,7 @@ namespace dukat
 		void set_mesh(MeshData* mesh) { this->mesh = mesh; }
 		MeshData* get_mesh(void) const { return mesh; }
 		void set_material(const Material& material) { this->material = material; update_material_buffer(); }
-		Material get_material(void) const { return material; }
+		const Material& get_material(void) const { return material; }
 		void set_ambient(const Color& ambient) { this->material.ambient = ambient; update_material_buffer(); }
 		Color get_ambient(void) const { return material.ambient; }
 		void set_diffuse(const Color& diffuse) { this->material.diffuse = diffuse; update_material_buffer(); }
@@ -49,9 +49,15 @@ namespace dukat
 		void set_specular(const Color& specular) { this->material.specular = specular; update_material_buffer(); }
 		Color get_specular(void) const { return material.specular; }
 		void set_program(ShaderProgram* program) { this->program = program; }
+		ShaderProgram* get_program(void) const { return program; }
 		void set_texture(Texture* texture, int index = 0);
+		Texture* get_texture(int index = 0) const { return texture[index]; }
 		// Updates mesh transform.		
 		virtual void update(float delta) { this->transform.update(); }
+		// Adds this instance to a render queue.
+		virtual bool enqueue(RenderQueue3& queue);
+		// Activates program, material and textures of this instance.
+		void bind(Renderer* renderer);
 		// Renders mesh instance using only local transformation.
 		virtual void render(Renderer* renderer);
 		// Renders mesh instance using transformation specified in mat.
@@ -90,6 +90,8 @@ namespace dukat
 		virtual ~Messenger(void) { }
 
 		// Triggers an event for all recievers subscribed to this entity.
+		// If called from a job, the message is delivered once the job has been
+		// awaited, so any parameters have to remain valid until then.
 		void trigger(const Message& message);
 		// Subscribes to an event on this entity.
 		void subscribe(Recipient* recipient, Event ev);
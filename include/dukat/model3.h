@@ -1,6 +1,7 @@
 #pragma once
 
 #include "aabb3.h"
+#include "mappedfile.h"
 #include "material.h"
 #include "sysutil.h"
 #include "transform3.h"
@@ -16,6 +17,10 @@ namespace dukat
         static constexpr size_t string_length = 256;
         static constexpr uint32_t model_id = mc_const('d','o','m','d');
         static constexpr uint32_t model_version = 1;
+        // Version of the packed layout, which can be mapped and used in place
+        static constexpr uint32_t packed_version = 2;
+        // Alignment of records and data blocks in the packed layout
+        static constexpr uint32_t packed_alignment = 16;
 
         enum VertexFormat
         {
@@ -67,7 +72,41 @@ namespace dukat
                 memset(texture, 0, string_length);
             }
         };
-    
+
+        // Records of the packed layout only contain fixed size fields, so that they can be
+        // read directly from a mapped file. The id and version are in the same place as
+        // in the stream layout.
+        struct PackedHeader
+        {
+            uint32_t id;
+            uint32_t version;
+            uint32_t file_size;
+            uint32_t mesh_offset;
+            uint32_t mesh_count;
+            uint32_t index_offset;
+            uint32_t index_count;
+            uint32_t vertex_offset;
+            uint32_t vertex_count;
+            uint32_t reserved[3];
+            GLfloat bounds[8];      // min and max of model
+            char name[string_length];
+        };
+
+        struct PackedMesh
+        {
+            uint32_t id;
+            uint32_t index_offset;  // relative to first index of model
+            uint32_t index_count;
+            uint32_t vertex_offset; // relative to first vertex of model
+            uint32_t vertex_count;
+            uint32_t reserved[3];
+            GLfloat material[16];   // ambient, diffuse, specular, custom
+            GLfloat transform[20];  // position, dir, up, left, scale
+            GLfloat bounds[8];      // min and max of vertex positions
+            char name[string_length];
+            char texture[string_length];
+        };
+
     private:
         Header header;
         std::vector<Mesh> meshes;
@@ -95,8 +134,45 @@ namespace dukat
         // Stream input / output
         friend std::ostream& operator<<(std::ostream& os, const Model3& v);
         friend std::istream& operator>>(std::istream& is, Model3& v);
+        // Writes model in the packed layout.
+        void write_packed(std::ostream& os) const;
+    };
+
+    // Model in the packed layout, used in place from a mapped file. Vertex and index data
+    // is passed to GL straight from the mapping.
+    class MappedModel3
+    {
+    private:
+        MappedFile file;
+        const Model3::PackedHeader* header;
+        const Model3::PackedMesh* meshes;
+        const GLushort* indices;
+        const Model3::Vertex* vertices;
+
+    public:
+        // Maps a file and validates the layout of its records. Throws if the file is
+        // not a valid packed model.
+        MappedModel3(const std::string& filename);
+        ~MappedModel3(void) { }
+
+        // Returns true if a file starts with the header of a packed model.
+        static bool is_packed(const std::string& filename);
+
+        std::string get_name(void) const;
+        uint32_t mesh_count(void) const { return header->mesh_count; }
+        const Model3::PackedMesh& get_mesh(uint32_t index) const { return meshes[index]; }
+        const GLushort* get_indices(const Model3::PackedMesh& mesh) const { return indices + mesh.index_offset; }
+        const Model3::Vertex* get_vertices(const Model3::PackedMesh& mesh) const { return vertices + mesh.vertex_offset; }
+        dukat::AABB3 get_bounds(void) const;
+        // Size of vertex and index data in bytes.
+        std::size_t data_size(void) const;
+
+        // Pages in all data and checks that indices refer to vertices of their mesh.
+        // Meant to be called on a worker thread before the model is uploaded.
+        void prefetch(void) const;
     };
 
 	// Utility method to generate mesh group from model
     extern std::unique_ptr<MeshGroup> build_mesh_group(GameBase* game, const Model3& model);
+    extern std::unique_ptr<MeshGroup> build_mesh_group(GameBase* game, const MappedModel3& model);
 }
\ No newline at end of file
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "jobscheduler.h"
+
+namespace dukat
+{
+	class GameBase;
+	class MappedModel3;
+	class MeshGroup;
+
+	// Loads models in the packed layout in the background. Files are mapped, validated and
+	// paged in on worker threads of the job scheduler. Finished models are uploaded on the
+	// GL thread during update, which hands the resulting mesh groups to a callback.
+	class ModelLoader
+	{
+	public:
+		typedef std::function<void(std::unique_ptr<MeshGroup>)> Callback;
+		// Default number of bytes of vertex and index data uploaded per update
+		static constexpr std::size_t default_budget = 4 * 1024 * 1024;
+
+	private:
+		struct Request
+		{
+			std::string filename;
+			Callback callback;
+			std::unique_ptr<MappedModel3> model;
+			std::exception_ptr error;
+		};
+
+		GameBase* game;
+		JobCounter counter;
+		// Requests which have been processed by a worker, in order of completion
+		std::mutex mutex;
+		std::deque<std::unique_ptr<Request>> completed;
+		// Number of requests which have not been handed over yet
+		std::size_t pending;
+
+		void process(Request* request);
+
+	public:
+		ModelLoader(GameBase* game);
+		~ModelLoader(void);
+
+		// Queues a model to be loaded. The callback is invoked from update once the model
+		// has been uploaded. Models which fail to load are logged and skipped.
+		void load(const std::string& filename, const Callback& callback);
+		// Uploads finished models until budget bytes have been uploaded, but at least one
+		// model. Has to be called on the GL thread. Returns number of models handed over.
+		int update(std::size_t budget = default_budget);
+		// Blocks until all queued models have been loaded and handed over.
+		void finish(void);
+		// Returns number of models which have not been handed over yet.
+		std::size_t get_pending(void) const { return pending; }
+		bool is_idle(void) const { return pending == 0; }
+	};
+}
\ No newline at end of file
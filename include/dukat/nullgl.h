@@ -0,0 +1,353 @@
+#pragma once
+
+#include <cstdint>
+
+#ifndef OPENGL_VERSION
+#include "version.h"
+#endif // !OPENGL_VERSION
+
+namespace dukat
+{
+	// OpenGL usage recorded by the null backend.
+	struct GLStats
+	{
+		uint64_t calls;				// No# of OpenGL calls
+		uint64_t draw_calls;		// No# of draw calls
+		uint64_t instances;			// No# of instances drawn
+		uint64_t vertices;			// No# of vertices drawn, including all instances
+		uint64_t state_changes;		// No# of calls which change pipeline state
+		uint64_t redundant_changes;	// No# of state changes which set the value already in effect
+		uint64_t program_binds;		// No# of program switches
+		uint64_t texture_binds;		// No# of texture binds
+		uint64_t buffer_binds;		// No# of buffer binds
+		uint64_t vertex_array_binds;// No# of vertex array binds
+		uint64_t framebuffer_binds;	// No# of framebuffer binds
+		uint64_t uniform_updates;	// No# of uniform updates
+		uint64_t uploaded_bytes;	// No# of bytes uploaded to buffers and textures
+	};
+
+	// Headless OpenGL backend, enabled by defining DUKAT_NULL_GL. All OpenGL entry points 
+	// used by the engine are redirected to functions which track objects and pipeline state 
+	// and record statistics, but skip rasterization. Shader sources are scanned for uniform 
+	// and attribute declarations, so that programs can be indexed as usual. Only the OpenGL 3 
+	// code path is covered. Calls have to be made from a single thread.
+	class NullGL
+	{
+	public:
+		static bool is_enabled(void);
+		// Returns statistics of the last completed frame.
+		static const GLStats& get_frame_stats(void);
+		// Returns statistics accumulated over all completed frames.
+		static const GLStats& get_total_stats(void);
+		// Completes the statistics of the current frame. Called by the application once per frame.
+		static void end_frame(void);
+	};
+}
+
+#ifdef DUKAT_NULL_GL
+
+void dukat_glActiveTexture(GLenum texture);
+void dukat_glAttachShader(GLuint program, GLuint shader);
+void dukat_glBindBuffer(GLenum target, GLuint buffer);
+void dukat_glBindBufferBase(GLenum target, GLuint index, GLuint buffer);
+void dukat_glBindFragDataLocation(GLuint program, GLuint color, const GLchar* name);
+void dukat_glBindFramebuffer(GLenum target, GLuint framebuffer);
+void dukat_glBindRenderbuffer(GLenum target, GLuint renderbuffer);
+void dukat_glBindTexture(GLenum target, GLuint texture);
+void dukat_glBindVertexArray(GLuint array);
+void dukat_glBlendFunc(GLenum sfactor, GLenum dfactor);
+void dukat_glBufferData(GLenum target, GLsizeiptr size, const void* data, GLenum usage);
+void dukat_glBufferStorage(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+void dukat_glBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void* data);
+GLenum dukat_glCheckFramebufferStatus(GLenum target);
+void dukat_glClear(GLbitfield mask);
+void dukat_glClearColor(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha);
+GLenum dukat_glClientWaitSync(GLsync sync, GLbitfield flags, GLuint64 timeout);
+void dukat_glCompileShader(GLuint shader);
+void dukat_glCompressedTexImage2D(GLenum target, GLint level, GLenum internalformat, GLsizei width, GLsizei height, GLint border, GLsizei image_size, const void* data);
+GLuint dukat_glCreateProgram(void);
+GLuint dukat_glCreateShader(GLenum type);
+void dukat_glCullFace(GLenum mode);
+void dukat_glDeleteBuffers(GLsizei n, const GLuint* buffers);
+void dukat_glDeleteFramebuffers(GLsizei n, const GLuint* framebuffers);
+void dukat_glDeleteProgram(GLuint program);
+void dukat_glDeleteRenderbuffers(GLsizei n, const GLuint* renderbuffers);
+void dukat_glDeleteShader(GLuint shader);
+void dukat_glDeleteSync(GLsync sync);
+void dukat_glDeleteTextures(GLsizei n, const GLuint* textures);
+void dukat_glDeleteVertexArrays(GLsizei n, const GLuint* arrays);
+void dukat_glDepthFunc(GLenum func);
+void dukat_glDetachShader(GLuint program, GLuint shader);
+void dukat_glDisable(GLenum cap);
+void dukat_glDisableVertexAttribArray(GLuint index);
+void dukat_glDrawArrays(GLenum mode, GLint first, GLsizei count);
+void dukat_glDrawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei instancecount);
+void dukat_glDrawElements(GLenum mode, GLsizei count, GLenum type, const void* indices);
+void dukat_glDrawElementsInstanced(GLenum mode, GLsizei count, GLenum type, const void* indices, GLsizei instancecount);
+void dukat_glEnable(GLenum cap);
+void dukat_glEnableVertexAttribArray(GLuint index);
+GLsync dukat_glFenceSync(GLenum condition, GLbitfield flags);
+void dukat_glFinish(void);
+void dukat_glFlushMappedBufferRange(GLenum target, GLintptr offset, GLsizeiptr length);
+void dukat_glFramebufferRenderbuffer(GLenum target, GLenum attachment, GLenum renderbuffertarget, GLuint renderbuffer);
+void dukat_glFramebufferTexture2D(GLenum target, GLenum attachment, GLenum textarget, GLuint texture, GLint level);
+void dukat_glFramebufferTextureLayer(GLenum target, GLenum attachment, GLuint texture, GLint level, GLint layer);
+void dukat_glFrontFace(GLenum mode);
+void dukat_glGenBuffers(GLsizei n, GLuint* buffers);
+void dukat_glGenFramebuffers(GLsizei n, GLuint* framebuffers);
+void dukat_glGenRenderbuffers(GLsizei n, GLuint* renderbuffers);
+void dukat_glGenTextures(GLsizei n, GLuint* textures);
+void dukat_glGenVertexArrays(GLsizei n, GLuint* arrays);
+void dukat_glGenerateMipmap(GLenum target);
+void dukat_glGetActiveAttrib(GLuint program, GLuint index, GLsizei buf_size, GLsizei* length, GLint* size, GLenum* type, GLchar* name);
+void dukat_glGetActiveUniform(GLuint program, GLuint index, GLsizei buf_size, GLsizei* length, GLint* size, GLenum* type, GLchar* name);
+GLint dukat_glGetAttribLocation(GLuint program, const GLchar* name);
+GLenum dukat_glGetError(void);
+void dukat_glGetFloatv(GLenum pname, GLfloat* data);
+void dukat_glGetIntegerv(GLenum pname, GLint* data);
+void dukat_glGetInternalformativ(GLenum target, GLenum internalformat, GLenum pname, GLsizei buf_size, GLint* params);
+void dukat_glGetProgramiv(GLuint program, GLenum pname, GLint* params);
+void dukat_glGetShaderInfoLog(GLuint shader, GLsizei buf_size, GLsizei* length, GLchar* info_log);
+void dukat_glGetShaderiv(GLuint shader, GLenum pname, GLint* params);
+const GLubyte* dukat_glGetString(GLenum name);
+void dukat_glGetTexLevelParameteriv(GLenum target, GLint level, GLenum pname, GLint* params);
+GLuint dukat_glGetUniformBlockIndex(GLuint program, const GLchar* block_name);
+GLint dukat_glGetUniformLocation(GLuint program, const GLchar* name);
+void dukat_glLinkProgram(GLuint program);
+void* dukat_glMapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access);
+void dukat_glPixelStorei(GLenum pname, GLint param);
+void dukat_glPolygonMode(GLenum face, GLenum mode);
+void dukat_glPrimitiveRestartIndex(GLuint index);
+void dukat_glReadPixels(GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, void* pixels);
+void dukat_glRenderbufferStorage(GLenum target, GLenum internalformat, GLsizei width, GLsizei height);
+void dukat_glShaderSource(GLuint shader, GLsizei count, const GLchar* const* string, const GLint* length);
+void dukat_glTexImage1D(GLenum target, GLint level, GLint internalformat, GLsizei width, GLint border, GLenum format, GLenum type, const void* pixels);
+void dukat_glTexImage2D(GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const void* pixels);
+void dukat_glTexImage3D(GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height, GLsizei depth, GLint border, GLenum format, GLenum type, const void* pixels);
+void dukat_glTexParameterf(GLenum target, GLenum pname, GLfloat param);
+void dukat_glTexParameteri(GLenum target, GLenum pname, GLint param);
+void dukat_glTexSubImage2D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height, GLenum format, GLenum type, const void* pixels);
+void dukat_glTexSubImage3D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLint zoffset, GLsizei width, GLsizei height, GLsizei depth, GLenum format, GLenum type, const void* pixels);
+void dukat_glUniform1f(GLint location, GLfloat v0);
+void dukat_glUniform1fv(GLint location, GLsizei count, const GLfloat* value);
+void dukat_glUniform1i(GLint location, GLint v0);
+void dukat_glUniform2f(GLint location, GLfloat v0, GLfloat v1);
+void dukat_glUniform2fv(GLint location, GLsizei count, const GLfloat* value);
+void dukat_glUniform3f(GLint location, GLfloat v0, GLfloat v1, GLfloat v2);
+void dukat_glUniform3fv(GLint location, GLsizei count, const GLfloat* value);
+void dukat_glUniform4f(GLint location, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3);
+void dukat_glUniform4fv(GLint location, GLsizei count, const GLfloat* value);
+void dukat_glUniformBlockBinding(GLuint program, GLuint block_index, GLuint block_binding);
+void dukat_glUniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value);
+GLboolean dukat_glUnmapBuffer(GLenum target);
+void dukat_glUseProgram(GLuint program);
+void dukat_glVertexAttribDivisor(GLuint index, GLuint divisor);
+void dukat_glVertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void* pointer);
+void dukat_glViewport(GLint x, GLint y, GLsizei width, GLsizei height);
+
+// Redirect OpenGL entry points to null backend
+#undef glActiveTexture
+#define glActiveTexture dukat_glActiveTexture
+#undef glAttachShader
+#define glAttachShader dukat_glAttachShader
+#undef glBindBuffer
+#define glBindBuffer dukat_glBindBuffer
+#undef glBindBufferBase
+#define glBindBufferBase dukat_glBindBufferBase
+#undef glBindFragDataLocation
+#define glBindFragDataLocation dukat_glBindFragDataLocation
+#undef glBindFramebuffer
+#define glBindFramebuffer dukat_glBindFramebuffer
+#undef glBindRenderbuffer
+#define glBindRenderbuffer dukat_glBindRenderbuffer
+#undef glBindTexture
+#define glBindTexture dukat_glBindTexture
+#undef glBindVertexArray
+#define glBindVertexArray dukat_glBindVertexArray
+#undef glBlendFunc
+#define glBlendFunc dukat_glBlendFunc
+#undef glBufferData
+#define glBufferData dukat_glBufferData
+#undef glBufferStorage
+#define glBufferStorage dukat_glBufferStorage
+#undef glBufferSubData
+#define glBufferSubData dukat_glBufferSubData
+#undef glCheckFramebufferStatus
+#define glCheckFramebufferStatus dukat_glCheckFramebufferStatus
+#undef glClear
+#define glClear dukat_glClear
+#undef glClearColor
+#define glClearColor dukat_glClearColor
+#undef glClientWaitSync
+#define glClientWaitSync dukat_glClientWaitSync
+#undef glCompileShader
+#define glCompileShader dukat_glCompileShader
+#undef glCompressedTexImage2D
+#define glCompressedTexImage2D dukat_glCompressedTexImage2D
+#undef glCreateProgram
+#define glCreateProgram dukat_glCreateProgram
+#undef glCreateShader
+#define glCreateShader dukat_glCreateShader
+#undef glCullFace
+#define glCullFace dukat_glCullFace
+#undef glDeleteBuffers
+#define glDeleteBuffers dukat_glDeleteBuffers
+#undef glDeleteFramebuffers
+#define glDeleteFramebuffers dukat_glDeleteFramebuffers
+#undef glDeleteProgram
+#define glDeleteProgram dukat_glDeleteProgram
+#undef glDeleteRenderbuffers
+#define glDeleteRenderbuffers dukat_glDeleteRenderbuffers
+#undef glDeleteShader
+#define glDeleteShader dukat_glDeleteShader
+#undef glDeleteSync
+#define glDeleteSync dukat_glDeleteSync
+#undef glDeleteTextures
+#define glDeleteTextures dukat_glDeleteTextures
+#undef glDeleteVertexArrays
+#define glDeleteVertexArrays dukat_glDeleteVertexArrays
+#undef glDepthFunc
+#define glDepthFunc dukat_glDepthFunc
+#undef glDetachShader
+#define glDetachShader dukat_glDetachShader
+#undef glDisable
+#define glDisable dukat_glDisable
+#undef glDisableVertexAttribArray
+#define glDisableVertexAttribArray dukat_glDisableVertexAttribArray
+#undef glDrawArrays
+#define glDrawArrays dukat_glDrawArrays
+#undef glDrawArraysInstanced
+#define glDrawArraysInstanced dukat_glDrawArraysInstanced
+#undef glDrawElements
+#define glDrawElements dukat_glDrawElements
+#undef glDrawElementsInstanced
+#define glDrawElementsInstanced dukat_glDrawElementsInstanced
+#undef glEnable
+#define glEnable dukat_glEnable
+#undef glEnableVertexAttribArray
+#define glEnableVertexAttribArray dukat_glEnableVertexAttribArray
+#undef glFenceSync
+#define glFenceSync dukat_glFenceSync
+#undef glFinish
+#define glFinish dukat_glFinish
+#undef glFlushMappedBufferRange
+#define glFlushMappedBufferRange dukat_glFlushMappedBufferRange
+#undef glFramebufferRenderbuffer
+#define glFramebufferRenderbuffer dukat_glFramebufferRenderbuffer
+#undef glFramebufferTexture2D
+#define glFramebufferTexture2D dukat_glFramebufferTexture2D
+#undef glFramebufferTextureLayer
+#define glFramebufferTextureLayer dukat_glFramebufferTextureLayer
+#undef glFrontFace
+#define glFrontFace dukat_glFrontFace
+#undef glGenBuffers
+#define glGenBuffers dukat_glGenBuffers
+#undef glGenFramebuffers
+#define glGenFramebuffers dukat_glGenFramebuffers
+#undef glGenRenderbuffers
+#define glGenRenderbuffers dukat_glGenRenderbuffers
+#undef glGenTextures
+#define glGenTextures dukat_glGenTextures
+#undef glGenVertexArrays
+#define glGenVertexArrays dukat_glGenVertexArrays
+#undef glGenerateMipmap
+#define glGenerateMipmap dukat_glGenerateMipmap
+#undef glGetActiveAttrib
+#define glGetActiveAttrib dukat_glGetActiveAttrib
+#undef glGetActiveUniform
+#define glGetActiveUniform dukat_glGetActiveUniform
+#undef glGetAttribLocation
+#define glGetAttribLocation dukat_glGetAttribLocation
+#undef glGetError
+#define glGetError dukat_glGetError
+#undef glGetFloatv
+#define glGetFloatv dukat_glGetFloatv
+#undef glGetIntegerv
+#define glGetIntegerv dukat_glGetIntegerv
+#undef glGetInternalformativ
+#define glGetInternalformativ dukat_glGetInternalformativ
+#undef glGetProgramiv
+#define glGetProgramiv dukat_glGetProgramiv
+#undef glGetShaderInfoLog
+#define glGetShaderInfoLog dukat_glGetShaderInfoLog
+#undef glGetShaderiv
+#define glGetShaderiv dukat_glGetShaderiv
+#undef glGetString
+#define glGetString dukat_glGetString
+#undef glGetTexLevelParameteriv
+#define glGetTexLevelParameteriv dukat_glGetTexLevelParameteriv
+#undef glGetUniformBlockIndex
+#define glGetUniformBlockIndex dukat_glGetUniformBlockIndex
+#undef glGetUniformLocation
+#define glGetUniformLocation dukat_glGetUniformLocation
+#undef glLinkProgram
+#define glLinkProgram dukat_glLinkProgram
+#undef glMapBufferRange
+#define glMapBufferRange dukat_glMapBufferRange
+#undef glPixelStorei
+#define glPixelStorei dukat_glPixelStorei
+#undef glPolygonMode
+#define glPolygonMode dukat_glPolygonMode
+#undef glPrimitiveRestartIndex
+#define glPrimitiveRestartIndex dukat_glPrimitiveRestartIndex
+#undef glReadPixels
+#define glReadPixels dukat_glReadPixels
+#undef glRenderbufferStorage
+#define glRenderbufferStorage dukat_glRenderbufferStorage
+#undef glShaderSource
+#define glShaderSource dukat_glShaderSource
+#undef glTexImage1D
+#define glTexImage1D dukat_glTexImage1D
+#undef glTexImage2D
+#define glTexImage2D dukat_glTexImage2D
+#undef glTexImage3D
+#define glTexImage3D dukat_glTexImage3D
+#undef glTexParameterf
+#define glTexParameterf dukat_glTexParameterf
+#undef glTexParameteri
+#define glTexParameteri dukat_glTexParameteri
+#undef glTexSubImage2D
+#define glTexSubImage2D dukat_glTexSubImage2D
+#undef glTexSubImage3D
+#define glTexSubImage3D dukat_glTexSubImage3D
+#undef glUniform1f
+#define glUniform1f dukat_glUniform1f
+#undef glUniform1fv
+#define glUniform1fv dukat_glUniform1fv
+#undef glUniform1i
+#define glUniform1i dukat_glUniform1i
+#undef glUniform2f
+#define glUniform2f dukat_glUniform2f
+#undef glUniform2fv
+#define glUniform2fv dukat_glUniform2fv
+#undef glUniform3f
+#define glUniform3f dukat_glUniform3f
+#undef glUniform3fv
+#define glUniform3fv dukat_glUniform3fv
+#undef glUniform4f
+#define glUniform4f dukat_glUniform4f
+#undef glUniform4fv
+#define glUniform4fv dukat_glUniform4fv
+#undef glUniformBlockBinding
+#define glUniformBlockBinding dukat_glUniformBlockBinding
+#undef glUniformMatrix4fv
+#define glUniformMatrix4fv dukat_glUniformMatrix4fv
+#undef glUnmapBuffer
+#define glUnmapBuffer dukat_glUnmapBuffer
+#undef glUseProgram
+#define glUseProgram dukat_glUseProgram
+#undef glVertexAttribDivisor
+#define glVertexAttribDivisor dukat_glVertexAttribDivisor
+#undef glVertexAttribPointer
+#define glVertexAttribPointer dukat_glVertexAttribPointer
+#undef glViewport
+#define glViewport dukat_glViewport
+
+#ifndef __ANDROID__
+// Persistently mapped buffers are written without any OpenGL calls, so use explicit flushes 
+// instead to keep track of uploads.
+#undef GLEW_ARB_buffer_storage
+#define GLEW_ARB_buffer_storage 0
+#endif
+
+#endif // DUKAT_NULL_GL
\ No newline at end of file
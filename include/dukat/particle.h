@@ -2,6 +2,7 @@
 
 #include "vector2.h"
 #include "color.h"
+#include "layerslot.h"
 #include "memorypool.h"
 
 namespace dukat
@@ -32,6 +33,7 @@ namespace dukat
 		float radius;	// Radius of the spiral
 		float angle;	// Current angle for spiraling motion
 		uint8_t	flags;	// Flags
+		LayerSlot layer_slot;	// Membership in render layer
 
 		Particle(void) : pos(), ref(), color(), size(1.f), dp(), dc(), 
 			dsize(0.f), ttl(0.f), radius(0.f), angle(0.f), 
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace dukat
+{
+	class Vector2;
+	struct Color;
+	struct ParticleStore;
+
+	// Instruction set used to integrate packed particles.
+	enum class ParticleKernel
+	{
+		Scalar,
+		SSE2,
+		AVX
+	};
+
+	// Constants shared by all particles during a single update.
+	struct ParticleStep
+	{
+		float delta;
+		float gravity;
+		float dampening;
+	};
+
+	// Returns the flags that affect particle motion. Flags which are shadowed by
+	// others (Spiraling by Linear, AntiGravitational by Gravitational) are cleared,
+	// so that particles which move the same way end up with the same value.
+	uint8_t motion_flags(uint8_t flags);
+	// Returns the widest kernel supported by the current CPU.
+	ParticleKernel detect_particle_kernel(void);
+	// Returns true if a kernel can be used on the current CPU.
+	bool is_supported(ParticleKernel kernel);
+	const char* kernel_name(ParticleKernel kernel);
+
+	// Integrates motion, color and size of a single particle.
+	void integrate_particle(uint8_t flags, Vector2& pos, Vector2& dp, const Vector2& ref,
+		Color& color, const Color& dc, float& size, float dsize, float& radius, float& angle,
+		const ParticleStep& step);
+	// Decrements time-to-live and integrates particles in range [begin, end) of a store.
+	// All particles in the range must share the same motion flags.
+	void integrate_particles(ParticleKernel kernel, uint8_t motion, ParticleStore& store,
+		std::size_t begin, std::size_t end, const ParticleStep& step);
+}
\ No newline at end of file
@@ -2,44 +2,106 @@
 
 #include <list>
 #include <memory>
+#include <vector>
 
 #include "particle.h"
 #include "particleemitter.h"
+#include "particlekernels.h"
+#include "particlestore.h"
 #include "manager.h"
 
 namespace dukat
 {
-	// Manager in charge of all particles on screen. 
+	class RenderLayer2;
+
+	// Manager in charge of all particles on screen.
 	class ParticleManager : public Manager
 	{
+	public:
+		// Determines how particles created by emitters are stored.
+		enum StorageMode
+		{
+			Pooled,	// Each particle is allocated individually from the particle pool
+			Packed	// Particles are stored in contiguous arrays per layer
+		};
+
 	private:
+		// Entry in handle table which maps stable handles to packed particles.
+		struct HandleSlot
+		{
+			ParticleStore* store;
+			uint32_t index;
+			uint32_t generation;
+		};
+
+		// Range of packed particles which is integrated as a single job.
+		struct ParticleBatch
+		{
+			ParticleStore* store;
+			std::size_t begin;
+			std::size_t end;
+		};
+
+		// Number of packed particles per job
+		static constexpr std::size_t batch_size = 4096;
+
+		StorageMode storage_mode;
+		// Instruction set used to integrate packed particles
+		ParticleKernel kernel;
 		// Object pools
 		std::list<std::unique_ptr<Particle>> particles;
 		std::list<std::unique_ptr<ParticleEmitter>> emitters;
+		// Packed particle storage, one store per layer and combination of motion flags
+		std::vector<std::unique_ptr<ParticleStore>> stores;
+		std::vector<HandleSlot> handle_slots;
+		std::vector<uint32_t> free_handles;
+		std::vector<ParticleBatch> batches;
 		// Gravitational constant applied to particles' vertical motion.
 		float gravity;
 		// Dampening factor.
 		float dampening;
 
 		void update_particles(float delta);
+		void update_stores(float delta);
 		void update_emitters(float delta);
+		// Returns packed store for a layer and motion flags, creating it if necessary.
+		ParticleStore* get_store(RenderLayer2* layer, uint8_t motion);
+		// Removes packed particle and releases its handle.
+		void remove_particle(ParticleStore& store, std::size_t index);
 
 	public:
 		ParticleManager(GameBase* game);
-		~ParticleManager(void) { }
+		// Detaches packed stores from their layers.
+		~ParticleManager(void);
 
 		void set_gravity(float gravity) { this->gravity = gravity; }
 		void set_dampening(float dampening) { this->dampening = dampening; }
+		void set_storage_mode(StorageMode mode) { this->storage_mode = mode; }
+		StorageMode get_storage_mode(void) const { return storage_mode; }
+		// Selects instruction set for packed particles. Falls back to the best supported kernel.
+		void set_kernel(ParticleKernel kernel);
+		ParticleKernel get_kernel(void) const { return kernel; }
 
 		// Updates all particles position in space.
-		void update(float delta) { update_emitters(delta); update_particles(delta); }
+		void update(float delta) { update_emitters(delta); update_particles(delta); update_stores(delta); }
 		// Creates a new particle.
 		Particle* create_particle(void);
+		// Adds a copy of a particle to a layer using the current storage mode.
+		void emit(const Particle& p, RenderLayer2* layer);
+		// Adds a copy of a particle to packed storage and returns a stable handle to it.
+		ParticleHandle add_particle(const Particle& p, RenderLayer2* layer);
+		// Returns accessor for a packed particle, or an invalid ref if the particle no longer exists.
+		ParticleRef get(const ParticleHandle& handle);
+		// Changes flags of a packed particle, moving it to a different store if its motion changes.
+		void set_flags(const ParticleHandle& handle, uint8_t flags);
+		// Returns true if handle refers to an existing packed particle.
+		bool is_valid(const ParticleHandle& handle) const;
 		// Creates a new particle emitter from a recipe. May return null if pool is at capacity.
 		ParticleEmitter* create_emitter(const ParticleRecipe& recipe);
 		// Frees up a particle emitter.
 		void remove_emitter(ParticleEmitter* emitter);
-		// Removes all particles and emitters
+		// Removes all particles and emitters. Packed stores stay attached to their layers 
+		// until the manager is destroyed.
 		void clear(void);
 	};
 }
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <vector>
+#include "color.h"
+#include "particle.h"
+#include "vector2.h"
+
+namespace dukat
+{
+	class RenderLayer2;
+
+	// Stable reference to a particle held in packed storage. Remains valid for
+	// the lifetime of the particle, even if the particle is moved within the store.
+	struct ParticleHandle
+	{
+		static constexpr uint32_t invalid_id = 0xffffffff;
+
+		uint32_t id;
+		uint32_t generation;
+
+		ParticleHandle(void) : id(invalid_id), generation(0u) { }
+		ParticleHandle(uint32_t id, uint32_t generation) : id(id), generation(generation) { }
+
+		bool is_valid(void) const { return id != invalid_id; }
+	};
+
+	// Structure-of-arrays storage for packed particles targeting a single
+	// render layer which share the same motion flags. Particles are kept contiguous;
+	// removing a particle moves the last particle into the vacated slot.
+	struct ParticleStore
+	{
+		// Layer that particles in this store are rendered to
+		RenderLayer2* const layer;
+		// Motion flags shared by all particles in this store
+		const uint8_t motion;
+		std::vector<Vector2> pos;
+		std::vector<Vector2> dp;
+		std::vector<Vector2> ref;
+		std::vector<Color> color;
+		std::vector<Color> dc;
+		std::vector<float> size;
+		std::vector<float> dsize;
+		std::vector<float> ttl;
+		std::vector<float> radius;
+		std::vector<float> angle;
+		std::vector<uint8_t> flags;
+		// Handle id of each particle
+		std::vector<uint32_t> ids;
+
+		ParticleStore(RenderLayer2* layer, uint8_t motion) : layer(layer), motion(motion) { }
+		~ParticleStore(void) { }
+
+		std::size_t count(void) const { return ids.size(); }
+		bool empty(void) const { return ids.empty(); }
+		void reserve(std::size_t capacity);
+		// Appends a particle and returns its index.
+		std::size_t push_back(const Particle& p, uint32_t id);
+		// Removes the particle at a given index by moving the last particle into its place.
+		void swap_remove(std::size_t index);
+		void clear(void);
+
+		// Copies particle at index into p.
+		void get(std::size_t index, Particle& p) const;
+		// Overwrites particle at index with p.
+		void set(std::size_t index, const Particle& p);
+	};
+
+	// Transient accessor for a packed particle. Only valid until the next call
+	// that creates or removes particles, so it should be re-acquired every frame.
+	struct ParticleRef
+	{
+		ParticleStore* store;
+		std::size_t index;
+
+		ParticleRef(void) : store(nullptr), index(0) { }
+		ParticleRef(ParticleStore* store, std::size_t index) : store(store), index(index) { }
+
+		bool is_valid(void) const { return store != nullptr; }
+
+		Vector2& pos(void) const { return store->pos[index]; }
+		Vector2& dp(void) const { return store->dp[index]; }
+		Vector2& ref(void) const { return store->ref[index]; }
+		Color& color(void) const { return store->color[index]; }
+		Color& dc(void) const { return store->dc[index]; }
+		float& size(void) const { return store->size[index]; }
+		float& dsize(void) const { return store->dsize[index]; }
+		float& ttl(void) const { return store->ttl[index]; }
+		// Use ParticleManager::set_flags to change motion flags.
+		uint8_t flags(void) const { return store->flags[index]; }
+	};
+}
\ No newline at end of file
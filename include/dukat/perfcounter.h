@@ -5,8 +5,10 @@ namespace dukat
 	// Simple performance counter to collect engine metrics.
 	class PerformanceCounter
 	{
-	private:
+	public:
 		static const int max_counters = 256;
+
+	private:
 		// current counters
 		long counters[max_counters];
 		// accumulator
@@ -43,7 +45,11 @@ namespace dukat
 			CUSTOM2,
 			CUSTOM3,
 			CUSTOM4,
-			CUSTOM5
+			CUSTOM5,
+			STATE_AVOIDED,	// No# of redundant GL state changes avoided
+			MESHES_CULLED,	// No# of meshes outside of the view frustum
+			MESHES_SUBMITTED,// No# of meshes submitted for rendering
+			POOLS			// First of 3 counters per named memory pool (see MemoryPoolBase)
 		};
 
 		PerformanceCounter(void);
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include "jobscheduler.h"
+
+namespace dukat
+{
+	// Struct for manipulating 24-bit pixels
+	struct Uint24 { uint8_t c[3]; };
+
+	// Compile-time layout of 32-bit pixels, given as bit offsets of the 8-bit color channels.
+	template<int RShift, int GShift, int BShift>
+	struct PixelLayout32
+	{
+		static constexpr int r_shift = RShift;
+		static constexpr int g_shift = GShift;
+		static constexpr int b_shift = BShift;
+	};
+
+	typedef PixelLayout32<24, 16, 8> PixelLayoutRGBA; // RGBA8888
+	typedef PixelLayout32<0, 8, 16> PixelLayoutABGR;  // ABGR8888, BGR888
+	typedef PixelLayout32<16, 8, 0> PixelLayoutARGB;  // ARGB8888, RGB888
+	typedef PixelLayout32<8, 16, 24> PixelLayoutBGRA; // BGRA8888
+
+	// Calls op with an instance of the layout matching the channel masks of a 32-bit
+	// format. Returns false if the format does not use one of the supported layouts.
+	template<class Op>
+	bool dispatch_pixel_layout(int bytes_per_pixel, uint32_t rmask, uint32_t gmask, uint32_t bmask, Op&& op)
+	{
+		if (bytes_per_pixel != 4)
+			return false;
+		if (rmask == 0xff000000 && gmask == 0x00ff0000 && bmask == 0x0000ff00)
+			op(PixelLayoutRGBA{});
+		else if (rmask == 0x000000ff && gmask == 0x0000ff00 && bmask == 0x00ff0000)
+			op(PixelLayoutABGR{});
+		else if (rmask == 0x00ff0000 && gmask == 0x0000ff00 && bmask == 0x000000ff)
+			op(PixelLayoutARGB{});
+		else if (rmask == 0x0000ff00 && gmask == 0x00ff0000 && bmask == 0xff000000)
+			op(PixelLayoutBGRA{});
+		else
+			return false;
+		return true;
+	}
+
+	// Typed view of a rectangle of pixels. Rows are pitch bytes apart.
+	template<typename T>
+	struct PixelRect
+	{
+		uint8_t* data;
+		int width;
+		int height;
+		int pitch;
+
+		T* row(int y) const { return reinterpret_cast<T*>(data + y * pitch); }
+		// Returns view of a part of this rectangle.
+		PixelRect sub(int x, int y, int w, int h) const
+		{
+			return PixelRect{ data + y * pitch + x * static_cast<int>(sizeof(T)), w, h, pitch };
+		}
+	};
+
+	// Row kernels. These process contiguous runs of pixels using SSE2, or AVX2 if supported
+	// by the CPU. All variants produce identical results.
+
+	// Converts pixels to luminance in [0, 1], with the same weights as luminance(const Color&).
+	template<class Layout>
+	void luminance_row(const uint32_t* src, float* dst, int count);
+	// Sets dst[i] to color0 if values[i] + thresholds[i] < 0.5, and to color1 otherwise.
+	void threshold_row(const float* values, const float* thresholds, uint32_t* dst, int count, uint32_t color0, uint32_t color1);
+	// Replaces pixels matching a source color with the destination color of the same index.
+	// If a color is listed more than once, the first entry wins.
+	void replace_row(uint32_t* row, int count, const uint32_t* src_colors, const uint32_t* dest_colors, int num_colors);
+	// Reverses the order of pixels in a row.
+	void reverse_row(uint8_t* row, int count);
+	void reverse_row(uint16_t* row, int count);
+	void reverse_row(Uint24* row, int count);
+	void reverse_row(uint32_t* row, int count);
+	// Swaps the contents of two non-overlapping rows.
+	void swap_rows(uint8_t* a, uint8_t* b, std::size_t bytes);
+	// Converts 16-bit values to floats, multiplied by factor.
+	void normalize_row(const uint16_t* src, float* dst, int count, float factor);
+	// Averages 2x2 blocks of two rows of 2 * count values into count values.
+	void downsample_row(const float* row0, const float* row1, float* dst, int count);
+
+	// Maximum number of colors for which replace_row compares all colors per pixel. Larger
+	// palettes should be looked up instead.
+	constexpr int max_replace_colors = 16;
+
+	// Splits a rectangle into tiles and calls fn(tile, x, y) for each of them, x and y being
+	// the offset of the tile within the rectangle. Tiles are processed on the workers of a
+	// scheduler if provided, so fn must not modify pixels outside of its tile. A tile size
+	// of 0 spans the entire width or height of the rectangle.
+	template<typename T, class Fn>
+	void for_each_tile(const PixelRect<T>& rect, int tile_width, int tile_height, JobScheduler* scheduler, const Fn& fn)
+	{
+		if (rect.width <= 0 || rect.height <= 0)
+			return;
+		const auto tw = tile_width > 0 ? tile_width : rect.width;
+		const auto th = tile_height > 0 ? tile_height : rect.height;
+		const auto cols = (rect.width + tw - 1) / tw;
+		const auto rows = (rect.height + th - 1) / th;
+		auto process = [&](std::size_t begin, std::size_t end) {
+			for (auto i = begin; i < end; i++)
+			{
+				const auto x = static_cast<int>(i % cols) * tw;
+				const auto y = static_cast<int>(i / cols) * th;
+				fn(rect.sub(x, y, std::min(tw, rect.width - x), std::min(th, rect.height - y)), x, y);
+			}
+		};
+		const auto count = static_cast<std::size_t>(cols) * static_cast<std::size_t>(rows);
+		if (scheduler != nullptr)
+			scheduler->parallel_for(0, count, 1, process);
+		else
+			process(0, count);
+	}
+}
\ No newline at end of file
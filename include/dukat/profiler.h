@@ -0,0 +1,170 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Define to compile out all profiler zones
+// #define DUKAT_NO_PROFILER
+
+#ifndef DUKAT_NO_PROFILER
+#define DUKAT_PROFILE_CONCAT_IMPL(a, b) a##b
+#define DUKAT_PROFILE_CONCAT(a, b) DUKAT_PROFILE_CONCAT_IMPL(a, b)
+// Records the enclosing scope as a zone. Name has to be a string literal.
+#define DUKAT_PROFILE_ZONE(name) dukat::ProfileZone DUKAT_PROFILE_CONCAT(profile_zone_, __LINE__)(name)
+// Records the enclosing function as a zone.
+#define DUKAT_PROFILE_FUNCTION() DUKAT_PROFILE_ZONE(__FUNCTION__)
+#else
+#define DUKAT_PROFILE_ZONE(name)
+#define DUKAT_PROFILE_FUNCTION()
+#endif
+
+namespace dukat
+{
+	// Timed zone recorded by the profiler.
+	struct ProfileEvent
+	{
+		const char* name;	// Name of the zone
+		uint64_t start;		// Start time in ns since profiler epoch
+		uint64_t end;		// End time in ns since profiler epoch
+		uint32_t depth;		// Nesting level of the zone within its thread
+	};
+
+	// Hierarchical CPU profiler. Each thread records zones into a ring buffer of its own,
+	// so that recording never locks. Zones are only recorded while a capture is in progress;
+	// during a capture, the main thread drains all buffers at the end of each frame and
+	// writes the collected zones in Chrome trace event format once the capture is complete.
+	class Profiler
+	{
+	private:
+		// Number of events per thread buffer
+		static constexpr std::size_t buffer_size = 1 << 14;
+
+		// Slot of a thread buffer. Fields are atomic so that the main thread can read a
+		// slot while its owning thread overwrites it; seq tells whether the read is valid.
+		struct EventSlot
+		{
+			// Number of events written including this one once the slot has been published,
+			// or 0 while the slot is being written
+			std::atomic<uint64_t> seq;
+			std::atomic<const char*> name;
+			std::atomic<uint64_t> start;
+			std::atomic<uint64_t> end;
+			std::atomic<uint32_t> depth;
+
+			EventSlot(void) : seq(0), name(nullptr), start(0), end(0), depth(0) { }
+		};
+
+		struct ThreadBuffer
+		{
+			uint32_t thread_id;
+			std::string thread_name;
+			// Current nesting level, only accessed by owning thread
+			uint32_t depth;
+			// Number of events written, only modified by owning thread
+			std::atomic<uint64_t> head;
+			// Number of events read, only accessed by main thread
+			uint64_t tail;
+			EventSlot events[buffer_size];
+
+			ThreadBuffer(uint32_t thread_id) : thread_id(thread_id), depth(0), head(0), tail(0) { }
+		};
+
+		struct CapturedEvent
+		{
+			ProfileEvent event;
+			uint32_t thread_id;
+		};
+
+		static std::atomic<bool> capturing;
+		// Guards list of thread buffers and thread names
+		static std::mutex mutex;
+		static std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+		static thread_local ThreadBuffer* current_buffer;
+		// Name of the calling thread, applied once its buffer is created
+		static thread_local std::string current_name;
+
+		// Capture state, only accessed by main thread
+		static int pending_frames;
+		static int captured_frames;
+		static std::string filename;
+		static std::vector<CapturedEvent> events;
+		static uint64_t dropped_events;
+		static uint64_t frame_start;
+
+		// Returns buffer of the calling thread, creating it if necessary.
+		static ThreadBuffer& thread_buffer(void);
+		// Appends event to a thread buffer, overwriting the oldest event if full.
+		static void push(ThreadBuffer& buffer, const ProfileEvent& e)
+		{
+			const auto head = buffer.head.load(std::memory_order_relaxed);
+			auto& slot = buffer.events[head & (buffer_size - 1)];
+			slot.seq.store(0, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_release);
+			slot.name.store(e.name, std::memory_order_relaxed);
+			slot.start.store(e.start, std::memory_order_relaxed);
+			slot.end.store(e.end, std::memory_order_relaxed);
+			slot.depth.store(e.depth, std::memory_order_relaxed);
+			// Publish slot once the event has been fully written
+			slot.seq.store(head + 1, std::memory_order_release);
+			buffer.head.store(head + 1, std::memory_order_release);
+		}
+		// Copies event from a slot. Returns false if the slot does not hold event seq - 1.
+		static bool read_slot(const EventSlot& slot, uint64_t seq, ProfileEvent& e);
+		// Moves all new events from thread buffers to the captured events.
+		static void drain(bool discard);
+		// Writes captured events to file.
+		static void write_trace(void);
+
+		friend class ProfileZone;
+
+	public:
+		// Returns time in ns since profiler epoch.
+		static uint64_t now(void);
+		static bool is_capturing(void) { return capturing.load(std::memory_order_relaxed); }
+		// Names the calling thread in captured traces.
+		static void set_thread_name(const std::string& name);
+
+		// Captures the next number of frames and writes them to a trace file that can be
+		// opened with chrome://tracing or compatible trace viewers.
+		static void capture(int frames, const std::string& filename);
+		// Marks start and end of a frame. Called by the application on the main thread.
+		static void begin_frame(void);
+		static void end_frame(void);
+	};
+
+	// Scoped zone, recorded when it goes out of scope.
+	class ProfileZone
+	{
+	private:
+		const char* name;
+		uint64_t start;
+		bool active;
+
+	public:
+		ProfileZone(const char* name) : name(name), start(0), active(Profiler::is_capturing())
+		{
+			if (active)
+			{
+				Profiler::thread_buffer().depth++;
+				start = Profiler::now();
+			}
+		}
+
+		~ProfileZone(void)
+		{
+			if (!active)
+				return;
+			const auto end = Profiler::now();
+			auto& buffer = Profiler::thread_buffer();
+			buffer.depth--;
+			Profiler::push(buffer, ProfileEvent{ name, start, end, buffer.depth });
+		}
+
+		ProfileZone(const ProfileZone&) = delete;
+		ProfileZone& operator=(const ProfileZone&) = delete;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <robin_hood.h>
+#include "broadphase2.h"
+#include "mathutil.h"
+#include "quadtree.h"
+
+namespace dukat
+{
+	// Broadphase which rebuilds a quad tree of all active values during each update.
+	template<class T>
+	class QuadTreeBroadphase2 : public Broadphase2<T>
+	{
+	public:
+		typedef typename Broadphase2<T>::Pair Pair;
+
+	private:
+		QuadTree<T> tree;
+		std::vector<T*> values;
+		robin_hood::unordered_map<T*, int> index;
+
+		// Collects values of all nodes which may contain a box.
+		void collect(const QuadTree<T>& t, const AABB2& bb, std::vector<T*>& res) const;
+		// Collects values of all nodes which are intersected by a ray.
+		void collect(const QuadTree<T>* t, const Ray2& ray, float min_t, float max_t, std::vector<T*>& res) const;
+
+	public:
+		QuadTreeBroadphase2(const Vector2& min_v, const Vector2& max_v, int max_depth) : tree(min_v, max_v, max_depth) { }
+		~QuadTreeBroadphase2(void) { }
+
+		void insert(T* value);
+		void remove(T* value);
+		void clear(void) { tree.clear(); values.clear(); index.clear(); }
+		void update(void);
+
+		void collect_pairs(std::vector<Pair>& pairs) const;
+		void query(const AABB2& bb, std::vector<T*>& res) const { collect(tree, bb, res); }
+		void query(const Ray2& ray, float min_t, float max_t, std::vector<T*>& res) const { collect(&tree, ray, min_t, max_t, res); }
+		void collect_regions(const AABB2& bb, std::vector<AABB2>& res) const;
+	};
+
+	template<class T>
+	void QuadTreeBroadphase2<T>::insert(T* value)
+	{
+		index[value] = static_cast<int>(values.size());
+		values.push_back(value);
+	}
+
+	template<class T>
+	void QuadTreeBroadphase2<T>::remove(T* value)
+	{
+		auto it = index.find(value);
+		if (it == index.end())
+			return;
+		const auto idx = it->second;
+		index.erase(it);
+		if (idx + 1 < static_cast<int>(values.size()))
+		{
+			values[idx] = values.back();
+			index[values[idx]] = idx;
+		}
+		values.pop_back();
+		tree.remove(value);
+	}
+
+	template<class T>
+	void QuadTreeBroadphase2<T>::update(void)
+	{
+		tree.clear();
+		for (auto v : values)
+		{
+			if (v->active)
+				tree.insert(v);
+		}
+	}
+
+	template<class T>
+	void QuadTreeBroadphase2<T>::collect_pairs(std::vector<Pair>& pairs) const
+	{
+		// Compare each value with the values of all nodes along its path from the root
+		for (auto v : values)
+		{
+			if (!v->active)
+				continue;
+
+			auto t = &tree;
+			while (t != nullptr)
+			{
+				for (auto other : t->get_values())
+				{
+					if (other != v)
+						pairs.emplace_back(v, other);
+				}
+				const auto idx = t->get_index(v);
+				t = idx > -1 ? t->child(idx) : nullptr;
+			}
+		}
+	}
+
+	template<class T>
+	void QuadTreeBroadphase2<T>::collect(const QuadTree<T>& t, const AABB2& bb, std::vector<T*>& res) const
+	{
+		const auto left = bb.min().x < t.center.x;
+		const auto right = bb.max().x >= t.center.x;
+		const auto top = bb.min().y < t.center.y;
+		const auto bottom = bb.max().y >= t.center.y;
+		if (right && top && t.has_child(0))
+			collect(*t.child(0), bb, res); // check top-right
+		if (right && bottom && t.has_child(1))
+			collect(*t.child(1), bb, res); // check bottom-right
+		if (left && bottom && t.has_child(2))
+			collect(*t.child(2), bb, res); // check bottom-left
+		if (left && top && t.has_child(3))
+			collect(*t.child(3), bb, res); // check top-left
+		const auto& values = t.get_values();
+		res.insert(res.end(), values.begin(), values.end());
+	}
+
+	template<class T>
+	void QuadTreeBroadphase2<T>::collect(const QuadTree<T>* t, const Ray2& ray, float min_t, float max_t, std::vector<T*>& res) const
+	{
+		if (t == nullptr)
+			return;
+
+		const AABB2 bb{ t->min_v, t->max_v };
+		if (bb.intersect_ray(ray, min_t, max_t) == no_intersection)
+			return; // no intersection with tree
+
+		const auto& values = t->get_values();
+		res.insert(res.end(), values.begin(), values.end());
+		for (auto i = 0; i < 4; i++)
+			collect(t->child(i), ray, min_t, max_t, res);
+	}
+
+	template<class T>
+	void QuadTreeBroadphase2<T>::collect_regions(const AABB2& bb, std::vector<AABB2>& res) const
+	{
+		std::vector<const QuadTree<T>*> nodes{ &tree };
+		while (!nodes.empty())
+		{
+			auto t = nodes.back();
+			nodes.pop_back();
+			for (auto i = 0; i < 4; i++)
+			{
+				if (t->has_child(i))
+					nodes.push_back(t->child(i));
+			}
+
+			const AABB2 node_bb{ t->min_v, t->max_v };
+			if (bb.overlaps(node_bb))
+				res.push_back(node_bb);
+		}
+	}
+}
\ No newline at end of file
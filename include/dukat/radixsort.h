@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace dukat
+{
+	// Value with a 64-bit sort key.
+	template<typename T>
+	struct SortItem
+	{
+		uint64_t key;
+		T value;
+	};
+
+	// Maps a float to an unsigned integer with the same ordering.
+	inline uint32_t sortable_float(float f)
+	{
+		f += 0.0f; // treat -0 as 0
+		uint32_t bits;
+		std::memcpy(&bits, &f, sizeof(bits));
+		return (bits & 0x80000000) ? ~bits : bits | 0x80000000;
+	}
+
+	// Stable LSD radix sort of items by the lowest number of bytes of the key returned by 
+	// key_of, processing 8 bits per pass. Passes over bytes which are the same for all keys 
+	// are skipped. The scratch vector is resized as needed and can be reused across calls 
+	// to avoid allocations.
+	template<typename T, typename F>
+	void radix_sort_by(std::vector<T>& items, std::vector<T>& scratch, F key_of, int bytes = 8)
+	{
+		const auto count = items.size();
+		if (count < 2)
+			return;
+
+		// Build histograms for all bytes in a single pass
+		uint32_t histograms[8][256];
+		std::memset(histograms, 0, sizeof(histograms));
+		for (const auto& item : items)
+		{
+			const uint64_t key = key_of(item);
+			for (auto b = 0; b < bytes; b++)
+				histograms[b][(key >> (b * 8)) & 0xff]++;
+		}
+
+		scratch.resize(count);
+		auto src = &items;
+		auto dst = &scratch;
+		for (auto b = 0; b < bytes; b++)
+		{
+			auto& histogram = histograms[b];
+			const auto shift = b * 8;
+			if (histogram[(static_cast<uint64_t>(key_of((*src)[0])) >> shift) & 0xff] == count)
+				continue; // all keys share this byte
+
+			// Convert counts to offsets
+			uint32_t offset = 0;
+			for (auto& h : histogram)
+			{
+				const auto n = h;
+				h = offset;
+				offset += n;
+			}
+
+			for (const auto& item : *src)
+				(*dst)[histogram[(static_cast<uint64_t>(key_of(item)) >> shift) & 0xff]++] = item;
+			std::swap(src, dst);
+		}
+
+		if (src != &items)
+			items.swap(scratch);
+	}
+
+	// Stable radix sort of items by key.
+	template<typename T>
+	void radix_sort(std::vector<SortItem<T>>& items, std::vector<SortItem<T>>& scratch)
+	{
+		radix_sort_by(items, scratch, [](const SortItem<T>& item) { return item.key; });
+	}
+
+	// Radix sort of items by key. Items with the same key are ordered by the 32-bit value 
+	// returned by order, rather than by their position in the input.
+	template<typename T, typename F>
+	void radix_sort(std::vector<SortItem<T>>& items, std::vector<SortItem<T>>& scratch, F order)
+	{
+		radix_sort_by(items, scratch, [&order](const SortItem<T>& item) { return static_cast<uint64_t>(static_cast<uint32_t>(order(item.value))); }, 4);
+		radix_sort(items, scratch);
+	}
+}
\ No newline at end of file
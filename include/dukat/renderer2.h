@@ -22,6 +22,7 @@
 namespace dukat
 {
 	// Forward declarations
+	class JobScheduler;
 	class MeshData;
 	struct Sprite;
 
@@ -31,7 +32,10 @@ namespace dukat
 	class Renderer2 : public Renderer
 	{
 	public:
-		static constexpr auto max_particles = 2048;
+		// Initial number of particles per frame; the particle buffer grows as needed.
+		static constexpr auto initial_particle_capacity = 2048;
+		// Initial number of batched sprites per frame; the instance buffer grows as needed.
+		static constexpr auto initial_sprite_capacity = 1024;
 		static constexpr auto max_lights = 24;
 #if OPENGL_VERSION <= 30
 		static constexpr auto u_cam_dimension = "u_cam_dimension";
@@ -56,7 +60,8 @@ namespace dukat
 		std::unique_ptr<Camera2> camera;
 		// Buffers for sprite and particle rendering shared by al layers.
 		std::unique_ptr<VertexBuffer> sprite_buffer;
-		std::unique_ptr<VertexBuffer> particle_buffer;
+		std::unique_ptr<StreamBuffer> sprite_instance_buffer;
+		std::unique_ptr<StreamBuffer> particle_buffer;
 		// Framebuffer used to render layers. Dimension based on camera.
 		std::unique_ptr<FrameBuffer> frame_buffer;
 		// Framebuffer that matches final screen. Used for post fx.
@@ -74,6 +79,8 @@ namespace dukat
 		std::array<Light2, max_lights> lights;
 		// Render flags
 		int render_flags;
+		// Optional scheduler used to cull sprites in parallel
+		JobScheduler* scheduler;
 
 		void initialize_sprite_buffers(void);
 		void initialize_particle_buffers(void);
@@ -118,6 +125,9 @@ namespace dukat
 		Light2* get_light(int idx) { assert((idx >= 0) && (idx < max_lights)); return &lights[idx]; }
 		// Updates program used to composite final image to screen.
 		void set_composite_program(ShaderProgram* composite_program, std::function<void(ShaderProgram*)> composite_binder = nullptr);
+		// Assigns scheduler used to spread work across cores.
+		void set_scheduler(JobScheduler* scheduler) { this->scheduler = scheduler; }
+		JobScheduler* get_scheduler(void) const { return scheduler; }
 		// Copies screenbuffer to surface.
 		std::unique_ptr<Surface> copy_screen_buffer(void);
 
@@ -12,6 +12,7 @@
 #include "effect3.h"
 #include "light.h"
 #include "renderer.h"
+#include "renderqueue3.h"
 #include "texturecache.h"
 #include "buffers.h"
 
@@ -59,6 +60,8 @@ namespace dukat
 		// Quad to composite final image onto
 		std::unique_ptr<MeshData> quad;
 		ShaderProgram* composite_program;
+		// Draw items of the current frame
+		RenderQueue3 queue;
 		
 		void init_lights(void);
 		void switch_fbo(void);
@@ -68,6 +71,8 @@ namespace dukat
 		Renderer3(Window* window, ShaderCache* shaders, TextureCache* textures);
 		~Renderer3(void) { }
 
+		// Renders visible meshes. Mesh instances and mesh groups are drawn through a render 
+		// queue, which sorts and batches them.
 		void render(const std::vector<Mesh*>& meshes);
 		// Updates uniform buffers for camera and lighting.
 		void update_uniforms(void);
@@ -1,10 +1,8 @@
 #pragma once
 
-#include <deque>
 #include <memory>
 #include <string>
 #include <vector>
-#include <queue>
 
 #ifndef OPENGL_VERSION
 #include "version.h"
@@ -12,6 +10,8 @@
 
 #include "bit.h"
 #include "color.h"
+#include "loosegrid2.h"
+#include "radixsort.h"
 #include "sprite.h"
 #include "renderer.h"
 
@@ -20,12 +20,17 @@ namespace dukat
 	class AABB2;
 	class Camera2;
 	class Effect2;
+	class JobScheduler;
 	class Matrix4;
 	struct Particle;
+	struct ParticleStore;
 	class Renderer2;
 	class ShaderCache;
 	class ShaderProgram;
+	struct StreamBuffer;
 	class TextMeshInstance;
+	struct SpriteInstance;
+	struct Vertex2PSRC;
 	struct VertexBuffer;
 
 	class RenderLayer2
@@ -38,7 +43,8 @@ namespace dukat
 			RenderFx = 4,	// Render effects
 			RenderSprites = 8,	// Render sprites
 			RenderParticles = 16,	// Render particles
-			RenderText = 32	// Render text
+			RenderText = 32,	// Render text
+			RetainOrder = 64	// Keep sprite order between frames, sorting only when sprites change
 		};
 
 	private:
@@ -48,21 +54,87 @@ namespace dukat
 		std::function<void(ShaderProgram*)> composite_binder;
 		std::unique_ptr<Texture> render_target;
 		VertexBuffer* sprite_buffer;
-		VertexBuffer* particle_buffer;
+		StreamBuffer* sprite_instance_buffer;
+		StreamBuffer* particle_buffer;
 		std::vector<std::unique_ptr<Effect2>> effects;
 		std::vector<Sprite*> sprites;
-		std::deque<Particle*> particles;
+		// Visibility of each sprite when culled in parallel
+		std::vector<uint8_t> sprite_visible;
+		// Visible sprites in render order
+		std::vector<Sprite*> sprite_queue;
+		// Sort keys of all dynamic sprites if order is retained
+		std::vector<SortItem<Sprite*>> sprite_keys;
+		// Sort keys of visible sprites
+		std::vector<SortItem<Sprite*>> visible_keys;
+		std::vector<SortItem<Sprite*>> sprite_scratch;
+		// All dynamic sprites in render order if order is retained
+		std::vector<Sprite*> sorted_sprites;
+		// Set if dynamic sprites were added or removed since last sort
+		bool sprites_changed;
+		// Sequence number assigned to the next renderable added to this layer
+		uint32_t next_order;
+		// Sprites which rarely move, indexed by their bounding box
+		LooseGrid2<Sprite> static_sprites;
+		// Visible static sprites
+		std::vector<Sprite*> static_queue;
+		std::vector<Sprite*> merged_queue;
+		// Consecutive batched sprites sharing a texture
+		struct SpriteRun
+		{
+			TextureId texture_id;
+			int count;
+		};
+		std::vector<SpriteRun> sprite_runs;
+		std::vector<Particle*> particles;
+		// Packed particle stores targeting this layer
+		std::vector<ParticleStore*> particle_stores;
 		std::vector<TextMeshInstance*> texts;
+		// Set if texts were removed since they were last put in order
+		bool texts_changed;
 		int render_flags;
 
-		// Fills up priority queue with visible sprites.
-		void fill_sprite_queue(const AABB2& camera_bb, std::function<bool(Sprite*)> predicate,
-			std::priority_queue<Sprite*, std::deque<Sprite*>, SpriteComparator<Sprite*>>& queue);
+		// Sprite count above which sprites are culled in parallel
+		static constexpr std::size_t parallel_cull_threshold = 1024;
+		// Cell size of static sprite index
+		static constexpr float static_cell_size = 256.0f;
+
+		// Returns true if sprite passes predicate and overlaps with camera.
+		bool is_sprite_visible(Sprite* sprite, const AABB2& camera_bb, const std::function<bool(Sprite*)>& predicate) const;
+		// Returns key which orders sprites by depth, then texture.
+		static uint64_t sprite_key(const Sprite& sprite) { return (static_cast<uint64_t>(sortable_float(sprite.z)) << 32) | sprite.texture_id; }
+		// Returns sequence number used to order sprites with the same key.
+		static uint32_t sprite_order(Sprite* sprite) { return sprite->layer_slot.order; }
+		// Returns true if a is rendered before b. Sprites with the same key are rendered in the order they were added.
+		static bool sprite_before(const Sprite* a, const Sprite* b);
+		// Appends visible sprites from source to queue, preserving their order. If a scheduler is provided, 
+		// large layers will be culled in parallel; in this case predicate may be called concurrently.
+		void cull_sprites(JobScheduler* scheduler, const std::vector<Sprite*>& source, const AABB2& camera_bb, 
+			const std::function<bool(Sprite*)>& predicate, std::vector<Sprite*>& queue);
+		// Sorts all dynamic sprites unless they are still in order from the previous frame.
+		void update_sorted_sprites(void);
+		// Sorts a list of sprites by key.
+		void sort_sprites(std::vector<Sprite*>& list);
+		// Appends visible static sprites to queue.
+		void query_static_sprites(const AABB2& camera_bb, const std::function<bool(Sprite*)>& predicate, std::vector<Sprite*>& queue);
+		// Fills queue with visible sprites in render order.
+		void fill_sprite_queue(JobScheduler* scheduler, const AABB2& camera_bb, std::function<bool(Sprite*)> predicate,
+			std::vector<Sprite*>& queue);
+		// Draws queued sprites one at a time.
+		void render_sprite_list(Renderer2* renderer, const std::vector<Sprite*>& queue);
+		// Draws queued sprites with one instanced draw call per texture. Requires a sprite program with instance attributes.
+		void render_sprite_batches(Renderer2* renderer, const std::vector<Sprite*>& queue);
 		void bind_sprite_buffers(GLint pos_id, GLint uv_id);
 		void unbind_sprite_buffers(GLint pos_id, GLint uv_id);
+		// Returns sprite position adjusted for alignment and relative addressing.
+		Vector2 compute_sprite_position(const Sprite& sprite, const Vector2& camera_position) const;
 		// Generates sprite model matrix.
 		void compute_model_matrix(const Sprite& sprite, const Vector2& camera_position, float camera_mag, Matrix4& mat_model);
-		std::size_t fill_particle_queue(Camera2* cam, const AABB2& camera_bb);
+		// Generates instance attributes equivalent to the sprite model matrix.
+		void compute_instance(const Sprite& sprite, const Vector2& camera_position, float camera_mag, SpriteInstance& instance);
+		// Returns upper bound for the number of particles rendered this frame.
+		std::size_t max_particle_count(void) const;
+		// Writes vertices of visible particles to buffer and returns their count.
+		std::size_t fill_particle_queue(Camera2* cam, const AABB2& camera_bb, Vertex2PSRC* buffer);
 
 	public:
 		const std::string id;
@@ -72,21 +144,37 @@ namespace dukat
 		const float priority;	
 
 		// Constructor
-		RenderLayer2(ShaderCache* shader_cache, VertexBuffer* sprite_buffer, VertexBuffer* particle_buffer,
-			const std::string& id, float priority, float parallax = 1.0f);
+		RenderLayer2(ShaderCache* shader_cache, VertexBuffer* sprite_buffer, StreamBuffer* sprite_instance_buffer, 
+			StreamBuffer* particle_buffer, const std::string& id, float priority, float parallax = 1.0f);
 		~RenderLayer2(void);
 
 		bool has_effects(void) const { return !effects.empty(); }
-		bool has_sprites(void) const { return !sprites.empty(); }
-		bool has_particles(void) const { return !particles.empty(); }
+		bool has_sprites(void) const { return !sprites.empty() || !static_sprites.empty(); }
+		bool has_particles(void) const;
 		bool has_text(void) const { return !texts.empty(); }
 
 		Effect2* add(std::unique_ptr<Effect2> fx);
 		void remove(Effect2* fx);
+		// Sprites, particles and texts can only be part of one layer at a time; adding
+		// one to a layer removes it from its previous layer and logs a warning, so a
+		// renderable can no longer be shared between layers. Adding and removing takes
+		// constant time, since each renderable keeps track of its slot in the layer.
 		void add(Sprite* sprite);
+		void add(const std::vector<Sprite*>& list);
+		// Adds a sprite which rarely moves. Static sprites are culled through a spatial index;
+		// update_static has to be called whenever a static sprite moves or changes its size.
+		void add_static(Sprite* sprite);
+		void add_static(const std::vector<Sprite*>& list);
+		void update_static(Sprite* sprite);
+		// Removes dynamic or static sprite.
 		void remove(Sprite* sprite);
+		void remove(const std::vector<Sprite*>& list);
 		void add(Particle* p);
+		void add(const std::vector<Particle*>& list);
 		void remove(Particle* p);
+		void remove(const std::vector<Particle*>& list);
+		void add(ParticleStore* store);
+		void remove(ParticleStore* store);
 		void add(TextMeshInstance* text);
 		void remove(TextMeshInstance* text);
 		
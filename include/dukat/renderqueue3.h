@@ -0,0 +1,110 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <robin_hood.h>
+
+#ifndef OPENGL_VERSION
+#include "version.h"
+#endif // !OPENGL_VERSION
+
+#include "aabb3.h"
+#include "matrix4.h"
+#include "radixsort.h"
+#include "renderer.h"
+
+namespace dukat
+{
+	// forward declarations
+	class Camera3;
+	class Frustum;
+	class Mesh;
+	class MeshInstance;
+	class Renderer3;
+	struct StreamBuffer;
+
+	// Collects draw items from the meshes rendered during a frame and submits them with as
+	// few state changes as possible. Within the scene stage, items are sorted by program,
+	// texture set, mesh data, material and front-to-back depth. Items with translucent
+	// materials are drawn after opaque ones, back to front. Meshes which render themselves
+	// are drawn in the order they were added, and items are never moved across them. The
+	// overlay stage keeps the order in which items were added.
+	//
+	// Scene items with bounds which have not been tested by their mesh already are culled
+	// against the camera frustum in a single pass before sorting.
+	//
+	// Consecutive items sharing mesh data, program, textures and material values form a run.
+	// If the program declares the per-instance attribute a_model, runs are drawn instanced.
+	class RenderQueue3
+	{
+	public:
+		static constexpr int initial_instance_capacity = 256;
+		// Per-instance model matrix
+		static constexpr const char* at_model = "a_model";
+
+	private:
+		struct DrawItem
+		{
+			Mesh* mesh; // Set for meshes which render themselves
+			MeshInstance* instance;
+			Matrix4 model; // Combined model matrix of instance
+			RenderStage stage;
+			uint32_t segment;
+			uint32_t program;
+			uint32_t textures;
+			uint32_t data;
+			uint32_t material;
+			bool translucent;
+		};
+
+		const Camera3* camera;
+		// Combined projection and view matrix of camera
+		Matrix4 clip;
+		std::vector<DrawItem> items;
+		// World space boxes of items which still have to be culled, and their indices
+		std::vector<AABB3> bounds;
+		std::vector<uint32_t> bounded;
+		std::vector<uint8_t> visible;
+		std::vector<SortItem<uint32_t>> order;
+		std::vector<SortItem<uint32_t>> scratch;
+		// Ordinals of programs, texture sets and mesh data added during this frame
+		robin_hood::unordered_flat_map<uint64_t, uint32_t> programs;
+		robin_hood::unordered_flat_map<uint64_t, uint32_t> texture_sets;
+		robin_hood::unordered_flat_map<uint64_t, uint32_t> mesh_data;
+		// Incremented around each mesh which renders itself
+		uint32_t segment;
+#if (OPENGL_CORE >= 33) || (OPENGL_ES >= 30)
+		std::unique_ptr<StreamBuffer> instance_buffer;
+#endif
+
+		static uint32_t ordinal(robin_hood::unordered_flat_map<uint64_t, uint32_t>& ordinals, uint64_t key);
+		static bool same_run(const MeshInstance* a, const MeshInstance* b);
+		uint64_t sort_key(const DrawItem& item, const Vector3& cam_pos, const Vector3& cam_dir, float far_clip) const;
+		void render_run(Renderer3* renderer, std::size_t first, std::size_t last);
+		void cull(void);
+
+	public:
+		RenderQueue3(void);
+		~RenderQueue3(void);
+
+		// Removes all items. Called at the start of each frame.
+		void clear(void);
+		// Sets camera used to cull and sort items. Has to be called before adding items.
+		void set_camera(const Camera3* camera);
+		// Computes the camera frustum in the space of a model matrix.
+		void get_frustum(const Matrix4& model, Frustum& frustum) const;
+		// Adds the draw items of a mesh.
+		void add(Mesh* mesh);
+		// Adds a mesh instance using a combined model matrix. Scene items are culled unless
+		// the caller has already tested them against the camera frustum.
+		void add(MeshInstance* instance, const Matrix4& model, RenderStage stage, bool culled = false);
+		// Culls and sorts items.
+		void sort(void);
+		// Renders all items of a stage in sort order.
+		void render(Renderer3* renderer, RenderStage stage);
+		// Has to be called once at the end of each frame.
+		void next_frame(void);
+		// Number of items added this frame.
+		std::size_t size(void) const { return items.size(); }
+	};
+}
\ No newline at end of file
@@ -63,6 +63,13 @@ namespace dukat
 		static constexpr auto logging_output = "logging.output";
 		static constexpr auto logging_truncate = "logging.truncate";
 
+		// profiler
+		static constexpr auto profiler_frames = "profiler.frames";
+
+		// frame report
+		static constexpr auto report_frames = "report.frames";
+		static constexpr auto report_file = "report.file";
+
 		// renderer
 		static constexpr auto renderer_effects_enabled = "renderer.effects.enabled";
 
@@ -74,6 +81,9 @@ namespace dukat
 		static constexpr auto resources_shaders = "resources.shaders";
 		static constexpr auto resources_textures = "resources.textures";
 
+		// system
+		static constexpr auto system_workers = "system.workers";
+
 		// update
 		static constexpr auto update_url = "update.url";
 		static constexpr auto update_dir = "update.dir";
@@ -1,6 +1,8 @@
 #pragma once
 
+#include <cstring>
 #include <string>
+#include <vector>
 #include <robin_hood.h>
 
 #include "matrix4.h"
@@ -9,12 +11,63 @@
 
 namespace dukat
 {
+	// Computes 64-bit FNV-1a hash of a shader attribute or uniform name.
+	constexpr uint64_t hash_shader_var(const char* name)
+	{
+		uint64_t hash = 0xcbf29ce484222325ull;
+		while (*name != 0)
+			hash = (hash ^ static_cast<uint8_t>(*name++)) * 0x100000001b3ull;
+		return hash;
+	}
+
+	// Identifies a shader attribute or uniform by the hash of its name. The hash of a
+	// constant name can be computed at compile time by declaring a constexpr ShaderVar.
+	struct ShaderVar
+	{
+		uint64_t hash;
+
+		constexpr ShaderVar(const char* name) : hash(hash_shader_var(name)) { }
+		ShaderVar(const std::string& name) : hash(hash_shader_var(name.c_str())) { }
+	};
+
 	class ShaderProgram
 	{
 	private:
-		robin_hood::unordered_map<std::string,GLint> attributes;
+		// Last value set for a uniform, stored as raw 32-bit words.
+		struct UniformValue
+		{
+			uint32_t offset;	// Offset into values
+			uint32_t words;		// Number of words, 0 if the uniform is not cached
+			bool valid;			// Set once a value has been stored
+		};
+		// Uniforms at locations above this limit are not cached
+		static constexpr GLint max_cached_location = 1024;
+
+		// Locations of attributes and uniforms by name hash
+		robin_hood::unordered_flat_map<uint64_t, GLint> locations;
 		robin_hood::unordered_map<std::string,GLuint> uniforms;
+		// Cached uniform values by location
+		std::vector<UniformValue> cached;
+		std::vector<uint32_t> values;
+
 		void index_attributes(void);
+		void add_location(const char* name, GLint location);
+		// Returns false if the value matches the last value set for a uniform.
+		// Otherwise, stores the value and returns true.
+		inline bool changed(GLint location, const void* data, uint32_t words)
+		{
+			if (location < 0)
+				return false; // GL ignores updates of unknown uniforms
+			if (location >= static_cast<GLint>(cached.size()) || cached[location].words != words)
+				return true;
+			auto& v = cached[location];
+			auto dst = values.data() + v.offset;
+			if (v.valid && std::memcmp(dst, data, words * sizeof(uint32_t)) == 0)
+				return false;
+			std::memcpy(dst, data, words * sizeof(uint32_t));
+			v.valid = true;
+			return true;
+		}
 
 	public:
 		GLuint id;
@@ -25,20 +78,33 @@ namespace dukat
 		ShaderProgram(GLuint id, const std::string& vertex_file, const std::string& fragment_file, const std::string& geometry_file);
 		~ShaderProgram(void);
 
-		GLint attr(const std::string& name);
-		inline void set(const std::string& name, GLfloat val0) { assert(attributes.count(name) > 0); glUniform1f(attributes.at(name), val0); }
-		inline void set(const std::string& name, GLfloat val0, GLfloat val1) { assert(attributes.count(name) > 0); glUniform2f(attributes.at(name), val0, val1); }
-		inline void set(const std::string& name, GLfloat val0, GLfloat val1, GLfloat val2) { assert(attributes.count(name) > 0); glUniform3f(attributes.at(name), val0, val1, val2); }
-		inline void set(const std::string& name, GLfloat val0, GLfloat val1, GLfloat val2, GLfloat val3) { assert(attributes.count(name) > 0); glUniform4f(attributes.at(name), val0, val1, val2, val3); }
-		inline void set(const std::string& name, GLfloat* val) { assert(attributes.count(name) > 0); glUniform4fv(attributes.at(name), 1, val); }
-		inline void set(GLint index, GLfloat val0) { glUniform1f(index, val0); }
-		inline void set(GLint index, GLfloat val0, GLfloat val1) { glUniform2f(index, val0, val1); }
-		inline void set(GLint index, GLfloat val0, GLfloat val1, GLfloat val2) { glUniform3f(index, val0, val1, val2); }
-		inline void set(GLint index, GLfloat val0, GLfloat val1, GLfloat val2, GLfloat val3) { glUniform4f(index, val0, val1, val2, val3); }
-		inline void set(GLint index, GLfloat* val) { glUniform4fv(index, 1, val); }
-		inline void set_vector3(const std::string& name, const Vector3& v) { assert(attributes.count(name) > 0); glUniform4f(attributes.at(name), v.x, v.y, v.z, v.w); }
-		inline void set_matrix4(const std::string& name, const Matrix4& matrix) { assert(attributes.count(name) > 0); glUniformMatrix4fv(attributes.at(name), 1, false, matrix.m); }
-		inline void set_matrix4(const std::string& name, GLfloat* matrix) { assert(attributes.count(name) > 0); glUniformMatrix4fv(attributes.at(name), 1, false, matrix); }
+		// Replaces the program object after it has been rebuilt.
+		void reset(GLuint id);
+		// Forgets cached uniform values. Has to be called after setting uniforms of this
+		// program through glUniform* directly.
+		void invalidate(void);
+
+		// Returns location of an attribute or uniform, or -1 if the program does not use it.
+		inline GLint attr(ShaderVar var) const { auto it = locations.find(var.hash); return it == locations.end() ? -1 : it->second; }
+
+		// Uniform setters skip the GL call if the uniform already has the provided value.
+		// The program has to be active when calling them.
+		inline void set(ShaderVar var, GLfloat val0) { set(attr(var), val0); }
+		inline void set(ShaderVar var, GLfloat val0, GLfloat val1) { set(attr(var), val0, val1); }
+		inline void set(ShaderVar var, GLfloat val0, GLfloat val1, GLfloat val2) { set(attr(var), val0, val1, val2); }
+		inline void set(ShaderVar var, GLfloat val0, GLfloat val1, GLfloat val2, GLfloat val3) { set(attr(var), val0, val1, val2, val3); }
+		inline void set(ShaderVar var, const GLfloat* val) { set(attr(var), val); }
+		inline void set(GLint index, GLfloat val0) { if (changed(index, &val0, 1)) glUniform1f(index, val0); }
+		inline void set(GLint index, GLfloat val0, GLfloat val1) { const GLfloat val[] = { val0, val1 }; if (changed(index, val, 2)) glUniform2f(index, val0, val1); }
+		inline void set(GLint index, GLfloat val0, GLfloat val1, GLfloat val2) { const GLfloat val[] = { val0, val1, val2 }; if (changed(index, val, 3)) glUniform3f(index, val0, val1, val2); }
+		inline void set(GLint index, GLfloat val0, GLfloat val1, GLfloat val2, GLfloat val3) { const GLfloat val[] = { val0, val1, val2, val3 }; if (changed(index, val, 4)) glUniform4f(index, val0, val1, val2, val3); }
+		inline void set(GLint index, const GLfloat* val) { if (changed(index, val, 4)) glUniform4fv(index, 1, val); }
+		inline void set_int(ShaderVar var, GLint val) { set_int(attr(var), val); }
+		inline void set_int(GLint index, GLint val) { if (changed(index, &val, 1)) glUniform1i(index, val); }
+		inline void set_vector3(ShaderVar var, const Vector3& v) { set(attr(var), v.x, v.y, v.z, v.w); }
+		inline void set_matrix4(ShaderVar var, const Matrix4& matrix) { set_matrix4(attr(var), matrix.m); }
+		inline void set_matrix4(ShaderVar var, const GLfloat* matrix) { set_matrix4(attr(var), matrix); }
+		inline void set_matrix4(GLint index, const GLfloat* matrix) { if (changed(index, matrix, 16)) glUniformMatrix4fv(index, 1, false, matrix); }
 		// Binds a named uniform buffer. Returns true if the operation was successful.
 		bool bind(const std::string& block_name, GLuint block_binding);
 	};
@@ -3,6 +3,7 @@
 #include <memory>
 #include "aabb2.h"
 #include "color.h"
+#include "layerslot.h"
 #include "memorypool.h"
 #include "texturecache.h"
 #include "vector2.h"
@@ -48,6 +49,8 @@ namespace dukat
 		int index;
 		// Sprite flags
 		uint8_t flags;
+		// Membership in render layer
+		LayerSlot layer_slot;
 
 		// Default constructor
 		Sprite(void) : cols(1), rows(1), p(0, 0), z(0), w(0), h(0), custom(), tex(), scale(1), 
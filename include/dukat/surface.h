@@ -1,6 +1,7 @@
 #pragma once
 
 #include "color.h"
+#include "pixelops.h"
 #include "rect.h"
 
 namespace dukat
@@ -13,6 +14,9 @@ namespace dukat
 	 * convert individual pixels from / to 32-bit RGBA integers.
 	 * Finally, individual color values can also be accessed regardless of the 
 	 * underlying bit depth via the `get_color` and `set_color` methods.
+	 *
+	 * Bulk operations work on whole rows through the typed view returned by `pixels`,
+	 * and can be split into tiles processed by a job scheduler.
 	 */
 	class Surface
 	{
@@ -52,10 +56,18 @@ namespace dukat
 		void read(int x, int y, uint8_t& c) const;
 		void write(int x, int y, uint8_t c);
 
-		// Replaces a specific color with another.
-		void replace(const Color& src_color, const Color& dest_color);
-		/// Replaces each source color with corresponding destination color.
-		void replace(const std::vector<Color>& src_colors, const std::vector<Color>& dest_colors);
+		// Returns typed view of all pixels. T has to match the number of bytes per pixel.
+		template<typename T>
+		PixelRect<T> pixels(void) const
+		{
+			assert(sizeof(T) == surface->format->BytesPerPixel);
+			return PixelRect<T>{ static_cast<uint8_t*>(surface->pixels), surface->w, surface->h, surface->pitch };
+		}
+
+		// Replaces a specific color with another. Only supports 32 bit surfaces.
+		void replace(const Color& src_color, const Color& dest_color, JobScheduler* scheduler = nullptr);
+		/// Replaces each source color with corresponding destination color. Only supports 32 bit surfaces.
+		void replace(const std::vector<Color>& src_colors, const std::vector<Color>& dest_colors, JobScheduler* scheduler = nullptr);
 
 		// Returns raw color value for this surface for a given color.
 		inline uint32_t raw_color(uint8_t r, uint8_t g, uint8_t b, uint8_t a = 0xff) const { return SDL_MapRGBA(surface->format, r, g, b, a); }
@@ -73,8 +85,23 @@ namespace dukat
 
 		// Applies a transformation to each pixel of the surface. Only supports 32 bit surfaces.
 		void apply(const std::function<void(int x, int y, SDL_Surface* s, uint32_t& p)>& f);
+		// Calls fn(x, y, row, count) for runs of count pixels starting at x, y. Runs are
+		// processed in parallel if a scheduler is provided. Only supports 32 bit surfaces.
+		template<class Fn>
+		void apply_rows(const Fn& fn, JobScheduler* scheduler = nullptr);
+		// Number of rows per tile used by bulk operations
+		static constexpr int tile_rows = 64;
 	};
 
+	template<class Fn>
+	void Surface::apply_rows(const Fn& fn, JobScheduler* scheduler)
+	{
+		for_each_tile(pixels<uint32_t>(), 0, tile_rows, scheduler, [&fn](const PixelRect<uint32_t>& tile, int x, int y) {
+			for (auto i = 0; i < tile.height; i++)
+				fn(x, y + i, tile.row(i), tile.width);
+		});
+	}
+
 	// Creates a new surface for an image file.
 	std::unique_ptr<Surface> load_surface(const std::string& filename);
 	void save_surface(const Surface&, const std::string& filename);
@@ -0,0 +1,273 @@
+#pragma once
+
+#include <robin_hood.h>
+#include "broadphase2.h"
+
+namespace dukat
+{
+	// Broadphase which keeps the extents of all values along the x-axis in a sorted
+	// list. Only endpoints of values whose bounding box changed are refreshed, and the
+	// list is updated incrementally with an insertion sort, which is close to linear as
+	// long as values move little between updates.
+	template<class T>
+	class SweepPruneBroadphase2 : public Broadphase2<T>
+	{
+	public:
+		typedef typename Broadphase2<T>::Pair Pair;
+
+	private:
+		// Number of new endpoints above which the list is fully sorted
+		static constexpr std::size_t max_insertions = 64;
+
+		struct Proxy
+		{
+			T* value;
+			AABB2 bb; // bounding box as of last update
+			bool in_list;
+			bool dirty; // bounding box changed during last update
+		};
+
+		struct Endpoint
+		{
+			float value;
+			int proxy;
+			bool is_min;
+
+			// Orders minimum before maximum endpoints, so that touching boxes overlap.
+			bool operator<(const Endpoint& e) const { return value < e.value || (value == e.value && is_min && !e.is_min); }
+		};
+
+		std::vector<Proxy> proxies;
+		std::vector<int> free_proxies;
+		// Removed proxies which still have endpoints in the list
+		std::vector<int> stale_proxies;
+		robin_hood::unordered_map<T*, int> index;
+		std::vector<Endpoint> endpoints;
+		// Largest extent of any value along the x-axis
+		float max_extent;
+		// True if endpoints of removed or deactivated proxies need to be purged
+		bool has_stale;
+
+	public:
+		SweepPruneBroadphase2(void) : max_extent(0.0f), has_stale(false) { }
+		~SweepPruneBroadphase2(void) { }
+
+		void insert(T* value);
+		void remove(T* value);
+		void clear(void);
+		void update(void);
+
+		void collect_pairs(std::vector<Pair>& pairs) const;
+		void query(const AABB2& bb, std::vector<T*>& res) const;
+		void query(const Ray2& ray, float min_t, float max_t, std::vector<T*>& res) const;
+	};
+
+	template<class T>
+	constexpr std::size_t SweepPruneBroadphase2<T>::max_insertions;
+
+	template<class T>
+	void SweepPruneBroadphase2<T>::insert(T* value)
+	{
+		int idx;
+		if (free_proxies.empty())
+		{
+			idx = static_cast<int>(proxies.size());
+			proxies.emplace_back();
+		}
+		else
+		{
+			idx = free_proxies.back();
+			free_proxies.pop_back();
+		}
+		proxies[idx].value = value;
+		proxies[idx].in_list = false;
+		proxies[idx].dirty = false;
+		index[value] = idx;
+	}
+
+	template<class T>
+	void SweepPruneBroadphase2<T>::remove(T* value)
+	{
+		auto it = index.find(value);
+		if (it == index.end())
+			return;
+		const auto idx = it->second;
+		index.erase(it);
+		auto& p = proxies[idx];
+		p.value = nullptr;
+		if (p.in_list)
+		{
+			// slot is reused once endpoints have been purged during next update
+			p.in_list = false;
+			stale_proxies.push_back(idx);
+			has_stale = true;
+		}
+		else
+		{
+			free_proxies.push_back(idx);
+		}
+	}
+
+	template<class T>
+	void SweepPruneBroadphase2<T>::clear(void)
+	{
+		proxies.clear();
+		free_proxies.clear();
+		stale_proxies.clear();
+		index.clear();
+		endpoints.clear();
+		max_extent = 0.0f;
+		has_stale = false;
+	}
+
+	template<class T>
+	void SweepPruneBroadphase2<T>::update(void)
+	{
+		// Add newly activated values to the end of the list, and flag deactivated ones
+		const auto count = static_cast<int>(proxies.size());
+		auto added = 0u;
+		for (auto i = 0; i < count; i++)
+		{
+			auto& p = proxies[i];
+			if (p.value == nullptr)
+				continue;
+			if (p.value->active && !p.in_list)
+			{
+				p.in_list = true;
+				p.bb = p.value->bb;
+				p.dirty = true;
+				endpoints.push_back(Endpoint{ 0.0f, i, true });
+				endpoints.push_back(Endpoint{ 0.0f, i, false });
+				added += 2;
+			}
+			else if (!p.value->active && p.in_list)
+			{
+				p.in_list = false;
+				has_stale = true;
+			}
+		}
+
+		// Purge endpoints of proxies which have been removed or deactivated
+		auto max_shrunk = has_stale;
+		if (has_stale)
+		{
+			endpoints.erase(std::remove_if(endpoints.begin(), endpoints.end(),
+				[&](const Endpoint& e) { return !proxies[e.proxy].in_list; }), endpoints.end());
+			free_proxies.insert(free_proxies.end(), stale_proxies.begin(), stale_proxies.end());
+			stale_proxies.clear();
+			has_stale = false;
+		}
+
+		// Refresh cached boxes of proxies which have moved
+		auto moved = added > 0;
+		for (auto& p : proxies)
+		{
+			if (!p.in_list)
+				continue;
+			if (!p.dirty && bb_equal(p.bb, p.value->bb))
+				continue;
+			const auto prev_extent = p.bb.max().x - p.bb.min().x;
+			p.bb = p.value->bb;
+			p.dirty = true;
+			moved = true;
+			const auto extent = p.bb.max().x - p.bb.min().x;
+			if (extent >= max_extent)
+				max_extent = extent;
+			else if (prev_extent >= max_extent)
+				max_shrunk = true;
+		}
+		if (max_shrunk)
+		{
+			max_extent = 0.0f;
+			for (const auto& p : proxies)
+			{
+				if (p.in_list)
+					max_extent = std::max(max_extent, p.bb.max().x - p.bb.min().x);
+			}
+		}
+		if (!moved)
+			return; // list is still sorted
+
+		for (auto& e : endpoints)
+		{
+			const auto& p = proxies[e.proxy];
+			if (p.dirty)
+				e.value = e.is_min ? p.bb.min().x : p.bb.max().x;
+		}
+		for (auto& p : proxies)
+			p.dirty = false;
+
+		if (added > max_insertions)
+		{
+			std::sort(endpoints.begin(), endpoints.end());
+		}
+		else
+		{
+			// Insertion sort takes advantage of order from previous frame
+			const auto n = endpoints.size();
+			for (auto i = 1u; i < n; i++)
+			{
+				const auto e = endpoints[i];
+				auto j = i;
+				for (; j > 0 && e < endpoints[j - 1]; j--)
+					endpoints[j] = endpoints[j - 1];
+				endpoints[j] = e;
+			}
+		}
+	}
+
+	template<class T>
+	void SweepPruneBroadphase2<T>::collect_pairs(std::vector<Pair>& pairs) const
+	{
+		// For each proxy, test all proxies starting between its own endpoints
+		const auto n = endpoints.size();
+		for (auto i = 0u; i < n; i++)
+		{
+			const auto& e = endpoints[i];
+			const auto& a = proxies[e.proxy];
+			if (!e.is_min || !a.in_list)
+				continue;
+
+			for (auto j = i + 1; j < n && endpoints[j].proxy != e.proxy; j++)
+			{
+				const auto& b = proxies[endpoints[j].proxy];
+				if (!endpoints[j].is_min || !b.in_list)
+					continue;
+				if (a.bb.min().y <= b.bb.max().y && a.bb.max().y >= b.bb.min().y)
+					pairs.emplace_back(a.value, b.value);
+			}
+		}
+	}
+
+	template<class T>
+	void SweepPruneBroadphase2<T>::query(const AABB2& bb, std::vector<T*>& res) const
+	{
+		// Any overlapping proxy has to start within max extent of the query
+		const Endpoint first{ bb.min().x - max_extent, 0, true };
+		auto it = std::lower_bound(endpoints.begin(), endpoints.end(), first);
+		for (; it != endpoints.end() && it->value <= bb.max().x; ++it)
+		{
+			const auto& p = proxies[it->proxy];
+			if (it->is_min && p.in_list && bb_touches(p.bb, bb))
+				res.push_back(p.value);
+		}
+	}
+
+	template<class T>
+	void SweepPruneBroadphase2<T>::query(const Ray2& ray, float min_t, float max_t, std::vector<T*>& res) const
+	{
+		AABB2 bb;
+		if (ray_bounds(ray, min_t, max_t, bb))
+		{
+			query(bb, res);
+			return;
+		}
+
+		// Unbounded ray, report all proxies
+		for (const auto& e : endpoints)
+		{
+			if (e.is_min && proxies[e.proxy].in_list)
+				res.push_back(proxies[e.proxy].value);
+		}
+	}
+}
\ No newline at end of file
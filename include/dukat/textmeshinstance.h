@@ -2,6 +2,7 @@
 
 #include <string>
 #include "bitmapfont.h"
+#include "layerslot.h"
 #include "meshinstance.h"
 
 namespace dukat
@@ -51,6 +52,7 @@ namespace dukat
 	public:
 		Align halign; // Valid values: Center, Left, Right
 		Align valign; // Valid values: Center, Top, Bottom
+		LayerSlot layer_slot; // Membership in render layer
 
 		TextMeshInstance(BitmapFont* font, float yorientation = 1.0f);
 		~TextMeshInstance(void) { }
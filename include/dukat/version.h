@@ -43,4 +43,10 @@
 #define OPENGL_CORE OPENGL_VERSION
 #else
 #define OPENGL_ES OPENGL_VERSION
+#endif
+
+// Define to replace OpenGL with a backend which records calls without rendering.
+// #define DUKAT_NULL_GL
+#ifdef DUKAT_NULL_GL
+#include "nullgl.h"
 #endif
\ No newline at end of file
@@ -40,4 +40,15 @@ namespace dukat
 		GLfloat ry;
 		GLfloat cr, cg, cb, ca;
 	};
+
+	// Per-instance attributes of a batched sprite.
+	struct SpriteInstance
+	{
+		GLfloat px, py;		// position
+		GLfloat sx, sy;		// size including scale
+		GLfloat rc, rs;		// cosine and sine of rotation
+		GLfloat tu, tv, tw, th;	// texture rect
+		GLfloat cr, cg, cb, ca;
+		GLfloat c0, c1;		// custom values
+	};
 }
\ No newline at end of file
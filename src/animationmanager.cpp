@@ -1,5 +1,6 @@
 #include "stdafx.h"
 #include <dukat/animationmanager.h>
+#include <dukat/profiler.h>
 
 namespace dukat
 {
@@ -24,6 +25,7 @@ namespace dukat
 
 	void AnimationManager::update(float delta)
 	{
+		DUKAT_PROFILE_ZONE("AnimationManager::update");
 		for (auto it = animations.begin(); it != animations.end(); )
 		{
 			const auto& a = (*it);
@@ -1,13 +1,18 @@
 #include "stdafx.h"
 #include <dukat/application.h>
 #include <dukat/audiomanager.h>
+#include <dukat/framereport.h>
 #include <dukat/log.h>
+#include <dukat/memorypool.h>
+#include <dukat/nullgl.h>
 #include <dukat/perfcounter.h>
+#include <dukat/profiler.h>
 #include <dukat/sdlutil.h>
 #include <dukat/sysutil.h>
 #include <dukat/window.h>
 #include <dukat/devicemanager.h>
 #include <dukat/inputrecorder.h>
+#include <dukat/jobscheduler.h>
 #include <dukat/keyboarddevice.h>
 #include <dukat/rand.h>
 #include <dukat/settings.h>
@@ -26,6 +31,7 @@ namespace dukat
 	{
 		const auto start = SDL_GetTicks();
 		init_logging(settings);
+		Profiler::set_thread_name("main");
 		log->info("Initializing application from: {}", current_working_directory());
 
 		SDL_version compiled;
@@ -36,6 +42,11 @@ namespace dukat
 			static_cast<int>(compiled.major), static_cast<int>(compiled.minor), static_cast<int>(compiled.patch),
 			static_cast<int>(linked.major), static_cast<int>(linked.minor), static_cast<int>(linked.patch));
 
+#ifdef DUKAT_NULL_GL
+		// Run without display or audio device unless drivers were chosen explicitly
+		SDL_setenv("SDL_VIDEODRIVER", "dummy", 0);
+		SDL_setenv("SDL_AUDIODRIVER", "dummy", 0);
+#endif
 		sdl_check_result(SDL_Init(SDL_INIT_EVERYTHING), "Initialize SDL");
 		window = std::make_unique<Window>(settings);
 		window->set_title(title);
@@ -54,6 +65,9 @@ namespace dukat
 		// Initialize random generator once
 		rand::seed(time(nullptr));
 
+		// Negative value will use one worker per core
+		scheduler = std::make_unique<JobScheduler>(settings.get_int(settings::system_workers, -1));
+
 		device_manager = std::make_unique<DeviceManager>(*window, settings);
 		device_manager->add_keyboard();
 		gl_check_error();
@@ -65,6 +79,7 @@ namespace dukat
 	{
 		// Force release of device manager before call to SDL_Quit
 		device_manager = nullptr;
+		scheduler = nullptr;
 		window = nullptr;
 		// Always show cursor before exiting
 		SDL_ShowCursor(SDL_ENABLE);
@@ -80,8 +95,23 @@ namespace dukat
 #endif
 		float delta;
 		SDL_Event e;
+
+		// Optionally report on a number of frames and exit afterwards
+		std::unique_ptr<FrameReport> report;
+		const auto report_frames = settings.get_int(settings::report_frames, 0);
+		if (report_frames > 0)
+		{
+			report = std::make_unique<FrameReport>(report_frames, settings.get_string(settings::report_file, "frame_report.json"));
+			// Use fixed time step so that runs are reproducible
+			if (fixed_frame_rate <= 0.0f)
+				fixed_frame_rate = 1.0f / 60.0f;
+		}
+
 		while (!done)
 		{
+			Profiler::begin_frame();
+			if (report != nullptr)
+				report->begin_frame();
 			ticks = SDL_GetTicks();
 #ifdef PERF_TRACE
 			start_ticks = SDL_GetPerformanceCounter();
@@ -93,12 +123,14 @@ namespace dukat
 			}
 			else if (fixed_frame_rate > 0.0f)
 			{
+				DUKAT_PROFILE_ZONE("Application::update");
 				delta = fixed_frame_rate;
 				runtime += fixed_frame_rate;
 				update(std::min(fixed_frame_rate, max_frame_delta));
 			}
 			else
 			{
+				DUKAT_PROFILE_ZONE("Application::update");
 				delta = static_cast<float>(ticks - last_update) / 1000.0f;
 				runtime += delta;
 				update(std::min(delta, max_frame_delta));
@@ -114,19 +146,26 @@ namespace dukat
 			}
 
 			// process events
-			while (SDL_PollEvent(&e))
 			{
-				handle_event(e);
+				DUKAT_PROFILE_ZONE("Application::events");
+				while (SDL_PollEvent(&e))
+				{
+					handle_event(e);
+				}
+				device_manager->update(delta);
 			}
-			
-			device_manager->update(delta);
 
 #ifdef PERF_TRACE
 			update_ticks = SDL_GetPerformanceCounter();
 #endif
 
 			// render to screen
-			render();
+			if (report != nullptr)
+				report->begin_render();
+			{
+				DUKAT_PROFILE_ZONE("Application::render");
+				render();
+			}
 
 #ifdef PERF_TRACE
 			render_ticks = SDL_GetPerformanceCounter();
@@ -138,9 +177,22 @@ namespace dukat
 				log->warn("Slow frame: {} [{} {}]", total_time, update_time, render_time);
 #endif
 			perfc.inc(PerformanceCounter::FRAMES);
+			NullGL::end_frame();
+			if (report != nullptr)
+			{
+				report->end_frame();
+				if (report->is_complete())
+				{
+					report->write();
+					done = true;
+				}
+			}
+			MemoryPoolBase::report_stats();
 			perfc.reset();
+			Profiler::end_frame();
 		}
 
+		MemoryPoolBase::log_stats();
 		return 0;
 	}
 
@@ -194,6 +246,13 @@ namespace dukat
 			toggle_pause();
 			break;
 		case SDLK_PRINTSCREEN:
+			if (e.key.keysym.mod & KMOD_CTRL)
+			{
+				std::stringstream ss;
+				ss << "profile_" << std::time(nullptr) << ".json";
+				Profiler::capture(settings.get_int(settings::profiler_frames, 60), ss.str());
+			}
+			else
 			{
 				std::stringstream ss;
 				ss << "screenshot_" << std::time(nullptr) << ".png";
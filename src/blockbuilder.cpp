@@ -1,6 +1,7 @@
 #include "stdafx.h"
 #include <dukat/blockbuilder.h>
 #include <dukat/buffers.h>
+#include <dukat/glstate.h>
 #include <dukat/renderer3.h>
 
 namespace dukat
@@ -59,16 +60,16 @@ namespace dukat
         vertex_buffer.counts[vertex_pos] = get_vertex_count();
         vertex_buffer.strides[vertex_pos] = 2 * sizeof(GLshort);
         auto size = vertex_buffer.counts[vertex_pos] * vertex_buffer.strides[vertex_pos];
-		glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer.buffers[vertex_pos]);
+		glstate.bind_buffer(GL_ARRAY_BUFFER, vertex_buffer.buffers[vertex_pos]);
         glBufferData(GL_ARRAY_BUFFER, size, vertex_data.data(), GL_STATIC_DRAW);
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glstate.bind_buffer(GL_ARRAY_BUFFER, 0);
 
         vertex_buffer.counts[index_pos] = get_index_count();
         vertex_buffer.strides[index_pos] = sizeof(GLushort);
         size = vertex_buffer.counts[index_pos] * vertex_buffer.strides[index_pos];
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, vertex_buffer.buffers[index_pos]);
+        glstate.bind_buffer(GL_ELEMENT_ARRAY_BUFFER, vertex_buffer.buffers[index_pos]);
         glBufferData(GL_ELEMENT_ARRAY_BUFFER, size, index_data.data(), GL_STATIC_DRAW);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+        glstate.bind_buffer(GL_ELEMENT_ARRAY_BUFFER, 0);
     }
 
     std::unique_ptr<MeshData> BlockBuilder::create_mesh(void)
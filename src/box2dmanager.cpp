@@ -1,6 +1,7 @@
 #include "stdafx.h"
 #include <dukat/box2dmanager.h>
 #include <dukat/game2.h>
+#include <dukat/profiler.h>
 #include <dukat/recipient.h>
 
 #ifdef BOX2D_SUPPORT
@@ -20,6 +21,7 @@ namespace dukat
 
 	void Box2DManager::update(float delta)
 	{
+		DUKAT_PROFILE_ZONE("Box2DManager::update");
 		box_world->Step(delta, 6, 2);
 		while (!messages.empty())
 		{
@@ -1,5 +1,8 @@
 #include "stdafx.h"
 #include <dukat/buffers.h>
+#include <dukat/glstate.h>
+#include <dukat/log.h>
+#include <dukat/mathutil.h>
 #include <dukat/perfcounter.h>
 #include <dukat/sysutil.h>
 
@@ -30,22 +33,184 @@
 
 #endif
 
+// Fence sync objects are part of OpenGL 3.2 and OpenGL ES 3.0
+#if (defined(OPENGL_CORE) && OPENGL_CORE >= 32) || (defined(OPENGL_ES) && OPENGL_ES >= 30)
+#define DUKAT_BUFFER_SYNC
+#endif
+
 namespace dukat
 {
 	void VertexBuffer::load_data(int index, GLenum target, int count, GLsizei stride, const GLvoid* data, GLenum usage)
 	{
 		counts[index] = data == nullptr ? 0 : count;
 		strides[index] = stride;
-		glBindBuffer(target, buffers[index]);
+		glstate.bind_buffer(target, buffers[index]);
 		glBufferData(target, count * stride, data, usage);
-		glBindBuffer(target, 0);
+		glstate.bind_buffer(target, 0);
+	}
+
+	StreamBuffer::StreamBuffer(GLsizei stride, int capacity) : buffer(0), stride(stride), capacity(0), 
+		frame(0), offset(0), persistent_data(nullptr)
+	{
+#if OPENGL_VERSION >= 30
+		glGenVertexArrays(1, &vao);
+		for (auto& fence : fences)
+			fence = nullptr;
+#endif
+		allocate(capacity);
+	}
+
+	StreamBuffer::~StreamBuffer(void)
+	{
+		release();
+#if OPENGL_VERSION >= 30
+		glstate.delete_vertex_array(vao);
+#endif
+		perfc.inc(PerformanceCounter::BUFFER_FREE);
+	}
+
+	void StreamBuffer::allocate(int capacity)
+	{
+		this->capacity = capacity;
+		frame = 0;
+		offset = 0;
+
+		const auto size = static_cast<GLsizeiptr>(max_frames) * capacity * stride;
+		glGenBuffers(1, &buffer);
+		glstate.bind_buffer(GL_ARRAY_BUFFER, buffer);
+		// Persistent mappings are only safe if regions can be fenced
+#if defined(DUKAT_BUFFER_SYNC) && defined(OPENGL_CORE)
+		if (GLEW_ARB_buffer_storage)
+		{
+			const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+			glBufferStorage(GL_ARRAY_BUFFER, size, nullptr, flags);
+			persistent_data = static_cast<uint8_t*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, size, flags));
+			if (persistent_data == nullptr)
+			{
+				// storage is immutable, so start over with a regular buffer
+				log->warn("Failed to map stream buffer persistently.");
+				glstate.delete_buffers(1, &buffer);
+				glGenBuffers(1, &buffer);
+				glstate.bind_buffer(GL_ARRAY_BUFFER, buffer);
+			}
+		}
+#endif
+		if (!is_persistent())
+			glBufferData(GL_ARRAY_BUFFER, size, nullptr, GL_STREAM_DRAW);
+		glstate.bind_buffer(GL_ARRAY_BUFFER, 0);
+	}
+
+	void StreamBuffer::release(void)
+	{
+#ifdef DUKAT_BUFFER_SYNC
+		for (auto& fence : fences)
+		{
+			if (fence != nullptr)
+			{
+				glDeleteSync(fence);
+				fence = nullptr;
+			}
+		}
+#endif
+		if (is_persistent())
+		{
+			glstate.bind_buffer(GL_ARRAY_BUFFER, buffer);
+			glUnmapBuffer(GL_ARRAY_BUFFER);
+			glstate.bind_buffer(GL_ARRAY_BUFFER, 0);
+			persistent_data = nullptr;
+		}
+		// Any pending draw calls keep the old buffer alive until they complete.
+		glstate.delete_buffers(1, &buffer);
+		buffer = 0;
+	}
+
+	void* StreamBuffer::map(int count)
+	{
+		assert(count > 0);
+		if (offset + count > capacity)
+		{
+			// Regions are too small - switch to a larger buffer and start over
+			const auto new_capacity = std::max(2 * capacity, next_pow_two(count));
+			log->debug("Resizing stream buffer: {} -> {}", capacity, new_capacity);
+			release();
+			allocate(new_capacity);
+		}
+
+#ifdef DUKAT_BUFFER_SYNC
+		// Before writing to a region for the first time, wait until the GPU
+		// is done with the frame that used it last.
+		auto& fence = fences[frame];
+		if (offset == 0 && fence != nullptr)
+		{
+			auto res = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+			while (res == GL_TIMEOUT_EXPIRED)
+				res = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+			glDeleteSync(fence);
+			fence = nullptr;
+		}
+#endif
+
+		const auto first = frame * capacity + offset;
+		if (is_persistent())
+			return persistent_data + static_cast<std::size_t>(first) * stride;
+
+#if OPENGL_VERSION >= 30
+		glstate.bind_buffer(GL_ARRAY_BUFFER, buffer);
+#ifdef DUKAT_BUFFER_SYNC
+		// Region is protected by a fence, so the driver does not need to synchronize.
+		const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT
+			| GL_MAP_FLUSH_EXPLICIT_BIT | GL_MAP_UNSYNCHRONIZED_BIT;
+#else
+		const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_FLUSH_EXPLICIT_BIT;
+#endif
+		auto res = glMapBufferRange(GL_ARRAY_BUFFER, static_cast<GLintptr>(first) * stride,
+			static_cast<GLsizeiptr>(count) * stride, flags);
+		glstate.bind_buffer(GL_ARRAY_BUFFER, 0);
+		return res;
+#else
+		staging.resize(static_cast<std::size_t>(count) * stride);
+		return staging.data();
+#endif
+	}
+
+	GLint StreamBuffer::unmap(int count)
+	{
+		assert(offset + count <= capacity);
+		const auto first = frame * capacity + offset;
+		if (!is_persistent())
+		{
+			glstate.bind_buffer(GL_ARRAY_BUFFER, buffer);
+#if OPENGL_VERSION >= 30
+			// flush range is relative to start of mapped range
+			if (count > 0)
+				glFlushMappedBufferRange(GL_ARRAY_BUFFER, 0, static_cast<GLsizeiptr>(count) * stride);
+			glUnmapBuffer(GL_ARRAY_BUFFER);
+#else
+			if (count > 0)
+				glBufferSubData(GL_ARRAY_BUFFER, static_cast<GLintptr>(first) * stride, 
+					static_cast<GLsizeiptr>(count) * stride, staging.data());
+#endif
+			glstate.bind_buffer(GL_ARRAY_BUFFER, 0);
+		}
+		offset += count;
+		return first;
+	}
+
+	void StreamBuffer::next_frame(void)
+	{
+#ifdef DUKAT_BUFFER_SYNC
+		if (offset > 0)
+			fences[frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+#endif
+		frame = (frame + 1) % max_frames;
+		offset = 0;
 	}
 
 	FrameBuffer::FrameBuffer(int width, int height, bool create_color_buffer, bool create_depth_buffer, TextureFilterProfile profile)
 		: fbo(0), texture(nullptr), rbo(0), width(width), height(height), profile(profile)
 	{
 		glGenFramebuffers(1, &fbo);
-		glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+		glstate.bind_framebuffer(GL_FRAMEBUFFER, fbo);
 
 		if (create_color_buffer)
 		{
@@ -60,8 +225,8 @@ namespace dukat
 		rebuild();
 
 		glBindRenderbuffer(GL_RENDERBUFFER, 0);
-		glBindTexture(GL_TEXTURE_2D, 0);
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		glstate.bind_texture(GL_TEXTURE_2D, 0);
+		glstate.bind_framebuffer(GL_FRAMEBUFFER, 0);
 #ifdef _DEBUG
 		gl_check_error();
 #endif
@@ -71,7 +236,7 @@ namespace dukat
 	{
 		if (fbo >= 0)
 		{
-			glDeleteFramebuffers(1, &fbo);
+			glstate.delete_framebuffer(fbo);
 			fbo = -1;
 		}
 		if (rbo >= 0)
@@ -126,29 +291,29 @@ namespace dukat
 			texture->h = height;
 		}
 
-		glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+		glstate.bind_framebuffer(GL_FRAMEBUFFER, fbo);
 
 		rebuild();
 
-		glBindTexture(GL_TEXTURE_2D, 0);
+		glstate.bind_texture(GL_TEXTURE_2D, 0);
 		glBindRenderbuffer(GL_RENDERBUFFER, 0);
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		glstate.bind_framebuffer(GL_FRAMEBUFFER, 0);
 	}
 
 	void FrameBuffer::bind(void)
 	{
-		glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+		glstate.bind_framebuffer(GL_FRAMEBUFFER, fbo);
 		glViewport(0, 0, width, height);
 	}
 
 	void FrameBuffer::unbind(void)
 	{
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		glstate.bind_framebuffer(GL_FRAMEBUFFER, 0);
 	}
 
 	void FrameBuffer::initialize_draw_buffer(Texture* t)
 	{
-		glBindTexture(t->target, t->id);
+		glstate.bind_texture(t->target, t->id);
 		glTexImage2D(t->target, 0, GL_RGBA, t->w, t->h, 0, GL_RGBA, GL_UNSIGNED_BYTE, 0);
 		glTexParameterf(t->target, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
 		glTexParameterf(t->target, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
@@ -168,7 +333,7 @@ namespace dukat
 
 	void FrameBuffer::attach_draw_buffer(Texture* t)
 	{
-		glBindTexture(t->target, t->id);
+		glstate.bind_texture(t->target, t->id);
         glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, t->target, t->id, 0);
 	}
 
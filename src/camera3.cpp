@@ -32,6 +32,7 @@ namespace dukat
 		transform.mat_proj_pers.setup_perspective(fov_v, aspect_ratio, near_clip, far_clip);
 		transform.mat_proj_orth.setup_orthographic(-aspect_ratio, 1.0f, aspect_ratio, -1.0f, -1.0f, 1.0f);
 		compute_horizontal_fov();
+		update_frustum();
 	}
 
 	void Camera3::update(float delta)
@@ -59,6 +60,7 @@ namespace dukat
 		mi[15] = 1.0f;
 
 		compute_clip_planes(transform, fov_h, left_clip_plane, right_clip_plane);
+		update_frustum();
 	}
 
 	Ray3 Camera3::pick_ray_screen(int x, int y)
@@ -8,6 +8,9 @@
 
 namespace dukat
 {
+	// Uniforms of caustics program
+	static constexpr ShaderVar uf_time = "u_time";
+
 	CausticsEffect2::CausticsEffect2(Game2* game, ShaderProgram* sp, int width, int height, float velocity)
 		: game(game), sp(sp), velocity(velocity), color_set(0)
 	{
@@ -38,7 +41,7 @@ namespace dukat
 		fbo->attach_draw_buffer(texture.get());
 		renderer->switch_shader(sp);
 
-		sp->set("u_time", velocity * game->get_time() + 23.0f);
+		sp->set(uf_time, velocity * game->get_time() + 23.0f);
 
 		if (update_handler != nullptr)
 			update_handler(this);
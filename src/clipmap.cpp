@@ -2,6 +2,7 @@
 #include <dukat/clipmap.h>
 #include <dukat/bit.h>
 #include <dukat/blockbuilder.h>
+#include <dukat/glstate.h>
 #include <dukat/heightmap.h>
 #include <dukat/log.h>
 #include <dukat/mathutil.h>
@@ -9,6 +10,7 @@
 #include <dukat/meshbuilder2.h>
 #include <dukat/perfcounter.h>
 #include <dukat/plane.h>
+#include <dukat/profiler.h>
 #include <dukat/renderer.h>
 #include <dukat/shadercache.h>
 #include <dukat/vertextypes3.h>
@@ -16,10 +18,16 @@
 namespace dukat
 {
     // Uniform constants
-    static const std::string uniform_size = "u_size";
-    static const std::string uniform_one_over_size = "u_one_over_size";
-    static const std::string uniform_tex_offset = "u_texture_offset";
-    static const std::string uniform_rect = "u_rect";
+    static constexpr ShaderVar uniform_size = "u_size";
+    static constexpr ShaderVar uniform_one_over_size = "u_one_over_size";
+    static constexpr ShaderVar uniform_tex_offset = "u_texture_offset";
+    static constexpr ShaderVar uniform_rect = "u_rect";
+    static constexpr ShaderVar uniform_grid_scale = "u_grid_scale";
+    static constexpr ShaderVar uniform_level = "u_level";
+    static constexpr ShaderVar uniform_debug = "u_debug";
+    static constexpr ShaderVar uniform_offset = "u_offset";
+    static constexpr ShaderVar uniform_model = Renderer::uf_model;
+    static constexpr ShaderVar uniform_color = Renderer::uf_color;
 
 	void ClipMapLevel::translate(const Vector2& offset)
 	{
@@ -34,9 +42,17 @@ namespace dukat
 		}
 	}
 
+    void ClipMapLevel::set_placement(const ClipMapLevel& level)
+    {
+        origin = level.origin;
+        last_shift = level.last_shift;
+        orientation = level.orientation;
+        bounding_boxes = level.bounding_boxes;
+    }
+
     ClipMap::ClipMap(Game3* game, int num_levels, int level_size, HeightMap* height_map)
         : num_levels(num_levels), level_size(level_size), texture_size(level_size + 1), game(game),
-          height_map(height_map), min_level(0),
+          height_map(height_map), min_level(0), upload_budget(default_upload_budget), level_budget(num_levels),
 		  culling(true), stitching(true), blending(true), lighting(true)
     {
         log->debug("Creating new clipmap: {}x{}x{}", level_size, level_size, num_levels);
@@ -46,14 +62,13 @@ namespace dukat
 
         build_buffers();
 		build_levels();
-
-        // Allocate buffer space
-        buffer.resize(texture_size * texture_size);
+        if (height_map->is_tiled())
+            reserve_tiles();
 
         // Generate elevation map array.
         elevation_maps = std::make_unique<Texture>(texture_size, texture_size);
         elevation_maps->target = GL_TEXTURE_2D_ARRAY;
-        glBindTexture(GL_TEXTURE_2D_ARRAY, elevation_maps->id);
+        glstate.bind_texture(GL_TEXTURE_2D_ARRAY, elevation_maps->id);
         glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
         glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
         glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
@@ -67,7 +82,7 @@ namespace dukat
 
         // Set up texture used for elevation map updates
         update_texture = std::make_unique<Texture>(texture_size, texture_size);
-        glBindTexture(GL_TEXTURE_2D, update_texture->id);
+        glstate.bind_texture(GL_TEXTURE_2D, update_texture->id);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
@@ -77,7 +92,7 @@ namespace dukat
         // Generate normal map array 
         normal_maps = std::make_unique<Texture>(2 * texture_size, 2 * texture_size);
         normal_maps->target = GL_TEXTURE_2D_ARRAY;
-        glBindTexture(GL_TEXTURE_2D_ARRAY, normal_maps->id);
+        glstate.bind_texture(GL_TEXTURE_2D_ARRAY, normal_maps->id);
 		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
         glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
         glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RG16F, 2 * texture_size, 2 * texture_size, num_levels,
@@ -103,10 +118,30 @@ namespace dukat
 		quad_update->set_vertices(reinterpret_cast<GLfloat*>(verts));
 
         // build initial height and normal maps 
-        auto max_index = update_elevation_maps();
+        queue_updates();
+        auto max_index = update_elevation_maps(true);
         update_normal_maps(max_index);
     }
 
+    ClipMap::~ClipMap(void)
+    {
+        // Jobs still reference the height map and staging buffers
+        auto scheduler = game->get_scheduler();
+        if (scheduler == nullptr)
+            return;
+        for (auto& batch : batches)
+        {
+            try
+            {
+                scheduler->wait(batch->counter);
+            }
+            catch (const std::exception& e)
+            {
+                log->warn("Failed to update clipmap: {}", e.what());
+            }
+        }
+    }
+
 	void ClipMap::build_levels(void)
 	{
 		const auto min_z = 0.0f;
@@ -162,6 +197,7 @@ namespace dukat
 			}
 
 			levels.push_back(level);
+			targets.push_back(level);
 		}
 	}
 
@@ -310,6 +346,7 @@ namespace dukat
 
     void ClipMap::update(float delta)
     {
+        DUKAT_PROFILE_ZONE("ClipMap::update");
         // determine height of observer and set min_level accordingly
 		auto height = height_map->get_scale_factor() * height_map->get_elevation((int)std::round(observer_pos.x), (int)std::round(observer_pos.z), 0);
 		min_level = 0;
@@ -318,14 +355,33 @@ namespace dukat
 			min_level++;
 		}
 
-        // Update level origins, then samplers, then normal maps
+        // Update level origins, then queue sampler updates for the new origins and apply 
+        // those which have been prepared, then normal maps
         update_levels();
-        auto max_index = update_elevation_maps();
+        queue_updates();
+        auto max_index = update_elevation_maps(false);
         update_normal_maps(max_index);
     }
 
+    void ClipMap::reserve_tiles(void)
+    {
+        // Prefetched regions of all levels have to fit into the tile cache at once,
+        // otherwise each prefetch evicts tiles loaded for another level.
+        const auto tile_size = height_map->get_tile_size();
+        const auto span = texture_size + 2 * prefetch_margin();
+        // Regions which are not aligned to tiles overlap one more tile per axis
+        const auto tiles_per_axis = static_cast<std::size_t>((span + tile_size - 2) / tile_size + 1);
+        const auto required = static_cast<std::size_t>(num_levels) * tiles_per_axis * tiles_per_axis;
+        if (height_map->get_tile_cache_size() < required)
+        {
+            log->debug("Increasing height map tile cache to {} tiles.", required);
+            height_map->set_tile_cache_size(required);
+        }
+    }
+
     void ClipMap::update_levels(void)
     {
+        DUKAT_PROFILE_ZONE("ClipMap::update_levels");
         // Check if we meed to update the origin of the most fine-grained level.
         const uint8_t down = 1;
         const uint8_t up = 2;
@@ -333,7 +389,7 @@ namespace dukat
         const uint8_t left = 8;
         uint8_t update_flags = 0;
 
-        auto it = levels.begin();
+        auto it = targets.begin();
 
         // Threshold for update is: 2 grid spaces * level.scale 
         auto grid_size = 2.0f * (*it).scale;
@@ -354,7 +410,7 @@ namespace dukat
             update_flags |= down;
 
         Vector2 offset_shift;
-        while (it != levels.end() && update_flags != 0)
+        while (it != targets.end() && update_flags != 0)
         {
             auto& level = *it;
             level.is_dirty = true;
@@ -430,164 +486,166 @@ namespace dukat
         }
     }
 
-    int ClipMap::update_elevation_maps(void)
+    void ClipMap::queue_updates(void)
     {
-        bool fbo_bound = false;
-        int max_index = -1;
-
-        // This will update all elevation samplers which are flagged as dirty. If the 
-        // last_shift for a level is 0, the full texture if updated. Otherwise, this
-        // will refresh only the updated section using torroidal addressing. Depending
-        // on the last_shift motion (x, y, or x+y) we will render 1-4 quads to update 
-        // the elevation sampler with new data.
-
-        for (auto& level : levels)
+        DUKAT_PROFILE_ZONE("ClipMap::queue_updates");
+        auto batch = std::make_unique<UpdateBatch>();
+        for (auto& target : targets)
         {
-            if (!level.is_dirty)
+            if (!target.is_dirty)
                 continue;
 
-            // only bind FBO once
-            if (!fbo_bound)
+            LevelUpdate update{ target, 0, { }, { } };
+            // need to convert origin from world to texture coordinates
+            const auto x = (int)std::floor(target.origin.x / target.scale);
+            const auto y = (int)std::floor(target.origin.y / target.scale);
+            // If this level hasn't been translated, perform a full rebuild of level
+            if (target.last_shift.x == 0.0f && target.last_shift.y == 0.0f)
+            {
+                update.regions[update.num_regions++] = Rect{ x, y, texture_size, texture_size };
+            }
+            else
             {
-                fb_update->bind();
+                // horizontal shift
+                if (target.last_shift.x != 0.0f)
+                {
+                    const auto w = (int)std::abs(target.last_shift.x);
+                    update.regions[update.num_regions++] = target.last_shift.x < 0.0f 
+                        ? Rect{ x, y, w, texture_size } 
+                        : Rect{ (int)(std::floor(target.origin.x / target.scale) - target.last_shift.x) + texture_size, y, w, texture_size };
+                }
+                // vertical shift
+                if (target.last_shift.y != 0.0f)
+                {
+                    const auto h = (int)std::abs(target.last_shift.y);
+                    update.regions[update.num_regions++] = target.last_shift.y < 0.0f
+                        ? Rect{ x, y, texture_size, h }
+                        : Rect{ x, (int)(std::floor(target.origin.y / target.scale) - target.last_shift.y) + texture_size, texture_size, h };
+                }
+            }
 
-                // Switch shader and bind uniforms
-			    game->get_renderer()->switch_shader(update_program);
-                auto one_over_size = 1.0f / (float)texture_size;
-                glUniform2f(update_program->attr(uniform_size), (float)texture_size, (float)texture_size);
-                glUniform2f(update_program->attr(uniform_one_over_size), one_over_size, one_over_size);
+            for (auto i = 0; i < update.num_regions; i++)
+            {
+                const auto& r = update.regions[i];
+                if (!spare_buffers.empty())
+                {
+                    update.data[i] = std::move(spare_buffers.back());
+                    spare_buffers.pop_back();
+                }
+                update.data[i].resize(r.w * r.h);
+                batch->bytes += r.w * r.h * sizeof(GLfloat);
+            }
+            target.is_dirty = false;
+            batch->updates.push_back(std::move(update));
+        }
 
-                // Bind update texture
-                update_texture->bind(0, update_program);
+        if (batch->updates.empty())
+            return;
 
-                fbo_bound = true;       
+        // Tiles around the new placement of each level are made resident along the way
+        std::vector<Rect> tile_rects;
+        if (height_map->is_tiled())
+        {
+            // Include a margin around each level, so that tiles are resident before the 
+            // level is shifted onto them. Finest levels are touched last to keep them 
+            // the most recently used.
+            const auto margin = prefetch_margin();
+            for (auto it = targets.rbegin(); it != targets.rend(); ++it)
+            {
+                tile_rects.push_back(Rect{
+                    (int)std::floor(it->origin.x / it->scale) - margin,
+                    (int)std::floor(it->origin.y / it->scale) - margin,
+                    texture_size + 2 * margin, texture_size + 2 * margin
+                });
             }
+        }
 
-            // If this level hasn't been translated, perform a full rebuild of level
-            if (level.last_shift.x == 0.0f && level.last_shift.y == 0.0f)
+        auto b = batch.get();
+        auto prepare = [this, b, tile_rects]() {
+            DUKAT_PROFILE_ZONE("ClipMap::prepare_updates");
+            for (auto& update : b->updates)
             {
-                Rect r = { 
-                    // need to convert origin from world to texture coordinates
-                    (int)std::floor(level.origin.x / level.scale), 
-                    (int)std::floor(level.origin.y / level.scale), 
-                    level_size + 1, level_size + 1
-                };
-
-                //logger << "Rebuild " << level.index << " [" << r.x << "," << r.y << "]" << std::endl;
-                height_map->get_data(level.index, r, buffer);
-                elevation_maps->bind(0);
-                glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, level.index, r.w, r.h, 1,
-                    GL_RED, GL_FLOAT, buffer.data());
-
-                level.u = 0; level.v = 0;
+                for (auto i = 0; i < update.num_regions; i++)
+                    height_map->get_data(update.state.index, update.regions[i], update.data[i]);
             }
-            else
-            {
-                // Sampling rect in world space
-                Rect r_world;
-                // Rect to replace in texture space
-                Rect r_texture;
+            for (auto i = 0; i < (int)tile_rects.size(); i++)
+                height_map->prefetch(num_levels - 1 - i, tile_rects[i]);
+        };
 
-				// Make layer elevation map render target for framebuffer
-                glFramebufferTextureLayer(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, elevation_maps->id, 0, level.index);
+        auto scheduler = game->get_scheduler();
+        if (scheduler != nullptr)
+            scheduler->submit(prepare, b->counter);
+        else
+            prepare();
+        batches.push_back(std::move(batch));
+    }
 
-                // Compute new texture offset
-                auto last_u = level.u;
-                auto last_v = level.v;
-                level.u = pos_mod(level.u + (int)level.last_shift.x, texture_size);
-                level.v = pos_mod(level.v + (int)level.last_shift.y, texture_size);
+    int ClipMap::update_elevation_maps(bool flush)
+    {
+        DUKAT_PROFILE_ZONE("ClipMap::update_elevation_maps");
+        bool fbo_bound = false;
+        int max_index = -1;
 
-                // horizontal shift
-                if (level.last_shift.x != 0.0f)
-                {
-                    if (level.last_shift.x < 0.0f) 
-                    {
-                        r_world.x = (int)std::floor(level.origin.x / level.scale);
-                        r_world.y = (int)std::floor(level.origin.y / level.scale);
-                        r_world.w = (int)std::abs(level.last_shift.x);
-                        r_world.h = texture_size;
-                        r_texture.x = level.u;
-                        r_texture.y = level.v;
-                        r_texture.w = r_world.w;
-                        r_texture.h = texture_size;
-                    }
-                    else 
-                    {
-                        r_world.x = (int)(std::floor(level.origin.x / level.scale) - level.last_shift.x) + texture_size;
-                        r_world.y = (int)std::floor(level.origin.y / level.scale);
-                        r_world.w = (int)std::abs(level.last_shift.x);
-                        r_world.h = texture_size;
-                        r_texture.x = last_u;
-                        r_texture.y = level.v;
-                        r_texture.w = r_world.w;
-                        r_texture.h = texture_size;
-                    }
-
-                    // Fill texture with height data
-                    height_map->get_data(level.index, r_world, buffer);
-                    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, r_world.w, r_world.h, GL_RED, GL_FLOAT, buffer.data());
-
-                    // Render quad to fill in new area
-                    glUniform4f(update_program->attr(uniform_rect), 
-                        (float)r_texture.x, (float)r_texture.y, (float)r_texture.w, (float)r_texture.h);
-                    quad_update->render(update_program);
-
-                    if (r_texture.y != texture_size)
-                    {
-                        glUniform4f(update_program->attr(uniform_rect), 
-                            (float)r_texture.x, (float)(r_texture.y - texture_size), (float)r_texture.w, (float)r_texture.h);
-                        quad_update->render(update_program);
-                    }
-                }
+        // This will apply batches of updates in the order they were queued, as long as 
+        // their data has been prepared and they fit into the budget. The first batch is 
+        // always applied, so that large batches cannot stall updates. A level with a 
+        // last_shift of 0 has its full texture updated. Otherwise, this will refresh only 
+        // the updated section using torroidal addressing. Depending on the last_shift 
+        // motion (x, y, or x+y) we will render 1-4 quads to update the elevation sampler 
+        // with new data.
+
+        std::size_t uploaded_bytes = 0;
+        int uploaded_levels = 0;
+        while (!batches.empty())
+        {
+            auto& batch = *batches.front();
+            if (!flush)
+            {
+                if (!batch.counter.is_done())
+                    break;
+                if (uploaded_levels > 0 && (uploaded_bytes + batch.bytes > upload_budget 
+                    || uploaded_levels + (int)batch.updates.size() > level_budget))
+                    break;
+            }
 
-                // vertical shift
-                if (level.last_shift.y != 0.0f)
+            // Rethrows errors of the preparing job
+            auto scheduler = game->get_scheduler();
+            if (scheduler != nullptr)
+                scheduler->wait(batch.counter);
+
+            for (auto& update : batch.updates)
+            {
+                // only bind FBO once
+                if (!fbo_bound)
                 {
-                    if (level.last_shift.y < 0.0f) 
-                    {
-                        r_world.x = (int)std::floor(level.origin.x / level.scale);
-                        r_world.y = (int)std::floor(level.origin.y / level.scale);
-                        r_world.w = texture_size;
-                        r_world.h = (int)std::abs(level.last_shift.y);
-                        r_texture.x = level.u;
-                        r_texture.y = level.v;
-                        r_texture.w = texture_size;
-                        r_texture.h = r_world.h;
-                    }
-                    else 
-                    {
-                        r_world.x = (int)std::floor(level.origin.x / level.scale);
-                        r_world.y = (int)(std::floor(level.origin.y / level.scale) - level.last_shift.y) + texture_size;
-                        r_world.w = texture_size;
-                        r_world.h = (int)std::abs(level.last_shift.y);
-                        r_texture.x = level.u;
-                        r_texture.y = last_v;
-                        r_texture.w = texture_size;
-                        r_texture.h = r_world.h;
-                    }
-
-                    // Fill texture with height data
-                    height_map->get_data(level.index, r_world, buffer);
-                    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, r_world.w, r_world.h, GL_RED, GL_FLOAT, buffer.data());
-
-                    // Render quad to fill in new area
-                    glUniform4f(update_program->attr(uniform_rect), 
-                        (float)r_texture.x, (float)r_texture.y, (float)r_texture.w, (float)r_texture.h);
-                    quad_update->render(update_program);
-
-                    if (r_texture.x != texture_size)
-                    {
-                        glUniform4f(update_program->attr(uniform_rect), 
-                            (float)(r_texture.x - texture_size), (float)r_texture.y, (float)r_texture.w, (float)r_texture.h);
-                        quad_update->render(update_program);
-                    }
+                    fb_update->bind();
+
+                    // Switch shader and bind uniforms
+                    game->get_renderer()->switch_shader(update_program);
+                    auto one_over_size = 1.0f / (float)texture_size;
+                    update_program->set(uniform_size, (float)texture_size, (float)texture_size);
+                    update_program->set(uniform_one_over_size, one_over_size, one_over_size);
+
+                    // Bind update texture
+                    update_texture->bind(0, update_program);
+
+                    fbo_bound = true;
                 }
 
-                perfc.inc(PerformanceCounter::FRAME_BUFFERS);
+                auto& level = levels[update.state.index];
+                level.set_placement(update.state);
+                apply_update(level, update);
+                max_index = std::max(max_index, level.index);
             }
 
-            level.is_dirty = false;
-            max_index = level.index;
+            uploaded_bytes += batch.bytes;
+            uploaded_levels += (int)batch.updates.size();
+            for (auto& update : batch.updates)
+            {
+                for (auto i = 0; i < update.num_regions; i++)
+                    spare_buffers.push_back(std::move(update.data[i]));
+            }
+            batches.pop_front();
         }
 
         if (fbo_bound)
@@ -599,8 +657,86 @@ namespace dukat
         return max_index;
     }
 
+    void ClipMap::apply_update(ClipMapLevel& level, const LevelUpdate& update)
+    {
+        // If this level hasn't been translated, perform a full rebuild of level
+        if (level.last_shift.x == 0.0f && level.last_shift.y == 0.0f)
+        {
+            const auto& r = update.regions[0];
+            elevation_maps->bind(0);
+            glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, level.index, r.w, r.h, 1,
+                GL_RED, GL_FLOAT, update.data[0].data());
+
+            level.u = 0; level.v = 0;
+            return;
+        }
+
+        // Rect to replace in texture space
+        Rect r_texture;
+        auto region = 0;
+
+		// Make layer elevation map render target for framebuffer
+        glFramebufferTextureLayer(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, elevation_maps->id, 0, level.index);
+
+        // Compute new texture offset
+        auto last_u = level.u;
+        auto last_v = level.v;
+        level.u = pos_mod(level.u + (int)level.last_shift.x, texture_size);
+        level.v = pos_mod(level.v + (int)level.last_shift.y, texture_size);
+
+        // horizontal shift
+        if (level.last_shift.x != 0.0f)
+        {
+            const auto& r_world = update.regions[region];
+            r_texture.x = level.last_shift.x < 0.0f ? level.u : last_u;
+            r_texture.y = level.v;
+            r_texture.w = r_world.w;
+            r_texture.h = texture_size;
+
+            // Fill texture with height data
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, r_world.w, r_world.h, GL_RED, GL_FLOAT, update.data[region].data());
+            region++;
+
+            // Render quad to fill in new area
+            update_program->set(uniform_rect, (float)r_texture.x, (float)r_texture.y, (float)r_texture.w, (float)r_texture.h);
+            quad_update->render(update_program);
+
+            if (r_texture.y != texture_size)
+            {
+                update_program->set(uniform_rect, (float)r_texture.x, (float)(r_texture.y - texture_size), (float)r_texture.w, (float)r_texture.h);
+                quad_update->render(update_program);
+            }
+        }
+
+        // vertical shift
+        if (level.last_shift.y != 0.0f)
+        {
+            const auto& r_world = update.regions[region];
+            r_texture.x = level.u;
+            r_texture.y = level.last_shift.y < 0.0f ? level.v : last_v;
+            r_texture.w = texture_size;
+            r_texture.h = r_world.h;
+
+            // Fill texture with height data
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, r_world.w, r_world.h, GL_RED, GL_FLOAT, update.data[region].data());
+
+            // Render quad to fill in new area
+            update_program->set(uniform_rect, (float)r_texture.x, (float)r_texture.y, (float)r_texture.w, (float)r_texture.h);
+            quad_update->render(update_program);
+
+            if (r_texture.x != texture_size)
+            {
+                update_program->set(uniform_rect, (float)(r_texture.x - texture_size), (float)r_texture.y, (float)r_texture.w, (float)r_texture.h);
+                quad_update->render(update_program);
+            }
+        }
+
+        perfc.inc(PerformanceCounter::FRAME_BUFFERS);
+    }
+
     void ClipMap::update_normal_maps(int max_index)
     {
+        DUKAT_PROFILE_ZONE("ClipMap::update_normal_maps");
         if (max_index < 0)
             return;
 
@@ -616,24 +752,22 @@ namespace dukat
         normal_maps->bind(1, normal_program);
 
         // size of normal map
-        glUniform1f(normal_program->attr(uniform_size), (float)(2 * texture_size));
+        normal_program->set(uniform_size, (float)(2 * texture_size));
         // 1 / normal map texture size 
         const auto one_over_size = 1.0f / (float)(2 * texture_size);
-        glUniform1f(normal_program->attr(uniform_one_over_size), one_over_size);
+        normal_program->set(uniform_one_over_size, one_over_size);
         // pass in ratio of z to x/y grid spacing
-        glUniform2f(normal_program->attr("u_grid_scale"),
-            -0.5f * height_map->get_scale_factor(),
+        normal_program->set(uniform_grid_scale, -0.5f * height_map->get_scale_factor(),
             -0.5f * height_map->get_scale_factor());
 
         for (int i = max_index; i >= 0; i--)
         {
             // Level specific uniforms
-            glUniform1i(normal_program->attr("u_level"), i);
+            normal_program->set_int(uniform_level, i);
 			// Pass in torroidial texture offset to handle artifacts along
 			// the border of the normal map. Multiply by 2 since normal map
 			// is twice the size of elevation sampler.
-			glUniform2f(normal_program->attr(uniform_tex_offset), 
-				2.0f * (float)levels[i].u, 2.0f * (float)levels[i].v);
+			normal_program->set(uniform_tex_offset, 2.0f * (float)levels[i].u, 2.0f * (float)levels[i].v);
             
             // Make layer normal map render target for framebuffer
             glFramebufferTextureLayer(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, normal_maps->id, 0, i);
@@ -681,25 +815,22 @@ namespace dukat
         model.m[14] = (float)level.index; model.m[15] = (float)num_levels - 1.0f;
 
 		// Debug parameters
-		glUniform2f(program->attr("u_debug"), 
-			blending ? 1.0f : 0.0f,
+		program->set(uniform_debug, blending ? 1.0f : 0.0f,
 			lighting ? 1.0f : 0.0f);
         
 		// debug color
 		auto color_factor = 1.0f - (float)level.index / (float)num_levels;
-		glUniform4f(program->attr("u_color"), 0.0f, 0.0f, color_factor, 1.0f);
+		program->set(uniform_color, 0.0f, 0.0f, color_factor, 1.0f);
 
 		// Pass in texture offset of current level within coarser level
         auto base_offset_x = (level_idx + 1) < num_levels ? (float)levels[level_idx + 1].u : 0.0f;
         auto base_offset_y = (level_idx + 1) < num_levels ? (float)levels[level_idx + 1].v : 0.0f;
-		glUniform4f(program->attr(uniform_tex_offset),
-            (float)level.u * model.m[4], (float)level.v * model.m[5],
+		program->set(uniform_tex_offset, (float)level.u * model.m[4], (float)level.v * model.m[5],
 			base_offset_x * model.m[4], base_offset_y * model.m[5]);
 		// We need to adjust for orientation of this level within the coarser level
 		// Offset is either width of 1 block of parent or width of 1 block + 1
 		auto block_size = texture_size / 4;
-		glUniform2f(program->attr("u_offset"),
-			(level.is_right() ? (float)block_size - 1.0f : (float)block_size) * model.m[4],
+		program->set(uniform_offset, (level.is_right() ? (float)block_size - 1.0f : (float)block_size) * model.m[4],
 			(level.is_bottom() ? (float)block_size - 1.0f : (float)block_size) * model.m[5]);
 
         // Handle min level as special case
@@ -716,7 +847,7 @@ namespace dukat
                 model.m[3] = level.origin.y + (inner_offsets[i].y * level.scale); 
                 model.m[6] = inner_offsets[i].x * model.m[4]; 
                 model.m[7] = inner_offsets[i].y * model.m[5];
-                glUniformMatrix4fv(program->attr(Renderer::uf_model), 1, false, model.m);
+                program->set_matrix4(uniform_model, model.m);
                 inner_mesh->render(program);
             }
         }
@@ -733,32 +864,32 @@ namespace dukat
                 model.m[3] = level.origin.y + (block_offsets[i].y * level.scale); 
                 model.m[6] = block_offsets[i].x * model.m[4]; 
                 model.m[7] = block_offsets[i].y * model.m[5];
-                glUniformMatrix4fv(program->attr(Renderer::uf_model), 1, false, model.m);
+                program->set_matrix4(uniform_model, model.m);
                 block_mesh->render(program);
             }
 
             // Render 4 <F> blocks
-            glUniform4f(program->attr("u_color"), 0.0f, color_factor, 0.0f, 1.0f);
+            program->set(uniform_color, 0.0f, color_factor, 0.0f, 1.0f);
             model.m[2] = level.origin.x; model.m[3] = level.origin.y; 
             model.m[6] = 0.0f; model.m[7] = 0.0f;
-            glUniformMatrix4fv(program->attr(Renderer::uf_model), 1, false, model.m);
+            program->set_matrix4(uniform_model, model.m);
             ring_mesh->render(program);
         
             // Render interior block based on orientation of next finer level
-            glUniform4f(program->attr("u_color"), color_factor, 0.0f, 0.0f, 1.0f);
+            program->set(uniform_color, color_factor, 0.0f, 0.0f, 1.0f);
             model.m[2] = level.origin.x; model.m[3] = level.origin.y; 
             model.m[6] = 0.0f; model.m[7] = 0.0f;
-            glUniformMatrix4fv(program->attr(Renderer::uf_model), 1, false, model.m);
+            program->set_matrix4(uniform_model, model.m);
             auto buffer_idx = (int)levels[level_idx - 1].orientation;
             fill_mesh[buffer_idx]->render(program);
         }
 
         if (stitching)
         {
-			glUniform4f(program->attr("u_color"), 1.0f, 1.0f, 1.0f, 1.0f);
+			program->set(uniform_color, 1.0f, 1.0f, 1.0f, 1.0f);
 			model.m[2] = level.origin.x; model.m[3] = level.origin.y;
             model.m[6] = 0.0f; model.m[7] = 0.0f;
-            glUniformMatrix4fv(program->attr(Renderer::uf_model), 1, false, model.m);
+            program->set_matrix4(uniform_model, model.m);
             perimeter_mesh->render(program);
         }
     }
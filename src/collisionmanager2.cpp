@@ -1,12 +1,19 @@
 #include "stdafx.h"
 #include <dukat/collisionmanager2.h>
 #include <dukat/mathutil.h>
+#include <dukat/profiler.h>
+#include <dukat/quadtreebroadphase2.h>
 
 namespace dukat
 {
-	MemoryPool<CollisionManager2::Body> CollisionManager2::Body::_pool(1024);
+	MemoryPool<CollisionManager2::Body> CollisionManager2::Body::_pool(1024, "bodies");
+	constexpr uint32_t CollisionManager2::id_index_bits;
+	constexpr uint32_t CollisionManager2::id_index_mask;
+	constexpr uint32_t CollisionManager2::max_bodies;
+
+	// Candidate buffers available to queries on the current thread
+	static thread_local std::vector<std::unique_ptr<std::vector<CollisionManager2::Body*>>> free_buffers;
 
-	static std::vector<CollisionManager2::Body*> candidates;
 	const CollisionManager2::predicate CollisionManager2::pred_active = [](CollisionManager2::Body* b) { return b->active; };
 	const CollisionManager2::predicate CollisionManager2::pred_solid = [](CollisionManager2::Body* b) { return b->active && b->solid; };
 	const CollisionManager2::predicate CollisionManager2::pred_sensor = [](CollisionManager2::Body* b) { return b->active && !b->solid; };
@@ -24,11 +31,13 @@ namespace dukat
 
 	CollisionManager2::Body* CollisionManager2::create_body(bool dynamic)
 	{
-		static uint16_t last_id = 0;
-		auto body = std::make_unique<Body>(last_id++);
+		auto body = std::make_unique<Body>(allocate_id());
+		slots[body->id & id_index_mask] = body.get();
 		body->dynamic = dynamic;
+		body->index = bodies.size();
 		bodies.push_back(std::move(body));
 		auto ptr = bodies.back().get();
+		broadphase->insert(ptr);
 		trigger(Message{ events::BodyCreated, ptr, nullptr });
 		return ptr;
 	}
@@ -37,34 +46,98 @@ namespace dukat
 	{
 		invalidate_contacts(body);
 
-		// Remove from tree
-		tree->remove(body);
+		// Remove from broadphase
+		broadphase->remove(body);
+
+		trigger(Message{ events::BodyDestroyed, body, nullptr });
+
+		// Swap with last body to keep list packed
+		const auto index = body->index;
+		assert(bodies[index].get() == body);
+		if (index + 1 < bodies.size())
+		{
+			std::swap(bodies[index], bodies.back());
+			bodies[index]->index = index;
+		}
+		release_id(body->id);
+		bodies.pop_back();
+	}
 
-		auto it = std::find_if(bodies.begin(), bodies.end(), 
-			[body](const std::unique_ptr<Body>& b) { return body == b.get(); });
-		if (it != bodies.end())
+	uint32_t CollisionManager2::allocate_id(void)
+	{
+		uint32_t index;
+		if (free_slots.empty())
+		{
+			index = static_cast<uint32_t>(slots.size());
+			if (index >= max_bodies)
+				throw std::runtime_error("Exceeded maximum number of collision bodies.");
+			slots.push_back(nullptr);
+			generations.push_back(0);
+		}
+		else
 		{
-			trigger(Message{ events::BodyDestroyed, (*it).get(), nullptr });
-			bodies.erase(it);
+			index = free_slots.back();
+			free_slots.pop_back();
 		}
+		return (generations[index] << id_index_bits) | index;
+	}
+
+	void CollisionManager2::release_id(uint32_t id)
+	{
+		const auto index = id & id_index_mask;
+		slots[index] = nullptr;
+		// generation wraps around once all remaining bits are used
+		generations[index] = (generations[index] + 1) & ((1u << (32 - id_index_bits)) - 1u);
+		free_slots.push_back(index);
+	}
+
+	CollisionManager2::Body* CollisionManager2::get_body(uint32_t id) const
+	{
+		const auto index = id & id_index_mask;
+		if (index >= slots.size() || slots[index] == nullptr || slots[index]->id != id)
+			return nullptr;
+		return slots[index];
+	}
+
+	void CollisionManager2::destroy_bodies(const std::vector<Body*>& bodies)
+	{
+		for (auto body : bodies)
+			destroy_body(body);
 	}
 
 	void CollisionManager2::invalidate_contacts(Body* body)
 	{
 		assert(!in_collision_loop);
 		// Remove any contacts this body is part of
-		for (const auto& c : get_contacts(body))
+		while (!body->neighbors.empty())
 		{
-			auto other_body = c->body1 == body ? c->body2 : c->body1;
+			auto other_body = body->neighbors.back();
 			if (other_body->owner != nullptr)
 			{
 				other_body->owner->trigger(Message{ events::CollisionEnd, body });
 			}
-			const auto res = contacts.erase(hash(c->body1, c->body2));
+			const auto res = contacts.erase(hash(body, other_body));
 			assert(res > 0u);
+			unlink_contact(body, other_body);
 		}
 	}
 
+	void CollisionManager2::link_contact(Body* b1, Body* b2)
+	{
+		b1->neighbors.push_back(b2);
+		b2->neighbors.push_back(b1);
+	}
+
+	void CollisionManager2::unlink_contact(Body* b1, Body* b2)
+	{
+		auto it = std::find(b1->neighbors.begin(), b1->neighbors.end(), b2);
+		*it = b1->neighbors.back();
+		b1->neighbors.pop_back();
+		it = std::find(b2->neighbors.begin(), b2->neighbors.end(), b1);
+		*it = b2->neighbors.back();
+		b2->neighbors.pop_back();
+	}
+
 	void CollisionManager2::test_collision(Body* this_body, Body* other_body)
 	{
 		if (this_body == other_body)
@@ -102,6 +175,7 @@ namespace dukat
 				c.generation = generation;
 				c.age = 0;
 				contacts[id] = c;
+				link_contact(this_body, other_body);
 
 				if (c.body1->owner != nullptr)
 					c.body1->owner->trigger(Message{ events::CollisionBegin, c.body2, &c });
@@ -123,6 +197,7 @@ namespace dukat
 					it->second.body1->owner->trigger(Message{ events::CollisionEnd, it->second.body2 });
 				if (it->second.body2->owner != nullptr)
 					it->second.body2->owner->trigger(Message{ events::CollisionEnd, it->second.body1 });
+				unlink_contact(it->second.body1, it->second.body2);
 				it = contacts.erase(it);
 			}
 			// attempt to resolve active contacts
@@ -161,43 +236,29 @@ namespace dukat
 
 	void CollisionManager2::update(float delta)
 	{
+		DUKAT_PROFILE_ZONE("CollisionManager2::update");
 		// broad phase - determine all possible collisions
-		tree->clear();
 		for (const auto& b : bodies)
 		{
 			if (b->active)
-			{
 				perfc.inc(PerformanceCounter::BODIES);
-				tree->insert(b.get());
-			}
 		}
-
-		// narrow phase - build up set of actual collisions
-		std::queue<QuadTree<Body>*> nodes;
-		for (const auto& b : bodies)
+		broadphase->update();
+		pairs.clear();
+		broadphase->collect_pairs(pairs);
+		// Order pairs by body ids, so that collision messages do not depend on the broadphase
+		for (auto& p : pairs)
 		{
-			if (!b->active)
-				continue;
-
-			// Start with root, compare with each child
-			nodes.push(tree.get());
-			auto this_body = b.get();
-			while (!nodes.empty())
-			{
-				auto t = nodes.front();
-				auto idx = t->get_index(this_body);
-				if (idx > -1 && t->has_child(idx))
-				{
-					nodes.push(t->child(idx));
-				}
-				const auto& values = t->get_values();
-				for (auto& it : values)
-				{
-					test_collision(this_body, it);
-				}
-				nodes.pop();
-			}
+			if (p.first->id > p.second->id)
+				std::swap(p.first, p.second);
 		}
+		std::sort(pairs.begin(), pairs.end(), [](const Broadphase2<Body>::Pair& a, const Broadphase2<Body>::Pair& b) {
+			return a.first->id < b.first->id || (a.first->id == b.first->id && a.second->id < b.second->id);
+		});
+
+		// narrow phase - build up set of actual collisions
+		for (const auto& p : pairs)
+			test_collision(p.first, p.second);
 
 		resolve_collisions();
 
@@ -206,197 +267,82 @@ namespace dukat
 
 	void CollisionManager2::create_tree(void)
 	{
+		// World settings only apply to the quad tree
+		if (broadphase != nullptr && dynamic_cast<QuadTreeBroadphase2<Body>*>(broadphase.get()) == nullptr)
+			return;
 		Vector2 dim{ 0.5f * world_size, 0.5f * world_size };
-		tree = std::make_unique<QuadTree<Body>>(world_origin - dim, world_origin + dim, world_depth);
+		set_broadphase(std::make_unique<QuadTreeBroadphase2<Body>>(world_origin - dim, world_origin + dim, world_depth));
 	}
 
-	bool CollisionManager2::has_contact(Body* b) const
+	void CollisionManager2::set_broadphase(std::unique_ptr<Broadphase2<Body>> broadphase)
 	{
-		for (const auto& it : contacts)
-		{
-			if (it.second.body1 == b || it.second.body2 == b)
-				return true;
-		}
-		return false;
+		this->broadphase = std::move(broadphase);
+		for (const auto& b : bodies)
+			this->broadphase->insert(b.get());
+		// Make bodies available to queries right away
+		this->broadphase->update();
 	}
 
 	std::list<CollisionManager2::Contact*> CollisionManager2::get_contacts(Body* b) const
 	{
 		std::list<Contact*> res;
-		for (const auto& it : contacts)
+		for (auto other : b->neighbors)
 		{
-			if (it.second.body1 == b || it.second.body2 == b)
-				res.push_back(const_cast<Contact*>(&it.second));
+			auto it = contacts.find(hash(b, other));
+			res.push_back(const_cast<Contact*>(&it->second));
 		}
 		return res;
 	}
 
-	// Index direction flags
-	static constexpr auto dir_left = 1;
-	static constexpr auto dir_right = 2;
-	static constexpr auto dir_top = 4;
-	static constexpr auto dir_bottom = 8;
-
-	int get_index_flags(const QuadTree<CollisionManager2::Body>& t, CollisionManager2::Body* body)
+	CollisionManager2::CandidateBuffer::CandidateBuffer(void)
 	{
-		auto res = dir_left | dir_right | dir_top | dir_bottom;
-		if (body->bb.max().x < t.center.x)
-			res &= ~dir_right; // value is in left quadrants
-		else if (body->bb.min().x >= t.center.x)
-			res &= ~dir_left; // value is in right quadrants
-		if (body->bb.max().y < t.center.y)
-			res &= ~dir_bottom; // value is in top quadrants
-		else if (body->bb.min().y >= t.center.y)
-			res &= ~dir_top; // value is in bottom quadrants
-		return res;
-	}
-
-	void CollisionManager2::collect_collisions(const QuadTree<Body>& t, Body* body, std::vector<Body*>& res) const
-	{
-		const auto flags = get_index_flags(t, body);
-		if (flags & dir_right)
+		if (free_buffers.empty())
 		{
-			if ((flags & dir_top) != 0 && t.has_child(0))
-				collect_collisions(*t.child(0), body, res); // check top-right
-			if ((flags & dir_bottom) != 0 && t.has_child(1))
-				collect_collisions(*t.child(1), body, res); // check bottom-right
+			buffer = new std::vector<Body*>();
 		}
-		if (flags & dir_left)
+		else
 		{
-			if ((flags & dir_top) != 0 && t.has_child(3))
-				collect_collisions(*t.child(3), body, res); // check top-left
-			if ((flags & dir_bottom) != 0 && t.has_child(2))
-				collect_collisions(*t.child(2), body, res); // check bottom-left
+			buffer = free_buffers.back().release();
+			free_buffers.pop_back();
 		}
-		const auto& values = t.get_values();
-		res.insert(res.end(), values.begin(), values.end());
 	}
 
-	std::list<CollisionManager2::Body*> CollisionManager2::find(const Vector2& pos, const predicate& p) const
+	CollisionManager2::CandidateBuffer::~CandidateBuffer(void)
 	{
-		Body b{ 0 };
-		b.bb = AABB2{ pos, pos };
-		candidates.clear();
-		collect_collisions(*tree, &b, candidates);
+		buffer->clear();
+		free_buffers.emplace_back(buffer);
+	}
 
+	std::list<CollisionManager2::Body*> CollisionManager2::find(const Vector2& pos, const predicate& p) const
+	{
 		std::list<Body*> res;
-		for (Body* b : candidates)
-		{
-			if ((p == nullptr || p(b)) && b->bb.contains(pos))
-				res.push_back(b);
-		}
+		visit(pos, [&res](Body* b) { res.push_back(b); }, [&p](Body* b) { return p == nullptr || p(b); });
 		return res;
 	}
 
 	std::list<CollisionManager2::Body*> CollisionManager2::find(const AABB2& bb, const predicate& p) const
 	{
-		Body b{ 0 };
-		b.bb = bb;
-		candidates.clear();
-		collect_collisions(*tree, &b, candidates);
-
 		std::list<Body*> res;
-		for (Body* b : candidates)
-		{
-			if ((p == nullptr || p(b)) && b->bb.overlaps(bb))
-				res.push_back(b);
-		}
+		visit(bb, [&res](Body* b) { res.push_back(b); }, [&p](Body* b) { return p == nullptr || p(b); });
 		return res;
 	}
 
 	std::list<CollisionManager2::Body*> CollisionManager2::find(const BoundingCircle& bc, const predicate& p) const
 	{
-		Body b{ 0 };
-		const Vector2 extent{ bc.radius, bc.radius };
-		b.bb = AABB2{ bc.center - extent, bc.center + extent };
-		candidates.clear();
-		collect_collisions(*tree, &b, candidates);
-
 		std::list<Body*> res;
-		for (Body* b : candidates)
-		{
-			if ((p == nullptr || p(b)) && b->bb.overlaps(bc))
-				res.push_back(b);
-		}
+		visit(bc, [&res](Body* b) { res.push_back(b); }, [&p](Body* b) { return p == nullptr || p(b); });
 		return res;
 	}
 
-	void CollisionManager2::find(QuadTree<Body>* tree, const Ray2& ray, float min_t, float max_t, std::list<Body*>& list, const predicate& p) const
-	{
-		if (tree == nullptr)
-			return;
-
-		const AABB2 bb{ tree->min_v, tree->max_v };
-		const auto tree_t = bb.intersect_ray(ray, min_t, max_t);
-		if (tree_t == no_intersection)
-			return; // no intersection with tree
-
-		// check values at this level
-		for (const auto& it : tree->get_values())
-		{
-			if (p == nullptr || p(it))
-			{
-				const auto t = it->bb.intersect_ray(ray, min_t, max_t);
-				if (t != no_intersection)
-					list.push_back(it);
-			}
-		}
-
-		// check lower levels of the tree
-		for (auto i = 0; i < 4; i++)
-			find(tree->child(i), ray, min_t, max_t, list, p);
-	}
-
 	std::list<CollisionManager2::Body*> CollisionManager2::find(const Ray2& ray, float min_t, float max_t, const predicate& p) const
 	{
 		std::list<Body*> res;
-		find(tree.get(), ray, min_t, max_t, res, p);
+		visit(ray, min_t, max_t, [&res](Body* b) { res.push_back(b); }, [&p](Body* b) { return p == nullptr || p(b); });
 		return res;
 	}
 
-	CollisionManager2::Body* CollisionManager2::find_closest(QuadTree<Body>* tree, const Ray2& ray, float min_t, float max_t, float& t, const predicate& p) const
-	{
-		if (tree == nullptr)
-			return nullptr;
-
-		const AABB2 bb{ tree->min_v, tree->max_v };
-		const auto tree_t = bb.intersect_ray(ray, min_t, max_t);
-		if (tree_t == no_intersection)
-			return nullptr; // no intersection with tree
-
-		// check values at this level
-		t = max_t;
-		Body* best_body = nullptr;
-		for (const auto& it : tree->get_values())
-		{
-			if (p == nullptr || p(it))
-			{
-				const auto body_t = it->bb.intersect_ray(ray, min_t, max_t);
-				if (body_t < t)
-				{
-					t = body_t;
-					best_body = it;
-				}
-			}
-		}
-
-		// check lower levels of the tree
-		for (auto i = 0; i < 4; i++)
-		{
-			float child_t;
-			auto res = find_closest(tree->child(i), ray, min_t, t, child_t, p);
-			if (res != nullptr && child_t < t)
-			{
-				best_body = res;
-				t = child_t;
-			}
-		}
-
-		return best_body;
-	}
-
 	CollisionManager2::Body* CollisionManager2::find_closest(const Ray2& ray, float min_t, float max_t, float& t, const predicate& p) const
 	{
-		return find_closest(tree.get(), ray, min_t, max_t, t, p);
+		return find_closest(ray, min_t, max_t, t, [&p](Body* b) { return p == nullptr || p(b); });
 	}
 }
\ No newline at end of file
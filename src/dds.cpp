@@ -1,5 +1,6 @@
 #include "stdafx.h"
 #include <dukat/dds.h>
+#include <dukat/glstate.h>
 #include <dukat/log.h>
 #include <dukat/sysutil.h>
 #include <dukat/texturecache.h>
@@ -344,7 +345,7 @@ namespace dukat
 			if ((header.caps2 & DDSCAPS2_CUBEMAP) == DDSCAPS2_CUBEMAP)
 			{
 				texture->target = GL_TEXTURE_CUBE_MAP;
-				glBindTexture(GL_TEXTURE_CUBE_MAP, texture->id);
+				glstate.bind_texture(GL_TEXTURE_CUBE_MAP, texture->id);
 			
 				// Set texture parameters
 				glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
@@ -386,7 +387,7 @@ namespace dukat
 				}*/
 #endif
 				
-				glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+				glstate.bind_texture(GL_TEXTURE_CUBE_MAP, 0);
 			}
 			else
 			{
@@ -395,7 +396,7 @@ namespace dukat
 		}
 		else
 		{
-			glBindTexture(GL_TEXTURE_2D, texture->id);
+			glstate.bind_texture(GL_TEXTURE_2D, texture->id);
 			glTexParameteri(GL_TEXTURE_2D, GL_GENERATE_MIPMAP, GL_FALSE);
 			loader(is, header, li, GL_TEXTURE_2D);
 
@@ -405,7 +406,7 @@ namespace dukat
 			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
 
-			glBindTexture(GL_TEXTURE_2D, 0);
+			glstate.bind_texture(GL_TEXTURE_2D, 0);
 		}
 
 		return texture;
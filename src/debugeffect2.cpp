@@ -80,24 +80,11 @@ namespace dukat
 		if (check_flag(flags, Flags::GRID))
 		{
 			Color tree_color{ 0.0f, 0.0f, 1.0f, 1.0f };
-			std::queue<QuadTree<CollisionManager2::Body>*> queue;
-			queue.push(cm->tree.get());
-
-			while (!queue.empty())
-			{
-				auto t = queue.front();
-				queue.pop();
-
-				for (auto i = 0; i < 4; i++)
-				{
-					if (t->has_child(i))
-						queue.push(t->child(i));
-				}
-
-				if (camera_bb.contains(t->min_v) || camera_bb.contains(Vector2{ t->min_v.x, t->max_v.y }) ||
-					camera_bb.contains(t->max_v) || camera_bb.contains(Vector2{ t->max_v.x, t->min_v.y }))
-					render_rect(t->min_v, t->max_v, tree_color);
-			}
+			static std::vector<AABB2> regions;
+			regions.clear();
+			cm->broadphase->collect_regions(camera_bb, regions);
+			for (const auto& r : regions)
+				render_rect(r.min(), r.max(), tree_color);
 		}
 
 		if (check_flag(flags, Flags::BODIES))
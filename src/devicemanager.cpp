@@ -6,6 +6,7 @@
 #include <dukat/gamepaddevice.h>
 #include <dukat/playbackdevice.h>
 #include <dukat/mathutil.h>
+#include <dukat/profiler.h>
 #include <dukat/settings.h>
 
 #ifdef XINPUT_SUPPORT
@@ -108,6 +109,7 @@ namespace dukat
 
 	void DeviceManager::update(float delta)
 	{
+		DUKAT_PROFILE_ZONE("DeviceManager::update");
 		if (active != nullptr && enabled)
 		{
 			active->update();
@@ -4,6 +4,8 @@
 #include <dukat/mathutil.h>
 #include <dukat/surface.h>
 #include <array>
+#include <atomic>
+#include <thread>
 
 namespace dukat
 {
@@ -36,13 +38,39 @@ namespace dukat
 			m[i] = static_cast<float>(raw[i]) / static_cast<float>(m.size()) - 0.5f;
 	}
 
-	void dither_ordered(Surface& surface, int n, const std::array<Color, 2>& palette)
+	void dither_ordered(Surface& surface, int n, const std::array<Color, 2>& palette, JobScheduler* scheduler)
 	{
 		// Create normalized bayer matrix
 		const auto dim = 1 << n;
 		std::vector<float> m(dim * dim);
 		generate_bayer_matrix(m, n);
 
+		const auto fmt = surface.get_surface()->format;
+		const auto bulk = dispatch_pixel_layout(fmt->BytesPerPixel, fmt->Rmask, fmt->Gmask, fmt->Bmask, [&](auto layout) {
+			// Repeat each row of the matrix across the width of the surface
+			const auto width = surface.width();
+			std::vector<float> thresholds(dim * width);
+			for (auto y = 0; y < dim; y++)
+				for (auto x = 0; x < width; x++)
+					thresholds[y * width + x] = m[y * dim + (x % dim)];
+
+			const auto color0 = surface.raw_color(palette[0]);
+			const auto color1 = surface.raw_color(palette[1]);
+			surface.apply_rows([&](int x, int y, uint32_t* row, int count) {
+				// Rows are converted in runs that fit on the stack
+				constexpr int max_run = 256;
+				float lum[max_run];
+				for (auto i = 0; i < count; i += max_run)
+				{
+					const auto run = std::min(max_run, count - i);
+					luminance_row<decltype(layout)>(row + i, lum, run);
+					threshold_row(lum, thresholds.data() + (y % dim) * width + x + i, row + i, run, color0, color1);
+				}
+			}, scheduler);
+		});
+		if (bulk)
+			return;
+
 		for (auto y = 0; y < surface.height(); y++)
 		{
 			for (auto x = 0; x < surface.width(); x++)
@@ -56,4 +84,166 @@ namespace dukat
 			}
 		}
 	}
-}
+
+	const DiffusionKernel DiffusionKernel::floyd_steinberg{ {
+		{ 1, 0, 7.f }, 
+		{ -1, 1, 3.f }, { 0, 1, 5.f }, { 1, 1, 1.f } }, 16.f };
+
+	const DiffusionKernel DiffusionKernel::sierra{ {
+		{ 1, 0, 4.f }, { 2, 0, 3.f }, 
+		{ -2, 1, 1.f }, { -1, 1, 2.f }, { 0, 1, 3.f }, { 1, 1, 2.f }, { 2, 1, 1.f } }, 16.f };
+
+	const DiffusionKernel DiffusionKernel::sierra_lite{ {
+		{ 1, 0, 2.f }, 
+		{ -1, 1, 1.f }, { 0, 1, 1.f } }, 4.f };
+
+	const DiffusionKernel DiffusionKernel::sierra3{ {
+		{ 1, 0, 5.f }, { 2, 0, 3.f },
+		{ -2, 1, 2.f }, { -1, 1, 4.f }, { 0, 1, 5.f }, { 1, 1, 4.f }, { 2, 1, 2.f },
+		{ -1, 2, 2.f }, { 0, 2, 3.f }, { 1, 2, 2.f } }, 32.f };
+
+	// Only passes on 3/4 of the error
+	const DiffusionKernel DiffusionKernel::atkinson{ {
+		{ 1, 0, 1.f }, { 2, 0, 1.f },
+		{ -1, 1, 1.f }, { 0, 1, 1.f }, { 1, 1, 1.f },
+		{ 0, 2, 1.f } }, 8.f };
+
+	const DiffusionKernel DiffusionKernel::burkes{ {
+		{ 1, 0, 8.f }, { 2, 0, 4.f },
+		{ -2, 1, 2.f }, { -1, 1, 4.f }, { 0, 1, 8.f }, { 1, 1, 4.f }, { 2, 1, 2.f } }, 32.f };
+
+	const DiffusionKernel DiffusionKernel::jarvis_judice_ninke{ {
+		{ 1, 0, 7.f }, { 2, 0, 5.f },
+		{ -2, 1, 3.f }, { -1, 1, 5.f }, { 0, 1, 7.f }, { 1, 1, 5.f }, { 2, 1, 3.f },
+		{ -2, 2, 1.f }, { -1, 2, 3.f }, { 0, 2, 5.f }, { 1, 2, 3.f }, { 2, 2, 1.f } }, 48.f };
+
+	const DiffusionKernel DiffusionKernel::stucki{ {
+		{ 1, 0, 8.f }, { 2, 0, 4.f },
+		{ -2, 1, 2.f }, { -1, 1, 4.f }, { 0, 1, 8.f }, { 1, 1, 4.f }, { 2, 1, 2.f },
+		{ -2, 2, 1.f }, { -1, 2, 2.f }, { 0, 2, 4.f }, { 1, 2, 2.f }, { 2, 2, 1.f } }, 42.f };
+
+	int DiffusionKernel::max_dy(void) const
+	{
+		auto res = 0;
+		for (const auto& e : entries)
+			res = std::max(res, e.dy);
+		return res;
+	}
+
+	// Number of pixels a row is processed in before progress is published to the rows below
+	static constexpr int wavefront_chunk = 64;
+
+	// Rows are claimed by a number of lanes in order. A pixel gathers the errors of the pixels
+	// which would have distributed to it, in the order in which the serial algorithm adds them,
+	// which makes the result independent of how rows are spread across threads. A lane waits
+	// until the rows above have progressed far enough to the right to cover the kernel.
+	template<class Layout>
+	static void dither_wavefront(Surface& surface, const DiffusionKernel& kernel, const std::array<Color, 2>& palette, JobScheduler* scheduler)
+	{
+		const auto rect = surface.pixels<uint32_t>();
+		const auto width = rect.width;
+		const auto height = rect.height;
+		if (width <= 0 || height <= 0)
+			return;
+		const auto color0 = surface.raw_color(palette[0]);
+		const auto color1 = surface.raw_color(palette[1]);
+
+		// Sources from top to bottom, left to right. Sources in the same row are to the left.
+		auto sources = kernel.entries;
+		std::sort(sources.begin(), sources.end(), [](const DiffusionKernel::Entry& a, const DiffusionKernel::Entry& b) {
+			return a.dy != b.dy ? a.dy > b.dy : a.dx > b.dx;
+		});
+		const auto max_dy = kernel.max_dy();
+		// Number of columns right of a pixel which a row above has to complete first
+		std::vector<int> reach(max_dy + 1, 0);
+		auto min_dx = 0, max_dx = 0;
+		for (const auto& e : sources)
+		{
+			assert(e.dy > 0 || (e.dy == 0 && e.dx > 0));
+			reach[e.dy] = std::max(reach[e.dy], -e.dx);
+			min_dx = std::min(min_dx, e.dx);
+			max_dx = std::max(max_dx, e.dx);
+		}
+
+		// Each lane works on one row at a time, so errors of the rows in flight and of the rows 
+		// they read from fit into a ring
+		const auto lanes = scheduler != nullptr ? std::min(scheduler->get_concurrency(), height) : 1;
+		const auto ring = lanes + max_dy + 1;
+		std::vector<float> errors(ring * width);
+		std::unique_ptr<std::atomic<int>[]> progress(new std::atomic<int>[height]);
+		for (auto y = 0; y < height; y++)
+			progress[y].store(0, std::memory_order_relaxed);
+		std::atomic<int> next_row(0);
+
+		auto lane = [&](std::size_t, std::size_t) {
+			std::vector<float> lum(width);
+			std::vector<const float*> rows(max_dy + 1);
+			for (auto y = next_row.fetch_add(1); y < height; y = next_row.fetch_add(1))
+			{
+				auto row = rect.row(y);
+				luminance_row<Layout>(row, lum.data(), width);
+				for (auto d = 0; d <= max_dy; d++)
+					rows[d] = errors.data() + ((y - d + ring) % ring) * width;
+				auto cur = errors.data() + (y % ring) * width;
+
+				for (auto x0 = 0; x0 < width; x0 += wavefront_chunk)
+				{
+					const auto x1 = std::min(width, x0 + wavefront_chunk);
+					for (auto d = 1; d <= std::min(max_dy, y); d++)
+					{
+						const auto needed = std::min(width, x1 + reach[d]);
+						while (progress[y - d].load(std::memory_order_acquire) < needed)
+							std::this_thread::yield();
+					}
+
+					for (auto x = x0; x < x1; x++)
+					{
+						auto error = 0.0f;
+						if (y >= max_dy && x >= max_dx && x < width + min_dx)
+						{
+							for (const auto& s : sources)
+								error += rows[s.dy][x - s.dx] * s.weight / kernel.divisor;
+						}
+						else
+						{
+							for (const auto& s : sources)
+							{
+								const auto sx = x - s.dx;
+								if (s.dy <= y && sx >= 0 && sx < width)
+									error += rows[s.dy][sx] * s.weight / kernel.divisor;
+							}
+						}
+
+						const auto color = lum[x] + error;
+						if (color < 0.5f)
+						{
+							cur[x] = color;
+							row[x] = color0;
+						}
+						else
+						{
+							cur[x] = color - 1.0f;
+							row[x] = color1;
+						}
+					}
+					progress[y].store(x1, std::memory_order_release);
+				}
+			}
+		};
+
+		if (lanes > 1)
+			scheduler->parallel_for(0, lanes, 1, lane);
+		else
+			lane(0, 1);
+	}
+
+	void dither(Surface& surface, const DiffusionKernel& kernel, const std::array<Color, 2>& palette, JobScheduler* scheduler)
+	{
+		const auto fmt = surface.get_surface()->format;
+		const auto bulk = dispatch_pixel_layout(fmt->BytesPerPixel, fmt->Rmask, fmt->Gmask, fmt->Bmask, [&](auto layout) {
+			dither_wavefront<decltype(layout)>(surface, kernel, palette, scheduler);
+		});
+		if (!bulk)
+			dither(surface, KernelDitherAlgorithm<float>{ surface.width(), surface.height(), kernel }, palette);
+	}
+}
\ No newline at end of file
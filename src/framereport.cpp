@@ -0,0 +1,115 @@
+#include "stdafx.h"
+#include <dukat/framereport.h>
+#include <dukat/log.h>
+#include <dukat/nullgl.h>
+#include <dukat/perfcounter.h>
+#include <dukat/profiler.h>
+#include <iomanip>
+
+namespace dukat
+{
+	const char* FrameReport::metric_names[Metric::_count] = {
+		"frame_ms", "render_ms", "gl_calls", "draw_calls", "instances", "vertices", "state_changes",
+		"redundant_changes", "avoided_changes", "program_binds", "texture_binds", "buffer_binds", "vertex_array_binds",
+		"framebuffer_binds", "uniform_updates", "uploaded_bytes", "sprites", "particles", "meshes",
+		"meshes_culled", "meshes_submitted"
+	};
+
+	FrameReport::FrameReport(int frames, const std::string& filename)
+		: frames(static_cast<std::size_t>(std::max(frames, 0))), filename(filename), frame_start(0), render_start(0)
+	{
+		samples.reserve(this->frames);
+	}
+
+	void FrameReport::begin_frame(void)
+	{
+		frame_start = Profiler::now();
+		render_start = frame_start;
+	}
+
+	void FrameReport::begin_render(void)
+	{
+		render_start = Profiler::now();
+	}
+
+	void FrameReport::end_frame(void)
+	{
+		if (is_complete())
+			return;
+
+		const auto now = Profiler::now();
+		const auto& gl = NullGL::get_frame_stats();
+		std::array<double, Metric::_count> sample;
+		sample[FrameTime] = static_cast<double>(now - frame_start) / 1.0e6;
+		sample[RenderTime] = static_cast<double>(now - render_start) / 1.0e6;
+		sample[GLCalls] = static_cast<double>(gl.calls);
+		sample[DrawCalls] = static_cast<double>(gl.draw_calls);
+		sample[Instances] = static_cast<double>(gl.instances);
+		sample[Vertices] = static_cast<double>(gl.vertices);
+		sample[StateChanges] = static_cast<double>(gl.state_changes);
+		sample[RedundantChanges] = static_cast<double>(gl.redundant_changes);
+		sample[AvoidedChanges] = static_cast<double>(perfc.get(PerformanceCounter::STATE_AVOIDED));
+		sample[ProgramBinds] = static_cast<double>(gl.program_binds);
+		sample[TextureBinds] = static_cast<double>(gl.texture_binds);
+		sample[BufferBinds] = static_cast<double>(gl.buffer_binds);
+		sample[VertexArrayBinds] = static_cast<double>(gl.vertex_array_binds);
+		sample[FramebufferBinds] = static_cast<double>(gl.framebuffer_binds);
+		sample[UniformUpdates] = static_cast<double>(gl.uniform_updates);
+		sample[UploadedBytes] = static_cast<double>(gl.uploaded_bytes);
+		sample[Sprites] = static_cast<double>(perfc.get(PerformanceCounter::SPRITES));
+		sample[Particles] = static_cast<double>(perfc.get(PerformanceCounter::PARTICLES));
+		sample[Meshes] = static_cast<double>(perfc.get(PerformanceCounter::MESHES));
+		sample[MeshesCulled] = static_cast<double>(perfc.get(PerformanceCounter::MESHES_CULLED));
+		sample[MeshesSubmitted] = static_cast<double>(perfc.get(PerformanceCounter::MESHES_SUBMITTED));
+		samples.push_back(sample);
+	}
+
+	void FrameReport::write(void) const
+	{
+		log->info("Writing report of {} frames to: {}", samples.size(), filename);
+		std::ofstream os(filename, std::ios::out);
+		if (!os)
+		{
+			log->warn("Failed to open report file: {}", filename);
+			return;
+		}
+
+		os << std::fixed << std::setprecision(3);
+		os << "{\n\"backend\":\"" << (NullGL::is_enabled() ? "null" : "opengl") << "\",\n";
+		os << "\"frame_count\":" << samples.size() << ",\n";
+
+		// Summary with distribution of each metric
+		os << "\"summary\":{";
+		std::vector<double> values(samples.size());
+		for (auto m = 0; m < Metric::_count; m++)
+		{
+			for (auto i = 0u; i < samples.size(); i++)
+				values[i] = samples[i][m];
+			std::sort(values.begin(), values.end());
+			auto mean = 0.0;
+			for (auto v : values)
+				mean += v;
+			os << (m > 0 ? ",\n" : "\n") << "\"" << metric_names[m] << "\":{";
+			if (values.empty())
+			{
+				os << "}";
+				continue;
+			}
+			mean /= static_cast<double>(values.size());
+			auto percentile = [&values](double p) { return values[static_cast<std::size_t>(p * static_cast<double>(values.size() - 1))]; };
+			os << "\"mean\":" << mean << ",\"min\":" << values.front() << ",\"p50\":" << percentile(0.5)
+				<< ",\"p95\":" << percentile(0.95) << ",\"max\":" << values.back() << "}";
+		}
+		os << "\n},\n";
+
+		os << "\"frames\":[";
+		for (auto i = 0u; i < samples.size(); i++)
+		{
+			os << (i > 0 ? ",\n" : "\n") << "{\"frame\":" << i;
+			for (auto m = 0; m < Metric::_count; m++)
+				os << ",\"" << metric_names[m] << "\":" << samples[i][m];
+			os << "}";
+		}
+		os << "\n]\n}" << std::endl;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,148 @@
+#include "stdafx.h"
+#include <dukat/frustum.h>
+#include <dukat/aabb3.h>
+#include <dukat/matrix4.h>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define DUKAT_FRUSTUM_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace dukat
+{
+	// Boxes are loaded as vectors of 4 floats
+	static_assert(sizeof(Vector3) == 4 * sizeof(float), "Unexpected Vector3 layout");
+
+	constexpr int Frustum::num_planes;
+	constexpr int Frustum::padded_planes;
+
+	Frustum::Frustum(void)
+	{
+		for (auto i = 0; i < padded_planes; i++)
+		{
+			nx[i] = ny[i] = nz[i] = 0.0f;
+			d[i] = 1.0f;
+		}
+	}
+
+	void Frustum::extract(const Matrix4& clip)
+	{
+		// Each pair of planes is the sum and difference of the 4th row and the x, y or z
+		// row of the clip matrix, which is stored in column-major order.
+		const auto& m = clip.m;
+		for (auto i = 0; i < 3; i++)
+		{
+			nx[2 * i] = m[3] + m[i];
+			ny[2 * i] = m[7] + m[4 + i];
+			nz[2 * i] = m[11] + m[8 + i];
+			d[2 * i] = m[15] + m[12 + i];
+			nx[2 * i + 1] = m[3] - m[i];
+			ny[2 * i + 1] = m[7] - m[4 + i];
+			nz[2 * i + 1] = m[11] - m[8 + i];
+			d[2 * i + 1] = m[15] - m[12 + i];
+		}
+	}
+
+	int Frustum::classify(const AABB3& bb) const
+	{
+		// Compares distance of box center to each plane with the projected half extent
+#ifdef DUKAT_FRUSTUM_SSE2
+		const auto half = _mm_set1_ps(0.5f);
+		const auto bmin = _mm_loadu_ps(&bb.min.x);
+		const auto bmax = _mm_loadu_ps(&bb.max.x);
+		const auto c = _mm_mul_ps(_mm_add_ps(bmax, bmin), half);
+		const auto e = _mm_mul_ps(_mm_sub_ps(bmax, bmin), half);
+		const auto cx = _mm_shuffle_ps(c, c, _MM_SHUFFLE(0, 0, 0, 0));
+		const auto cy = _mm_shuffle_ps(c, c, _MM_SHUFFLE(1, 1, 1, 1));
+		const auto cz = _mm_shuffle_ps(c, c, _MM_SHUFFLE(2, 2, 2, 2));
+		const auto ex = _mm_shuffle_ps(e, e, _MM_SHUFFLE(0, 0, 0, 0));
+		const auto ey = _mm_shuffle_ps(e, e, _MM_SHUFFLE(1, 1, 1, 1));
+		const auto ez = _mm_shuffle_ps(e, e, _MM_SHUFFLE(2, 2, 2, 2));
+		const auto abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+		const auto zero = _mm_setzero_ps();
+
+		auto res = 1;
+		for (auto i = 0; i < padded_planes; i += 4)
+		{
+			const auto pnx = _mm_loadu_ps(nx + i);
+			const auto pny = _mm_loadu_ps(ny + i);
+			const auto pnz = _mm_loadu_ps(nz + i);
+			const auto dist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(pnx, cx), _mm_mul_ps(pny, cy)),
+				_mm_add_ps(_mm_mul_ps(pnz, cz), _mm_loadu_ps(d + i)));
+			const auto radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_and_ps(pnx, abs_mask), ex),
+				_mm_mul_ps(_mm_and_ps(pny, abs_mask), ey)), _mm_mul_ps(_mm_and_ps(pnz, abs_mask), ez));
+			if (_mm_movemask_ps(_mm_cmplt_ps(_mm_add_ps(dist, radius), zero)) != 0)
+				return -1;
+			if (_mm_movemask_ps(_mm_cmplt_ps(_mm_sub_ps(dist, radius), zero)) != 0)
+				res = 0;
+		}
+		return res;
+#else
+		const auto cx = 0.5f * (bb.max.x + bb.min.x);
+		const auto cy = 0.5f * (bb.max.y + bb.min.y);
+		const auto cz = 0.5f * (bb.max.z + bb.min.z);
+		const auto ex = 0.5f * (bb.max.x - bb.min.x);
+		const auto ey = 0.5f * (bb.max.y - bb.min.y);
+		const auto ez = 0.5f * (bb.max.z - bb.min.z);
+
+		auto res = 1;
+		for (auto i = 0; i < num_planes; i++)
+		{
+			const auto dist = nx[i] * cx + ny[i] * cy + nz[i] * cz + d[i];
+			const auto radius = std::abs(nx[i]) * ex + std::abs(ny[i]) * ey + std::abs(nz[i]) * ez;
+			if (dist + radius < 0.0f)
+				return -1;
+			if (dist - radius < 0.0f)
+				res = 0;
+		}
+		return res;
+#endif
+	}
+
+	std::size_t Frustum::cull(const AABB3* boxes, std::size_t count, uint8_t* visible) const
+	{
+		std::size_t res = 0;
+		std::size_t i = 0;
+#ifdef DUKAT_FRUSTUM_SSE2
+		const auto half = _mm_set1_ps(0.5f);
+		const auto zero = _mm_setzero_ps();
+		for (; i + 4 <= count; i += 4)
+		{
+			// Transpose centers and half extents of four boxes into x, y and z vectors
+			__m128 c[4], e[4];
+			for (auto j = 0; j < 4; j++)
+			{
+				const auto bmin = _mm_loadu_ps(&boxes[i + j].min.x);
+				const auto bmax = _mm_loadu_ps(&boxes[i + j].max.x);
+				c[j] = _mm_mul_ps(_mm_add_ps(bmax, bmin), half);
+				e[j] = _mm_mul_ps(_mm_sub_ps(bmax, bmin), half);
+			}
+			_MM_TRANSPOSE4_PS(c[0], c[1], c[2], c[3]);
+			_MM_TRANSPOSE4_PS(e[0], e[1], e[2], e[3]);
+
+			auto outside = _mm_setzero_ps();
+			for (auto p = 0; p < num_planes; p++)
+			{
+				const auto dist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(nx[p]), c[0]), _mm_mul_ps(_mm_set1_ps(ny[p]), c[1])),
+					_mm_add_ps(_mm_mul_ps(_mm_set1_ps(nz[p]), c[2]), _mm_set1_ps(d[p])));
+				const auto radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(std::abs(nx[p])), e[0]),
+					_mm_mul_ps(_mm_set1_ps(std::abs(ny[p])), e[1])), _mm_mul_ps(_mm_set1_ps(std::abs(nz[p])), e[2]));
+				outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(dist, radius), zero));
+			}
+
+			const auto mask = _mm_movemask_ps(outside);
+			for (auto j = 0; j < 4; j++)
+			{
+				visible[i + j] = (mask & (1 << j)) ? 0 : 1;
+				res += visible[i + j];
+			}
+		}
+#endif
+		for (; i < count; i++)
+		{
+			visible[i] = is_clipped(boxes[i]) ? 0 : 1;
+			res += visible[i];
+		}
+		return res;
+	}
+}
\ No newline at end of file
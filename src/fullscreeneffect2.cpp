@@ -8,8 +8,8 @@ namespace dukat
 {
     FullscreenEffect2::FullscreenEffect2(Game2* game) : game(game)
     {
-        static constexpr auto uniform_time = "u_time";
-        static constexpr auto uniform_diffuse = "u_diffuse";
+        static constexpr ShaderVar uniform_time = "u_time";
+        static constexpr ShaderVar uniform_diffuse = "u_diffuse";
 
         composite_binder = [&](ShaderProgram* sp) {
             if (sp->attr(uniform_time) != -1)
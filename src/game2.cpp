@@ -10,6 +10,7 @@ namespace dukat
 		const auto start = SDL_GetTicks();
 		renderer = std::make_unique<Renderer2>(window.get(), shader_cache.get());
 		renderer->set_force_sync(settings.get_bool(settings::video_forcesync, false));
+		renderer->set_scheduler(scheduler.get());
 		log->trace("Renderer initialized in {} ms", SDL_GetTicks() - start);
 		effect = std::make_unique<FullscreenEffect2>(this);
 	}
@@ -18,6 +19,8 @@ namespace dukat
 	{
 		// clear scenes to allow clean deallocation
 		scenes.clear();
+		// managers may still reference render layers
+		managers.clear();
 	}
 	
 	void Game2::update(float delta)
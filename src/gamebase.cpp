@@ -8,6 +8,7 @@
 #include <dukat/manager.h>
 #include <dukat/meshcache.h>
 #include <dukat/particlemanager.h>
+#include <dukat/profiler.h>
 #include <dukat/scene.h>
 #include <dukat/settings.h>
 #include <dukat/shadercache.h>
@@ -74,12 +75,30 @@ namespace dukat
 		}
 
 		// Scene first so that managers can operate on updated properties.
-		scene_stack.top()->update(delta);
+		{
+			DUKAT_PROFILE_ZONE("Scene::update");
+			scene_stack.top()->update(delta);
+		}
+
+		DUKAT_PROFILE_ZONE("GameBase::update_managers");
+		// Concurrent managers run on workers while the remaining managers are
+		// updated on this thread, in the order of their type index.
+		manager_tasks.clear();
+		for (auto& it : managers)
+		{
+			auto manager = it.second.get();
+			if (manager->is_enabled() && manager->is_concurrent())
+				manager_tasks.add([manager, delta]() { manager->update(delta); });
+		}
+		if (!manager_tasks.empty())
+			scheduler->start(manager_tasks);
 		for (auto& it : managers)
 		{
-			if (it.second->is_enabled())
+			if (it.second->is_enabled() && !it.second->is_concurrent())
 				(it.second)->update(delta);
 		}
+		if (!manager_tasks.empty())
+			scheduler->finish(manager_tasks);
 	}
 
 	void GameBase::render(void)
@@ -0,0 +1,244 @@
+#include "stdafx.h"
+#include <dukat/glstate.h>
+
+// Rebind EXT_framebuffer_object methods
+#if defined(OPENGL_CORE) && (OPENGL_CORE < 30)
+#undef glBindFramebuffer
+#undef glDeleteFramebuffers
+#define glBindFramebuffer glBindFramebufferEXT
+#define glDeleteFramebuffers glDeleteFramebuffersEXT
+#endif
+
+namespace dukat
+{
+	constexpr int GLState::max_texture_units;
+	constexpr int GLState::max_buffer_bases;
+	constexpr GLuint GLState::unknown;
+
+	GLState glstate;
+
+	int GLState::target_index(GLenum target)
+	{
+		switch (target)
+		{
+		case GL_TEXTURE_2D:
+			return Texture2D;
+		case GL_TEXTURE_CUBE_MAP:
+			return TextureCube;
+#if OPENGL_VERSION >= 30
+		case GL_TEXTURE_2D_ARRAY:
+			return Texture2DArray;
+		case GL_TEXTURE_3D:
+			return Texture3D;
+#endif
+		default:
+			return -1;
+		}
+	}
+
+	int GLState::capability_index(GLenum cap)
+	{
+		switch (cap)
+		{
+		case GL_BLEND:
+			return Blend;
+		case GL_DEPTH_TEST:
+			return DepthTest;
+		case GL_CULL_FACE:
+			return CullFace;
+		case GL_SCISSOR_TEST:
+			return ScissorTest;
+		default:
+			return -1;
+		}
+	}
+
+	void GLState::invalidate(void)
+	{
+		program = unknown;
+		active_unit = unknown;
+		for (auto& unit : textures)
+		{
+			for (auto& id : unit)
+				id = unknown;
+		}
+		vertex_array = unknown;
+		array_buffer = unknown;
+		uniform_buffer = unknown;
+		for (auto& id : uniform_bases)
+			id = unknown;
+		draw_framebuffer = unknown;
+		read_framebuffer = unknown;
+		for (auto& c : capabilities)
+			c = unknown;
+		blend_src = unknown;
+		blend_dst = unknown;
+	}
+
+	void GLState::active_texture(GLuint unit)
+	{
+		if (update(active_unit, unit))
+			glActiveTexture(GL_TEXTURE0 + unit);
+	}
+
+	void GLState::bind_texture(GLenum target, GLuint id)
+	{
+		const auto idx = target_index(target);
+		if (idx < 0 || active_unit >= static_cast<GLuint>(max_texture_units))
+			glBindTexture(target, id);
+		else if (update(textures[active_unit][idx], id))
+			glBindTexture(target, id);
+	}
+
+	void GLState::bind_vertex_array(GLuint id)
+	{
+#if OPENGL_VERSION >= 30
+		if (update(vertex_array, id))
+			glBindVertexArray(id);
+#endif
+	}
+
+	void GLState::bind_buffer(GLenum target, GLuint id)
+	{
+		switch (target)
+		{
+		case GL_ARRAY_BUFFER:
+			if (update(array_buffer, id))
+				glBindBuffer(target, id);
+			break;
+#if OPENGL_VERSION >= 30
+		case GL_UNIFORM_BUFFER:
+			if (update(uniform_buffer, id))
+				glBindBuffer(target, id);
+			break;
+#endif
+		default:
+			glBindBuffer(target, id);
+			break;
+		}
+	}
+
+	void GLState::bind_buffer_base(GLenum target, GLuint index, GLuint id)
+	{
+#if OPENGL_VERSION >= 30
+		// Binding an indexed target also binds the generic target
+		if (target != GL_UNIFORM_BUFFER || index >= static_cast<GLuint>(max_buffer_bases))
+		{
+			glBindBufferBase(target, index, id);
+		}
+		else if (uniform_bases[index] != id || uniform_buffer != id)
+		{
+			glBindBufferBase(target, index, id);
+			uniform_bases[index] = id;
+			uniform_buffer = id;
+		}
+		else
+		{
+			perfc.inc(PerformanceCounter::STATE_AVOIDED);
+		}
+#endif
+	}
+
+	void GLState::bind_framebuffer(GLenum target, GLuint id)
+	{
+		switch (target)
+		{
+		case GL_FRAMEBUFFER:
+			if (draw_framebuffer != id || read_framebuffer != id)
+			{
+				glBindFramebuffer(target, id);
+				draw_framebuffer = id;
+				read_framebuffer = id;
+			}
+			else
+			{
+				perfc.inc(PerformanceCounter::STATE_AVOIDED);
+			}
+			break;
+#if OPENGL_VERSION >= 30
+		case GL_DRAW_FRAMEBUFFER:
+			if (update(draw_framebuffer, id))
+				glBindFramebuffer(target, id);
+			break;
+		case GL_READ_FRAMEBUFFER:
+			if (update(read_framebuffer, id))
+				glBindFramebuffer(target, id);
+			break;
+#endif
+		default:
+			glBindFramebuffer(target, id);
+			break;
+		}
+	}
+
+	void GLState::set_capability(GLenum cap, bool enabled)
+	{
+		const auto idx = capability_index(cap);
+		if (idx >= 0 && !update(capabilities[idx], enabled ? 1 : 0))
+			return;
+		if (enabled)
+			glEnable(cap);
+		else
+			glDisable(cap);
+	}
+
+	void GLState::blend_func(GLenum src, GLenum dst)
+	{
+		if (blend_src == src && blend_dst == dst)
+		{
+			perfc.inc(PerformanceCounter::STATE_AVOIDED);
+			return;
+		}
+		glBlendFunc(src, dst);
+		blend_src = src;
+		blend_dst = dst;
+	}
+
+	void GLState::delete_texture(GLuint id)
+	{
+		glDeleteTextures(1, &id);
+		for (auto& unit : textures)
+		{
+			for (auto& t : unit)
+			{
+				if (t == id)
+					t = 0;
+			}
+		}
+	}
+
+	void GLState::delete_vertex_array(GLuint id)
+	{
+#if OPENGL_VERSION >= 30
+		glDeleteVertexArrays(1, &id);
+		if (vertex_array == id)
+			vertex_array = 0;
+#endif
+	}
+
+	void GLState::delete_buffers(GLsizei count, const GLuint* ids)
+	{
+		glDeleteBuffers(count, ids);
+		for (auto i = 0; i < count; i++)
+		{
+			if (array_buffer == ids[i])
+				array_buffer = 0;
+			if (uniform_buffer == ids[i])
+				uniform_buffer = 0;
+			for (auto& b : uniform_bases)
+			{
+				if (b == ids[i])
+					b = 0;
+			}
+		}
+	}
+
+	void GLState::delete_framebuffer(GLuint id)
+	{
+		glDeleteFramebuffers(1, &id);
+		if (draw_framebuffer == id)
+			draw_framebuffer = 0;
+		if (read_framebuffer == id)
+			read_framebuffer = 0;
+	}
+}
\ No newline at end of file
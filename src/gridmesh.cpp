@@ -1,6 +1,7 @@
 #include "stdafx.h"
 #include <dukat/gridmesh.h>
 #include <dukat/blockbuilder.h>
+#include <dukat/glstate.h>
 
 namespace dukat
 {
@@ -14,7 +15,7 @@ namespace dukat
 	{ 
 		// Create elevation texture
 		heightmap_texture = std::make_unique<Texture>(grid_size, grid_size, ProfileLinear);
-		glBindTexture(GL_TEXTURE_2D, heightmap_texture->id);
+		glstate.bind_texture(GL_TEXTURE_2D, heightmap_texture->id);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
@@ -30,7 +31,7 @@ namespace dukat
         const auto nm_size = 2 * grid_size;
         auto fb_normal = std::make_unique<FrameBuffer>(nm_size, nm_size, true, false);
         normal_texture = fb_normal->texture.get();
-        glBindTexture(GL_TEXTURE_2D, normal_texture->id);
+        glstate.bind_texture(GL_TEXTURE_2D, normal_texture->id);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
         // 2-channel GL_RG16F texture for normal data
@@ -70,13 +71,13 @@ namespace dukat
 
 	void GridMesh::load_height_level(const HeightMap::Level& level)
 	{
-		glBindTexture(GL_TEXTURE_2D, heightmap_texture->id);
+		glstate.bind_texture(GL_TEXTURE_2D, heightmap_texture->id);
 #if OPENGL_VERSION >= 30
 		glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, grid_size, grid_size, 0, GL_RED, GL_FLOAT, level.data.data());
 #else
 		glTexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE, grid_size, grid_size, 0, GL_RED, GL_FLOAT, level.data.data());
 #endif
-		glBindTexture(GL_TEXTURE_2D, 0);
+		glstate.bind_texture(GL_TEXTURE_2D, 0);
 
 		update_normal_map();
 	}
@@ -1,8 +1,11 @@
 #include "stdafx.h"
 #include <dukat/heightmap.h>
 #include <dukat/heightmapgenerator.h>
+#include <dukat/heightmaptiles.h>
+#include <dukat/jobscheduler.h>
 #include <dukat/log.h>
 #include <dukat/mathutil.h>
+#include <dukat/pixelops.h>
 #include <dukat/rect.h>
 #include <dukat/surface.h>
 #include <dukat/ray3.h>
@@ -10,44 +13,96 @@
 
 namespace dukat
 {
+    // Number of rows processed by a single job
+    static constexpr int rows_per_job = 32;
+
+    // Calls fn(begin, end) for blocks of rows, using the workers of a scheduler if available.
+    template<class Fn>
+    static void for_each_rows(JobScheduler* scheduler, int rows, const Fn& fn)
+    {
+        if (scheduler != nullptr && rows > rows_per_job)
+        {
+            scheduler->parallel_for(0, rows, rows_per_job, [&](std::size_t begin, std::size_t end) {
+                fn(static_cast<int>(begin), static_cast<int>(end));
+            });
+        }
+        else
+        {
+            fn(0, rows);
+        }
+    }
+
+    HeightMap::HeightMap(int num_levels, float scale_factor) 
+        : num_levels(num_levels), level_size(0), scale_factor(scale_factor), generated_levels(0), 
+        lazy_levels(false), scheduler(nullptr), tile_cache_size(0)
+    {
+    }
+
+    HeightMap::~HeightMap(void)
+    {
+    }
+
     void HeightMap::generate_levels(void)
     {
-        // For now, done on the CPU - investigate performance gains for doing this on the GPU
+        // Levels are created up front, so that references remain valid when levels are 
+        // generated later on.
         for (auto i = 1; i < num_levels; i++)
         {
-            levels.push_back({ i, level_size >> i });
+            levels.push_back(Level{});
+            levels[i].index = i;
+            levels[i].size = level_size >> i;
+        }
+        generated_levels.store(1, std::memory_order_release);
 
-            auto cur_stride = levels[i].size;
-            auto prev_stride = levels[i - 1].size;
+        if (!lazy_levels)
+            ensure_level(num_levels - 1);
+    }
 
-            for (auto y = 0; y < cur_stride; y++)
+    void HeightMap::generate_level(int level, std::vector<GLfloat>& data) const
+    {
+        const auto size = levels[level].size;
+        const auto& prev = levels[level - 1];
+        data.resize(size * size);
+
+        // Perform bilinear filtering of previous level to generate this level 
+        for_each_rows(scheduler, size, [&](int begin, int end) {
+            for (auto y = begin; y < end; y++)
             {
-                for (auto x = 0; x < cur_stride; x++)
-                {
-                    auto prev_y = y * 2;
-                    auto prev_x = x * 2;
-                    auto i0 = prev_y * prev_stride + prev_x;
-                    auto i1 = prev_y * prev_stride + prev_x + 1;
-                    auto i2 = (prev_y + 1) * prev_stride + prev_x;
-                    auto i3 = (prev_y + 1) * prev_stride + prev_x + 1;
-
-                    // Perform bilinear filtering of previous level to generate this level 
-                    auto z0 = levels[i - 1].data[i0];
-                    auto z1 = levels[i - 1].data[i1];
-                    auto z2 = levels[i - 1].data[i2];
-                    auto z3 = levels[i - 1].data[i3];
-					levels[i].data[y * cur_stride + x] = (z0 + z1 + z2 + z3) / 4.0f;
-                }                
+                const auto src = prev.data.data() + 2 * y * prev.size;
+                downsample_row(src, src + prev.size, data.data() + y * size, size);
+            }
+        });
+    }
+
+    void HeightMap::ensure_level(int level) const
+    {
+        level = std::min(level, static_cast<int>(levels.size()) - 1);
+        for (auto i = generated_levels.load(std::memory_order_acquire); i <= level; 
+            i = generated_levels.load(std::memory_order_acquire))
+        {
+            // The lock is not held while generating, since waiting for the parallel rows 
+            // may run a job on this thread which accesses the same map. Concurrent callers 
+            // may generate a level twice; only the first result is kept.
+            std::vector<GLfloat> data;
+            generate_level(i, data);
+
+            std::lock_guard<std::mutex> lock(level_mutex);
+            if (generated_levels.load(std::memory_order_relaxed) == i)
+            {
+                levels[i].data = std::move(data);
+                generated_levels.store(i + 1, std::memory_order_release);
             }
         }
     }
 
 	void HeightMap::load(const std::string& filename)
 	{
+        tiles = nullptr;
         // reset level structure
         if (!levels.empty())
         {
             levels.clear();
+            generated_levels.store(0, std::memory_order_relaxed);
         }
 
 		png_image img;
@@ -81,11 +136,10 @@ namespace dukat
         levels.push_back({ 0, level_size });
 
 		// normalize data and store at level 0
-		for (auto i = 0u; i < num_pixels; i++)
-		{
-			auto z = (float)buffer[i];
-			levels[0].data[i] = factor * z;
-		}
+		for_each_rows(scheduler, level_size, [&](int begin, int end) {
+			for (auto y = begin; y < end; y++)
+				normalize_row(buffer.data() + y * level_size, levels[0].data.data() + y * level_size, level_size, factor);
+		});
 
 		png_image_free(&img);
 	
@@ -94,6 +148,11 @@ namespace dukat
 
 	void HeightMap::save(const std::string& filename) const
 	{
+		if (tiles != nullptr)
+		{
+			throw std::runtime_error("Cannot save tiled height map as PNG.");
+		}
+
 		png_image img;
 		memset(&img, 0, sizeof(img));
 		img.version = PNG_IMAGE_VERSION;
@@ -114,11 +173,37 @@ namespace dukat
 		png_image_write_to_file(&img, filename.c_str(), 0, buffer.data(), 0, nullptr);
 	}
 
+	void HeightMap::load_tiled(const std::string& filename)
+	{
+		auto res = std::make_unique<HeightMapTiles>(filename, 
+			tile_cache_size > 0 ? tile_cache_size : HeightMapTiles::default_capacity);
+		if (res->get_num_levels() < num_levels)
+		{
+			throw std::runtime_error("Tiled height map does not contain enough levels.");
+		}
+
+		levels.clear();
+		generated_levels.store(0, std::memory_order_relaxed);
+		level_size = res->get_level_size();
+		tiles = std::move(res);
+	}
+
+	void HeightMap::save_tiled(const std::string& filename, int tile_size, TileFormat format) const
+	{
+		if (tiles != nullptr)
+		{
+			throw std::runtime_error("Height map is already tiled.");
+		}
+		HeightMapTiles::write(filename, *this, num_levels, tile_size, format);
+	}
+
 	void HeightMap::allocate(int level_size)
 	{
+		tiles = nullptr;
 		if (!levels.empty())
 		{
 			levels.clear();
+			generated_levels.store(0, std::memory_order_relaxed);
 		}
 
 		this->level_size = level_size;
@@ -129,9 +214,11 @@ namespace dukat
 
 	void HeightMap::generate(int level_size, const HeightMapGenerator& gen)
 	{
+		tiles = nullptr;
 		if (!levels.empty())
 		{
 			levels.clear();
+			generated_levels.store(0, std::memory_order_relaxed);
 		}
 
 		this->level_size = level_size;
@@ -143,62 +230,65 @@ namespace dukat
 		generate_levels();
 	}
 
-    void HeightMap::get_data(int level, const Rect& rect, std::vector<GLfloat>& buffer) const
+    HeightMap::Level& HeightMap::get_level(int level)
     {
-		const auto stride = levels[level].size;
-		const auto last_row = std::min(rect.y + rect.h, stride);
-		const auto last_col = std::min(rect.x + rect.w, stride);
+        if (tiles != nullptr)
+        {
+            throw std::runtime_error("Levels of a tiled height map cannot be accessed directly.");
+        }
+        ensure_level(level);
+        return levels[level];
+    }
 
-		auto dst = buffer.begin();
-		auto y = rect.y;
+    const HeightMap::Level& HeightMap::get_level(int level) const
+    {
+        if (tiles != nullptr)
+        {
+            throw std::runtime_error("Levels of a tiled height map cannot be accessed directly.");
+        }
+        ensure_level(level);
+        return levels[level];
+    }
 
-		// Outside of bounds < 0
-		if (y < 0)
+    void HeightMap::get_data(int level, const Rect& rect, std::vector<GLfloat>& buffer) const
+    {
+		if (tiles != nullptr)
 		{
-			auto count = abs(y) * rect.w;
-			std::fill(dst, dst + count, 0.0f);
-			dst += count;
-			y = 0;
+			tiles->get_data(level, rect, buffer);
+			return;
 		}
 
-        for ( ; y < last_row; y++)
-        {
-			auto x = rect.x;
-			// outside of bounds < 0
-			if (x < 0)
-			{
-				auto count = abs(x);
-				std::fill(dst, dst + count, 0.0f);
-				dst += count;
-				x = 0;
-			}
-
-			if (x < last_col)
-			{
-				auto src = levels[level].data.begin() + y * stride;
-				std::copy(src + x, src + last_col, dst);
-				dst += (last_col - x);
-			}
-
-			// outside of bounds > level_size
-			if (last_col < rect.x + rect.w)
-			{
-				auto count = (rect.x + rect.w) - last_col;
-				std::fill(dst, dst + count, 0.0f);
-				dst += count;
-			}
-        }
+		ensure_level(level);
+		const auto stride = levels[level].size;
+		const auto count = std::min(buffer.size(), static_cast<std::size_t>(std::max(rect.w, 0)) * std::max(rect.h, 0));
+		std::fill(buffer.begin(), buffer.begin() + count, 0.0f);
 
-		// Outside of bounds > level_size
-		if (last_row < rect.y + rect.h)
+		// Clip rect against level, and copy rows until the buffer is full
+		const auto first_col = std::max(rect.x, 0);
+		const auto last_col = std::min(rect.x + rect.w, stride);
+		if (first_col >= last_col)
+			return;
+		const auto last_row = std::min(rect.y + rect.h, stride);
+		for (auto y = std::max(rect.y, 0); y < last_row; y++)
 		{
-			std::fill(dst, buffer.end(), 0.0f);
+			const auto offset = static_cast<std::size_t>((y - rect.y) * rect.w + (first_col - rect.x));
+			if (offset >= count)
+				break;
+			const auto src = levels[level].data.begin() + y * stride;
+			const auto len = std::min(static_cast<std::size_t>(last_col - first_col), count - offset);
+			std::copy(src + first_col, src + first_col + len, buffer.begin() + offset);
 		}
     }
 
 	float HeightMap::get_elevation(int x, int y, int level) const
 	{
 		assert(level < num_levels);
+		if (tiles != nullptr)
+		{
+			return tiles->get_elevation(level, x, y);
+		}
+
+		ensure_level(level);
 		const auto stride = levels[level].size;
 		if (x < 0 || x >= stride || y < 0 || y >= stride)
 		{
@@ -230,6 +320,33 @@ namespace dukat
 		return (z0 * dx1 * dy1) + (z1 * dx0 * dy1) + (z2 * dx1 * dy0) + (z3 * dx0 * dy0);
 	}
 
+	void HeightMap::prefetch(int level, const Rect& rect) const
+	{
+		if (tiles != nullptr)
+		{
+			tiles->prefetch(level, rect);
+		}
+	}
+
+	void HeightMap::set_tile_cache_size(std::size_t size)
+	{
+		tile_cache_size = size;
+		if (tiles != nullptr)
+		{
+			tiles->set_capacity(size > 0 ? size : HeightMapTiles::default_capacity);
+		}
+	}
+
+	std::size_t HeightMap::get_tile_cache_size(void) const
+	{
+		return tile_cache_size > 0 ? tile_cache_size : HeightMapTiles::default_capacity;
+	}
+
+	int HeightMap::get_tile_size(void) const
+	{
+		return tiles != nullptr ? tiles->get_tile_size() : 0;
+	}
+
 	float HeightMap::intersect_ray(const Ray3& ray, float min_t, float max_t) const
 	{
 		const auto step_size = std::sqrt(2.0f);
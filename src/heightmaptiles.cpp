@@ -0,0 +1,282 @@
+#include "stdafx.h"
+#include <dukat/heightmaptiles.h>
+#include <dukat/log.h>
+#include <dukat/mathutil.h>
+#include <dukat/pixelops.h>
+#include <dukat/rect.h>
+
+namespace dukat
+{
+	constexpr uint32_t HeightMapTiles::file_id;
+	constexpr uint32_t HeightMapTiles::file_version;
+	constexpr uint32_t HeightMapTiles::page_alignment;
+	constexpr std::size_t HeightMapTiles::default_capacity;
+	constexpr uint32_t HeightMapTiles::max_levels;
+
+	static_assert(sizeof(HeightMapTiles::Header) == 32, "Unexpected tile header size");
+	static_assert(sizeof(HeightMapTiles::LevelEntry) == 16, "Unexpected tile level entry size");
+
+	static constexpr float max_uint16 = static_cast<float>(std::numeric_limits<uint16_t>::max());
+
+	static std::size_t sample_size(HeightMap::TileFormat format)
+	{
+		return format == HeightMap::TileFormat::UInt16 ? sizeof(uint16_t) : sizeof(GLfloat);
+	}
+
+	static uint64_t align_page(uint64_t offset)
+	{
+		return (offset + HeightMapTiles::page_alignment - 1) & ~static_cast<uint64_t>(HeightMapTiles::page_alignment - 1);
+	}
+
+	HeightMapTiles::HeightMapTiles(const std::string& filename, std::size_t capacity) 
+		: file(filename), header(nullptr), entries(nullptr), tile_bytes(0), capacity(std::max(capacity, static_cast<std::size_t>(1)))
+	{
+		const auto size = file.size();
+		if (size < sizeof(Header))
+			throw std::runtime_error("Invalid height map format or version!");
+		header = reinterpret_cast<const Header*>(file.data());
+		if (header->id != file_id || header->version != file_version)
+			throw std::runtime_error("Invalid height map format or version!");
+		// Sizes are limited so that the layout arithmetic below cannot overflow
+		if (header->num_levels > max_levels || header->level_size > static_cast<uint32_t>(std::numeric_limits<int>::max())
+			|| header->tile_size == 0 || header->tile_size > header->level_size
+			|| static_cast<uint64_t>(header->tile_size) * header->tile_size > size
+			|| header->format > static_cast<uint32_t>(HeightMap::TileFormat::UInt16)
+			|| sizeof(Header) + static_cast<uint64_t>(header->num_levels) * sizeof(LevelEntry) > size)
+			throw std::runtime_error("Invalid height map layout!");
+
+		entries = reinterpret_cast<const LevelEntry*>(file.data() + sizeof(Header));
+		tile_bytes = static_cast<std::size_t>(static_cast<uint64_t>(header->tile_size) * header->tile_size
+			* sample_size(static_cast<HeightMap::TileFormat>(header->format)));
+		for (auto i = 0u; i < header->num_levels; i++)
+		{
+			const auto& e = entries[i];
+			const auto tiles = (static_cast<uint64_t>(e.size) + header->tile_size - 1) / header->tile_size;
+			if (e.size != (header->level_size >> i) || e.tiles != tiles || e.offset % page_alignment != 0 
+				|| e.offset > size || tiles * tiles > (size - e.offset) / tile_bytes)
+				throw std::runtime_error("Invalid height map layout!");
+		}
+	}
+
+	void HeightMapTiles::write(const std::string& filename, const HeightMap& map, int num_levels, int tile_size, HeightMap::TileFormat format)
+	{
+		assert(tile_size > 0 && num_levels <= static_cast<int>(max_levels));
+		// Tiles larger than the map would only contain padding
+		tile_size = std::max(1, std::min(tile_size, map.get_level(0).size));
+		std::ofstream os(filename, std::ofstream::binary);
+		if (!os)
+			throw std::runtime_error("Could not open file for writing: " + filename);
+
+		Header h;
+		memset(&h, 0, sizeof(Header));
+		h.id = file_id;
+		h.version = file_version;
+		h.level_size = map.get_level(0).size;
+		h.num_levels = num_levels;
+		h.tile_size = tile_size;
+		h.format = static_cast<uint32_t>(format);
+
+		const auto bytes = static_cast<uint64_t>(tile_size) * tile_size * sample_size(format);
+		std::vector<LevelEntry> levels(num_levels);
+		auto offset = align_page(sizeof(Header) + num_levels * sizeof(LevelEntry));
+		for (auto i = 0; i < num_levels; i++)
+		{
+			levels[i].size = h.level_size >> i;
+			levels[i].tiles = (levels[i].size + tile_size - 1) / tile_size;
+			levels[i].offset = offset;
+			offset = align_page(offset + static_cast<uint64_t>(levels[i].tiles) * levels[i].tiles * bytes);
+		}
+
+		uint64_t pos = 0;
+		auto write = [&os, &pos](const void* data, std::size_t size) {
+			os.write(reinterpret_cast<const char*>(data), size);
+			pos += size;
+		};
+		auto pad = [&write, &pos](uint64_t offset) {
+			static const char zeros[page_alignment] = { 0 };
+			write(zeros, static_cast<std::size_t>(offset - pos));
+		};
+
+		write(&h, sizeof(Header));
+		write(levels.data(), levels.size() * sizeof(LevelEntry));
+
+		// Tiles at the edge of a level are padded with 0
+		std::vector<GLfloat> tile(tile_size * tile_size);
+		std::vector<uint16_t> quantized(tile.size());
+		for (auto i = 0; i < num_levels; i++)
+		{
+			pad(levels[i].offset);
+			const auto& level = map.get_level(i);
+			const auto count = static_cast<int>(levels[i].tiles);
+			for (auto ty = 0; ty < count; ty++)
+			{
+				for (auto tx = 0; tx < count; tx++)
+				{
+					std::fill(tile.begin(), tile.end(), 0.0f);
+					const auto w = std::min(tile_size, level.size - tx * tile_size);
+					const auto h = std::min(tile_size, level.size - ty * tile_size);
+					for (auto y = 0; y < h; y++)
+					{
+						const auto src = level.data.data() + (ty * tile_size + y) * level.size + tx * tile_size;
+						std::copy(src, src + w, tile.data() + y * tile_size);
+					}
+
+					if (format == HeightMap::TileFormat::UInt16)
+					{
+						for (auto j = 0u; j < tile.size(); j++)
+						{
+							auto z = tile[j];
+							clamp(z, 0.0f, 1.0f);
+							quantized[j] = static_cast<uint16_t>(z * max_uint16 + 0.5f);
+						}
+						write(quantized.data(), quantized.size() * sizeof(uint16_t));
+					}
+					else
+					{
+						write(tile.data(), tile.size() * sizeof(GLfloat));
+					}
+				}
+			}
+		}
+
+		if (!os)
+			throw std::runtime_error("Failed to write height map: " + filename);
+	}
+
+	void HeightMapTiles::convert(const std::string& png_file, const std::string& filename, int num_levels, int tile_size, HeightMap::TileFormat format)
+	{
+		log->info("Converting height map: {} -> {}", png_file, filename);
+		HeightMap map(num_levels);
+		map.load(png_file);
+		write(filename, map, num_levels, tile_size, format);
+	}
+
+	uint64_t HeightMapTiles::tile_key(int level, int tx, int ty)
+	{
+		return (static_cast<uint64_t>(level) << 48) | (static_cast<uint64_t>(ty) << 24) | static_cast<uint64_t>(tx);
+	}
+
+	const GLfloat* HeightMapTiles::fetch(int level, int tx, int ty)
+	{
+		const auto key = tile_key(level, tx, ty);
+		auto it = index.find(key);
+		if (it != index.end())
+		{
+			tiles.splice(tiles.begin(), tiles, it->second);
+			return tiles.front().data.data();
+		}
+
+		// Reuse least recently used tile once the cache is full
+		if (tiles.size() >= capacity)
+		{
+			index.erase(tiles.back().key);
+			tiles.splice(tiles.begin(), tiles, std::prev(tiles.end()));
+		}
+		else
+		{
+			tiles.push_front(Tile{ 0, std::vector<GLfloat>(static_cast<std::size_t>(header->tile_size) * header->tile_size) });
+		}
+
+		auto& tile = tiles.front();
+		tile.key = key;
+		index[key] = tiles.begin();
+
+		const auto& e = entries[level];
+		const auto src = file.data() + e.offset + (static_cast<std::size_t>(ty) * e.tiles + tx) * tile_bytes;
+		if (header->format == static_cast<uint32_t>(HeightMap::TileFormat::UInt16))
+			normalize_row(reinterpret_cast<const uint16_t*>(src), tile.data.data(), static_cast<int>(tile.data.size()), 1.0f / max_uint16);
+		else
+			memcpy(tile.data.data(), src, tile_bytes);
+		return tile.data.data();
+	}
+
+	float HeightMapTiles::get_elevation(int level, int x, int y)
+	{
+		assert(level < get_num_levels());
+		const auto size = static_cast<int>(entries[level].size);
+		if (x < 0 || x >= size || y < 0 || y >= size)
+			return 0.0f;
+
+		const auto ts = get_tile_size();
+		std::lock_guard<std::mutex> lock(mtx);
+		return fetch(level, x / ts, y / ts)[(y % ts) * ts + (x % ts)];
+	}
+
+	void HeightMapTiles::get_data(int level, const Rect& rect, std::vector<GLfloat>& buffer)
+	{
+		assert(level < get_num_levels());
+		// A buffer smaller than the rect receives as many values as it can hold
+		const auto count = std::min(buffer.size(), static_cast<std::size_t>(std::max(rect.w, 0)) * std::max(rect.h, 0));
+		std::fill(buffer.begin(), buffer.begin() + count, 0.0f);
+
+		// Clip rect against level and buffer, then copy overlap with each tile
+		const auto size = static_cast<int>(entries[level].size);
+		const auto x0 = std::max(rect.x, 0);
+		const auto y0 = std::max(rect.y, 0);
+		const auto x1 = std::min(rect.x + rect.w, size);
+		const auto y1 = std::min(std::min(rect.y + rect.h, size), 
+			rect.y + static_cast<int>((count + rect.w - 1) / std::max(rect.w, 1)));
+		if (x0 >= x1 || y0 >= y1)
+			return;
+
+		const auto ts = get_tile_size();
+		std::lock_guard<std::mutex> lock(mtx);
+		for (auto ty = y0 / ts; ty <= (y1 - 1) / ts; ty++)
+		{
+			for (auto tx = x0 / ts; tx <= (x1 - 1) / ts; tx++)
+			{
+				const auto tile = fetch(level, tx, ty);
+				const auto cx0 = std::max(x0, tx * ts);
+				const auto cx1 = std::min(x1, (tx + 1) * ts);
+				const auto cy0 = std::max(y0, ty * ts);
+				const auto cy1 = std::min(y1, (ty + 1) * ts);
+				for (auto y = cy0; y < cy1; y++)
+				{
+					const auto offset = static_cast<std::size_t>((y - rect.y) * rect.w + (cx0 - rect.x));
+					if (offset >= count)
+						break;
+					const auto src = tile + (y - ty * ts) * ts + (cx0 - tx * ts);
+					const auto len = std::min(static_cast<std::size_t>(cx1 - cx0), count - offset);
+					std::copy(src, src + len, buffer.begin() + offset);
+				}
+			}
+		}
+	}
+
+	void HeightMapTiles::prefetch(int level, const Rect& rect)
+	{
+		assert(level < get_num_levels());
+		const auto size = static_cast<int>(entries[level].size);
+		const auto x0 = std::max(rect.x, 0);
+		const auto y0 = std::max(rect.y, 0);
+		const auto x1 = std::min(rect.x + rect.w, size);
+		const auto y1 = std::min(rect.y + rect.h, size);
+		if (x0 >= x1 || y0 >= y1)
+			return;
+
+		const auto ts = get_tile_size();
+		std::lock_guard<std::mutex> lock(mtx);
+		for (auto ty = y0 / ts; ty <= (y1 - 1) / ts; ty++)
+		{
+			for (auto tx = x0 / ts; tx <= (x1 - 1) / ts; tx++)
+				fetch(level, tx, ty);
+		}
+	}
+
+	void HeightMapTiles::set_capacity(std::size_t capacity)
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		this->capacity = std::max(capacity, static_cast<std::size_t>(1));
+		while (tiles.size() > this->capacity)
+		{
+			index.erase(tiles.back().key);
+			tiles.pop_back();
+		}
+	}
+
+	std::size_t HeightMapTiles::resident_count(void) const
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		return tiles.size();
+	}
+}
\ No newline at end of file
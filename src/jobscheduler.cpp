@@ -0,0 +1,317 @@
+#include "stdafx.h"
+#include <dukat/jobscheduler.h>
+#include <dukat/log.h>
+#include <dukat/profiler.h>
+
+namespace dukat
+{
+	// Scheduler and queue of the current worker thread
+	static thread_local JobScheduler* current_scheduler = nullptr;
+	static thread_local int current_queue = 0;
+	// Deferred actions of the job executed by the current thread
+	static thread_local std::vector<std::function<void(void)>>* current_deferred = nullptr;
+
+	TaskGraph::TaskId TaskGraph::add(const std::function<void(void)>& fn)
+	{
+		tasks.emplace_back(fn);
+		return static_cast<TaskId>(tasks.size() - 1);
+	}
+
+	void TaskGraph::depend(TaskId task, TaskId prerequisite)
+	{
+		assert(task != prerequisite);
+		tasks[prerequisite].successors.push_back(task);
+		tasks[task].dependencies++;
+	}
+
+	JobScheduler::JobScheduler(int worker_count) : queued(0), done(false)
+	{
+		if (worker_count < 0)
+			worker_count = std::max(0, static_cast<int>(std::thread::hardware_concurrency()) - 1);
+		log->debug("Starting job scheduler with {} workers.", worker_count);
+
+		for (auto i = 0; i <= worker_count; i++)
+			queues.push_back(std::make_unique<JobQueue>());
+		for (auto i = 1; i <= worker_count; i++)
+			threads.emplace_back(&JobScheduler::worker_loop, this, i);
+	}
+
+	JobScheduler::~JobScheduler(void)
+	{
+		{
+			std::lock_guard<std::mutex> lock(wake_mutex);
+			done = true;
+		}
+		wake.notify_all();
+		for (auto& t : threads)
+			t.join();
+	}
+
+	void JobScheduler::worker_loop(int index)
+	{
+		current_scheduler = this;
+		current_queue = index;
+		Profiler::set_thread_name("worker " + std::to_string(index));
+		Job job;
+		while (!done)
+		{
+			if (pop(index, job))
+			{
+				execute(job);
+				continue;
+			}
+
+			std::unique_lock<std::mutex> lock(wake_mutex);
+			wake.wait(lock, [this]() { return done || queued > 0; });
+		}
+	}
+
+	int JobScheduler::queue_index(void) const
+	{
+		return current_scheduler == this ? current_queue : 0;
+	}
+
+	void JobScheduler::push(Job&& job)
+	{
+		auto& queue = *queues[queue_index()];
+		{
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			queue.jobs.push_back(std::move(job));
+		}
+		queued++;
+		if (!threads.empty())
+		{
+			// lock to avoid lost wake-up between predicate check and wait
+			std::lock_guard<std::mutex> lock(wake_mutex);
+		}
+		wake.notify_one();
+	}
+
+	bool JobScheduler::pop(int index, Job& job)
+	{
+		if (queued == 0)
+			return false;
+
+		// Newest job from own queue first to keep caches warm
+		{
+			auto& queue = *queues[index];
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			if (!queue.jobs.empty())
+			{
+				job = std::move(queue.jobs.back());
+				queue.jobs.pop_back();
+				queued--;
+				return true;
+			}
+		}
+
+		// Otherwise steal oldest job from another queue
+		const auto count = static_cast<int>(queues.size());
+		for (auto i = 1; i < count; i++)
+		{
+			auto& queue = *queues[(index + i) % count];
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			if (!queue.jobs.empty())
+			{
+				job = std::move(queue.jobs.front());
+				queue.jobs.pop_front();
+				queued--;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void JobScheduler::execute(Job& job)
+	{
+		DUKAT_PROFILE_ZONE("JobScheduler::execute");
+		auto prev_deferred = current_deferred;
+		current_deferred = job.deferred;
+		try
+		{
+			job.fn();
+		}
+		catch (...)
+		{
+			std::lock_guard<std::mutex> lock(job.counter->mutex);
+			if (job.counter->error == nullptr)
+				job.counter->error = std::current_exception();
+		}
+		current_deferred = prev_deferred;
+		if (job.counter->pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+		{
+			// wake up threads blocked in wait; counter must not be touched after this point
+			std::lock_guard<std::mutex> lock(wake_mutex);
+			wake.notify_all();
+		}
+	}
+
+	void JobScheduler::submit(const std::function<void(void)>& fn, JobCounter& counter)
+	{
+		counter.pending++;
+		push(Job{ fn, &counter, nullptr });
+	}
+
+	void JobScheduler::wait(JobCounter& counter)
+	{
+		const auto index = queue_index();
+		Job job;
+		while (!counter.is_done())
+		{
+			if (pop(index, job))
+			{
+				execute(job);
+				continue;
+			}
+
+			// Remaining jobs are running on other threads, so block until they complete 
+			// or more jobs are queued
+			std::unique_lock<std::mutex> lock(wake_mutex);
+			wake.wait(lock, [this, &counter]() { return queued > 0 || counter.is_done(); });
+		}
+
+		if (counter.error != nullptr)
+		{
+			auto error = counter.error;
+			counter.error = nullptr;
+			std::rethrow_exception(error);
+		}
+	}
+
+	void JobScheduler::flush(DeferredQueue& queue)
+	{
+		for (auto& action : queue)
+			action();
+		queue.clear();
+	}
+
+	void JobScheduler::parallel_for(std::size_t begin, std::size_t end, std::size_t grain,
+		const std::function<void(std::size_t, std::size_t)>& fn)
+	{
+		if (begin >= end)
+			return;
+
+		// Aim for a few chunks per thread so that stealing can balance the load
+		const auto count = end - begin;
+		const auto target_chunks = static_cast<std::size_t>(get_concurrency()) * 4;
+		const auto chunk_size = std::max(std::max(grain, static_cast<std::size_t>(1)), (count + target_chunks - 1) / target_chunks);
+		const auto chunks = (count + chunk_size - 1) / chunk_size;
+		if (chunks == 1 || threads.empty())
+		{
+			fn(begin, end);
+			return;
+		}
+
+		JobCounter counter;
+		std::vector<DeferredQueue> deferred(chunks);
+		counter.pending += static_cast<int>(chunks);
+		for (auto i = chunks - 1; i > 0; i--)
+		{
+			const auto chunk_begin = begin + i * chunk_size;
+			const auto chunk_end = std::min(end, chunk_begin + chunk_size);
+			push(Job{ [&fn, chunk_begin, chunk_end]() { fn(chunk_begin, chunk_end); }, &counter, &deferred[i] });
+		}
+
+		// Process first chunk on this thread
+		Job first{ [&fn, begin, chunk_size]() { fn(begin, begin + chunk_size); }, &counter, &deferred[0] };
+		execute(first);
+		wait(counter);
+
+		for (auto& queue : deferred)
+			flush(queue);
+	}
+
+	void JobScheduler::run_task(TaskGraph& graph, TaskGraph::TaskId id)
+	{
+		try
+		{
+			graph.tasks[id].fn();
+		}
+		catch (...)
+		{
+			// successors still have to run for the graph to complete
+			release_successors(graph, id);
+			throw;
+		}
+		release_successors(graph, id);
+	}
+
+	void JobScheduler::release_successors(TaskGraph& graph, TaskGraph::TaskId id)
+	{
+		for (auto successor : graph.tasks[id].successors)
+		{
+			auto& task = graph.tasks[successor];
+			if (task.remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+			{
+				push(Job{ [this, &graph, successor]() { run_task(graph, successor); }, 
+					&graph.counter, &task.deferred });
+			}
+		}
+	}
+
+	void JobScheduler::start(TaskGraph& graph)
+	{
+		assert(graph.counter.is_done());
+		const auto count = static_cast<int>(graph.tasks.size());
+
+		// Make sure that every task can be reached before starting any of them
+		std::vector<int> remaining(count);
+		std::vector<TaskGraph::TaskId> ready;
+		for (auto i = 0; i < count; i++)
+		{
+			remaining[i] = graph.tasks[i].dependencies;
+			if (remaining[i] == 0)
+				ready.push_back(i);
+		}
+		for (auto i = 0u; i < ready.size(); i++)
+		{
+			for (auto successor : graph.tasks[ready[i]].successors)
+			{
+				if (--remaining[successor] == 0)
+					ready.push_back(successor);
+			}
+		}
+		if (static_cast<int>(ready.size()) != count)
+			throw std::runtime_error("Task graph contains a cycle.");
+
+		graph.counter.pending += count;
+		for (auto i = 0; i < count; i++)
+			graph.tasks[i].remaining = graph.tasks[i].dependencies;
+		for (auto i = 0; i < count; i++)
+		{
+			auto& task = graph.tasks[i];
+			if (task.dependencies > 0)
+				continue;
+			push(Job{ [this, &graph, i]() { run_task(graph, i); }, &graph.counter, &task.deferred });
+		}
+	}
+
+	void JobScheduler::finish(TaskGraph& graph)
+	{
+		try
+		{
+			wait(graph.counter);
+		}
+		catch (...)
+		{
+			for (auto& task : graph.tasks)
+				task.deferred.clear();
+			throw;
+		}
+		for (auto& task : graph.tasks)
+			flush(task.deferred);
+	}
+
+	bool JobScheduler::is_deferring(void)
+	{
+		return current_deferred != nullptr;
+	}
+
+	void JobScheduler::defer(const std::function<void(void)>& action)
+	{
+		if (current_deferred != nullptr)
+			current_deferred->push_back(action);
+		else
+			action();
+	}
+}
\ No newline at end of file
@@ -0,0 +1,123 @@
+#include "stdafx.h"
+#include <dukat/mappedfile.h>
+#include <dukat/log.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace dukat
+{
+	static constexpr std::size_t page_size = 4096;
+
+#ifdef _WIN32
+	MappedFile::MappedFile(void) : ptr(nullptr), length(0), file_handle(INVALID_HANDLE_VALUE), map_handle(nullptr)
+	{
+	}
+#else
+	MappedFile::MappedFile(void) : ptr(nullptr), length(0), fd(-1)
+	{
+	}
+#endif
+
+	MappedFile::MappedFile(const std::string& filename) : MappedFile()
+	{
+		open(filename);
+	}
+
+	MappedFile::~MappedFile(void)
+	{
+		close();
+	}
+
+	void MappedFile::open(const std::string& filename)
+	{
+		close();
+		log->debug("Mapping file: {}", filename);
+
+#ifdef _WIN32
+		file_handle = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+			OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (file_handle == INVALID_HANDLE_VALUE)
+			throw std::runtime_error("Could not open file: " + filename);
+		LARGE_INTEGER file_size;
+		if (!GetFileSizeEx(file_handle, &file_size))
+		{
+			close();
+			throw std::runtime_error("Could not get size of file: " + filename);
+		}
+		length = static_cast<std::size_t>(file_size.QuadPart);
+		if (length == 0)
+			return; // empty files cannot be mapped
+		map_handle = CreateFileMappingA(file_handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (map_handle == nullptr)
+		{
+			close();
+			throw std::runtime_error("Could not map file: " + filename);
+		}
+		ptr = static_cast<const uint8_t*>(MapViewOfFile(map_handle, FILE_MAP_READ, 0, 0, 0));
+#else
+		fd = ::open(filename.c_str(), O_RDONLY);
+		if (fd < 0)
+			throw std::runtime_error("Could not open file: " + filename);
+		struct stat st;
+		if (fstat(fd, &st) != 0)
+		{
+			close();
+			throw std::runtime_error("Could not get size of file: " + filename);
+		}
+		length = static_cast<std::size_t>(st.st_size);
+		if (length == 0)
+			return; // empty files cannot be mapped
+		auto addr = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+		ptr = addr == MAP_FAILED ? nullptr : static_cast<const uint8_t*>(addr);
+#endif
+		if (ptr == nullptr)
+		{
+			close();
+			throw std::runtime_error("Could not map file: " + filename);
+		}
+	}
+
+	void MappedFile::close(void)
+	{
+#ifdef _WIN32
+		if (ptr != nullptr)
+			UnmapViewOfFile(ptr);
+		if (map_handle != nullptr)
+			CloseHandle(map_handle);
+		if (file_handle != INVALID_HANDLE_VALUE)
+			CloseHandle(file_handle);
+		map_handle = nullptr;
+		file_handle = INVALID_HANDLE_VALUE;
+#else
+		if (ptr != nullptr)
+			munmap(const_cast<uint8_t*>(ptr), length);
+		if (fd >= 0)
+			::close(fd);
+		fd = -1;
+#endif
+		ptr = nullptr;
+		length = 0;
+	}
+
+	void MappedFile::prefetch(std::size_t offset, std::size_t count) const
+	{
+		if (ptr == nullptr || offset >= length)
+			return;
+		count = std::min(count, length - offset);
+#ifndef _WIN32
+		// Let the kernel start reading ahead before we touch the pages
+		const auto start = offset & ~(page_size - 1);
+		madvise(const_cast<uint8_t*>(ptr) + start, offset + count - start, MADV_WILLNEED);
+#endif
+		volatile uint8_t sum = 0;
+		for (auto i = offset; i < offset + count; i += page_size)
+			sum += ptr[i];
+		if (count > 0)
+			sum += ptr[offset + count - 1];
+	}
+}
\ No newline at end of file
@@ -0,0 +1,74 @@
+#include "stdafx.h"
+#include <dukat/memorypool.h>
+#include <dukat/log.h>
+#include <dukat/perfcounter.h>
+
+namespace dukat
+{
+	static uint32_t last_serial = 0;
+
+	std::mutex& MemoryPoolBase::registry_mutex(void)
+	{
+		static std::mutex mutex;
+		return mutex;
+	}
+
+	std::vector<MemoryPoolBase*>& MemoryPoolBase::registry(void)
+	{
+		static std::vector<MemoryPoolBase*> pools;
+		return pools;
+	}
+
+	MemoryPoolBase::MemoryPoolBase(const char* name) : name(name), serial(++last_serial), reported_allocations(0)
+	{
+		std::lock_guard<std::mutex> lock(registry_mutex());
+		registry().push_back(this);
+	}
+
+	MemoryPoolBase::~MemoryPoolBase(void)
+	{
+		std::lock_guard<std::mutex> lock(registry_mutex());
+		auto& pools = registry();
+		pools.erase(std::remove(pools.begin(), pools.end(), this), pools.end());
+	}
+
+	bool MemoryPoolBase::is_registered(const MemoryPoolBase* pool, uint32_t serial)
+	{
+		std::lock_guard<std::mutex> lock(registry_mutex());
+		const auto& pools = registry();
+		return std::find(pools.begin(), pools.end(), pool) != pools.end() && pool->serial == serial;
+	}
+
+	void MemoryPoolBase::report_stats(void)
+	{
+		std::lock_guard<std::mutex> lock(registry_mutex());
+		auto counter = static_cast<int>(PerformanceCounter::POOLS);
+		for (auto pool : registry())
+		{
+			if (pool->name == nullptr)
+				continue;
+			if (counter + 2 >= PerformanceCounter::max_counters)
+				break; // out of counters
+
+			const auto stats = pool->get_stats();
+			perfc.set(counter, static_cast<long>(stats.live));
+			perfc.set(counter + 1, static_cast<long>(stats.high_water));
+			perfc.set(counter + 2, static_cast<long>(stats.allocations - pool->reported_allocations));
+			pool->reported_allocations = stats.allocations;
+			counter += 3;
+		}
+	}
+
+	void MemoryPoolBase::log_stats(void)
+	{
+		std::lock_guard<std::mutex> lock(registry_mutex());
+		for (auto pool : registry())
+		{
+			if (pool->name == nullptr)
+				continue;
+			const auto stats = pool->get_stats();
+			log->debug("Memory pool {}: capacity {}, live {}, high-water mark {}, allocations {}",
+				pool->name, stats.capacity, stats.live, stats.high_water, stats.allocations);
+		}
+	}
+}
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include "stdafx.h"
 #include <dukat/meshdata.h>
 #include <dukat/buffers.h>
+#include <dukat/glstate.h>
 #include <dukat/shaderprogram.h>
 #include <dukat/log.h>
 #include <dukat/renderer.h>
@@ -55,7 +56,20 @@ namespace dukat
 	void MeshData::set_vertices(const GLvoid* vertices, int vertex_count)
 	{
 		buffer->counts[0] = vertex_count >= 0 ? vertex_count : max_vertices;
-		glBindBuffer(GL_ARRAY_BUFFER, buffer->buffers[0]);
+		update_bounds(vertices);
+		upload_vertices(vertices);
+	}
+
+	void MeshData::set_vertices(const GLvoid* vertices, int vertex_count, const AABB3& bounds)
+	{
+		buffer->counts[0] = vertex_count >= 0 ? vertex_count : max_vertices;
+		bb = bounds;
+		upload_vertices(vertices);
+	}
+
+	void MeshData::upload_vertices(const GLvoid* vertices)
+	{
+		glstate.bind_buffer(GL_ARRAY_BUFFER, buffer->buffers[0]);
 		if (static_mesh)
 		{
 			glBufferData(GL_ARRAY_BUFFER, buffer->counts[0] * buffer->strides[0], vertices, GL_STATIC_DRAW);
@@ -66,7 +80,26 @@ namespace dukat
 			glBufferData(GL_ARRAY_BUFFER, max_vertices * buffer->strides[0], nullptr, GL_STREAM_DRAW);
 			glBufferSubData(GL_ARRAY_BUFFER, 0, buffer->counts[0] * buffer->strides[0], vertices);
 		}
-		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		glstate.bind_buffer(GL_ARRAY_BUFFER, 0);
+	}
+
+	void MeshData::update_bounds(const GLvoid* vertices)
+	{
+		bb.clear();
+		if (vertices == nullptr)
+			return;
+		for (const auto& attr : attributes)
+		{
+			if (attr.alias != Renderer::at_pos || attr.type != GL_FLOAT)
+				continue;
+			auto data = static_cast<const uint8_t*>(vertices) + attr.offset;
+			for (auto i = 0; i < buffer->counts[0]; i++, data += buffer->strides[0])
+			{
+				auto p = reinterpret_cast<const GLfloat*>(data);
+				bb.add(Vector3{ p[0], attr.components > 1 ? p[1] : 0.0f, attr.components > 2 ? p[2] : 0.0f });
+			}
+			break;
+		}
 	}
 
 	void MeshData::set_indices(const std::vector<GLushort>& indices, int index_count)
@@ -78,16 +111,16 @@ namespace dukat
 	{
 		assert(buffer->buffer_count > 1);
 		buffer->counts[1] = index_count >= 0 ? index_count : max_indices;
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer->buffers[1]);
+		glstate.bind_buffer(GL_ELEMENT_ARRAY_BUFFER, buffer->buffers[1]);
 		glBufferData(GL_ELEMENT_ARRAY_BUFFER, buffer->counts[1] * buffer->strides[1], indices, GL_STATIC_DRAW);
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+		glstate.bind_buffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 	}
 	
-	void MeshData::render(ShaderProgram* program)
+	void MeshData::bind(ShaderProgram* program)
 	{
 #if OPENGL_VERSION >= 30
-		glBindVertexArray(buffer->vao);
-		glBindBuffer(GL_ARRAY_BUFFER, buffer->buffers[0]);
+		glstate.bind_vertex_array(buffer->vao);
+		glstate.bind_buffer(GL_ARRAY_BUFFER, buffer->buffers[0]);
 
 		for (auto& attr : attributes)
 		{
@@ -99,7 +132,7 @@ namespace dukat
 				reinterpret_cast<const GLvoid*>(attr.offset));
 		}
 #else
-		glBindBuffer(GL_ARRAY_BUFFER, buffer->buffers[0]);
+		glstate.bind_buffer(GL_ARRAY_BUFFER, buffer->buffers[0]);
 		
 		// TODO: check performance of the following:
 		for (auto& attr : attributes)
@@ -130,18 +163,37 @@ namespace dukat
 			}
 		}
 #endif
+	}
 
+	void MeshData::draw(int instances)
+	{
 		if (max_indices > 0)
 		{
-			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer->buffers[1]);
-			glDrawElements(mode, buffer->counts[1], GL_UNSIGNED_SHORT, static_cast<GLvoid*>(0));
-			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+			glstate.bind_buffer(GL_ELEMENT_ARRAY_BUFFER, buffer->buffers[1]);
+			if (instances == 1)
+				glDrawElements(mode, buffer->counts[1], GL_UNSIGNED_SHORT, static_cast<GLvoid*>(0));
+#if (OPENGL_CORE >= 33) || (OPENGL_ES >= 30)
+			else
+				glDrawElementsInstanced(mode, buffer->counts[1], GL_UNSIGNED_SHORT, static_cast<GLvoid*>(0), instances);
+#endif
+			glstate.bind_buffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 		}
 		else
 		{
-			glDrawArrays(mode, 0, buffer->counts[0]);
+			if (instances == 1)
+				glDrawArrays(mode, 0, buffer->counts[0]);
+#if (OPENGL_CORE >= 33) || (OPENGL_ES >= 30)
+			else
+				glDrawArraysInstanced(mode, 0, buffer->counts[0], instances);
+#endif
 		}
 
+		perfc.inc(PerformanceCounter::MESHES, instances);
+		perfc.inc(PerformanceCounter::VERTICES, buffer->counts[0] * instances);
+	}
+
+	void MeshData::unbind(ShaderProgram* program)
+	{
 #if OPENGL_VERSION >= 30
 		for (auto& attr : attributes)
 		{
@@ -152,8 +204,8 @@ namespace dukat
 		}
 
 	#ifdef _DEBUG
-		glBindBuffer(GL_ARRAY_BUFFER, 0);
-		glBindVertexArray(0);
+		glstate.bind_buffer(GL_ARRAY_BUFFER, 0);
+		glstate.bind_vertex_array(0);
 	#endif
 #else
 	#ifdef _DEBUG
@@ -161,11 +213,15 @@ namespace dukat
 		glDisableClientState(GL_COLOR_ARRAY);
 		glDisableClientState(GL_TEXTURE_COORD_ARRAY);
 		glDisableClientState(GL_NORMAL_ARRAY);
-		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		glstate.bind_buffer(GL_ARRAY_BUFFER, 0);
 	#endif
 #endif
+	}
 
-		perfc.inc(PerformanceCounter::MESHES);
-		perfc.inc(PerformanceCounter::VERTICES, buffer->counts[0]);
+	void MeshData::render(ShaderProgram* program)
+	{
+		bind(program);
+		draw();
+		unbind(program);
 	}
 }
\ No newline at end of file
@@ -1,10 +1,13 @@
 #include "stdafx.h"
 #include <dukat/meshgroup.h>
+#include <dukat/frustum.h>
+#include <dukat/perfcounter.h>
 #include <dukat/renderer.h>
+#include <dukat/renderqueue3.h>
 
 namespace dukat
 {
-	MeshGroup::MeshGroup(void)
+	MeshGroup::MeshGroup(void) : bounds_changed(false)
 	{ 
 		bb.clear();
 	}
@@ -13,6 +16,7 @@ namespace dukat
 	{
 		auto res = instance.get();
 		instances.push_back(std::move(instance));
+		bounds_changed = true;
 		return res;
 	}
 
@@ -23,7 +27,9 @@ namespace dukat
         });
         if (it != instances.end())
         {
+            tree.remove(instance);
             instances.erase(it);
+            bounds_changed = true;
         }
     }
 
@@ -34,6 +40,67 @@ namespace dukat
 		{
 			it->update(delta);
 		}
+		update_bounds();
+	}
+
+	void MeshGroup::update_bounds(void)
+	{
+		unbounded.clear();
+		AABB3 bb;
+		for (auto& it : instances)
+		{
+			auto mesh = it->get_mesh();
+			if (mesh == nullptr || mesh->get_bounds().empty())
+			{
+				tree.remove(it.get());
+				unbounded.push_back(it.get());
+				continue;
+			}
+			bb.set_to_transformed_box(mesh->get_bounds(), it->transform.mat_model);
+			tree.insert(it.get(), bb);
+		}
+		bounds_changed = false;
+	}
+
+	bool MeshGroup::enqueue(RenderQueue3& queue)
+	{
+		if (stage != RenderStage::Scene)
+		{
+			for (auto& it : instances)
+			{
+				if (it->visible)
+				{
+					queue.add(it.get(), transform.mat_model * it->transform.mat_model, stage);
+				}
+			}
+			return true;
+		}
+
+		if (bounds_changed)
+			update_bounds();
+
+		// Query instances against camera frustum in group space
+		Frustum frustum;
+		queue.get_frustum(transform.mat_model, frustum);
+		visible_instances.clear();
+		tree.query(frustum, visible_instances);
+		perfc.inc(PerformanceCounter::MESHES_CULLED, static_cast<int>(tree.size() - visible_instances.size()));
+
+		for (auto it : visible_instances)
+		{
+			if (it->visible)
+			{
+				queue.add(it, transform.mat_model * it->transform.mat_model, stage, true);
+			}
+		}
+		for (auto it : unbounded)
+		{
+			if (it->visible)
+			{
+				queue.add(it, transform.mat_model * it->transform.mat_model, stage, true);
+			}
+		}
+		return true;
 	}
 
 	void MeshGroup::render(Renderer* renderer)
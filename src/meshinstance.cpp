@@ -1,19 +1,23 @@
 #include "stdafx.h"
 #include <dukat/meshinstance.h>
 #include <dukat/buffers.h>
+#include <dukat/glstate.h>
 #include <dukat/shaderprogram.h>
 #include <dukat/perfcounter.h>
 #include <dukat/renderer.h>
+#include <dukat/renderqueue3.h>
 
 namespace dukat
 {
+	static constexpr ShaderVar uf_model = Renderer::uf_model;
+
 	MeshInstance::MeshInstance(void) : Mesh(), program(nullptr)
 	{
 		for (auto i = 0; i < Renderer::max_texture_units; i++)
 			texture[i] = nullptr;
 #if OPENGL_VERSION >= 30
 		uniform_buffers = std::make_unique<GenericBuffer>(1);
-		glBindBufferBase(GL_UNIFORM_BUFFER, static_cast<GLuint>(Renderer::UniformBuffer::Material), uniform_buffers->buffers[0]);
+		glstate.bind_buffer_base(GL_UNIFORM_BUFFER, static_cast<GLuint>(Renderer::UniformBuffer::Material), uniform_buffers->buffers[0]);
 		glBufferData(GL_UNIFORM_BUFFER, sizeof(Material), &material, GL_STATIC_DRAW);
 #endif
 		// initialize default transform
@@ -23,7 +27,7 @@ namespace dukat
 	void MeshInstance::update_material_buffer(void)
 	{
 #if OPENGL_VERSION >= 30
-		glBindBufferBase(GL_UNIFORM_BUFFER, static_cast<GLuint>(Renderer::UniformBuffer::Material), uniform_buffers->buffers[0]);
+		glstate.bind_buffer_base(GL_UNIFORM_BUFFER, static_cast<GLuint>(Renderer::UniformBuffer::Material), uniform_buffers->buffers[0]);
 		glBufferData(GL_UNIFORM_BUFFER, sizeof(Material), &material, GL_STATIC_DRAW);
 #endif
 	}
@@ -41,18 +45,31 @@ namespace dukat
 		render(renderer, mat);
 	}
 
+	bool MeshInstance::enqueue(RenderQueue3& queue)
+	{
+		queue.add(this, transform.mat_model, stage);
+		return true;
+	}
+
 	void MeshInstance::render(Renderer* renderer, const Matrix4& mat)
 	{
-		renderer->switch_shader(program);
+		bind(renderer);
 
 		// combine entity and mesh model matrices
 		Matrix4 model = mat * transform.mat_model;
-		glUniformMatrix4fv(program->attr(Renderer::uf_model), 1, false, model.m);
+		program->set_matrix4(uf_model, model.m);
+
+		mesh->render(program);
+	}
+
+	void MeshInstance::bind(Renderer* renderer)
+	{
+		renderer->switch_shader(program);
 
 #if OPENGL_VERSION >= 30
 		// Bind uniform buffers
 		if (program->bind(Renderer::uf_material, static_cast<GLuint>(Renderer::UniformBuffer::Material)))
-			glBindBufferBase(GL_UNIFORM_BUFFER, static_cast<GLuint>(Renderer::UniformBuffer::Material), uniform_buffers->buffers[0]);
+			glstate.bind_buffer_base(GL_UNIFORM_BUFFER, static_cast<GLuint>(Renderer::UniformBuffer::Material), uniform_buffers->buffers[0]);
 #else
 		// manually bind material (sending custom.r twice since there is no dedicated
 		// shininess in later versions)
@@ -71,7 +88,5 @@ namespace dukat
 				texture[i]->bind(i, program);
 			}
 		}
-
-		mesh->render(program);
 	}
 }
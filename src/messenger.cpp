@@ -1,5 +1,6 @@
 #include "stdafx.h"
 #include <dukat/messenger.h>
+#include <dukat/jobscheduler.h>
 
 namespace dukat
 {
@@ -20,6 +21,13 @@ namespace dukat
 
 	void Messenger::trigger(const Message& message)
 	{
+		// Recipients are not thread-safe, so messages sent from jobs are delivered
+		// once the job has been awaited.
+		if (JobScheduler::is_deferring())
+		{
+			JobScheduler::defer([this, message]() { trigger(message); });
+			return;
+		}
 		if (!subscriptions.count(message.event))
 			return;
 		EventLock lock(active_trigger, message.event);
@@ -12,6 +12,41 @@ namespace dukat
     constexpr size_t Model3::string_length;
     constexpr uint32_t Model3::model_id;
     constexpr uint32_t Model3::model_version;
+    constexpr uint32_t Model3::packed_version;
+    constexpr uint32_t Model3::packed_alignment;
+
+    static_assert(sizeof(Model3::PackedHeader) % Model3::packed_alignment == 0, "Unexpected packed header size");
+    static_assert(sizeof(Model3::PackedMesh) % Model3::packed_alignment == 0, "Unexpected packed mesh size");
+    static_assert(sizeof(Model3::Vertex) == 8 * sizeof(GLfloat), "Unexpected vertex layout");
+
+    static uint32_t align_packed(std::size_t offset)
+    {
+        return static_cast<uint32_t>((offset + Model3::packed_alignment - 1) & ~static_cast<std::size_t>(Model3::packed_alignment - 1));
+    }
+
+    static void write_bounds(GLfloat* dst, const AABB3& bb)
+    {
+        memcpy(dst, &bb.min, sizeof(GLfloat) * 4);
+        memcpy(dst + 4, &bb.max, sizeof(GLfloat) * 4);
+    }
+
+    static AABB3 read_bounds(const GLfloat* src)
+    {
+        return AABB3{ Vector3{ src[0], src[1], src[2] }, Vector3{ src[4], src[5], src[6] } };
+    }
+
+    static Vector3 read_vector(const GLfloat* src)
+    {
+        Vector3 res{ src[0], src[1], src[2] };
+        res.w = src[3];
+        return res;
+    }
+
+    // Returns string of a fixed size field, which is not terminated if it uses the entire field.
+    static std::string read_string(const char* src)
+    {
+        return std::string(src, strnlen(src, Model3::string_length));
+    }
 
     Model3::Model3()
 	{
@@ -161,6 +196,140 @@ namespace dukat
 		return is;
 	}
 
+	void Model3::write_packed(std::ostream& os) const
+	{
+		PackedHeader h;
+		memset(&h, 0, sizeof(PackedHeader));
+		h.id = model_id;
+		h.version = packed_version;
+		memcpy(h.name, header.name, string_length);
+		h.mesh_offset = align_packed(sizeof(PackedHeader));
+		h.mesh_count = static_cast<uint32_t>(meshes.size());
+		h.index_offset = align_packed(h.mesh_offset + meshes.size() * sizeof(PackedMesh));
+		h.index_count = static_cast<uint32_t>(indices.size());
+		h.vertex_offset = align_packed(h.index_offset + indices.size() * sizeof(GLushort));
+		h.vertex_count = static_cast<uint32_t>(vertices.size());
+		h.file_size = static_cast<uint32_t>(h.vertex_offset + vertices.size() * sizeof(Vertex));
+		write_bounds(h.bounds, create_aabb());
+
+		std::size_t pos = 0;
+		auto write = [&os, &pos](const void* data, std::size_t size) {
+			os.write(reinterpret_cast<const char*>(data), size);
+			pos += size;
+		};
+		auto pad = [&write, &pos](uint32_t offset) {
+			static const char zeros[packed_alignment] = { 0 };
+			write(zeros, offset - pos);
+		};
+
+		write(&h, sizeof(PackedHeader));
+		pad(h.mesh_offset);
+		for (const auto& m : meshes)
+		{
+			PackedMesh pm;
+			memset(&pm, 0, sizeof(PackedMesh));
+			pm.id = m.id;
+			pm.index_offset = m.index_offset;
+			pm.index_count = m.index_count;
+			pm.vertex_offset = m.vertex_offset;
+			pm.vertex_count = m.vertex_count;
+			memcpy(pm.material, &m.material.ambient, sizeof(GLfloat) * 4);
+			memcpy(pm.material + 4, &m.material.diffuse, sizeof(GLfloat) * 4);
+			memcpy(pm.material + 8, &m.material.specular, sizeof(GLfloat) * 4);
+			memcpy(pm.material + 12, &m.material.custom, sizeof(GLfloat) * 4);
+			memcpy(pm.transform, &m.transform.position, sizeof(GLfloat) * 4);
+			memcpy(pm.transform + 4, &m.transform.dir, sizeof(GLfloat) * 4);
+			memcpy(pm.transform + 8, &m.transform.up, sizeof(GLfloat) * 4);
+			memcpy(pm.transform + 12, &m.transform.left, sizeof(GLfloat) * 4);
+			memcpy(pm.transform + 16, &m.transform.scale, sizeof(GLfloat) * 4);
+			AABB3 bb;
+			for (auto i = m.vertex_offset; i < m.vertex_offset + m.vertex_count; i++)
+				bb.add(Vector3{ vertices[i].pos[0], vertices[i].pos[1], vertices[i].pos[2] });
+			write_bounds(pm.bounds, bb);
+			memcpy(pm.name, m.name, string_length);
+			memcpy(pm.texture, m.texture, string_length);
+			write(&pm, sizeof(PackedMesh));
+		}
+		pad(h.index_offset);
+		write(indices.data(), sizeof(GLushort) * indices.size());
+		pad(h.vertex_offset);
+		write(vertices.data(), sizeof(Vertex) * vertices.size());
+	}
+
+	MappedModel3::MappedModel3(const std::string& filename) : file(filename), header(nullptr),
+		meshes(nullptr), indices(nullptr), vertices(nullptr)
+	{
+		const auto size = file.size();
+		if (size < sizeof(Model3::PackedHeader))
+			throw std::runtime_error("Invalid model format or version!");
+		header = reinterpret_cast<const Model3::PackedHeader*>(file.data());
+		if (header->id != Model3::model_id || header->version != Model3::packed_version)
+			throw std::runtime_error("Invalid model format or version!");
+		if (header->file_size != size)
+			throw std::runtime_error("Model file is truncated!");
+
+		// Blocks have to be aligned and lie within the file
+		auto valid_block = [size](uint32_t offset, uint32_t count, std::size_t element_size) {
+			return offset % Model3::packed_alignment == 0 && offset <= size 
+				&& static_cast<uint64_t>(count) * element_size <= size - offset;
+		};
+		if (!valid_block(header->mesh_offset, header->mesh_count, sizeof(Model3::PackedMesh))
+			|| !valid_block(header->index_offset, header->index_count, sizeof(GLushort))
+			|| !valid_block(header->vertex_offset, header->vertex_count, sizeof(Model3::Vertex)))
+			throw std::runtime_error("Invalid model layout!");
+
+		meshes = reinterpret_cast<const Model3::PackedMesh*>(file.data() + header->mesh_offset);
+		indices = reinterpret_cast<const GLushort*>(file.data() + header->index_offset);
+		vertices = reinterpret_cast<const Model3::Vertex*>(file.data() + header->vertex_offset);
+		for (auto i = 0u; i < header->mesh_count; i++)
+		{
+			const auto& m = meshes[i];
+			if (static_cast<uint64_t>(m.index_offset) + m.index_count > header->index_count
+				|| static_cast<uint64_t>(m.vertex_offset) + m.vertex_count > header->vertex_count
+				|| m.vertex_count > static_cast<uint32_t>(std::numeric_limits<GLushort>::max()) + 1)
+				throw std::runtime_error("Invalid model layout!");
+		}
+	}
+
+	bool MappedModel3::is_packed(const std::string& filename)
+	{
+		std::ifstream is(filename, std::ifstream::binary);
+		uint32_t id = 0, version = 0;
+		is.read(reinterpret_cast<char*>(&id), sizeof(uint32_t));
+		is.read(reinterpret_cast<char*>(&version), sizeof(uint32_t));
+		return is && id == Model3::model_id && version == Model3::packed_version;
+	}
+
+	std::string MappedModel3::get_name(void) const
+	{
+		return read_string(header->name);
+	}
+
+	AABB3 MappedModel3::get_bounds(void) const
+	{
+		return read_bounds(header->bounds);
+	}
+
+	std::size_t MappedModel3::data_size(void) const
+	{
+		return header->index_count * sizeof(GLushort) + header->vertex_count * sizeof(Model3::Vertex);
+	}
+
+	void MappedModel3::prefetch(void) const
+	{
+		file.prefetch(0, file.size());
+		for (auto i = 0u; i < header->mesh_count; i++)
+		{
+			const auto& m = meshes[i];
+			const auto mesh_indices = get_indices(m);
+			GLushort max_index = 0;
+			for (auto j = 0u; j < m.index_count; j++)
+				max_index = std::max(max_index, mesh_indices[j]);
+			if (m.index_count > 0 && max_index >= m.vertex_count)
+				throw std::runtime_error("Invalid model indices!");
+		}
+	}
+
 	AABB3 Model3::create_aabb(void) const
 	{
 		AABB3 res;
@@ -178,61 +347,99 @@ namespace dukat
 		return res;
 	}
 
-	std::unique_ptr<MeshGroup> build_mesh_group(GameBase* game, const Model3& model)
+	// Returns cached mesh data or uploads a new mesh. Bounds are computed from vertices if not provided.
+	static MeshData* get_mesh_data(GameBase* game, const std::string& mesh_id, const Model3::Vertex* vertices, 
+		uint32_t vertex_count, const GLushort* indices, uint32_t index_count, const AABB3* bounds)
 	{
-		auto res = std::make_unique<MeshGroup>();
+		auto mesh_cache = game->get_meshes();
+		if (mesh_cache->contains(mesh_id))
+			return mesh_cache->get(mesh_id);
 
 		std::vector<VertexAttribute> attr;
 		attr.push_back(VertexAttribute(dukat::Renderer::at_pos, 3, offsetof(Vertex3PNT, px)));
 		attr.push_back(VertexAttribute(dukat::Renderer::at_normal, 3, offsetof(Vertex3PNT, nx)));
 		attr.push_back(VertexAttribute(dukat::Renderer::at_texcoord, 2, offsetof(Vertex3PNT, tu)));
 
-		auto mesh_cache = game->get_meshes();
+		auto src_mesh = std::make_unique<MeshData>(GL_TRIANGLES, vertex_count, index_count, attr);
+		if (bounds != nullptr)
+			src_mesh->set_vertices(reinterpret_cast<const GLfloat*>(vertices), vertex_count, *bounds);
+		else
+			src_mesh->set_vertices(reinterpret_cast<const GLfloat*>(vertices), vertex_count);
+		if (index_count > 0)
+		{
+			src_mesh->set_indices(indices, index_count);
+		}
+		// Store mesh in cache
+		return mesh_cache->put(mesh_id, std::move(src_mesh));
+	}
+
+	static void add_instance(GameBase* game, MeshGroup* group, MeshData* mesh, const std::string& name,
+		const std::string& texture, const Material& material, const Transform3& transform)
+	{
+		auto instance = group->create_instance();
+		instance->set_name(name);
+		instance->set_mesh(mesh);
+		if (texture.length() > 0)
+		{
+			instance->set_texture(game->get_textures()->get_or_load(texture, TextureFilterProfile::ProfileMipMapped));
+		}
+		else
+		{
+			instance->set_texture(game->get_textures()->get_or_load("white.png", TextureFilterProfile::ProfileNearest));
+		}
+		instance->set_material(material);
+		instance->set_program(game->get_shaders()->get_program("sc_texture.vsh", "sc_texture.fsh"));
+		instance->transform = transform;
+	}
+
+	std::unique_ptr<MeshGroup> build_mesh_group(GameBase* game, const Model3& model)
+	{
+		auto res = std::make_unique<MeshGroup>();
 
 		// Create instance for each mesh
 		const auto& indices = model.get_indices();
 		const auto& vertices = model.get_vertices();
 		for (const auto& m : model.get_meshes())
 		{
-			MeshData* mesh;
-			std::string mesh_id = model.get_name() + "|" + m.name;
-			if (mesh_cache->contains(mesh_id))
-			{
-				mesh = mesh_cache->get(mesh_id);
-			}
-			else
-			{
-				auto src_mesh = std::make_unique<MeshData>(GL_TRIANGLES, m.vertex_count, m.index_count, attr);
-				src_mesh->set_vertices(reinterpret_cast<const GLfloat*>(vertices.data() + m.vertex_offset), m.vertex_count);
-				if (m.index_count > 0)
-				{
-					src_mesh->set_indices(reinterpret_cast<const GLushort*>(indices.data() + m.index_offset), m.index_count);
-				}
-				mesh = src_mesh.get();
-				// Store mesh in cache
-				mesh_cache->put(mesh_id, std::move(src_mesh));
-			}
-
-			// Create mesh instance
-			auto instance = res->create_instance();
-			instance->set_name(m.name);
-			instance->set_mesh(mesh);
-			std::string texture(m.texture);
-			if (texture.length() > 0)
-			{
-				instance->set_texture(game->get_textures()->get_or_load(texture, TextureFilterProfile::ProfileMipMapped));
-			}
-			else
-			{
-				instance->set_texture(game->get_textures()->get_or_load("white.png", TextureFilterProfile::ProfileNearest));
-			}
-			instance->set_material(m.material);
-			instance->set_program(game->get_shaders()->get_program("sc_texture.vsh", "sc_texture.fsh"));
-			instance->transform = m.transform;
+			const auto name = read_string(m.name);
+			auto mesh = get_mesh_data(game, model.get_name() + "|" + name, vertices.data() + m.vertex_offset, 
+				m.vertex_count, indices.data() + m.index_offset, m.index_count, nullptr);
+			add_instance(game, res.get(), mesh, name, read_string(m.texture), m.material, m.transform);
 		}
 
 		res->bb = model.create_aabb();
-		//return std::move(res);
+		return res;
+	}
+
+	std::unique_ptr<MeshGroup> build_mesh_group(GameBase* game, const MappedModel3& model)
+	{
+		auto res = std::make_unique<MeshGroup>();
+
+		// Vertex and index data is uploaded from the mapping, using precomputed bounds
+		const auto model_name = model.get_name();
+		for (auto i = 0u; i < model.mesh_count(); i++)
+		{
+			const auto& m = model.get_mesh(i);
+			const auto name = read_string(m.name);
+			const auto bounds = read_bounds(m.bounds);
+			auto mesh = get_mesh_data(game, model_name + "|" + name, model.get_vertices(m), m.vertex_count,
+				model.get_indices(m), m.index_count, &bounds);
+
+			Material material;
+			memcpy(&material.ambient, m.material, sizeof(GLfloat) * 4);
+			memcpy(&material.diffuse, m.material + 4, sizeof(GLfloat) * 4);
+			memcpy(&material.specular, m.material + 8, sizeof(GLfloat) * 4);
+			memcpy(&material.custom, m.material + 12, sizeof(GLfloat) * 4);
+			Transform3 transform;
+			transform.position = read_vector(m.transform);
+			transform.dir = read_vector(m.transform + 4);
+			transform.up = read_vector(m.transform + 8);
+			transform.left = read_vector(m.transform + 12);
+			transform.scale = read_vector(m.transform + 16);
+			add_instance(game, res.get(), mesh, name, read_string(m.texture), material, transform);
+		}
+
+		res->bb = model.get_bounds();
 		return res;
 	}
 }
\ No newline at end of file
@@ -0,0 +1,100 @@
+#include "stdafx.h"
+#include <dukat/modelloader.h>
+#include <dukat/gamebase.h>
+#include <dukat/log.h>
+#include <dukat/meshgroup.h>
+#include <dukat/model3.h>
+
+namespace dukat
+{
+	constexpr std::size_t ModelLoader::default_budget;
+
+	ModelLoader::ModelLoader(GameBase* game) : game(game), pending(0)
+	{
+	}
+
+	ModelLoader::~ModelLoader(void)
+	{
+		// Jobs refer to this loader, so they have to complete first
+		game->get_scheduler()->wait(counter);
+	}
+
+	void ModelLoader::load(const std::string& filename, const Callback& callback)
+	{
+		log->debug("Queueing model: {}", filename);
+		auto request = new Request{ filename, callback, nullptr, nullptr };
+		pending++;
+		game->get_scheduler()->submit([this, request](void) { process(request); }, counter);
+	}
+
+	void ModelLoader::process(Request* request)
+	{
+		std::unique_ptr<Request> r(request);
+		try
+		{
+			r->model = std::make_unique<MappedModel3>(r->filename);
+			r->model->prefetch();
+		}
+		catch (...)
+		{
+			r->model = nullptr;
+			r->error = std::current_exception();
+		}
+		std::lock_guard<std::mutex> lock(mutex);
+		completed.push_back(std::move(r));
+	}
+
+	int ModelLoader::update(std::size_t budget)
+	{
+		auto res = 0;
+		std::size_t uploaded = 0;
+		while (uploaded < budget || res == 0)
+		{
+			std::unique_ptr<Request> r;
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				if (completed.empty())
+					break;
+				r = std::move(completed.front());
+				completed.pop_front();
+			}
+			pending--;
+
+			if (r->error)
+			{
+				try
+				{
+					std::rethrow_exception(r->error);
+				}
+				catch (const std::exception& e)
+				{
+					log->warn("Failed to load model {}: {}", r->filename, e.what());
+				}
+				catch (...)
+				{
+					log->warn("Failed to load model {}: unknown error", r->filename);
+				}
+				continue;
+			}
+
+			// Data is uploaded straight from the mapping, which is released afterwards
+			uploaded += r->model->data_size();
+			auto group = build_mesh_group(game, *r->model);
+			r->model = nullptr;
+			res++;
+			if (r->callback)
+				r->callback(std::move(group));
+		}
+		return res;
+	}
+
+	void ModelLoader::finish(void)
+	{
+		// Callbacks may queue further models
+		while (pending > 0)
+		{
+			game->get_scheduler()->wait(counter);
+			update(std::numeric_limits<std::size_t>::max());
+		}
+	}
+}
\ No newline at end of file
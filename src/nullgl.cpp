@@ -0,0 +1,1317 @@
+#include "stdafx.h"
+#include <dukat/nullgl.h>
+
+namespace dukat
+{
+	// Statistics of the current, the last completed and all completed frames
+	static GLStats current_stats = {};
+	static GLStats frame_stats = {};
+	static GLStats total_stats = {};
+
+	bool NullGL::is_enabled(void)
+	{
+#ifdef DUKAT_NULL_GL
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	const GLStats& NullGL::get_frame_stats(void)
+	{
+		return frame_stats;
+	}
+
+	const GLStats& NullGL::get_total_stats(void)
+	{
+		return total_stats;
+	}
+
+	void NullGL::end_frame(void)
+	{
+		total_stats.calls += current_stats.calls;
+		total_stats.draw_calls += current_stats.draw_calls;
+		total_stats.instances += current_stats.instances;
+		total_stats.vertices += current_stats.vertices;
+		total_stats.state_changes += current_stats.state_changes;
+		total_stats.redundant_changes += current_stats.redundant_changes;
+		total_stats.program_binds += current_stats.program_binds;
+		total_stats.texture_binds += current_stats.texture_binds;
+		total_stats.buffer_binds += current_stats.buffer_binds;
+		total_stats.vertex_array_binds += current_stats.vertex_array_binds;
+		total_stats.framebuffer_binds += current_stats.framebuffer_binds;
+		total_stats.uniform_updates += current_stats.uniform_updates;
+		total_stats.uploaded_bytes += current_stats.uploaded_bytes;
+		frame_stats = current_stats;
+		current_stats = GLStats{};
+	}
+}
+
+#ifdef DUKAT_NULL_GL
+
+namespace dukat
+{
+	struct NullShader
+	{
+		GLenum type;
+		std::string source;
+	};
+
+	struct NullUniform
+	{
+		std::string name;
+		GLenum type;
+		GLint size;
+	};
+
+	struct NullProgram
+	{
+		std::vector<GLuint> shaders;
+		// Declared uniforms, location is the index into this list
+		std::vector<NullUniform> uniforms;
+		// Declared vertex attributes and their locations
+		std::vector<std::pair<std::string, GLint>> attributes;
+		// Location assigned to the next attribute without explicit location
+		GLint next_location;
+		// Declared uniform blocks, block index is the index into this list
+		std::vector<std::string> blocks;
+	};
+
+	struct NullBuffer
+	{
+		// Backing store, only allocated once the buffer is mapped
+		std::vector<uint8_t> data;
+		GLsizeiptr map_length;
+		GLbitfield map_access;
+	};
+
+	struct NullTexture
+	{
+		GLint internal_format;
+		GLsizei width;
+		GLsizei height;
+	};
+
+	// Objects and pipeline state of the null backend.
+	struct NullState
+	{
+		GLuint next_id;
+		uintptr_t next_sync;
+		std::unordered_map<GLuint, NullShader> shaders;
+		std::unordered_map<GLuint, NullProgram> programs;
+		std::unordered_map<GLuint, NullBuffer> buffers;
+		std::unordered_map<GLuint, NullTexture> textures;
+
+		GLuint program;
+		GLuint vertex_array;
+		GLuint draw_framebuffer;
+		GLuint read_framebuffer;
+		GLuint renderbuffer;
+		GLenum active_texture;
+		// Keyed by texture unit and target
+		std::unordered_map<uint64_t, GLuint> texture_bindings;
+		std::unordered_map<GLenum, GLuint> buffer_bindings;
+		// Keyed by target and binding point
+		std::unordered_map<uint64_t, GLuint> indexed_buffer_bindings;
+		// Keyed by vertex array and attribute index
+		std::unordered_map<uint64_t, bool> attribute_arrays;
+		std::unordered_map<GLenum, bool> caps;
+		GLenum blend_src, blend_dst;
+		GLenum depth_func;
+		GLenum cull_face;
+		GLenum front_face;
+		GLenum polygon_mode[2];
+		GLint viewport[4];
+		GLfloat clear_color[4];
+
+		NullState(void) : next_id(1), next_sync(0), program(0), vertex_array(0), draw_framebuffer(0), read_framebuffer(0),
+			renderbuffer(0), active_texture(GL_TEXTURE0), blend_src(GL_ONE), blend_dst(GL_ZERO), depth_func(GL_LESS),
+			cull_face(GL_BACK), front_face(GL_CCW), polygon_mode{ GL_FILL, GL_FILL }, viewport{ 0, 0, 0, 0 },
+			clear_color{ 0.0f, 0.0f, 0.0f, 0.0f } { }
+	};
+
+	static NullState& null_state(void)
+	{
+		static NullState state;
+		return state;
+	}
+
+	static inline uint64_t pair_key(uint32_t a, uint32_t b)
+	{
+		return (static_cast<uint64_t>(a) << 32) | b;
+	}
+
+	static inline void record_call(void)
+	{
+		current_stats.calls++;
+	}
+
+	// Records a state change and applies it. Returns true if the value differed from the current value.
+	template<typename T>
+	static bool change_state(T& current, const T& value)
+	{
+		current_stats.state_changes++;
+		if (current == value)
+		{
+			current_stats.redundant_changes++;
+			return false;
+		}
+		current = value;
+		return true;
+	}
+
+	static void record_draw(GLsizei count, GLsizei instances)
+	{
+		current_stats.draw_calls++;
+		current_stats.instances += static_cast<uint64_t>(instances);
+		current_stats.vertices += static_cast<uint64_t>(count) * static_cast<uint64_t>(instances);
+	}
+
+	// Returns size of a pixel in bytes.
+	static std::size_t pixel_size(GLenum format, GLenum type)
+	{
+		switch (type)
+		{
+		case GL_UNSIGNED_SHORT_5_6_5:
+		case GL_UNSIGNED_SHORT_4_4_4_4:
+		case GL_UNSIGNED_SHORT_5_5_5_1:
+			return 2;
+		case GL_UNSIGNED_INT_2_10_10_10_REV:
+		case GL_UNSIGNED_INT_10F_11F_11F_REV:
+		case GL_UNSIGNED_INT_24_8:
+			return 4;
+		}
+
+		std::size_t components;
+		switch (format)
+		{
+		case GL_RED:
+		case GL_RED_INTEGER:
+		case GL_DEPTH_COMPONENT:
+		case GL_ALPHA:
+			components = 1;
+			break;
+		case GL_RG:
+		case GL_RG_INTEGER:
+			components = 2;
+			break;
+		case GL_RGB:
+		case GL_RGB_INTEGER:
+#ifdef GL_BGR
+		case GL_BGR:
+#endif
+			components = 3;
+			break;
+		default:
+			components = 4;
+			break;
+		}
+
+		switch (type)
+		{
+		case GL_UNSIGNED_SHORT:
+		case GL_SHORT:
+		case GL_HALF_FLOAT:
+			return 2 * components;
+		case GL_UNSIGNED_INT:
+		case GL_INT:
+		case GL_FLOAT:
+			return 4 * components;
+		default:
+			return components;
+		}
+	}
+
+	static void record_upload(std::size_t bytes)
+	{
+		current_stats.uploaded_bytes += bytes;
+	}
+
+	static void record_upload(GLsizei width, GLsizei height, GLsizei depth, GLenum format, GLenum type, const void* pixels)
+	{
+		if (pixels != nullptr)
+			record_upload(static_cast<std::size_t>(width) * height * depth * pixel_size(format, type));
+	}
+
+	static NullBuffer* bound_buffer(GLenum target)
+	{
+		auto& state = null_state();
+		auto it = state.buffer_bindings.find(target);
+		if (it == state.buffer_bindings.end() || it->second == 0)
+			return nullptr;
+		return &state.buffers[it->second];
+	}
+
+	static NullTexture* bound_texture(GLenum target)
+	{
+		auto& state = null_state();
+		if (target >= GL_TEXTURE_CUBE_MAP_POSITIVE_X && target <= GL_TEXTURE_CUBE_MAP_NEGATIVE_Z)
+			target = GL_TEXTURE_CUBE_MAP;
+		auto it = state.texture_bindings.find(pair_key(state.active_texture, target));
+		if (it == state.texture_bindings.end() || it->second == 0)
+			return nullptr;
+		return &state.textures[it->second];
+	}
+
+	static void define_texture(GLenum target, GLint level, GLint internal_format, GLsizei width, GLsizei height)
+	{
+		auto texture = bound_texture(target);
+		if (texture != nullptr && level == 0)
+		{
+			texture->internal_format = internal_format;
+			texture->width = width;
+			texture->height = height;
+		}
+	}
+
+	static void generate_ids(GLsizei n, GLuint* ids)
+	{
+		auto& state = null_state();
+		for (auto i = 0; i < n; i++)
+			ids[i] = state.next_id++;
+	}
+
+	static void copy_string(const std::string& str, GLsizei buf_size, GLsizei* length, GLchar* buffer)
+	{
+		if (buf_size <= 0)
+			return;
+		const auto n = std::min(static_cast<GLsizei>(str.size()), buf_size - 1);
+		std::memcpy(buffer, str.c_str(), n);
+		buffer[n] = '\0';
+		if (length != nullptr)
+			*length = n;
+	}
+
+	// Splits GLSL source into identifiers, numbers and single-character symbols.
+	// Skips comments and preprocessor directives.
+	static std::vector<std::string> tokenize_glsl(const std::string& source)
+	{
+		std::vector<std::string> tokens;
+		auto line_start = true;
+		for (std::size_t i = 0; i < source.size(); )
+		{
+			const auto c = source[i];
+			if (c == '\n')
+			{
+				line_start = true;
+				i++;
+			}
+			else if (std::isspace(static_cast<unsigned char>(c)))
+			{
+				i++;
+			}
+			else if (c == '#' && line_start)
+			{
+				i = source.find('\n', i);
+			}
+			else if (source.compare(i, 2, "//") == 0)
+			{
+				i = source.find('\n', i);
+			}
+			else if (source.compare(i, 2, "/*") == 0)
+			{
+				const auto end = source.find("*/", i + 2);
+				i = end == std::string::npos ? end : end + 2;
+			}
+			else if (std::isalnum(static_cast<unsigned char>(c)) || c == '_')
+			{
+				auto j = i + 1;
+				while (j < source.size() && (std::isalnum(static_cast<unsigned char>(source[j])) || source[j] == '_' || source[j] == '.'))
+					j++;
+				tokens.push_back(source.substr(i, j - i));
+				line_start = false;
+				i = j;
+			}
+			else
+			{
+				tokens.push_back(std::string(1, c));
+				line_start = false;
+				i++;
+			}
+		}
+		return tokens;
+	}
+
+	// Maps a GLSL type name to the type reported for active uniforms.
+	static GLenum glsl_type(const std::string& name)
+	{
+		static const std::unordered_map<std::string, GLenum> types = {
+			{ "float", GL_FLOAT }, { "vec2", GL_FLOAT_VEC2 }, { "vec3", GL_FLOAT_VEC3 }, { "vec4", GL_FLOAT_VEC4 },
+			{ "int", GL_INT }, { "ivec2", GL_INT_VEC2 }, { "ivec3", GL_INT_VEC3 }, { "ivec4", GL_INT_VEC4 },
+			{ "uint", GL_UNSIGNED_INT }, { "bool", GL_BOOL },
+			{ "mat2", GL_FLOAT_MAT2 }, { "mat3", GL_FLOAT_MAT3 }, { "mat4", GL_FLOAT_MAT4 },
+			{ "sampler2D", GL_SAMPLER_2D }, { "sampler3D", GL_SAMPLER_3D }, { "samplerCube", GL_SAMPLER_CUBE },
+			{ "sampler2DShadow", GL_SAMPLER_2D_SHADOW }, { "sampler2DArray", GL_SAMPLER_2D_ARRAY } };
+		auto it = types.find(name);
+		return it == types.end() ? GL_FLOAT_VEC4 : it->second;
+	}
+
+	// Adds a declaration found at global scope of a shader to a program.
+	static void add_declaration(const std::vector<std::string>& stmt, bool vertex_shader, NullProgram& program)
+	{
+		static const std::set<std::string> qualifiers = { "flat", "smooth", "noperspective", "centroid",
+			"invariant", "precise", "highp", "mediump", "lowp" };
+
+		GLint location = -1;
+		std::size_t i = 0;
+		while (i < stmt.size())
+		{
+			if (stmt[i] == "layout")
+			{
+				// parse layout qualifier for explicit location
+				for (i++; i < stmt.size() && stmt[i] != ")"; i++)
+				{
+					if (stmt[i] == "location" && i + 2 < stmt.size() && stmt[i + 1] == "=")
+						location = std::atoi(stmt[i + 2].c_str());
+				}
+				i++;
+			}
+			else if (qualifiers.count(stmt[i]) > 0)
+			{
+				i++;
+			}
+			else
+			{
+				break;
+			}
+		}
+		if (i >= stmt.size())
+			return;
+
+		const auto& storage = stmt[i];
+		const auto is_uniform = storage == "uniform";
+		const auto is_attribute = vertex_shader && (storage == "in" || storage == "attribute");
+		if (!is_uniform && !is_attribute)
+			return;
+
+		// name precedes array size or initializer
+		auto end = i + 1;
+		while (end < stmt.size() && stmt[end] != "[" && stmt[end] != "=")
+			end++;
+		if (end < i + 3)
+			return; // missing type or name
+		auto name = stmt[end - 1];
+		auto size = 1;
+		if (end < stmt.size() && stmt[end] == "[")
+		{
+			name += "[0]";
+			if (end + 1 < stmt.size())
+				size = std::max(1, std::atoi(stmt[end + 1].c_str()));
+		}
+
+		if (is_uniform)
+		{
+			for (const auto& u : program.uniforms)
+			{
+				if (u.name == name)
+					return;
+			}
+			program.uniforms.push_back(NullUniform{ name, glsl_type(stmt[end - 2]), size });
+		}
+		else
+		{
+			for (const auto& a : program.attributes)
+			{
+				if (a.first == name)
+					return;
+			}
+			// matrix attributes occupy one location per column
+			const auto type = glsl_type(stmt[end - 2]);
+			const auto slots = type == GL_FLOAT_MAT4 ? 4 : type == GL_FLOAT_MAT3 ? 3 : type == GL_FLOAT_MAT2 ? 2 : 1;
+			if (location < 0)
+				location = program.next_location;
+			program.next_location = std::max(program.next_location, location + slots * size);
+			program.attributes.push_back(std::make_pair(name, location));
+		}
+	}
+
+	// Collects uniforms, uniform blocks and vertex attributes declared by a shader.
+	static void scan_shader(const NullShader& shader, NullProgram& program)
+	{
+		const auto tokens = tokenize_glsl(shader.source);
+		const auto vertex_shader = shader.type == GL_VERTEX_SHADER;
+		std::vector<std::string> stmt;
+		auto depth = 0;
+		for (const auto& t : tokens)
+		{
+			if (depth > 0)
+			{
+				if (t == "{")
+					depth++;
+				else if (t == "}" && --depth == 0)
+					stmt.clear();
+			}
+			else if (t == "{")
+			{
+				// uniform block or function body
+				auto it = std::find(stmt.begin(), stmt.end(), "uniform");
+				if (it != stmt.end() && it + 1 != stmt.end())
+					program.blocks.push_back(*(it + 1));
+				stmt.clear();
+				depth++;
+			}
+			else if (t == ";")
+			{
+				add_declaration(stmt, vertex_shader, program);
+				stmt.clear();
+			}
+			else
+			{
+				stmt.push_back(t);
+			}
+		}
+	}
+
+	static NullProgram* find_program(GLuint id)
+	{
+		auto& state = null_state();
+		auto it = state.programs.find(id);
+		return it == state.programs.end() ? nullptr : &it->second;
+	}
+}
+
+using namespace dukat;
+
+void dukat_glActiveTexture(GLenum texture)
+{
+	record_call();
+	change_state(null_state().active_texture, texture);
+}
+
+void dukat_glAttachShader(GLuint program, GLuint shader)
+{
+	record_call();
+	null_state().programs[program].shaders.push_back(shader);
+}
+
+void dukat_glBindBuffer(GLenum target, GLuint buffer)
+{
+	record_call();
+	current_stats.buffer_binds++;
+	change_state(null_state().buffer_bindings[target], buffer);
+}
+
+void dukat_glBindBufferBase(GLenum target, GLuint index, GLuint buffer)
+{
+	record_call();
+	current_stats.buffer_binds++;
+	auto& state = null_state();
+	change_state(state.indexed_buffer_bindings[pair_key(target, index)], buffer);
+	// also binds the generic binding point
+	state.buffer_bindings[target] = buffer;
+}
+
+void dukat_glBindFragDataLocation(GLuint program, GLuint color, const GLchar* name)
+{
+	record_call();
+}
+
+void dukat_glBindFramebuffer(GLenum target, GLuint framebuffer)
+{
+	record_call();
+	current_stats.framebuffer_binds++;
+	auto& state = null_state();
+	switch (target)
+	{
+	case GL_DRAW_FRAMEBUFFER:
+		change_state(state.draw_framebuffer, framebuffer);
+		break;
+	case GL_READ_FRAMEBUFFER:
+		change_state(state.read_framebuffer, framebuffer);
+		break;
+	default:
+	{
+		// binds both draw and read framebuffer
+		auto current = pair_key(state.draw_framebuffer, state.read_framebuffer);
+		if (change_state(current, pair_key(framebuffer, framebuffer)))
+			state.draw_framebuffer = state.read_framebuffer = framebuffer;
+		break;
+	}
+	}
+}
+
+void dukat_glBindRenderbuffer(GLenum target, GLuint renderbuffer)
+{
+	record_call();
+	change_state(null_state().renderbuffer, renderbuffer);
+}
+
+void dukat_glBindTexture(GLenum target, GLuint texture)
+{
+	record_call();
+	current_stats.texture_binds++;
+	auto& state = null_state();
+	change_state(state.texture_bindings[pair_key(state.active_texture, target)], texture);
+}
+
+void dukat_glBindVertexArray(GLuint array)
+{
+	record_call();
+	current_stats.vertex_array_binds++;
+	change_state(null_state().vertex_array, array);
+}
+
+void dukat_glBlendFunc(GLenum sfactor, GLenum dfactor)
+{
+	record_call();
+	auto& state = null_state();
+	auto current = pair_key(state.blend_src, state.blend_dst);
+	if (change_state(current, pair_key(sfactor, dfactor)))
+	{
+		state.blend_src = sfactor;
+		state.blend_dst = dfactor;
+	}
+}
+
+void dukat_glBufferData(GLenum target, GLsizeiptr size, const void* data, GLenum usage)
+{
+	record_call();
+	auto buffer = bound_buffer(target);
+	if (buffer != nullptr && !buffer->data.empty())
+		buffer->data.resize(static_cast<std::size_t>(size));
+	if (data != nullptr)
+		record_upload(static_cast<std::size_t>(size));
+}
+
+void dukat_glBufferStorage(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags)
+{
+	record_call();
+	if (data != nullptr)
+		record_upload(static_cast<std::size_t>(size));
+}
+
+void dukat_glBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void* data)
+{
+	record_call();
+	record_upload(static_cast<std::size_t>(size));
+}
+
+GLenum dukat_glCheckFramebufferStatus(GLenum target)
+{
+	record_call();
+	return GL_FRAMEBUFFER_COMPLETE;
+}
+
+void dukat_glClear(GLbitfield mask)
+{
+	record_call();
+}
+
+void dukat_glClearColor(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha)
+{
+	record_call();
+	auto& clr = null_state().clear_color;
+	current_stats.state_changes++;
+	if (clr[0] == red && clr[1] == green && clr[2] == blue && clr[3] == alpha)
+	{
+		current_stats.redundant_changes++;
+		return;
+	}
+	clr[0] = red;
+	clr[1] = green;
+	clr[2] = blue;
+	clr[3] = alpha;
+}
+
+GLenum dukat_glClientWaitSync(GLsync sync, GLbitfield flags, GLuint64 timeout)
+{
+	record_call();
+	return GL_ALREADY_SIGNALED;
+}
+
+void dukat_glCompileShader(GLuint shader)
+{
+	record_call();
+}
+
+void dukat_glCompressedTexImage2D(GLenum target, GLint level, GLenum internalformat, GLsizei width, GLsizei height, GLint border, GLsizei image_size, const void* data)
+{
+	record_call();
+	define_texture(target, level, internalformat, width, height);
+	if (data != nullptr)
+		record_upload(static_cast<std::size_t>(image_size));
+}
+
+GLuint dukat_glCreateProgram(void)
+{
+	record_call();
+	auto& state = null_state();
+	const auto id = state.next_id++;
+	state.programs[id] = NullProgram{};
+	return id;
+}
+
+GLuint dukat_glCreateShader(GLenum type)
+{
+	record_call();
+	auto& state = null_state();
+	const auto id = state.next_id++;
+	state.shaders[id] = NullShader{ type, "" };
+	return id;
+}
+
+void dukat_glCullFace(GLenum mode)
+{
+	record_call();
+	change_state(null_state().cull_face, mode);
+}
+
+void dukat_glDeleteBuffers(GLsizei n, const GLuint* buffers)
+{
+	record_call();
+	for (auto i = 0; i < n; i++)
+		null_state().buffers.erase(buffers[i]);
+}
+
+void dukat_glDeleteFramebuffers(GLsizei n, const GLuint* framebuffers)
+{
+	record_call();
+}
+
+void dukat_glDeleteProgram(GLuint program)
+{
+	record_call();
+	null_state().programs.erase(program);
+}
+
+void dukat_glDeleteRenderbuffers(GLsizei n, const GLuint* renderbuffers)
+{
+	record_call();
+}
+
+void dukat_glDeleteShader(GLuint shader)
+{
+	record_call();
+	null_state().shaders.erase(shader);
+}
+
+void dukat_glDeleteSync(GLsync sync)
+{
+	record_call();
+}
+
+void dukat_glDeleteTextures(GLsizei n, const GLuint* textures)
+{
+	record_call();
+	for (auto i = 0; i < n; i++)
+		null_state().textures.erase(textures[i]);
+}
+
+void dukat_glDeleteVertexArrays(GLsizei n, const GLuint* arrays)
+{
+	record_call();
+}
+
+void dukat_glDepthFunc(GLenum func)
+{
+	record_call();
+	change_state(null_state().depth_func, func);
+}
+
+void dukat_glDetachShader(GLuint program, GLuint shader)
+{
+	record_call();
+	auto p = find_program(program);
+	if (p != nullptr)
+		p->shaders.erase(std::remove(p->shaders.begin(), p->shaders.end(), shader), p->shaders.end());
+}
+
+void dukat_glDisable(GLenum cap)
+{
+	record_call();
+	change_state(null_state().caps[cap], false);
+}
+
+void dukat_glDisableVertexAttribArray(GLuint index)
+{
+	record_call();
+	auto& state = null_state();
+	change_state(state.attribute_arrays[pair_key(state.vertex_array, index)], false);
+}
+
+void dukat_glDrawArrays(GLenum mode, GLint first, GLsizei count)
+{
+	record_call();
+	record_draw(count, 1);
+}
+
+void dukat_glDrawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei instancecount)
+{
+	record_call();
+	record_draw(count, instancecount);
+}
+
+void dukat_glDrawElements(GLenum mode, GLsizei count, GLenum type, const void* indices)
+{
+	record_call();
+	record_draw(count, 1);
+}
+
+void dukat_glDrawElementsInstanced(GLenum mode, GLsizei count, GLenum type, const void* indices, GLsizei instancecount)
+{
+	record_call();
+	record_draw(count, instancecount);
+}
+
+void dukat_glEnable(GLenum cap)
+{
+	record_call();
+	change_state(null_state().caps[cap], true);
+}
+
+void dukat_glEnableVertexAttribArray(GLuint index)
+{
+	record_call();
+	auto& state = null_state();
+	change_state(state.attribute_arrays[pair_key(state.vertex_array, index)], true);
+}
+
+GLsync dukat_glFenceSync(GLenum condition, GLbitfield flags)
+{
+	record_call();
+	return reinterpret_cast<GLsync>(++null_state().next_sync);
+}
+
+void dukat_glFinish(void)
+{
+	record_call();
+}
+
+void dukat_glFlushMappedBufferRange(GLenum target, GLintptr offset, GLsizeiptr length)
+{
+	record_call();
+	record_upload(static_cast<std::size_t>(length));
+}
+
+void dukat_glFramebufferRenderbuffer(GLenum target, GLenum attachment, GLenum renderbuffertarget, GLuint renderbuffer)
+{
+	record_call();
+	current_stats.state_changes++;
+}
+
+void dukat_glFramebufferTexture2D(GLenum target, GLenum attachment, GLenum textarget, GLuint texture, GLint level)
+{
+	record_call();
+	current_stats.state_changes++;
+}
+
+void dukat_glFramebufferTextureLayer(GLenum target, GLenum attachment, GLuint texture, GLint level, GLint layer)
+{
+	record_call();
+	current_stats.state_changes++;
+}
+
+void dukat_glFrontFace(GLenum mode)
+{
+	record_call();
+	change_state(null_state().front_face, mode);
+}
+
+void dukat_glGenBuffers(GLsizei n, GLuint* buffers)
+{
+	record_call();
+	generate_ids(n, buffers);
+}
+
+void dukat_glGenFramebuffers(GLsizei n, GLuint* framebuffers)
+{
+	record_call();
+	generate_ids(n, framebuffers);
+}
+
+void dukat_glGenRenderbuffers(GLsizei n, GLuint* renderbuffers)
+{
+	record_call();
+	generate_ids(n, renderbuffers);
+}
+
+void dukat_glGenTextures(GLsizei n, GLuint* textures)
+{
+	record_call();
+	generate_ids(n, textures);
+}
+
+void dukat_glGenVertexArrays(GLsizei n, GLuint* arrays)
+{
+	record_call();
+	generate_ids(n, arrays);
+}
+
+void dukat_glGenerateMipmap(GLenum target)
+{
+	record_call();
+}
+
+void dukat_glGetActiveAttrib(GLuint program, GLuint index, GLsizei buf_size, GLsizei* length, GLint* size, GLenum* type, GLchar* name)
+{
+	record_call();
+	auto p = find_program(program);
+	if (p == nullptr || index >= p->attributes.size())
+		return;
+	copy_string(p->attributes[index].first, buf_size, length, name);
+	*size = 1;
+	*type = GL_FLOAT_VEC4;
+}
+
+void dukat_glGetActiveUniform(GLuint program, GLuint index, GLsizei buf_size, GLsizei* length, GLint* size, GLenum* type, GLchar* name)
+{
+	record_call();
+	auto p = find_program(program);
+	if (p == nullptr || index >= p->uniforms.size())
+		return;
+	const auto& u = p->uniforms[index];
+	copy_string(u.name, buf_size, length, name);
+	*size = u.size;
+	*type = u.type;
+}
+
+GLint dukat_glGetAttribLocation(GLuint program, const GLchar* name)
+{
+	record_call();
+	auto p = find_program(program);
+	if (p != nullptr)
+	{
+		for (const auto& a : p->attributes)
+		{
+			if (a.first == name)
+				return a.second;
+		}
+	}
+	return -1;
+}
+
+GLenum dukat_glGetError(void)
+{
+	record_call();
+	return GL_NO_ERROR;
+}
+
+void dukat_glGetFloatv(GLenum pname, GLfloat* data)
+{
+	record_call();
+	switch (pname)
+	{
+#ifdef GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT
+	case GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT:
+		*data = 16.0f;
+		break;
+#endif
+	default:
+		*data = 0.0f;
+		break;
+	}
+}
+
+void dukat_glGetIntegerv(GLenum pname, GLint* data)
+{
+	record_call();
+	auto& state = null_state();
+	switch (pname)
+	{
+	case GL_VIEWPORT:
+		std::copy(state.viewport, state.viewport + 4, data);
+		break;
+	case GL_CURRENT_PROGRAM:
+		*data = static_cast<GLint>(state.program);
+		break;
+	case GL_DRAW_FRAMEBUFFER_BINDING:
+		*data = static_cast<GLint>(state.draw_framebuffer);
+		break;
+	case GL_READ_FRAMEBUFFER_BINDING:
+		*data = static_cast<GLint>(state.read_framebuffer);
+		break;
+	case GL_MAX_TEXTURE_SIZE:
+		*data = 16384;
+		break;
+	case GL_MAX_TEXTURE_IMAGE_UNITS:
+	case GL_MAX_VERTEX_TEXTURE_IMAGE_UNITS:
+		*data = 32;
+		break;
+	case GL_MAX_COMBINED_TEXTURE_IMAGE_UNITS:
+		*data = 192;
+		break;
+	case GL_MAX_UNIFORM_BUFFER_BINDINGS:
+		*data = 84;
+		break;
+	case GL_MAX_UNIFORM_BLOCK_SIZE:
+		*data = 65536;
+		break;
+	case GL_MAX_VERTEX_UNIFORM_BLOCKS:
+		*data = 14;
+		break;
+	default:
+		*data = 0;
+		break;
+	}
+}
+
+void dukat_glGetInternalformativ(GLenum target, GLenum internalformat, GLenum pname, GLsizei buf_size, GLint* params)
+{
+	record_call();
+	if (buf_size > 0)
+		params[0] = static_cast<GLint>(internalformat);
+}
+
+void dukat_glGetProgramiv(GLuint program, GLenum pname, GLint* params)
+{
+	record_call();
+	auto p = find_program(program);
+	switch (pname)
+	{
+	case GL_ACTIVE_UNIFORMS:
+		*params = p == nullptr ? 0 : static_cast<GLint>(p->uniforms.size());
+		break;
+	case GL_ACTIVE_ATTRIBUTES:
+		*params = p == nullptr ? 0 : static_cast<GLint>(p->attributes.size());
+		break;
+	case GL_ACTIVE_UNIFORM_BLOCKS:
+		*params = p == nullptr ? 0 : static_cast<GLint>(p->blocks.size());
+		break;
+	case GL_LINK_STATUS:
+	case GL_VALIDATE_STATUS:
+		*params = p == nullptr ? GL_FALSE : GL_TRUE;
+		break;
+	default:
+		*params = 0;
+		break;
+	}
+}
+
+void dukat_glGetShaderInfoLog(GLuint shader, GLsizei buf_size, GLsizei* length, GLchar* info_log)
+{
+	record_call();
+	copy_string("", buf_size, length, info_log);
+}
+
+void dukat_glGetShaderiv(GLuint shader, GLenum pname, GLint* params)
+{
+	record_call();
+	switch (pname)
+	{
+	case GL_COMPILE_STATUS:
+		*params = GL_TRUE;
+		break;
+	case GL_SHADER_TYPE:
+		*params = static_cast<GLint>(null_state().shaders[shader].type);
+		break;
+	default:
+		*params = 0;
+		break;
+	}
+}
+
+const GLubyte* dukat_glGetString(GLenum name)
+{
+	record_call();
+	switch (name)
+	{
+	case GL_VENDOR:
+		return reinterpret_cast<const GLubyte*>("dukat");
+	case GL_RENDERER:
+		return reinterpret_cast<const GLubyte*>("Null renderer");
+	case GL_VERSION:
+		return reinterpret_cast<const GLubyte*>("3.3 Null");
+	case GL_SHADING_LANGUAGE_VERSION:
+		return reinterpret_cast<const GLubyte*>("3.30 Null");
+	default:
+		return reinterpret_cast<const GLubyte*>("");
+	}
+}
+
+void dukat_glGetTexLevelParameteriv(GLenum target, GLint level, GLenum pname, GLint* params)
+{
+	record_call();
+	auto texture = bound_texture(target);
+	switch (pname)
+	{
+	case GL_TEXTURE_INTERNAL_FORMAT:
+		*params = texture == nullptr ? GL_RGBA : texture->internal_format;
+		break;
+	case GL_TEXTURE_WIDTH:
+		*params = texture == nullptr ? 0 : std::max(1, texture->width >> level);
+		break;
+	case GL_TEXTURE_HEIGHT:
+		*params = texture == nullptr ? 0 : std::max(1, texture->height >> level);
+		break;
+	default:
+		*params = 0;
+		break;
+	}
+}
+
+GLuint dukat_glGetUniformBlockIndex(GLuint program, const GLchar* block_name)
+{
+	record_call();
+	auto p = find_program(program);
+	if (p != nullptr)
+	{
+		auto it = std::find(p->blocks.begin(), p->blocks.end(), block_name);
+		if (it != p->blocks.end())
+			return static_cast<GLuint>(it - p->blocks.begin());
+	}
+	return GL_INVALID_INDEX;
+}
+
+GLint dukat_glGetUniformLocation(GLuint program, const GLchar* name)
+{
+	record_call();
+	auto p = find_program(program);
+	if (p != nullptr)
+	{
+		for (std::size_t i = 0; i < p->uniforms.size(); i++)
+		{
+			if (p->uniforms[i].name == name)
+				return static_cast<GLint>(i);
+		}
+	}
+	return -1;
+}
+
+void dukat_glLinkProgram(GLuint program)
+{
+	record_call();
+	auto& state = null_state();
+	auto p = find_program(program);
+	if (p == nullptr)
+		return;
+	p->uniforms.clear();
+	p->attributes.clear();
+	p->next_location = 0;
+	p->blocks.clear();
+	for (auto id : p->shaders)
+	{
+		auto it = state.shaders.find(id);
+		if (it != state.shaders.end())
+			scan_shader(it->second, *p);
+	}
+}
+
+void* dukat_glMapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access)
+{
+	record_call();
+	auto buffer = bound_buffer(target);
+	if (buffer == nullptr)
+		return nullptr;
+	const auto size = static_cast<std::size_t>(offset + length);
+	if (buffer->data.size() < size)
+		buffer->data.resize(size);
+	buffer->map_length = length;
+	buffer->map_access = access;
+	return buffer->data.data() + offset;
+}
+
+void dukat_glPixelStorei(GLenum pname, GLint param)
+{
+	record_call();
+	current_stats.state_changes++;
+}
+
+void dukat_glPolygonMode(GLenum face, GLenum mode)
+{
+	record_call();
+	auto& state = null_state();
+	switch (face)
+	{
+	case GL_FRONT:
+		change_state(state.polygon_mode[0], mode);
+		break;
+	case GL_BACK:
+		change_state(state.polygon_mode[1], mode);
+		break;
+	default:
+	{
+		auto current = pair_key(state.polygon_mode[0], state.polygon_mode[1]);
+		if (change_state(current, pair_key(mode, mode)))
+			state.polygon_mode[0] = state.polygon_mode[1] = mode;
+		break;
+	}
+	}
+}
+
+void dukat_glPrimitiveRestartIndex(GLuint index)
+{
+	record_call();
+	current_stats.state_changes++;
+}
+
+void dukat_glReadPixels(GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, void* pixels)
+{
+	record_call();
+	std::memset(pixels, 0, static_cast<std::size_t>(width) * height * pixel_size(format, type));
+}
+
+void dukat_glRenderbufferStorage(GLenum target, GLenum internalformat, GLsizei width, GLsizei height)
+{
+	record_call();
+}
+
+void dukat_glShaderSource(GLuint shader, GLsizei count, const GLchar* const* string, const GLint* length)
+{
+	record_call();
+	auto& source = null_state().shaders[shader].source;
+	source.clear();
+	for (auto i = 0; i < count; i++)
+	{
+		if (length != nullptr && length[i] >= 0)
+			source.append(string[i], length[i]);
+		else
+			source.append(string[i]);
+	}
+}
+
+void dukat_glTexImage1D(GLenum target, GLint level, GLint internalformat, GLsizei width, GLint border, GLenum format, GLenum type, const void* pixels)
+{
+	record_call();
+	define_texture(target, level, internalformat, width, 1);
+	record_upload(width, 1, 1, format, type, pixels);
+}
+
+void dukat_glTexImage2D(GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const void* pixels)
+{
+	record_call();
+	define_texture(target, level, internalformat, width, height);
+	record_upload(width, height, 1, format, type, pixels);
+}
+
+void dukat_glTexImage3D(GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height, GLsizei depth, GLint border, GLenum format, GLenum type, const void* pixels)
+{
+	record_call();
+	define_texture(target, level, internalformat, width, height);
+	record_upload(width, height, depth, format, type, pixels);
+}
+
+void dukat_glTexParameterf(GLenum target, GLenum pname, GLfloat param)
+{
+	record_call();
+	current_stats.state_changes++;
+}
+
+void dukat_glTexParameteri(GLenum target, GLenum pname, GLint param)
+{
+	record_call();
+	current_stats.state_changes++;
+}
+
+void dukat_glTexSubImage2D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height, GLenum format, GLenum type, const void* pixels)
+{
+	record_call();
+	record_upload(width, height, 1, format, type, pixels);
+}
+
+void dukat_glTexSubImage3D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLint zoffset, GLsizei width, GLsizei height, GLsizei depth, GLenum format, GLenum type, const void* pixels)
+{
+	record_call();
+	record_upload(width, height, depth, format, type, pixels);
+}
+
+void dukat_glUniform1f(GLint location, GLfloat v0)
+{
+	record_call();
+	current_stats.uniform_updates++;
+}
+
+void dukat_glUniform1fv(GLint location, GLsizei count, const GLfloat* value)
+{
+	record_call();
+	current_stats.uniform_updates++;
+}
+
+void dukat_glUniform1i(GLint location, GLint v0)
+{
+	record_call();
+	current_stats.uniform_updates++;
+}
+
+void dukat_glUniform2f(GLint location, GLfloat v0, GLfloat v1)
+{
+	record_call();
+	current_stats.uniform_updates++;
+}
+
+void dukat_glUniform2fv(GLint location, GLsizei count, const GLfloat* value)
+{
+	record_call();
+	current_stats.uniform_updates++;
+}
+
+void dukat_glUniform3f(GLint location, GLfloat v0, GLfloat v1, GLfloat v2)
+{
+	record_call();
+	current_stats.uniform_updates++;
+}
+
+void dukat_glUniform3fv(GLint location, GLsizei count, const GLfloat* value)
+{
+	record_call();
+	current_stats.uniform_updates++;
+}
+
+void dukat_glUniform4f(GLint location, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3)
+{
+	record_call();
+	current_stats.uniform_updates++;
+}
+
+void dukat_glUniform4fv(GLint location, GLsizei count, const GLfloat* value)
+{
+	record_call();
+	current_stats.uniform_updates++;
+}
+
+void dukat_glUniformBlockBinding(GLuint program, GLuint block_index, GLuint block_binding)
+{
+	record_call();
+	current_stats.state_changes++;
+}
+
+void dukat_glUniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value)
+{
+	record_call();
+	current_stats.uniform_updates++;
+}
+
+GLboolean dukat_glUnmapBuffer(GLenum target)
+{
+	record_call();
+	auto buffer = bound_buffer(target);
+	if (buffer != nullptr && (buffer->map_access & GL_MAP_FLUSH_EXPLICIT_BIT) == 0)
+		record_upload(static_cast<std::size_t>(buffer->map_length));
+	return GL_TRUE;
+}
+
+void dukat_glUseProgram(GLuint program)
+{
+	record_call();
+	current_stats.program_binds++;
+	change_state(null_state().program, program);
+}
+
+void dukat_glVertexAttribDivisor(GLuint index, GLuint divisor)
+{
+	record_call();
+	current_stats.state_changes++;
+}
+
+void dukat_glVertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void* pointer)
+{
+	record_call();
+	current_stats.state_changes++;
+}
+
+void dukat_glViewport(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+	record_call();
+	auto& vp = null_state().viewport;
+	current_stats.state_changes++;
+	if (vp[0] == x && vp[1] == y && vp[2] == width && vp[3] == height)
+	{
+		current_stats.redundant_changes++;
+		return;
+	}
+	vp[0] = x;
+	vp[1] = y;
+	vp[2] = width;
+	vp[3] = height;
+}
+
+#endif // DUKAT_NULL_GL
\ No newline at end of file
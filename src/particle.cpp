@@ -3,5 +3,6 @@
 
 namespace dukat
 {
-	MemoryPool<Particle> Particle::_pool(4096);
+	// Particles may be created by game code while the particle manager updates concurrently
+	MemoryPool<Particle> Particle::_pool(4096, "particles", MemoryPool<Particle>::Growable | MemoryPool<Particle>::ThreadCache);
 }
\ No newline at end of file
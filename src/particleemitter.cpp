@@ -9,7 +9,7 @@
 
 namespace dukat
 {
-	MemoryPool<ParticleEmitter> ParticleEmitter::_pool(512);
+	MemoryPool<ParticleEmitter> ParticleEmitter::_pool(512, "emitters");
 
 	// LINEAR
 	// - particles are created with unique direction in +/- dp range
@@ -22,24 +22,22 @@ namespace dukat
 		const auto offset_count = em.offsets.size();
         while (em.accumulator >= 1.0f)
         {
-			auto p = pm.create_particle();
-			if (p == nullptr)
-				return;
-			p->flags = em.recipe.flags;
-			p->ref.y = em.pos.y + em.mirror_offset;
+			Particle p;
+			p.flags = em.recipe.flags;
+			p.ref.y = em.pos.y + em.mirror_offset;
 			
 			if (offset_count == 0)
-				p->pos = em.pos;
+				p.pos = em.pos;
 			else
-				p->pos = em.pos + em.offsets[random(0, offset_count)];
+				p.pos = em.pos + em.offsets[random(0, offset_count)];
 
-			p->dp = random(em.recipe.min_dp, em.recipe.max_dp);
-            p->size = random(em.recipe.min_size, em.recipe.max_size);
-			p->color = em.recipe.colors[random(0, em.recipe.colors.size())];
-			p->dc = em.recipe.dc;
-            p->ttl = random(em.recipe.min_ttl, em.recipe.max_ttl);
+			p.dp = random(em.recipe.min_dp, em.recipe.max_dp);
+            p.size = random(em.recipe.min_size, em.recipe.max_size);
+			p.color = em.recipe.colors[random(0, em.recipe.colors.size())];
+			p.dc = em.recipe.dc;
+            p.ttl = random(em.recipe.min_ttl, em.recipe.max_ttl);
 			
-			em.target_layer->add(p);
+			pm.emit(p, em.target_layer);
 
 			em.accumulator -= 1.0f;
         }
@@ -60,20 +58,18 @@ namespace dukat
 		const auto& max_offset = em.offsets[1];
 		while (em.accumulator >= 1.0f)
 		{
-			auto p = pm.create_particle();
-			if (p == nullptr)
-				return;
-			p->flags = em.recipe.flags;
-			p->ref.y = em.pos.y + em.mirror_offset;
-			p->pos = em.pos + random(min_offset, max_offset);
+			Particle p;
+			p.flags = em.recipe.flags;
+			p.ref.y = em.pos.y + em.mirror_offset;
+			p.pos = em.pos + random(min_offset, max_offset);
 
-			p->dp = random(em.recipe.min_dp, em.recipe.max_dp);
-			p->size = random(em.recipe.min_size, em.recipe.max_size);
-			p->color = em.recipe.colors[random(0, em.recipe.colors.size())];
-			p->dc = em.recipe.dc;
-			p->ttl = random(em.recipe.min_ttl, em.recipe.max_ttl);
+			p.dp = random(em.recipe.min_dp, em.recipe.max_dp);
+			p.size = random(em.recipe.min_size, em.recipe.max_size);
+			p.color = em.recipe.colors[random(0, em.recipe.colors.size())];
+			p.dc = em.recipe.dc;
+			p.ttl = random(em.recipe.min_ttl, em.recipe.max_ttl);
 
-			em.target_layer->add(p);
+			pm.emit(p, em.target_layer);
 
 			em.accumulator -= 1.0f;
 		}
@@ -96,23 +92,21 @@ namespace dukat
 		const auto& max_offset = em.offsets[1];
 		while (em.accumulator >= 1.0f)
 		{
-			auto p = pm.create_particle();
-			if (p == nullptr)
-				return;
-			p->flags = em.recipe.flags;
-			p->ref.y = em.pos.y + em.mirror_offset;
-			p->pos = em.pos + random(min_offset, max_offset);
+			Particle p;
+			p.flags = em.recipe.flags;
+			p.ref.y = em.pos.y + em.mirror_offset;
+			p.pos = em.pos + random(min_offset, max_offset);
 
 			const auto z = random(0, em.recipe.colors.size());
-			p->dp = (z >= 2) ? em.recipe.min_dp : em.recipe.max_dp;
+			p.dp = (z >= 2) ? em.recipe.min_dp : em.recipe.max_dp;
 
-			p->size = static_cast<float>(random(static_cast<int>(em.recipe.min_size), static_cast<int>(em.recipe.max_size)));
+			p.size = static_cast<float>(random(static_cast<int>(em.recipe.min_size), static_cast<int>(em.recipe.max_size)));
 			
-			p->color = em.recipe.colors[z];
-			p->dc = em.recipe.dc;
-			p->ttl = random(em.recipe.min_ttl, em.recipe.max_ttl);
+			p.color = em.recipe.colors[z];
+			p.dc = em.recipe.dc;
+			p.ttl = random(em.recipe.min_ttl, em.recipe.max_ttl);
 
-			em.target_layer->add(p);
+			pm.emit(p, em.target_layer);
 
 			em.accumulator -= 1.0f;
 		}
@@ -133,29 +127,27 @@ namespace dukat
 		const auto offset_count = em.offsets.size();
 		while (em.accumulator >= 1.0f)
 		{
-			auto p = pm.create_particle();
-			if (p == nullptr)
-				return;
-			p->flags = em.recipe.flags;
-			p->ref.y = em.pos.y + em.mirror_offset;
+			Particle p;
+			p.flags = em.recipe.flags;
+			p.ref.y = em.pos.y + em.mirror_offset;
 
 			const auto angle = random(0.0f, two_pi);
 			const auto offset = base_vector.rotate(angle);
 			if (offset_count == 0)
-				p->pos = em.pos;
+				p.pos = em.pos;
 			else
-				p->pos = em.pos + em.offsets[random(0, offset_count)];
+				p.pos = em.pos + em.offsets[random(0, offset_count)];
 
 			if (em.recipe.min_dp.x != 0.0f)
-				p->pos += offset * em.recipe.min_dp.x;
+				p.pos += offset * em.recipe.min_dp.x;
 
-			p->dp = offset * random(em.recipe.min_dp.y, em.recipe.max_dp.y);
-			p->size = random(em.recipe.min_size, em.recipe.max_size);
-			p->color = em.recipe.colors[random(0, em.recipe.colors.size())];
-			p->dc = em.recipe.dc;
-			p->ttl = random(em.recipe.min_ttl, em.recipe.max_ttl);
+			p.dp = offset * random(em.recipe.min_dp.y, em.recipe.max_dp.y);
+			p.size = random(em.recipe.min_size, em.recipe.max_size);
+			p.color = em.recipe.colors[random(0, em.recipe.colors.size())];
+			p.dc = em.recipe.dc;
+			p.ttl = random(em.recipe.min_ttl, em.recipe.max_ttl);
 
-			em.target_layer->add(p);
+			pm.emit(p, em.target_layer);
 
 			em.accumulator -= 1.0f;
 		}
@@ -180,37 +172,35 @@ namespace dukat
 		const auto offset_count = em.offsets.size();
         while (em.accumulator >= 1.0f)
         {
-			auto p = pm.create_particle();
-			if (p == nullptr)
-				break;
+			Particle p;
 
-			p->flags = em.recipe.flags;
-			p->ref.y = em.pos.y + em.mirror_offset;
+			p.flags = em.recipe.flags;
+			p.ref.y = em.pos.y + em.mirror_offset;
 			
 			auto offset = Vector2{ 0.f, range }.rotate(em.value);
 			offset.y = 0.f;
 
-			p->dp.x = em.recipe.max_dp.x * offset.x;
-			p->dp.y = -random(em.recipe.min_dp.y, em.recipe.max_dp.y);
+			p.dp.x = em.recipe.max_dp.x * offset.x;
+			p.dp.y = -random(em.recipe.min_dp.y, em.recipe.max_dp.y);
 
 			if (offset_count > 0)
 				offset += em.offsets[random(0, offset_count)];
-			p->pos = em.pos + offset;
+			p.pos = em.pos + offset;
 
             auto n_size = random(0.0f, 1.0f);
-            p->size = em.recipe.min_size + n_size * (em.recipe.max_size - em.recipe.min_size);
+            p.size = em.recipe.min_size + n_size * (em.recipe.max_size - em.recipe.min_size);
 
             // determine initial color of particle based on distance from center 
 			// TODO: revise this - idea is that for offsets that are further from pos.x, go into red
             auto dist = std::abs(offset.x) / (4.0f * range);
-			p->color = em.recipe.colors[0] - em.recipe.colors[1] * dist;
-			p->dc = em.recipe.dc;
-			p->dc.a -= n_size;
+			p.color = em.recipe.colors[0] - em.recipe.colors[1] * dist;
+			p.dc = em.recipe.dc;
+			p.dc.a -= n_size;
 
             // The smaller the particle, the longer it will live
-            p->ttl = em.recipe.min_ttl + (1.f - n_size) * (em.recipe.max_ttl - em.recipe.min_ttl);
+            p.ttl = em.recipe.min_ttl + (1.f - n_size) * (em.recipe.max_ttl - em.recipe.min_ttl);
 
-			em.target_layer->add(p);
+			pm.emit(p, em.target_layer);
 
 			em.accumulator -= 1.0f;
         }
@@ -231,33 +221,31 @@ namespace dukat
 		const auto offset_count = em.offsets.size();
 		while (em.accumulator >= 1.0f)
         {
-			auto p = pm.create_particle();
-			if (p == nullptr)
-				break;
+			Particle p;
 
-			p->flags = em.recipe.flags;
-			p->ref.y = em.pos.y + em.mirror_offset;
+			p.flags = em.recipe.flags;
+			p.ref.y = em.pos.y + em.mirror_offset;
 			
 			auto offset = Vector2{ 0.f, em.recipe.min_dp.x }.rotate(em.value);
 			offset.y = 0.f;
 			if (offset_count == 0)
-				p->pos = em.pos + offset;
+				p.pos = em.pos + offset;
 			else
-				p->pos = em.pos + em.offsets[random(0, static_cast<int>(offset_count))] + offset;
+				p.pos = em.pos + em.offsets[random(0, static_cast<int>(offset_count))] + offset;
 			
-            p->dp.x = offset.x * em.recipe.max_dp.x;
-            p->dp.y = -random(em.recipe.min_dp.y, em.recipe.max_dp.y);
+            p.dp.x = offset.x * em.recipe.max_dp.x;
+            p.dp.y = -random(em.recipe.min_dp.y, em.recipe.max_dp.y);
 
 			const auto size = random(0.0f, 1.0f);
-            p->size = em.recipe.min_size + size * (em.recipe.max_size - em.recipe.min_size);
-            p->color = em.recipe.colors[0];
-			p->dc = em.recipe.dc * (0.25f + size);
-			p->ref.y = em.pos.y + em.mirror_offset;
+            p.size = em.recipe.min_size + size * (em.recipe.max_size - em.recipe.min_size);
+            p.color = em.recipe.colors[0];
+			p.dc = em.recipe.dc * (0.25f + size);
+			p.ref.y = em.pos.y + em.mirror_offset;
 
             // The smaller the particle, the longer it will live
-            p->ttl = em.recipe.min_ttl + (1.f - size) * (em.recipe.max_ttl - em.recipe.min_ttl);
+            p.ttl = em.recipe.min_ttl + (1.f - size) * (em.recipe.max_ttl - em.recipe.min_ttl);
 
-			em.target_layer->add(p);
+			pm.emit(p, em.target_layer);
 
 			em.accumulator -= 1.0f;
         }
@@ -285,39 +273,37 @@ namespace dukat
 		const auto small_max_size = static_cast<int>(em.recipe.max_size * em.recipe.colors[1].g);
 		while (em.accumulator >= 1.0f)
 		{
-			auto p = pm.create_particle();
-			if (p == nullptr)
-				break;
+			Particle p;
 
 			em.value += 1.f;
 
-			p->flags = em.recipe.flags;
-			p->pos = random(min_pos, max_pos); // spawn within rect
+			p.flags = em.recipe.flags;
+			p.pos = random(min_pos, max_pos); // spawn within rect
 
 			// most particles are large + slow-moving
 			if (em.value < small_threshold)
 			{
-				p->dp.x = random(em.recipe.min_dp.x, em.recipe.max_dp.x);
-				p->dp.y = random(-0.5f, 0.5f); // minimal movement along vertical axis
+				p.dp.x = random(em.recipe.min_dp.x, em.recipe.max_dp.x);
+				p.dp.y = random(-0.5f, 0.5f); // minimal movement along vertical axis
 				const auto size = random(0.0f, 1.0f);
-				p->size = std::round(em.recipe.min_size + size * (em.recipe.max_size - em.recipe.min_size));
+				p.size = std::round(em.recipe.min_size + size * (em.recipe.max_size - em.recipe.min_size));
 			}
 			else
 			{
-				p->dp.x = random(em.recipe.min_dp.x, em.recipe.max_dp.x);
-				p->dp.y = -random(em.recipe.min_dp.y, em.recipe.max_dp.y);
-				p->size = static_cast<float>(random(small_min_size, small_max_size));
+				p.dp.x = random(em.recipe.min_dp.x, em.recipe.max_dp.x);
+				p.dp.y = -random(em.recipe.min_dp.y, em.recipe.max_dp.y);
+				p.size = static_cast<float>(random(small_min_size, small_max_size));
 				em.value = 0.0f; // reset accumulator
 			}
 
-			p->color = em.recipe.colors[0];
-			p->dc = em.recipe.dc;
-			p->ref.y = em.pos.y + em.mirror_offset;
+			p.color = em.recipe.colors[0];
+			p.dc = em.recipe.dc;
+			p.ref.y = em.pos.y + em.mirror_offset;
 
-			p->ttl = random(em.recipe.min_ttl, em.recipe.max_ttl);
-			p->dc.a = -0.5f / p->ttl; // alpha reduction based on ttl
+			p.ttl = random(em.recipe.min_ttl, em.recipe.max_ttl);
+			p.dc.a = -0.5f / p.ttl; // alpha reduction based on ttl
 
-			em.target_layer->add(p);
+			pm.emit(p, em.target_layer);
 
 			em.accumulator -= 1.0f;
 		}
@@ -339,30 +325,28 @@ namespace dukat
 		const auto max_v = em.recipe.max_dp.y * (1.0f + 0.25f * fast_cos(em.age));
         while (em.accumulator >= 1.0f)
         {
-			auto p = pm.create_particle();
-			if (p == nullptr)
-				break;
+			Particle p;
 
-			p->flags = em.recipe.flags;
-			p->ref.y = em.pos.y + em.mirror_offset;
+			p.flags = em.recipe.flags;
+			p.ref.y = em.pos.y + em.mirror_offset;
 
 			auto offset = Vector2{ 0.f, em.recipe.max_dp.x }.rotate(em.value);
 			offset.y = 0.f;
 			if (offset_count == 0)
-				p->pos = em.pos + offset;
+				p.pos = em.pos + offset;
 			else
-				p->pos = em.pos + em.offsets[random(0, offset_count)] + offset;
+				p.pos = em.pos + em.offsets[random(0, offset_count)] + offset;
 
-			p->dp.x = offset.x;
-            p->dp.y = -random(em.recipe.min_dp.y, em.recipe.max_dp.y);
+			p.dp.x = offset.x;
+            p.dp.y = -random(em.recipe.min_dp.y, em.recipe.max_dp.y);
             
             auto size = random(1, em.recipe.colors.size());
-            p->size = random(em.recipe.min_size, em.recipe.max_size);
-            p->color = em.recipe.colors[size - 1];
-			p->dc = em.recipe.dc;
-            p->ttl = random(em.recipe.min_ttl, em.recipe.max_ttl);
+            p.size = random(em.recipe.min_size, em.recipe.max_size);
+            p.color = em.recipe.colors[size - 1];
+			p.dc = em.recipe.dc;
+            p.ttl = random(em.recipe.min_ttl, em.recipe.max_ttl);
 
-			em.target_layer->add(p);
+			pm.emit(p, em.target_layer);
 
 			em.accumulator -= 1.0f;
         }
@@ -403,39 +387,37 @@ namespace dukat
 		static const Vector2 base_vector{ 0.0f, -1.0f };
 		for (auto i = 0; i < static_cast<int>(em.recipe.rate); i++)
 		{
-			auto p = pm.create_particle();
-			if (p == nullptr)
-				break;
+			Particle p;
 
-			p->flags = em.recipe.flags;
-			p->ref.y = em.pos.y + em.mirror_offset;
+			p.flags = em.recipe.flags;
+			p.ref.y = em.pos.y + em.mirror_offset;
 
 			const auto angle = random(0.0f, two_pi);
 			const auto offset = base_vector.rotate(angle);
-			p->pos = em.pos + base_offset;
+			p.pos = em.pos + base_offset;
 
 			if (scale_delta != 0.0f)
 			{
 				const auto init_scale = random(0.0f, 1.0f);
-				p->pos += offset * (em.recipe.min_dp.x + init_scale * scale_delta);
-				p->color = lerp(em.recipe.colors[0], em.recipe.colors[1], init_scale);
+				p.pos += offset * (em.recipe.min_dp.x + init_scale * scale_delta);
+				p.color = lerp(em.recipe.colors[0], em.recipe.colors[1], init_scale);
 			}
 			else
 			{
-				p->color = em.recipe.colors[0];
+				p.color = em.recipe.colors[0];
 			}
 			
-			p->dp = offset * random(em.recipe.min_dp.y, em.recipe.max_dp.y);
+			p.dp = offset * random(em.recipe.min_dp.y, em.recipe.max_dp.y);
 
 			const auto n_size = random(0.0f, 1.0f);
-			p->size = em.recipe.min_size + n_size * (em.recipe.max_size - em.recipe.min_size);
-			p->dc = em.recipe.dc;
-			p->dc.a -= n_size;
+			p.size = em.recipe.min_size + n_size * (em.recipe.max_size - em.recipe.min_size);
+			p.dc = em.recipe.dc;
+			p.dc.a -= n_size;
 
 			// The smaller the particle, the longer it will live
-			p->ttl = em.recipe.min_ttl + (1.f - n_size) * (em.recipe.max_ttl - em.recipe.min_ttl);
+			p.ttl = em.recipe.min_ttl + (1.f - n_size) * (em.recipe.max_ttl - em.recipe.min_ttl);
 
-			em.target_layer->add(p);
+			pm.emit(p, em.target_layer);
 		}
     }
 
@@ -475,41 +457,39 @@ namespace dukat
 		static const Vector2 base_vector{ 0.0f, -1.0f };
 		for (auto i = 0; i < static_cast<int>(em.recipe.rate); i++)
 		{
-			auto p = pm.create_particle();
-			if (p == nullptr)
-				break;
+			Particle p;
 
-			p->flags = em.recipe.flags;
-			p->ref.y = em.pos.y + em.mirror_offset;
+			p.flags = em.recipe.flags;
+			p.ref.y = em.pos.y + em.mirror_offset;
 
 			const auto angle = random(-pi_over_two, pi_over_two);
 			const auto offset = base_vector.rotate(angle);
-			p->pos = em.pos + base_offset;
+			p.pos = em.pos + base_offset;
 
 			if (scale_delta != 0.0f)
 			{
 				const auto init_scale = random(0.0f, 1.0f);
-				p->pos += offset * (em.recipe.min_dp.x + init_scale * scale_delta);
-				p->color = lerp(em.recipe.colors[0], em.recipe.colors[1], init_scale);
+				p.pos += offset * (em.recipe.min_dp.x + init_scale * scale_delta);
+				p.color = lerp(em.recipe.colors[0], em.recipe.colors[1], init_scale);
 			}
 			else
 			{
-				p->color = em.recipe.colors[0];
+				p.color = em.recipe.colors[0];
 			}
 
 			// scale dp base on angle - to closer to [0,-1] the faster
 			const auto vel = std::abs(offset.y);
-			p->dp = offset * random(em.recipe.min_dp.y, em.recipe.max_dp.y) * vel;
+			p.dp = offset * random(em.recipe.min_dp.y, em.recipe.max_dp.y) * vel;
 
 			const auto n_size = random(0.0f, 1.0f);
-			p->size = em.recipe.min_size + n_size * (em.recipe.max_size - em.recipe.min_size);
-			p->dc = em.recipe.dc;
-			p->dc.a -= n_size;
+			p.size = em.recipe.min_size + n_size * (em.recipe.max_size - em.recipe.min_size);
+			p.dc = em.recipe.dc;
+			p.dc.a -= n_size;
 
 			// The smaller the particle, the longer it will live
-			p->ttl = em.recipe.min_ttl + (1.f - n_size) * (em.recipe.max_ttl - em.recipe.min_ttl);
+			p.ttl = em.recipe.min_ttl + (1.f - n_size) * (em.recipe.max_ttl - em.recipe.min_ttl);
 
-			em.target_layer->add(p);
+			pm.emit(p, em.target_layer);
 		}
 	}
 
@@ -536,24 +516,22 @@ namespace dukat
 		const auto offset_count = em.offsets.size();
 		while (em.accumulator >= 1.0f)
 		{
-			auto p = pm.create_particle();
-			if (p == nullptr)
-				return;
-			p->flags = em.recipe.flags;
-			p->ref.y = em.pos.y + em.mirror_offset;
+			Particle p;
+			p.flags = em.recipe.flags;
+			p.ref.y = em.pos.y + em.mirror_offset;
 
 			if (offset_count == 0)
-				p->pos = em.pos;
+				p.pos = em.pos;
 			else
-				p->pos = em.pos + em.offsets[random(0, offset_count)];
+				p.pos = em.pos + em.offsets[random(0, offset_count)];
 
-			p->dp = random(em.recipe.min_dp, em.recipe.max_dp);
-			p->size = random(em.recipe.min_size, em.recipe.max_size);
-			p->color = em.recipe.colors[random(0, em.recipe.colors.size())];
-			p->dc = em.recipe.dc;
-			p->ttl = random(em.recipe.min_ttl, em.recipe.max_ttl);
+			p.dp = random(em.recipe.min_dp, em.recipe.max_dp);
+			p.size = random(em.recipe.min_size, em.recipe.max_size);
+			p.color = em.recipe.colors[random(0, em.recipe.colors.size())];
+			p.dc = em.recipe.dc;
+			p.ttl = random(em.recipe.min_ttl, em.recipe.max_ttl);
 
-			em.target_layer->add(p);
+			pm.emit(p, em.target_layer);
 
 			em.accumulator -= 1.0f;
 		}
@@ -577,30 +555,28 @@ namespace dukat
 		const auto offset_count = em.offsets.size();
 		while (em.accumulator >= 1.0f)
 		{
-			auto p = pm.create_particle();
-			if (p == nullptr)
-				break;
+			Particle p;
 
-			p->flags = em.recipe.flags;
-			p->ref.y = em.pos.y + em.mirror_offset;
-			p->dp.x = em.recipe.max_dp.x * offset.x;
-			p->dp.y = em.recipe.max_dp.y * offset.y;
+			p.flags = em.recipe.flags;
+			p.ref.y = em.pos.y + em.mirror_offset;
+			p.dp.x = em.recipe.max_dp.x * offset.x;
+			p.dp.y = em.recipe.max_dp.y * offset.y;
 
-			p->pos = em.pos + offset * em.recipe.min_dp.x;
+			p.pos = em.pos + offset * em.recipe.min_dp.x;
 			if (offset_count > 0)
-				p->pos += em.offsets[random(0, offset_count)];
+				p.pos += em.offsets[random(0, offset_count)];
 
 			const auto n_size = random(0.0f, 1.0f);
-			p->size = em.recipe.min_size + n_size * (em.recipe.max_size - em.recipe.min_size);
+			p.size = em.recipe.min_size + n_size * (em.recipe.max_size - em.recipe.min_size);
 
-			p->color = em.recipe.colors[0];
-			p->dc = em.recipe.dc;
-			p->dc.a -= n_size;
+			p.color = em.recipe.colors[0];
+			p.dc = em.recipe.dc;
+			p.dc.a -= n_size;
 
 			// The smaller the particle, the longer it will live
-			p->ttl = em.recipe.min_ttl + (1.f - n_size) * (em.recipe.max_ttl - em.recipe.min_ttl);
+			p.ttl = em.recipe.min_ttl + (1.f - n_size) * (em.recipe.max_ttl - em.recipe.min_ttl);
 
-			em.target_layer->add(p);
+			pm.emit(p, em.target_layer);
 
 			em.accumulator -= 1.0f;
 		}
@@ -622,31 +598,29 @@ namespace dukat
 		const auto offset_x = em.recipe.min_dp.x * fast_sin(em.value);
 		while (em.accumulator >= 1.0f)
 		{
-			auto p = pm.create_particle();
-			if (p == nullptr)
-				break;
+			Particle p;
 
-			p->flags = em.recipe.flags;
-			p->ref.y = em.pos.y + em.mirror_offset;
-			p->dp.x = em.recipe.max_dp.x;
-			p->dp.y = em.recipe.max_dp.y;
+			p.flags = em.recipe.flags;
+			p.ref.y = em.pos.y + em.mirror_offset;
+			p.dp.x = em.recipe.max_dp.x;
+			p.dp.y = em.recipe.max_dp.y;
 
-			p->pos.x = em.pos.x + offset_x;
-			p->pos.y = em.pos.y;
+			p.pos.x = em.pos.x + offset_x;
+			p.pos.y = em.pos.y;
 			if (offset_count > 0)
-				p->pos += em.offsets[random(0, offset_count)];
+				p.pos += em.offsets[random(0, offset_count)];
 
 			const auto n_size = random(0.0f, 1.0f);
-			p->size = em.recipe.min_size + n_size * (em.recipe.max_size - em.recipe.min_size);
+			p.size = em.recipe.min_size + n_size * (em.recipe.max_size - em.recipe.min_size);
 
-			p->color = em.recipe.colors[0];
-			p->dc = em.recipe.dc;
-			p->dc.a -= n_size;
+			p.color = em.recipe.colors[0];
+			p.dc = em.recipe.dc;
+			p.dc.a -= n_size;
 
 			// The smaller the particle, the longer it will live
-			p->ttl = em.recipe.min_ttl + (1.f - n_size) * (em.recipe.max_ttl - em.recipe.min_ttl);
+			p.ttl = em.recipe.min_ttl + (1.f - n_size) * (em.recipe.max_ttl - em.recipe.min_ttl);
 
-			em.target_layer->add(p);
+			pm.emit(p, em.target_layer);
 
 			em.accumulator -= 1.0f;
 		}
@@ -664,29 +638,27 @@ namespace dukat
 		const auto offset_count = em.offsets.size();
 		while (em.accumulator >= 1.0f)
 		{
-			auto p = pm.create_particle();
-			if (p == nullptr)
-				return;
-			p->flags = em.recipe.flags;
+			Particle p;
+			p.flags = em.recipe.flags;
 
 			if (offset_count == 0)
-				p->pos = em.pos;
+				p.pos = em.pos;
 			else
-				p->pos = em.pos + em.offsets[random(0, offset_count)];
-
-			p->ref.x = p->pos.x;
-			p->ref.y = em.pos.y + em.mirror_offset;
-
-			p->dp = random(em.recipe.min_dp, em.recipe.max_dp);
-			p->size = em.recipe.min_size; 
-			p->dsize = em.recipe.max_size;
-			p->color = em.recipe.colors[random(0, em.recipe.colors.size())];
-			p->dc = em.recipe.dc;
-			p->radius = em.recipe.radius;
-			p->angle = pi_over_two;
-			p->ttl = random(em.recipe.min_ttl, em.recipe.max_ttl);
+				p.pos = em.pos + em.offsets[random(0, offset_count)];
+
+			p.ref.x = p.pos.x;
+			p.ref.y = em.pos.y + em.mirror_offset;
+
+			p.dp = random(em.recipe.min_dp, em.recipe.max_dp);
+			p.size = em.recipe.min_size; 
+			p.dsize = em.recipe.max_size;
+			p.color = em.recipe.colors[random(0, em.recipe.colors.size())];
+			p.dc = em.recipe.dc;
+			p.radius = em.recipe.radius;
+			p.angle = pi_over_two;
+			p.ttl = random(em.recipe.min_ttl, em.recipe.max_ttl);
 			
-			em.target_layer->add(p);
+			pm.emit(p, em.target_layer);
 
 			em.accumulator -= 1.0f;
 		}
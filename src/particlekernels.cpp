@@ -0,0 +1,353 @@
+#include "stdafx.h"
+#include <dukat/particlekernels.h>
+#include <dukat/bit.h>
+#include <dukat/color.h>
+#include <dukat/mathutil.h>
+#include <dukat/particle.h>
+#include <dukat/particlestore.h>
+#include <dukat/vector2.h>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define DUKAT_PARTICLE_SSE2
+#include <emmintrin.h>
+#if defined(_MSC_VER) || defined(__GNUC__)
+#define DUKAT_PARTICLE_AVX
+#include <immintrin.h>
+#endif
+#endif
+
+// GCC and Clang only emit AVX instructions for functions that ask for them
+#if defined(__GNUC__)
+#define DUKAT_TARGET_AVX __attribute__((target("avx")))
+#else
+#define DUKAT_TARGET_AVX
+#endif
+
+namespace dukat
+{
+	// Kernels treat the vector and color arrays as plain float arrays
+	static_assert(sizeof(Vector2) == 2 * sizeof(float), "Unexpected Vector2 layout");
+	static_assert(sizeof(Color) == 4 * sizeof(float), "Unexpected Color layout");
+
+	static constexpr uint8_t motion_mask = Particle::Linear | Particle::Spiraling | Particle::Dampened
+		| Particle::Gravitational | Particle::AntiGravitational;
+
+	uint8_t motion_flags(uint8_t flags)
+	{
+		auto res = static_cast<uint8_t>(flags & motion_mask);
+		if (check_flag(res, Particle::Linear))
+			res &= ~Particle::Spiraling;
+		if (check_flag(res, Particle::Gravitational))
+			res &= ~Particle::AntiGravitational;
+		return res;
+	}
+
+	bool is_supported(ParticleKernel kernel)
+	{
+		switch (kernel)
+		{
+		case ParticleKernel::Scalar:
+			return true;
+#ifdef DUKAT_PARTICLE_SSE2
+		case ParticleKernel::SSE2:
+			return SDL_HasSSE2() == SDL_TRUE;
+#endif
+#ifdef DUKAT_PARTICLE_AVX
+		case ParticleKernel::AVX:
+			return SDL_HasAVX() == SDL_TRUE;
+#endif
+		default:
+			return false;
+		}
+	}
+
+	ParticleKernel detect_particle_kernel(void)
+	{
+		if (is_supported(ParticleKernel::AVX))
+			return ParticleKernel::AVX;
+		else if (is_supported(ParticleKernel::SSE2))
+			return ParticleKernel::SSE2;
+		else
+			return ParticleKernel::Scalar;
+	}
+
+	const char* kernel_name(ParticleKernel kernel)
+	{
+		switch (kernel)
+		{
+		case ParticleKernel::SSE2:
+			return "SSE2";
+		case ParticleKernel::AVX:
+			return "AVX";
+		default:
+			return "Scalar";
+		}
+	}
+
+	// Spiraling motion relies on fast_cos and stays scalar in all kernels.
+	static inline void integrate_spiral(Vector2& pos, Vector2& dp, const Vector2& ref,
+		float& radius, float& angle, float delta)
+	{
+		angle += dp.x * delta;
+		pos.x = ref.x + radius * fast_cos(angle);
+		pos.y += dp.y * delta;
+
+		// reduce angular speed over time
+		const auto reduction = delta * 0.125f;
+		dp.x = dp.x > 0.f ? std::max(0.1f, dp.x - reduction) : std::min(-0.1f, dp.x + reduction);
+		radius += 10.f * delta;
+	}
+
+	void integrate_particle(uint8_t flags, Vector2& pos, Vector2& dp, const Vector2& ref,
+		Color& color, const Color& dc, float& size, float dsize, float& radius, float& angle,
+		const ParticleStep& step)
+	{
+		const auto delta = step.delta;
+		if (check_flag(flags, Particle::Linear))
+		{
+			pos += dp * delta;
+		}
+		else if (check_flag(flags, Particle::Spiraling))
+		{
+			integrate_spiral(pos, dp, ref, radius, angle, delta);
+		}
+
+		// For gravitational particles, only apply effect as long as we're above
+		// reflection line
+		if (check_flag(flags, Particle::Gravitational))
+		{
+			if (pos.y < ref.y)
+				dp.y += step.gravity * delta;
+			else
+			{
+				pos.y = ref.y;
+				// zero out dp once we reach reflection line
+				dp.x = dp.y = 0.f;
+			}
+		}
+		else if (check_flag(flags, Particle::AntiGravitational))
+		{
+			dp.y -= step.gravity * delta;
+		}
+
+		if (check_flag(flags, Particle::Dampened))
+			dp *= step.dampening;
+
+		color += dc * delta;
+		size += dsize * delta;
+	}
+
+	static void integrate_scalar(uint8_t motion, ParticleStore& store,
+		std::size_t begin, std::size_t end, const ParticleStep& step)
+	{
+		for (auto i = begin; i < end; i++)
+		{
+			store.ttl[i] -= step.delta;
+			integrate_particle(motion, store.pos[i], store.dp[i], store.ref[i], store.color[i],
+				store.dc[i], store.size[i], store.dsize[i], store.radius[i], store.angle[i], step);
+		}
+	}
+
+#ifdef DUKAT_PARTICLE_SSE2
+	// Integrates motion of two particles stored as [x0, y0, x1, y1].
+	static inline void integrate_motion_sse2(uint8_t motion, __m128& p, __m128& v, const __m128& r,
+		const __m128& delta, const __m128& gravity, const __m128& dampening, const __m128& y_mask)
+	{
+		if (check_flag(motion, Particle::Linear))
+			p = _mm_add_ps(p, _mm_mul_ps(v, delta));
+
+		if (check_flag(motion, Particle::Gravitational))
+		{
+			// broadcast result of y comparison to both components of each particle
+			auto above = _mm_cmplt_ps(p, r);
+			above = _mm_shuffle_ps(above, above, _MM_SHUFFLE(3, 3, 1, 1));
+			v = _mm_and_ps(above, _mm_add_ps(v, gravity));
+			// clamp y to reflection line for particles that reached it
+			const auto clamp = _mm_andnot_ps(above, y_mask);
+			p = _mm_or_ps(_mm_and_ps(clamp, r), _mm_andnot_ps(clamp, p));
+		}
+		else if (check_flag(motion, Particle::AntiGravitational))
+		{
+			v = _mm_sub_ps(v, gravity);
+		}
+
+		if (check_flag(motion, Particle::Dampened))
+			v = _mm_mul_ps(v, dampening);
+	}
+
+	static void integrate_sse2(uint8_t motion, ParticleStore& store,
+		std::size_t begin, std::size_t end, const ParticleStep& step)
+	{
+		// integrate spiral component up front, so that the remaining passes are uniform
+		const auto spiral = check_flag(motion, Particle::Spiraling);
+		if (spiral)
+		{
+			for (auto i = begin; i < end; i++)
+				integrate_spiral(store.pos[i], store.dp[i], store.ref[i], store.radius[i], store.angle[i], step.delta);
+		}
+
+		const auto delta = _mm_set1_ps(step.delta);
+		const auto gd = step.gravity * step.delta;
+		const auto gravity = _mm_setr_ps(0.0f, gd, 0.0f, gd);
+		const auto dampening = _mm_set1_ps(step.dampening);
+		const auto y_mask = _mm_castsi128_ps(_mm_setr_epi32(0, -1, 0, -1));
+
+		auto ttl = store.ttl.data();
+		auto size = store.size.data();
+		auto dsize = store.dsize.data();
+		auto pos = reinterpret_cast<float*>(store.pos.data());
+		auto dp = reinterpret_cast<float*>(store.dp.data());
+		auto ref = reinterpret_cast<const float*>(store.ref.data());
+		auto color = reinterpret_cast<float*>(store.color.data());
+		auto dc = reinterpret_cast<const float*>(store.dc.data());
+
+		// 4 particles per iteration
+		auto i = begin;
+		for (; i + 4 <= end; i += 4)
+		{
+			_mm_storeu_ps(ttl + i, _mm_sub_ps(_mm_loadu_ps(ttl + i), delta));
+			_mm_storeu_ps(size + i, _mm_add_ps(_mm_loadu_ps(size + i),
+				_mm_mul_ps(_mm_loadu_ps(dsize + i), delta)));
+
+			for (auto j = 0; j < 4; j++)
+			{
+				const auto k = (i + j) * 4;
+				_mm_storeu_ps(color + k, _mm_add_ps(_mm_loadu_ps(color + k),
+					_mm_mul_ps(_mm_loadu_ps(dc + k), delta)));
+			}
+
+			for (auto j = 0; j < 2; j++)
+			{
+				const auto k = i * 2 + j * 4;
+				auto p = _mm_loadu_ps(pos + k);
+				auto v = _mm_loadu_ps(dp + k);
+				const auto r = _mm_loadu_ps(ref + k);
+				integrate_motion_sse2(motion, p, v, r, delta, gravity, dampening, y_mask);
+				_mm_storeu_ps(pos + k, p);
+				_mm_storeu_ps(dp + k, v);
+			}
+		}
+
+		// remainder
+		const auto tail_motion = spiral ? static_cast<uint8_t>(motion & ~Particle::Spiraling) : motion;
+		for (; i < end; i++)
+		{
+			store.ttl[i] -= step.delta;
+			integrate_particle(tail_motion, store.pos[i], store.dp[i], store.ref[i], store.color[i],
+				store.dc[i], store.size[i], store.dsize[i], store.radius[i], store.angle[i], step);
+		}
+	}
+#endif
+
+#ifdef DUKAT_PARTICLE_AVX
+	// Integrates motion of four particles stored as [x0, y0, x1, y1, x2, y2, x3, y3].
+	DUKAT_TARGET_AVX static inline void integrate_motion_avx(uint8_t motion, __m256& p, __m256& v, const __m256& r,
+		const __m256& delta, const __m256& gravity, const __m256& dampening, const __m256& y_mask)
+	{
+		if (check_flag(motion, Particle::Linear))
+			p = _mm256_add_ps(p, _mm256_mul_ps(v, delta));
+
+		if (check_flag(motion, Particle::Gravitational))
+		{
+			// shuffle operates on each 128-bit lane, so the pattern matches the SSE2 version
+			auto above = _mm256_cmp_ps(p, r, _CMP_LT_OQ);
+			above = _mm256_shuffle_ps(above, above, _MM_SHUFFLE(3, 3, 1, 1));
+			v = _mm256_and_ps(above, _mm256_add_ps(v, gravity));
+			const auto clamp = _mm256_andnot_ps(above, y_mask);
+			p = _mm256_blendv_ps(p, r, clamp);
+		}
+		else if (check_flag(motion, Particle::AntiGravitational))
+		{
+			v = _mm256_sub_ps(v, gravity);
+		}
+
+		if (check_flag(motion, Particle::Dampened))
+			v = _mm256_mul_ps(v, dampening);
+	}
+
+	DUKAT_TARGET_AVX static void integrate_avx(uint8_t motion, ParticleStore& store,
+		std::size_t begin, std::size_t end, const ParticleStep& step)
+	{
+		const auto spiral = check_flag(motion, Particle::Spiraling);
+		if (spiral)
+		{
+			for (auto i = begin; i < end; i++)
+				integrate_spiral(store.pos[i], store.dp[i], store.ref[i], store.radius[i], store.angle[i], step.delta);
+		}
+
+		const auto delta = _mm256_set1_ps(step.delta);
+		const auto gd = step.gravity * step.delta;
+		const auto gravity = _mm256_setr_ps(0.0f, gd, 0.0f, gd, 0.0f, gd, 0.0f, gd);
+		const auto dampening = _mm256_set1_ps(step.dampening);
+		const auto y_mask = _mm256_castsi256_ps(_mm256_setr_epi32(0, -1, 0, -1, 0, -1, 0, -1));
+
+		auto ttl = store.ttl.data();
+		auto size = store.size.data();
+		auto dsize = store.dsize.data();
+		auto pos = reinterpret_cast<float*>(store.pos.data());
+		auto dp = reinterpret_cast<float*>(store.dp.data());
+		auto ref = reinterpret_cast<const float*>(store.ref.data());
+		auto color = reinterpret_cast<float*>(store.color.data());
+		auto dc = reinterpret_cast<const float*>(store.dc.data());
+
+		// 8 particles per iteration
+		auto i = begin;
+		for (; i + 8 <= end; i += 8)
+		{
+			_mm256_storeu_ps(ttl + i, _mm256_sub_ps(_mm256_loadu_ps(ttl + i), delta));
+			_mm256_storeu_ps(size + i, _mm256_add_ps(_mm256_loadu_ps(size + i),
+				_mm256_mul_ps(_mm256_loadu_ps(dsize + i), delta)));
+
+			for (auto j = 0; j < 4; j++)
+			{
+				const auto k = i * 4 + j * 8;
+				_mm256_storeu_ps(color + k, _mm256_add_ps(_mm256_loadu_ps(color + k),
+					_mm256_mul_ps(_mm256_loadu_ps(dc + k), delta)));
+			}
+
+			for (auto j = 0; j < 2; j++)
+			{
+				const auto k = i * 2 + j * 8;
+				auto p = _mm256_loadu_ps(pos + k);
+				auto v = _mm256_loadu_ps(dp + k);
+				const auto r = _mm256_loadu_ps(ref + k);
+				integrate_motion_avx(motion, p, v, r, delta, gravity, dampening, y_mask);
+				_mm256_storeu_ps(pos + k, p);
+				_mm256_storeu_ps(dp + k, v);
+			}
+		}
+
+		// avoid mixing legacy SSE and AVX code in the remainder
+		_mm256_zeroupper();
+		const auto tail_motion = spiral ? static_cast<uint8_t>(motion & ~Particle::Spiraling) : motion;
+		for (; i < end; i++)
+		{
+			store.ttl[i] -= step.delta;
+			integrate_particle(tail_motion, store.pos[i], store.dp[i], store.ref[i], store.color[i],
+				store.dc[i], store.size[i], store.dsize[i], store.radius[i], store.angle[i], step);
+		}
+	}
+#endif
+
+	void integrate_particles(ParticleKernel kernel, uint8_t motion, ParticleStore& store,
+		std::size_t begin, std::size_t end, const ParticleStep& step)
+	{
+		assert(end <= store.count());
+		switch (kernel)
+		{
+#ifdef DUKAT_PARTICLE_AVX
+		case ParticleKernel::AVX:
+			integrate_avx(motion, store, begin, end, step);
+			break;
+#endif
+#ifdef DUKAT_PARTICLE_SSE2
+		case ParticleKernel::SSE2:
+			integrate_sse2(motion, store, begin, end, step);
+			break;
+#endif
+		default:
+			integrate_scalar(motion, store, begin, end, step);
+			break;
+		}
+	}
+}
\ No newline at end of file
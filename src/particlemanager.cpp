@@ -2,25 +2,59 @@
 #include <dukat/particlemanager.h>
 #include <dukat/particleemitter.h>
 #include <dukat/bit.h>
+#include <dukat/gamebase.h>
+#include <dukat/jobscheduler.h>
 #include <dukat/log.h>
 #include <dukat/mathutil.h>
 #include <dukat/perfcounter.h>
+#include <dukat/profiler.h>
+#include <dukat/renderlayer2.h>
 
 namespace dukat
 {
-	ParticleManager::ParticleManager(GameBase* game) : Manager(game), gravity(60.0f), dampening(0.99f) 
+	constexpr std::size_t ParticleManager::batch_size;
+
+	ParticleManager::ParticleManager(GameBase* game) : Manager(game), storage_mode(Pooled), 
+		kernel(detect_particle_kernel()), gravity(60.0f), dampening(0.99f) 
 	{ 
 	}
 
+	ParticleManager::~ParticleManager(void)
+	{
+		for (auto& s : stores)
+			s->layer->remove(s.get());
+	}
+
 	void ParticleManager::clear(void)
 	{
 		for (auto& p : particles)
 			p->ttl = -1.0f; // allow particle to be deallocated during next update cycle
+		// stores stay attached to their layers, so only release their contents
+		for (auto& s : stores)
+		{
+			while (!s->empty())
+				remove_particle(*s, s->count() - 1);
+		}
 		emitters.clear();
 	}
 
+	void ParticleManager::set_kernel(ParticleKernel kernel)
+	{
+		if (is_supported(kernel))
+		{
+			this->kernel = kernel;
+		}
+		else
+		{
+			log->warn("Particle kernel {} is not supported by this CPU.", kernel_name(kernel));
+			this->kernel = detect_particle_kernel();
+		}
+	}
+
 	void ParticleManager::update_particles(float delta)
 	{
+		DUKAT_PROFILE_ZONE("ParticleManager::update_particles");
+		const ParticleStep step{ delta, gravity, dampening };
 		for (auto it = particles.begin(); it != particles.end(); )
 		{
 			auto& p = *(*it);
@@ -38,45 +72,8 @@ namespace dukat
 			else
 			{
 				p.ttl -= delta;
-				if (check_flag(p.flags, Particle::Linear))
-				{
-					p.pos += p.dp * delta;
-				}
-				else if (check_flag(p.flags, Particle::Spiraling))
-				{
-					p.angle += p.dp.x * delta;
-					p.pos.x = p.ref.x + p.radius * fast_cos(p.angle);
-					p.pos.y += p.dp.y * delta;
-
-					// reduce angular speed over time
-					const auto reduction = delta * 0.125f;
-					p.dp.x = p.dp.x > 0.f ? std::max(0.1f, p.dp.x - reduction) : std::min(-0.1f, p.dp.x + reduction);
-					p.radius += 10.f * delta;
-				}
-
-				// For gravitational particles, only apply effect as long as we're above
-				// reflection line
-				if (check_flag(p.flags, Particle::Gravitational))
-				{
-					if (p.pos.y < p.ref.y)
-						p.dp.y += gravity * delta;
-					else
-					{
-						p.pos.y = p.ref.y;
-						// zero out dp once we reach reflection line
-						p.dp.x = p.dp.y = 0.f;
-					}
-				}
-				else if (check_flag(p.flags, Particle::AntiGravitational))
-				{
-					p.dp.y -= gravity * delta;
-				}
-
-				if (check_flag(p.flags, Particle::Dampened))
-					p.dp *= dampening;
-
-				p.color += p.dc * delta;
-				p.size += p.dsize * delta;
+				integrate_particle(p.flags, p.pos, p.dp, p.ref, p.color, p.dc, p.size, p.dsize, 
+					p.radius, p.angle, step);
 			}
 
 			++it;
@@ -84,8 +81,46 @@ namespace dukat
 		perfc.inc(PerformanceCounter::PARTICLES_TOTAL, static_cast<int>(particles.size()));
 	}
 
+	void ParticleManager::update_stores(float delta)
+	{
+		DUKAT_PROFILE_ZONE("ParticleManager::update_stores");
+		const ParticleStep step{ delta, gravity, dampening };
+		batches.clear();
+		for (auto& s : stores)
+		{
+			auto& store = *s;
+			// Layers skip expired particles, so they can be removed right away
+			for (auto i = 0u; i < store.count(); )
+			{
+				if (store.ttl[i] <= 0.0f || !check_flag(store.flags[i], Particle::Alive))
+					remove_particle(store, i); // last particle has been moved into slot i
+				else
+					++i;
+			}
+
+			// all particles in a store move the same way, so they can be integrated in bulk
+			for (std::size_t begin = 0; begin < store.count(); begin += batch_size)
+				batches.push_back(ParticleBatch{ &store, begin, std::min(store.count(), begin + batch_size) });
+			perfc.inc(PerformanceCounter::PARTICLES_TOTAL, static_cast<int>(store.count()));
+		}
+
+		const auto integrate = [&](std::size_t begin, std::size_t end) {
+			for (auto i = begin; i < end; i++)
+			{
+				const auto& b = batches[i];
+				integrate_particles(kernel, b.store->motion, *b.store, b.begin, b.end, step);
+			}
+		};
+		auto scheduler = game != nullptr ? game->get_scheduler() : nullptr;
+		if (scheduler != nullptr)
+			scheduler->parallel_for(0, batches.size(), 1, integrate);
+		else
+			integrate(0, batches.size());
+	}
+
 	void ParticleManager::update_emitters(float delta)
 	{
+		DUKAT_PROFILE_ZONE("ParticleManager::update_emitters");
 		for (auto it = emitters.begin(); it != emitters.end(); )
 		{
 			auto& e = *(*it);
@@ -110,6 +145,121 @@ namespace dukat
 		return res;
 	}
 
+	void ParticleManager::emit(const Particle& p, RenderLayer2* layer)
+	{
+		if (storage_mode == Packed)
+		{
+			add_particle(p, layer);
+		}
+		else
+		{
+			auto particle = std::make_unique<Particle>(p);
+			layer->add(particle.get());
+			particles.push_back(std::move(particle));
+		}
+	}
+
+	ParticleStore* ParticleManager::get_store(RenderLayer2* layer, uint8_t motion)
+	{
+		ParticleStore* store = nullptr;
+		for (auto& s : stores)
+		{
+			if (s->layer == layer && s->motion == motion)
+			{
+				store = s.get();
+				break;
+			}
+		}
+		if (store == nullptr)
+		{
+			stores.push_back(std::make_unique<ParticleStore>(layer, motion));
+			store = stores.back().get();
+		}
+		// attaching is a no-op if the layer already knows about this store
+		layer->add(store);
+		return store;
+	}
+
+	ParticleHandle ParticleManager::add_particle(const Particle& p, RenderLayer2* layer)
+	{
+		assert(layer != nullptr);
+		uint32_t id;
+		if (free_handles.empty())
+		{
+			id = static_cast<uint32_t>(handle_slots.size());
+			handle_slots.push_back(HandleSlot{ nullptr, 0u, 0u });
+		}
+		else
+		{
+			id = free_handles.back();
+			free_handles.pop_back();
+		}
+
+		auto store = get_store(layer, motion_flags(p.flags));
+		auto& slot = handle_slots[id];
+		slot.store = store;
+		slot.index = static_cast<uint32_t>(store->push_back(p, id));
+		return ParticleHandle{ id, slot.generation };
+	}
+
+	void ParticleManager::remove_particle(ParticleStore& store, std::size_t index)
+	{
+		// invalidate any outstanding handles to this particle
+		const auto id = store.ids[index];
+		auto& slot = handle_slots[id];
+		slot.store = nullptr;
+		slot.generation++;
+		free_handles.push_back(id);
+
+		store.swap_remove(index);
+		if (index < store.count())
+			handle_slots[store.ids[index]].index = static_cast<uint32_t>(index);
+	}
+
+	void ParticleManager::set_flags(const ParticleHandle& handle, uint8_t flags)
+	{
+		if (!is_valid(handle))
+			return;
+
+		auto& slot = handle_slots[handle.id];
+		auto src = slot.store;
+		const auto index = static_cast<std::size_t>(slot.index);
+		const auto motion = motion_flags(flags);
+		if (src->motion == motion)
+		{
+			src->flags[index] = flags;
+			return;
+		}
+
+		// move particle to the store matching its new motion, keeping its handle
+		Particle p;
+		src->get(index, p);
+		p.flags = flags;
+		src->swap_remove(index);
+		if (index < src->count())
+			handle_slots[src->ids[index]].index = static_cast<uint32_t>(index);
+
+		auto dst = get_store(src->layer, motion);
+		slot.store = dst;
+		slot.index = static_cast<uint32_t>(dst->push_back(p, handle.id));
+	}
+
+	bool ParticleManager::is_valid(const ParticleHandle& handle) const
+	{
+		if (handle.id >= handle_slots.size())
+			return false;
+		const auto& slot = handle_slots[handle.id];
+		return slot.store != nullptr && slot.generation == handle.generation;
+	}
+
+	ParticleRef ParticleManager::get(const ParticleHandle& handle)
+	{
+		if (!is_valid(handle))
+			return ParticleRef{};
+		const auto& slot = handle_slots[handle.id];
+		return ParticleRef{ slot.store, slot.index };
+	}
+
 	ParticleEmitter* ParticleManager::create_emitter(const ParticleRecipe& recipe)
 	{
 		auto emitter = std::make_unique<ParticleEmitter>();
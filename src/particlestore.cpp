@@ -0,0 +1,117 @@
+#include "stdafx.h"
+#include <dukat/particlestore.h>
+
+namespace dukat
+{
+	void ParticleStore::reserve(std::size_t capacity)
+	{
+		pos.reserve(capacity);
+		dp.reserve(capacity);
+		ref.reserve(capacity);
+		color.reserve(capacity);
+		dc.reserve(capacity);
+		size.reserve(capacity);
+		dsize.reserve(capacity);
+		ttl.reserve(capacity);
+		radius.reserve(capacity);
+		angle.reserve(capacity);
+		flags.reserve(capacity);
+		ids.reserve(capacity);
+	}
+
+	std::size_t ParticleStore::push_back(const Particle& p, uint32_t id)
+	{
+		pos.push_back(p.pos);
+		dp.push_back(p.dp);
+		ref.push_back(p.ref);
+		color.push_back(p.color);
+		dc.push_back(p.dc);
+		size.push_back(p.size);
+		dsize.push_back(p.dsize);
+		ttl.push_back(p.ttl);
+		radius.push_back(p.radius);
+		angle.push_back(p.angle);
+		flags.push_back(p.flags);
+		ids.push_back(id);
+		return ids.size() - 1;
+	}
+
+	void ParticleStore::swap_remove(std::size_t index)
+	{
+		assert(index < ids.size());
+		const auto last = ids.size() - 1;
+		if (index != last)
+		{
+			pos[index] = pos[last];
+			dp[index] = dp[last];
+			ref[index] = ref[last];
+			color[index] = color[last];
+			dc[index] = dc[last];
+			size[index] = size[last];
+			dsize[index] = dsize[last];
+			ttl[index] = ttl[last];
+			radius[index] = radius[last];
+			angle[index] = angle[last];
+			flags[index] = flags[last];
+			ids[index] = ids[last];
+		}
+		pos.pop_back();
+		dp.pop_back();
+		ref.pop_back();
+		color.pop_back();
+		dc.pop_back();
+		size.pop_back();
+		dsize.pop_back();
+		ttl.pop_back();
+		radius.pop_back();
+		angle.pop_back();
+		flags.pop_back();
+		ids.pop_back();
+	}
+
+	void ParticleStore::clear(void)
+	{
+		pos.clear();
+		dp.clear();
+		ref.clear();
+		color.clear();
+		dc.clear();
+		size.clear();
+		dsize.clear();
+		ttl.clear();
+		radius.clear();
+		angle.clear();
+		flags.clear();
+		ids.clear();
+	}
+
+	void ParticleStore::get(std::size_t index, Particle& p) const
+	{
+		p.pos = pos[index];
+		p.dp = dp[index];
+		p.ref = ref[index];
+		p.color = color[index];
+		p.dc = dc[index];
+		p.size = size[index];
+		p.dsize = dsize[index];
+		p.ttl = ttl[index];
+		p.radius = radius[index];
+		p.angle = angle[index];
+		p.flags = flags[index];
+	}
+
+	void ParticleStore::set(std::size_t index, const Particle& p)
+	{
+		pos[index] = p.pos;
+		dp[index] = p.dp;
+		ref[index] = p.ref;
+		color[index] = p.color;
+		dc[index] = p.dc;
+		size[index] = p.size;
+		dsize[index] = p.dsize;
+		ttl[index] = p.ttl;
+		radius[index] = p.radius;
+		angle[index] = p.angle;
+		flags[index] = p.flags;
+	}
+}
\ No newline at end of file
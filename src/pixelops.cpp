@@ -0,0 +1,357 @@
+#include "stdafx.h"
+#include <dukat/pixelops.h>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define DUKAT_PIXEL_SSE2
+#include <emmintrin.h>
+#if defined(_MSC_VER) || defined(__GNUC__)
+#define DUKAT_PIXEL_AVX2
+#include <immintrin.h>
+#endif
+#endif
+
+// GCC and Clang only emit AVX2 instructions for functions that ask for them
+#if defined(__GNUC__)
+#define DUKAT_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define DUKAT_TARGET_AVX2
+#endif
+
+namespace dukat
+{
+	// Luminance weights, matching luminance(const Color&)
+	static constexpr float lum_r = 0.2126f;
+	static constexpr float lum_g = 0.7152f;
+	static constexpr float lum_b = 0.0722f;
+
+#ifdef DUKAT_PIXEL_AVX2
+	static bool has_avx2(void)
+	{
+		static const bool res = SDL_HasAVX2() == SDL_TRUE;
+		return res;
+	}
+#endif
+
+	// Channels are converted the same way as by Surface::get_color, so that results
+	// match the per-pixel path exactly.
+	template<class Layout>
+	static inline float luminance_scalar(uint32_t p)
+	{
+		const auto r = static_cast<float>((p >> Layout::r_shift) & 0xff) / 255.0f;
+		const auto g = static_cast<float>((p >> Layout::g_shift) & 0xff) / 255.0f;
+		const auto b = static_cast<float>((p >> Layout::b_shift) & 0xff) / 255.0f;
+		return lum_r * r + lum_g * g + lum_b * b;
+	}
+
+#ifdef DUKAT_PIXEL_AVX2
+	template<class Layout>
+	DUKAT_TARGET_AVX2 static int luminance_avx2(const uint32_t* src, float* dst, int count)
+	{
+		const auto mask = _mm256_set1_epi32(0xff);
+		const auto scale = _mm256_set1_ps(255.0f);
+		const auto wr = _mm256_set1_ps(lum_r);
+		const auto wg = _mm256_set1_ps(lum_g);
+		const auto wb = _mm256_set1_ps(lum_b);
+		auto i = 0;
+		for (; i + 8 <= count; i += 8)
+		{
+			const auto p = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+			const auto r = _mm256_div_ps(_mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(p, Layout::r_shift), mask)), scale);
+			const auto g = _mm256_div_ps(_mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(p, Layout::g_shift), mask)), scale);
+			const auto b = _mm256_div_ps(_mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(p, Layout::b_shift), mask)), scale);
+			_mm256_storeu_ps(dst + i, _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(wr, r), _mm256_mul_ps(wg, g)), _mm256_mul_ps(wb, b)));
+		}
+		// avoid mixing legacy SSE and AVX code in the remainder
+		_mm256_zeroupper();
+		return i;
+	}
+#endif
+
+	template<class Layout>
+	void luminance_row(const uint32_t* src, float* dst, int count)
+	{
+		auto i = 0;
+#ifdef DUKAT_PIXEL_AVX2
+		if (has_avx2())
+			i = luminance_avx2<Layout>(src, dst, count);
+#endif
+#ifdef DUKAT_PIXEL_SSE2
+		const auto mask = _mm_set1_epi32(0xff);
+		const auto scale = _mm_set1_ps(255.0f);
+		const auto wr = _mm_set1_ps(lum_r);
+		const auto wg = _mm_set1_ps(lum_g);
+		const auto wb = _mm_set1_ps(lum_b);
+		for (; i + 4 <= count; i += 4)
+		{
+			const auto p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+			const auto r = _mm_div_ps(_mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(p, Layout::r_shift), mask)), scale);
+			const auto g = _mm_div_ps(_mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(p, Layout::g_shift), mask)), scale);
+			const auto b = _mm_div_ps(_mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(p, Layout::b_shift), mask)), scale);
+			_mm_storeu_ps(dst + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(wr, r), _mm_mul_ps(wg, g)), _mm_mul_ps(wb, b)));
+		}
+#endif
+		for (; i < count; i++)
+			dst[i] = luminance_scalar<Layout>(src[i]);
+	}
+
+	template void luminance_row<PixelLayoutRGBA>(const uint32_t* src, float* dst, int count);
+	template void luminance_row<PixelLayoutABGR>(const uint32_t* src, float* dst, int count);
+	template void luminance_row<PixelLayoutARGB>(const uint32_t* src, float* dst, int count);
+	template void luminance_row<PixelLayoutBGRA>(const uint32_t* src, float* dst, int count);
+
+	void threshold_row(const float* values, const float* thresholds, uint32_t* dst, int count, uint32_t color0, uint32_t color1)
+	{
+		auto i = 0;
+#ifdef DUKAT_PIXEL_SSE2
+		const auto half = _mm_set1_ps(0.5f);
+		const auto c0 = _mm_set1_epi32(static_cast<int>(color0));
+		const auto c1 = _mm_set1_epi32(static_cast<int>(color1));
+		for (; i + 4 <= count; i += 4)
+		{
+			const auto v = _mm_add_ps(_mm_loadu_ps(values + i), _mm_loadu_ps(thresholds + i));
+			const auto m = _mm_castps_si128(_mm_cmplt_ps(v, half));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_or_si128(_mm_and_si128(m, c0), _mm_andnot_si128(m, c1)));
+		}
+#endif
+		for (; i < count; i++)
+			dst[i] = values[i] + thresholds[i] < 0.5f ? color0 : color1;
+	}
+
+#ifdef DUKAT_PIXEL_AVX2
+	DUKAT_TARGET_AVX2 static int replace_avx2(uint32_t* row, int count, const uint32_t* src_colors, const uint32_t* dest_colors, int num_colors)
+	{
+		__m256i src[max_replace_colors], dest[max_replace_colors];
+		for (auto k = 0; k < num_colors; k++)
+		{
+			src[k] = _mm256_set1_epi32(static_cast<int>(src_colors[k]));
+			dest[k] = _mm256_set1_epi32(static_cast<int>(dest_colors[k]));
+		}
+		auto i = 0;
+		for (; i + 8 <= count; i += 8)
+		{
+			const auto p = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + i));
+			auto res = p;
+			for (auto k = num_colors - 1; k >= 0; k--)
+				res = _mm256_blendv_epi8(res, dest[k], _mm256_cmpeq_epi32(p, src[k]));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(row + i), res);
+		}
+		_mm256_zeroupper();
+		return i;
+	}
+#endif
+
+	void replace_row(uint32_t* row, int count, const uint32_t* src_colors, const uint32_t* dest_colors, int num_colors)
+	{
+		assert(num_colors <= max_replace_colors);
+		auto i = 0;
+#ifdef DUKAT_PIXEL_AVX2
+		if (has_avx2())
+			i = replace_avx2(row, count, src_colors, dest_colors, num_colors);
+#endif
+#ifdef DUKAT_PIXEL_SSE2
+		__m128i src[max_replace_colors], dest[max_replace_colors];
+		for (auto k = 0; k < num_colors; k++)
+		{
+			src[k] = _mm_set1_epi32(static_cast<int>(src_colors[k]));
+			dest[k] = _mm_set1_epi32(static_cast<int>(dest_colors[k]));
+		}
+		for (; i + 4 <= count; i += 4)
+		{
+			// Colors are compared against the original pixel, and applied in reverse so
+			// that the first match wins
+			const auto p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + i));
+			auto res = p;
+			for (auto k = num_colors - 1; k >= 0; k--)
+			{
+				const auto m = _mm_cmpeq_epi32(p, src[k]);
+				res = _mm_or_si128(_mm_and_si128(m, dest[k]), _mm_andnot_si128(m, res));
+			}
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(row + i), res);
+		}
+#endif
+		for (; i < count; i++)
+		{
+			for (auto k = 0; k < num_colors; k++)
+			{
+				if (row[i] == src_colors[k])
+				{
+					row[i] = dest_colors[k];
+					break;
+				}
+			}
+		}
+	}
+
+#ifdef DUKAT_PIXEL_SSE2
+	// Reverses the order of elements within a vector of 4, 8 or 16 elements.
+	static inline __m128i reverse32(__m128i v)
+	{
+		return _mm_shuffle_epi32(v, _MM_SHUFFLE(0, 1, 2, 3));
+	}
+
+	static inline __m128i reverse16(__m128i v)
+	{
+		v = reverse32(v);
+		return _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, _MM_SHUFFLE(2, 3, 0, 1)), _MM_SHUFFLE(2, 3, 0, 1));
+	}
+
+	static inline __m128i reverse8(__m128i v)
+	{
+		v = reverse16(v);
+		return _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+	}
+
+	// Swaps and reverses vectors from both ends of a row until they meet. Leaves left
+	// and right at the range in the middle which still has to be reversed.
+	template<typename T, __m128i(*Reverse)(__m128i)>
+	static inline void reverse_sse2(T*& left, T*& right)
+	{
+		constexpr auto n = static_cast<int>(16 / sizeof(T));
+		while (right - left >= 2 * n)
+		{
+			right -= n;
+			const auto a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(left));
+			const auto b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(right));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(left), Reverse(b));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(right), Reverse(a));
+			left += n;
+		}
+	}
+#endif
+
+	void reverse_row(uint8_t* row, int count)
+	{
+		auto left = row;
+		auto right = row + count;
+#ifdef DUKAT_PIXEL_SSE2
+		reverse_sse2<uint8_t, reverse8>(left, right);
+#endif
+		std::reverse(left, right);
+	}
+
+	void reverse_row(uint16_t* row, int count)
+	{
+		auto left = row;
+		auto right = row + count;
+#ifdef DUKAT_PIXEL_SSE2
+		reverse_sse2<uint16_t, reverse16>(left, right);
+#endif
+		std::reverse(left, right);
+	}
+
+	void reverse_row(Uint24* row, int count)
+	{
+		std::reverse(row, row + count);
+	}
+
+	void reverse_row(uint32_t* row, int count)
+	{
+		auto left = row;
+		auto right = row + count;
+#ifdef DUKAT_PIXEL_SSE2
+		reverse_sse2<uint32_t, reverse32>(left, right);
+#endif
+		std::reverse(left, right);
+	}
+
+	void swap_rows(uint8_t* a, uint8_t* b, std::size_t bytes)
+	{
+		std::size_t i = 0;
+#ifdef DUKAT_PIXEL_SSE2
+		for (; i + 16 <= bytes; i += 16)
+		{
+			const auto va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+			const auto vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(a + i), vb);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(b + i), va);
+		}
+#endif
+		std::swap_ranges(a + i, a + bytes, b + i);
+	}
+
+#ifdef DUKAT_PIXEL_AVX2
+	DUKAT_TARGET_AVX2 static int normalize_avx2(const uint16_t* src, float* dst, int count, float factor)
+	{
+		const auto f = _mm256_set1_ps(factor);
+		auto i = 0;
+		for (; i + 8 <= count; i += 8)
+		{
+			const auto p = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)));
+			_mm256_storeu_ps(dst + i, _mm256_mul_ps(f, _mm256_cvtepi32_ps(p)));
+		}
+		_mm256_zeroupper();
+		return i;
+	}
+#endif
+
+	void normalize_row(const uint16_t* src, float* dst, int count, float factor)
+	{
+		auto i = 0;
+#ifdef DUKAT_PIXEL_AVX2
+		if (has_avx2())
+			i = normalize_avx2(src, dst, count, factor);
+#endif
+#ifdef DUKAT_PIXEL_SSE2
+		const auto f = _mm_set1_ps(factor);
+		const auto zero = _mm_setzero_si128();
+		for (; i + 8 <= count; i += 8)
+		{
+			const auto p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+			_mm_storeu_ps(dst + i, _mm_mul_ps(f, _mm_cvtepi32_ps(_mm_unpacklo_epi16(p, zero))));
+			_mm_storeu_ps(dst + i + 4, _mm_mul_ps(f, _mm_cvtepi32_ps(_mm_unpackhi_epi16(p, zero))));
+		}
+#endif
+		for (; i < count; i++)
+			dst[i] = factor * static_cast<float>(src[i]);
+	}
+
+#ifdef DUKAT_PIXEL_AVX2
+	DUKAT_TARGET_AVX2 static int downsample_avx2(const float* row0, const float* row1, float* dst, int count)
+	{
+		const auto quarter = _mm256_set1_ps(0.25f);
+		auto i = 0;
+		for (; i + 8 <= count; i += 8)
+		{
+			const auto a0 = _mm256_loadu_ps(row0 + 2 * i);
+			const auto a1 = _mm256_loadu_ps(row0 + 2 * i + 8);
+			const auto b0 = _mm256_loadu_ps(row1 + 2 * i);
+			const auto b1 = _mm256_loadu_ps(row1 + 2 * i + 8);
+			// Shuffles work within 128-bit lanes, so the sums are in order 0 1 4 5 2 3 6 7
+			const auto sum = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(
+				_mm256_shuffle_ps(a0, a1, _MM_SHUFFLE(2, 0, 2, 0)), _mm256_shuffle_ps(a0, a1, _MM_SHUFFLE(3, 1, 3, 1))),
+				_mm256_shuffle_ps(b0, b1, _MM_SHUFFLE(2, 0, 2, 0))), _mm256_shuffle_ps(b0, b1, _MM_SHUFFLE(3, 1, 3, 1)));
+			const auto res = _mm256_permute4x64_pd(_mm256_castps_pd(_mm256_mul_ps(sum, quarter)), _MM_SHUFFLE(3, 1, 2, 0));
+			_mm256_storeu_ps(dst + i, _mm256_castpd_ps(res));
+		}
+		_mm256_zeroupper();
+		return i;
+	}
+#endif
+
+	void downsample_row(const float* row0, const float* row1, float* dst, int count)
+	{
+		// Values are summed in the same order by all variants. Multiplying by 0.25 is
+		// exact, so it matches a division by 4.
+		auto i = 0;
+#ifdef DUKAT_PIXEL_AVX2
+		if (has_avx2())
+			i = downsample_avx2(row0, row1, dst, count);
+#endif
+#ifdef DUKAT_PIXEL_SSE2
+		const auto quarter = _mm_set1_ps(0.25f);
+		for (; i + 4 <= count; i += 4)
+		{
+			const auto a0 = _mm_loadu_ps(row0 + 2 * i);
+			const auto a1 = _mm_loadu_ps(row0 + 2 * i + 4);
+			const auto b0 = _mm_loadu_ps(row1 + 2 * i);
+			const auto b1 = _mm_loadu_ps(row1 + 2 * i + 4);
+			const auto sum = _mm_add_ps(_mm_add_ps(_mm_add_ps(
+				_mm_shuffle_ps(a0, a1, _MM_SHUFFLE(2, 0, 2, 0)), _mm_shuffle_ps(a0, a1, _MM_SHUFFLE(3, 1, 3, 1))),
+				_mm_shuffle_ps(b0, b1, _MM_SHUFFLE(2, 0, 2, 0))), _mm_shuffle_ps(b0, b1, _MM_SHUFFLE(3, 1, 3, 1)));
+			_mm_storeu_ps(dst + i, _mm_mul_ps(sum, quarter));
+		}
+#endif
+		for (; i < count; i++)
+			dst[i] = (row0[2 * i] + row0[2 * i + 1] + row1[2 * i] + row1[2 * i + 1]) / 4.0f;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,215 @@
+#include "stdafx.h"
+#include <dukat/profiler.h>
+#include <dukat/log.h>
+#include <chrono>
+#include <iomanip>
+
+namespace dukat
+{
+	constexpr std::size_t Profiler::buffer_size;
+
+	std::atomic<bool> Profiler::capturing(false);
+	std::mutex Profiler::mutex;
+	std::vector<std::unique_ptr<Profiler::ThreadBuffer>> Profiler::buffers;
+	int Profiler::pending_frames = 0;
+	int Profiler::captured_frames = 0;
+	std::string Profiler::filename;
+	std::vector<Profiler::CapturedEvent> Profiler::events;
+	uint64_t Profiler::dropped_events = 0;
+	uint64_t Profiler::frame_start = 0;
+	thread_local Profiler::ThreadBuffer* Profiler::current_buffer = nullptr;
+	thread_local std::string Profiler::current_name;
+
+	static const auto epoch = std::chrono::steady_clock::now();
+	// Set if the current frame started while capturing
+	static bool frame_active = false;
+
+	// Writes string as quoted JSON string.
+	static void write_json_string(std::ostream& os, const char* str)
+	{
+		static const char* hex = "0123456789abcdef";
+		os << '"';
+		for (auto c = str; *c != '\0'; c++)
+		{
+			const auto ch = static_cast<unsigned char>(*c);
+			if (ch == '"' || ch == '\\')
+				os << '\\' << *c;
+			else if (ch < 0x20)
+				os << "\\u00" << hex[ch >> 4] << hex[ch & 0xf];
+			else
+				os << *c;
+		}
+		os << '"';
+	}
+
+	uint64_t Profiler::now(void)
+	{
+		return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now() - epoch).count());
+	}
+
+	Profiler::ThreadBuffer& Profiler::thread_buffer(void)
+	{
+		if (current_buffer == nullptr)
+		{
+			// Buffers are kept after their thread exits so that pending events can still be read
+			std::lock_guard<std::mutex> lock(mutex);
+			const auto id = static_cast<uint32_t>(buffers.size());
+			buffers.push_back(std::make_unique<ThreadBuffer>(id));
+			current_buffer = buffers.back().get();
+			current_buffer->thread_name = current_name.empty() ? "thread " + std::to_string(id) : current_name;
+		}
+		return *current_buffer;
+	}
+
+	void Profiler::set_thread_name(const std::string& name)
+	{
+		// Buffer is only allocated once the thread records its first zone
+		current_name = name;
+		if (current_buffer != nullptr)
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			current_buffer->thread_name = name;
+		}
+	}
+
+	void Profiler::capture(int frames, const std::string& filename)
+	{
+		if (frames <= 0 || pending_frames > 0)
+			return;
+		log->info("Capturing profile of {} frames.", frames);
+		pending_frames = frames;
+		Profiler::filename = filename;
+	}
+
+	bool Profiler::read_slot(const EventSlot& slot, uint64_t seq, ProfileEvent& e)
+	{
+		if (slot.seq.load(std::memory_order_acquire) != seq)
+			return false;
+		e.name = slot.name.load(std::memory_order_relaxed);
+		e.start = slot.start.load(std::memory_order_relaxed);
+		e.end = slot.end.load(std::memory_order_relaxed);
+		e.depth = slot.depth.load(std::memory_order_relaxed);
+		// Event is only valid if the slot has not been touched since checking seq
+		std::atomic_thread_fence(std::memory_order_acquire);
+		return slot.seq.load(std::memory_order_relaxed) == seq;
+	}
+
+	void Profiler::drain(bool discard)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		for (auto& b : buffers)
+		{
+			const auto head = b->head.load(std::memory_order_acquire);
+			if (discard)
+			{
+				b->tail = head;
+				continue;
+			}
+
+			// Events older than one buffer length have been overwritten
+			const auto first = head > buffer_size ? std::max(b->tail, head - buffer_size) : b->tail;
+			dropped_events += first - b->tail;
+			for (auto i = first; i < head; i++)
+			{
+				ProfileEvent e;
+				if (read_slot(b->events[i & (buffer_size - 1)], i + 1, e))
+					events.push_back(CapturedEvent{ e, b->thread_id });
+				else
+					dropped_events++; // overwritten by owning thread while we were copying
+			}
+			b->tail = head;
+		}
+	}
+
+	void Profiler::begin_frame(void)
+	{
+		if (pending_frames > 0 && !is_capturing())
+		{
+			// Discard anything recorded by zones which completed after the last capture
+			drain(true);
+			events.clear();
+			captured_frames = 0;
+			dropped_events = 0;
+			capturing.store(true, std::memory_order_relaxed);
+		}
+
+		frame_active = is_capturing();
+		if (frame_active)
+		{
+			thread_buffer().depth++;
+			frame_start = now();
+		}
+	}
+
+	void Profiler::end_frame(void)
+	{
+		if (!frame_active)
+			return;
+		frame_active = false;
+
+		auto& buffer = thread_buffer();
+		buffer.depth--;
+		push(buffer, ProfileEvent{ "Frame", frame_start, now(), buffer.depth });
+		drain(false);
+		captured_frames++;
+
+		if (--pending_frames == 0)
+		{
+			capturing.store(false, std::memory_order_relaxed);
+			write_trace();
+			events.clear();
+			events.shrink_to_fit();
+		}
+	}
+
+	void Profiler::write_trace(void)
+	{
+		log->info("Writing profile of {} frames to: {}", captured_frames, filename);
+		if (dropped_events > 0)
+			log->warn("Profiler dropped {} events due to full thread buffers.", dropped_events);
+
+		std::ofstream os(filename, std::ios::out);
+		if (!os)
+		{
+			log->warn("Failed to open profile file: {}", filename);
+			return;
+		}
+
+		std::sort(events.begin(), events.end(), [](const CapturedEvent& a, const CapturedEvent& b) {
+			return a.event.start < b.event.start;
+		});
+
+		os << "{\"traceEvents\":[";
+		auto separator = "\n";
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			for (const auto& b : buffers)
+			{
+				os << separator << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << b->thread_id
+					<< ",\"args\":{\"name\":";
+				write_json_string(os, b->thread_name.c_str());
+				os << "}}";
+				separator = ",\n";
+			}
+		}
+
+		// Timestamps are given in microseconds
+		os << std::fixed << std::setprecision(3);
+		auto frame = 0;
+		for (const auto& e : events)
+		{
+			os << separator << "{\"name\":";
+			write_json_string(os, e.event.name);
+			os << ",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":0,\"tid\":" << e.thread_id
+				<< ",\"ts\":" << static_cast<double>(e.event.start) / 1000.0
+				<< ",\"dur\":" << static_cast<double>(e.event.end - e.event.start) / 1000.0
+				<< ",\"args\":{\"depth\":" << e.event.depth;
+			if (e.event.depth == 0 && std::strcmp(e.event.name, "Frame") == 0)
+				os << ",\"frame\":" << frame++;
+			os << "}}";
+			separator = ",\n";
+		}
+		os << "\n],\"displayTimeUnit\":\"ns\"}" << std::endl;
+	}
+}
\ No newline at end of file
@@ -1,5 +1,6 @@
 ﻿#include "stdafx.h"
 #include <dukat/color.h>
+#include <dukat/glstate.h>
 #include <dukat/log.h>
 #include <dukat/perfcounter.h>
 #include <dukat/renderer.h>
@@ -103,15 +104,15 @@ namespace dukat
 		assert(program != nullptr);
 		if (active_program != program)
 		{
-			glUseProgram(program->id);
+			glstate.use_program(program->id);
 			perfc.inc(PerformanceCounter::SHADERS);
 			this->active_program = program;
 #if OPENGL_VERSION >= 30
 			// re-bind uniform blocks
 			if (program->bind(Renderer::uf_camera, static_cast<GLuint>(UniformBuffer::Camera)))
-				glBindBufferBase(GL_UNIFORM_BUFFER, static_cast<GLuint>(UniformBuffer::Camera), uniform_buffers->buffers[static_cast<int>(UniformBuffer::Camera)]);
+				glstate.bind_buffer_base(GL_UNIFORM_BUFFER, static_cast<GLuint>(UniformBuffer::Camera), uniform_buffers->buffers[static_cast<int>(UniformBuffer::Camera)]);
 			if (program->bind(Renderer::uf_light, static_cast<GLuint>(UniformBuffer::Light)))
-				glBindBufferBase(GL_UNIFORM_BUFFER, static_cast<GLuint>(UniformBuffer::Light), uniform_buffers->buffers[static_cast<int>(UniformBuffer::Light)]);
+				glstate.bind_buffer_base(GL_UNIFORM_BUFFER, static_cast<GLuint>(UniformBuffer::Light), uniform_buffers->buffers[static_cast<int>(UniformBuffer::Light)]);
 #else
 			// update all uniforms
 			update_uniforms();
@@ -121,7 +122,7 @@ namespace dukat
 
 	void Renderer::bind_uniform(UniformBuffer buffer, GLsizeiptr size, const GLvoid* data)
 	{
-		glBindBufferBase(GL_UNIFORM_BUFFER, static_cast<GLuint>(buffer), uniform_buffers->buffers[static_cast<int>(buffer)]);
+		glstate.bind_buffer_base(GL_UNIFORM_BUFFER, static_cast<GLuint>(buffer), uniform_buffers->buffers[static_cast<int>(buffer)]);
 		glBufferData(GL_UNIFORM_BUFFER, size, data, GL_STREAM_DRAW);
 	}
 
@@ -155,12 +156,12 @@ namespace dukat
 		this->backface_culling = backface_culling;
 		if (backface_culling)
 		{
-			glEnable(GL_CULL_FACE);
+			glstate.enable(GL_CULL_FACE);
 			glCullFace(GL_BACK);
 		}
 		else
 		{
-			glDisable(GL_CULL_FACE);
+			glstate.disable(GL_CULL_FACE);
 #ifdef OPENGL_CORE
 			glPolygonMode(GL_BACK, GL_LINE);
 			glPolygonMode(GL_FRONT, GL_FILL);
@@ -173,11 +174,11 @@ namespace dukat
 		this->blending = blending;
 		if (blending)
 		{
-			glEnable(GL_BLEND);
+			glstate.enable(GL_BLEND);
 		}
 		else
 		{
-			glDisable(GL_BLEND);
+			glstate.disable(GL_BLEND);
 		}
 	}
 
@@ -1,6 +1,8 @@
 #include "stdafx.h"
 #include <dukat/camera2.h>
+#include <dukat/glstate.h>
 #include <dukat/log.h>
+#include <dukat/profiler.h>
 #include <dukat/renderer2.h>
 #include <dukat/renderlayer2.h>
 #include <dukat/shadercache.h>
@@ -13,17 +15,21 @@
 
 namespace dukat
 {
+	// Uniforms of composite program
+	static constexpr ShaderVar uf_aspect = "u_aspect";
+
 	Renderer2::Renderer2(Window* window, ShaderCache* shader_cache) : Renderer(window, shader_cache), 
-		composite_program(nullptr), composite_binder(nullptr), render_flags(RenderFx | RenderSprites | RenderParticles | RenderText | ForceClear)
+		composite_program(nullptr), composite_binder(nullptr), render_flags(RenderFx | RenderSprites | RenderParticles | RenderText | ForceClear),
+		scheduler(nullptr)
 	{
 		// Enable transparency
 		set_blending(true);
-		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+		glstate.blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 		// Disable depth test - we'll have to take care of rendering order ourselves
-		glDisable(GL_DEPTH_TEST);
+		glstate.disable(GL_DEPTH_TEST);
 #ifdef OPENGL_CORE
         // Enable gl_PointSize instruction in shader
-		glEnable(GL_VERTEX_PROGRAM_POINT_SIZE);
+		glstate.enable(GL_VERTEX_PROGRAM_POINT_SIZE);
 #endif
 
 		initialize_sprite_buffers();
@@ -60,13 +66,14 @@ namespace dukat
 		// Create buffer for sprite rendering
 		sprite_buffer = std::make_unique<VertexBuffer>(1);
 		sprite_buffer->load_data(0, GL_ARRAY_BUFFER, 4, sizeof(Vertex2PT), vertices, GL_STATIC_DRAW);
+		// Create buffer for per-instance data of batched sprites
+		sprite_instance_buffer = std::make_unique<StreamBuffer>(sizeof(SpriteInstance), initial_sprite_capacity);
 	}
 
 	void Renderer2::initialize_particle_buffers(void)
 	{
 		// Create buffer for particle rendering
-		particle_buffer = std::make_unique<VertexBuffer>(1);
-		particle_buffer->load_data(0, GL_ARRAY_BUFFER, max_particles, sizeof(Vertex2PSC), nullptr, GL_STREAM_DRAW);
+		particle_buffer = std::make_unique<StreamBuffer>(sizeof(Vertex2PSRC), initial_particle_capacity);
 	}
 
 	void Renderer2::initialize_frame_buffers(void)
@@ -114,7 +121,7 @@ namespace dukat
 	{
 		log->debug("Creating layer: {} [{} {}]", id, priority, parallax);
 		auto layer = std::make_unique<RenderLayer2>(shader_cache,
-			sprite_buffer.get(), particle_buffer.get(), id, priority, parallax);
+			sprite_buffer.get(), sprite_instance_buffer.get(), particle_buffer.get(), id, priority, parallax);
 		auto res = layer.get();
 		bool inserted = false;
 		layer_map.emplace(id, res);
@@ -227,6 +234,7 @@ namespace dukat
 
 	void Renderer2::render_layer(RenderLayer2& layer, FrameBuffer* target_buffer)
 	{
+		DUKAT_PROFILE_ZONE("Renderer2::render_layer");
 		// Each layer can either render directly to the global screen buffer,
 		// or alternatively render to a dedicated frame buffer followed by
 		// a composite pass to merge the frame buffer into the screen buffer
@@ -254,10 +262,11 @@ namespace dukat
 
 	void Renderer2::render_composite(FrameBuffer* target_buffer, ShaderProgram* comp_program, ShaderBinder comp_binder, Texture* source_tex)
 	{
+		DUKAT_PROFILE_ZONE("Renderer2::render_composite");
 		// Swith to screen buffer
 		target_buffer->bind();
 		switch_shader(comp_program);
-		auto id = comp_program->attr("u_aspect");
+		auto id = comp_program->attr(uf_aspect);
 		if (id != -1)
 			comp_program->set(id, camera->get_aspect_ratio());
 		source_tex->bind(0, comp_program);
@@ -270,6 +279,7 @@ namespace dukat
 
 	void Renderer2::render(void)
 	{
+		DUKAT_PROFILE_ZONE("Renderer2::render");
 		// Call glFinish to avoid buffer updates on older Intel GPU.
 		// The goal is to wait until all pending render operations of
 		// the previous frame have finished.
@@ -329,6 +339,10 @@ namespace dukat
 		screen_buffer->unbind();
 		render_screenbuffer();
 
+		// sprite and particle data written this frame stays untouched while the GPU may still read it
+		sprite_instance_buffer->next_frame();
+		particle_buffer->next_frame();
+
 		if (check_flag(render_flags, ForceClear))
 			clear(); // clean actual screen
 
@@ -342,7 +356,7 @@ namespace dukat
 	void Renderer2::render_screenbuffer(void)
 	{
 		if (check_flag(render_flags, GammaCorrect))
-			glEnable(GL_FRAMEBUFFER_SRGB);
+			glstate.enable(GL_FRAMEBUFFER_SRGB);
 		switch_shader(composite_program);
 		screen_buffer->texture->bind(0, composite_program);
 		if (composite_binder != nullptr)
@@ -350,7 +364,7 @@ namespace dukat
 		quad->render(composite_program);
 		perfc.inc(PerformanceCounter::FRAME_BUFFERS);
 		if (check_flag(render_flags, GammaCorrect))
-			glDisable(GL_FRAMEBUFFER_SRGB);
+			glstate.disable(GL_FRAMEBUFFER_SRGB);
 		window->present();
 	}
 
@@ -368,16 +382,16 @@ namespace dukat
 	{
 #if OPENGL_VERSION >= 30
 		// Update uniform buffers
-		glBindBufferBase(GL_UNIFORM_BUFFER, static_cast<GLuint>(UniformBuffer::Camera), uniform_buffers->buffers[static_cast<int>(UniformBuffer::Camera)]);
+		glstate.bind_buffer_base(GL_UNIFORM_BUFFER, static_cast<GLuint>(UniformBuffer::Camera), uniform_buffers->buffers[static_cast<int>(UniformBuffer::Camera)]);
 		glBufferData(GL_UNIFORM_BUFFER, sizeof(CameraTransform2), &camera->transform, GL_STREAM_DRAW);
-		glBindBufferBase(GL_UNIFORM_BUFFER, static_cast<GLuint>(UniformBuffer::Light), uniform_buffers->buffers[static_cast<int>(UniformBuffer::Light)]);
+		glstate.bind_buffer_base(GL_UNIFORM_BUFFER, static_cast<GLuint>(UniformBuffer::Light), uniform_buffers->buffers[static_cast<int>(UniformBuffer::Light)]);
 		glBufferData(GL_UNIFORM_BUFFER, max_lights * sizeof(Light2), &lights, GL_STREAM_DRAW);
 #else
 		// Update uniform variables
-		glUniformMatrix4fv(active_program->attr(Renderer2::u_cam_proj_orth), 1, false, camera->transform.mat_proj_orth.m);
-		glUniformMatrix4fv(active_program->attr(Renderer2::u_cam_view), 1, false, camera->transform.mat_view.m);
-		glUniform2fv(active_program->attr(Renderer2::u_cam_position), 1, (GLfloat*)(&camera->transform.position));
-		glUniform2fv(active_program->attr(Renderer2::u_cam_dimension), 1, (GLfloat*)(&camera->transform.dimension));
+		active_program->set_matrix4(Renderer2::u_cam_proj_orth, camera->transform.mat_proj_orth.m);
+		active_program->set_matrix4(Renderer2::u_cam_view, camera->transform.mat_view.m);
+		active_program->set(Renderer2::u_cam_position, camera->transform.position.x, camera->transform.position.y);
+		active_program->set(Renderer2::u_cam_dimension, camera->transform.dimension.x, camera->transform.dimension.y);
 #endif
 	}
 
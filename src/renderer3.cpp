@@ -1,6 +1,7 @@
 #include "stdafx.h"
 #include <dukat/renderer3.h>
 #include <dukat/buffers.h>
+#include <dukat/glstate.h>
 #include <dukat/log.h>
 #include <dukat/meshdata.h>
 #include <dukat/meshbuilder2.h>
@@ -12,6 +13,9 @@
 
 namespace dukat
 {
+	// Uniforms of composite program
+	static constexpr ShaderVar uf_scale = "u_scale";
+
 	// Required definitions
 	constexpr int Renderer3::fbo_size;
 
@@ -20,20 +24,20 @@ namespace dukat
 	{
 		// Enable transparency
 		set_blending(true);
-		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+		glstate.blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 		// Enable depth buffer
-		glEnable(GL_DEPTH_TEST);
+		glstate.enable(GL_DEPTH_TEST);
 		glDepthFunc(GL_LEQUAL);
 
 #if OPENGL_CORE >= 31
 		// Enable primitive restart - only available in OpenGL >= 3.1
-		glEnable(GL_PRIMITIVE_RESTART);
+		glstate.enable(GL_PRIMITIVE_RESTART);
 		glPrimitiveRestartIndex(primitive_restart);
 #elif OPENGL_ES >= 30
 		// Enable primitive restart using -1 as fixed index. 
 		// More specifically, the restart index will be:
 		// GL_UNSIGNED_BYTE (2^8-1), GL_UNSIGNED_SHORT (2^16-1), GL_UNSIGNED_INT (2^32-1)
-		glEnable(GL_PRIMITIVE_RESTART_FIXED_INDEX);
+		glstate.enable(GL_PRIMITIVE_RESTART_FIXED_INDEX);
 #endif
 
 #if OPENGL_VERSION >= 30
@@ -66,8 +70,8 @@ namespace dukat
 	void Renderer3::switch_fbo(void)
 	{
 		// set input texture
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, frame_buffer->texture->id);
+		glstate.active_texture(0);
+		glstate.bind_texture(GL_TEXTURE_2D, frame_buffer->texture->id);
 
 		if (frame_buffer == fb1.get())
 		{
@@ -108,16 +112,21 @@ namespace dukat
 		if (show_wireframe)
 			glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
 #endif
-		// Scene pass
-		glEnable(GL_DEPTH_TEST);
-
+		// Gather and sort draw items for both stages
+		queue.clear();
+		queue.set_camera(camera.get());
 		for (auto& it : meshes)
 		{
-			if (it->visible && it->stage == RenderStage::Scene)
+			if (it->visible)
 			{
-				it->render(this);
+				queue.add(it);
 			}
 		}
+		queue.sort();
+
+		// Scene pass
+		glstate.enable(GL_DEPTH_TEST);
+		queue.render(this, RenderStage::Scene);
 
 #ifdef OPENGL_CORE
 		if (show_wireframe)
@@ -125,7 +134,7 @@ namespace dukat
 #endif
 
 		// Effects pass		
-		glDisable(GL_DEPTH_TEST);
+		glstate.disable(GL_DEPTH_TEST);
 
 #if OPENGL_VERSION >= 30
 		if (effects_enabled)
@@ -137,22 +146,22 @@ namespace dukat
 			{
 				switch_fbo();
 				switch_shader(it->program);
-				glUniform1i(it->program->attr(Renderer::uf_tex0), 0);
+				it->program->set_int(Renderer::uf_tex0, 0);
 				for (auto it2 : it->parameters)
 				{
 					switch (it2.second.count)
 					{
 					case 1:
-						glUniform1fv(it->program->attr(it2.first), 1, it2.second.values);
+						it->program->set(it2.first, it2.second.values[0]);
 						break;
 					case 2:
-						glUniform2fv(it->program->attr(it2.first), 1, it2.second.values);
+						it->program->set(it2.first, it2.second.values[0], it2.second.values[1]);
 						break;
 					case 3:
-						glUniform3fv(it->program->attr(it2.first), 1, it2.second.values);
+						it->program->set(it2.first, it2.second.values[0], it2.second.values[1], it2.second.values[2]);
 						break;
 					case 4:
-						glUniform4fv(it->program->attr(it2.first), 1, it2.second.values);
+						it->program->set(it2.first, it2.second.values);
 						break;
 					}
 				}
@@ -160,37 +169,32 @@ namespace dukat
 			}
 
 			// Composite pass
-			glBindFramebuffer(GL_FRAMEBUFFER, 0);
+			glstate.bind_framebuffer(GL_FRAMEBUFFER, 0);
 			reset_viewport();
 			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-			glActiveTexture(GL_TEXTURE0);
-			glBindTexture(GL_TEXTURE_2D, fb0->texture->id);
-			glActiveTexture(GL_TEXTURE1);
-			glBindTexture(GL_TEXTURE_2D, frame_buffer->texture->id);
+			glstate.active_texture(0);
+			glstate.bind_texture(GL_TEXTURE_2D, fb0->texture->id);
+			glstate.active_texture(1);
+			glstate.bind_texture(GL_TEXTURE_2D, frame_buffer->texture->id);
 
 			switch_shader(composite_program);
-			glUniform1i(composite_program->attr(Renderer::uf_tex0), 0);
-			glUniform1i(composite_program->attr(Renderer::uf_tex1), 1);
-			glUniform1f(composite_program->attr("u_scale"), 0.0f);
+			composite_program->set_int(Renderer::uf_tex0, 0);
+			composite_program->set_int(Renderer::uf_tex1, 1);
+			composite_program->set(uf_scale, 0.0f);
 
 			quad->render(composite_program);
 
 			// reset texture units
-			glActiveTexture(GL_TEXTURE0);
+			glstate.active_texture(0);
 		}
 #endif
 
 		// Overlay pass
-		for (auto& it : meshes)
-		{
-			if (it->visible && it->stage == RenderStage::Overlay)
-			{
-				it->render(this);
-			}
-		}
+		queue.render(this, RenderStage::Overlay);
 
         window->present();
+		queue.next_frame();
 
 #if OPENGL_VERSION < 30
 		// invalidate active program to force uniforms rebind during
@@ -203,20 +207,20 @@ namespace dukat
 	{
 #if OPENGL_VERSION >= 30
 		// Update uniform buffers
-		glBindBufferBase(GL_UNIFORM_BUFFER, static_cast<GLuint>(UniformBuffer::Camera), uniform_buffers->buffers[static_cast<int>(UniformBuffer::Camera)]);
+		glstate.bind_buffer_base(GL_UNIFORM_BUFFER, static_cast<GLuint>(UniformBuffer::Camera), uniform_buffers->buffers[static_cast<int>(UniformBuffer::Camera)]);
 		glBufferData(GL_UNIFORM_BUFFER, sizeof(CameraTransform3), &camera->transform, GL_STREAM_DRAW);
-		glBindBufferBase(GL_UNIFORM_BUFFER, static_cast<GLuint>(UniformBuffer::Light), uniform_buffers->buffers[static_cast<int>(UniformBuffer::Light)]);
+		glstate.bind_buffer_base(GL_UNIFORM_BUFFER, static_cast<GLuint>(UniformBuffer::Light), uniform_buffers->buffers[static_cast<int>(UniformBuffer::Light)]);
 		glBufferData(GL_UNIFORM_BUFFER, num_lights * sizeof(Light3), &lights, GL_STREAM_DRAW);
 #else
 		// Update individual uniforms.
-		glUniformMatrix4fv(active_program->attr(Renderer3::u_cam_proj_pers), 1, false, camera->transform.mat_proj_pers.m);
-		glUniformMatrix4fv(active_program->attr(Renderer3::u_cam_proj_orth), 1, false, camera->transform.mat_proj_orth.m);
-		glUniformMatrix4fv(active_program->attr(Renderer3::u_cam_view), 1, false, camera->transform.mat_view.m);
-		glUniformMatrix4fv(active_program->attr(Renderer3::u_cam_view_inv), 1, false, camera->transform.mat_view.m);
-		glUniform4fv(active_program->attr(Renderer3::u_cam_position), 1, (GLfloat*)(&camera->transform.position));
-		glUniform4fv(active_program->attr(Renderer3::u_cam_dir), 1, (GLfloat*)(&camera->transform.dir));
-		glUniform4fv(active_program->attr(Renderer3::u_cam_up), 1, (GLfloat*)(&camera->transform.up));
-		glUniform4fv(active_program->attr(Renderer3::u_cam_left), 1, (GLfloat*)(&camera->transform.right));
+		active_program->set_matrix4(Renderer3::u_cam_proj_pers, camera->transform.mat_proj_pers.m);
+		active_program->set_matrix4(Renderer3::u_cam_proj_orth, camera->transform.mat_proj_orth.m);
+		active_program->set_matrix4(Renderer3::u_cam_view, camera->transform.mat_view.m);
+		active_program->set_matrix4(Renderer3::u_cam_view_inv, camera->transform.mat_view.m);
+		active_program->set(Renderer3::u_cam_position, (GLfloat*)(&camera->transform.position));
+		active_program->set(Renderer3::u_cam_dir, (GLfloat*)(&camera->transform.dir));
+		active_program->set(Renderer3::u_cam_up, (GLfloat*)(&camera->transform.up));
+		active_program->set(Renderer3::u_cam_left, (GLfloat*)(&camera->transform.right));
 		// Bind light information
 		for (auto i = 0; i < num_lights; i++)
 		{
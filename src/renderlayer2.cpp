@@ -5,9 +5,15 @@
 #include <dukat/buffers.h>
 #include <dukat/camera2.h>
 #include <dukat/effect2.h>
+#include <dukat/glstate.h>
+#include <dukat/jobscheduler.h>
+#include <dukat/log.h>
+#include <dukat/mathutil.h>
 #include <dukat/matrix4.h>
 #include <dukat/particle.h>
+#include <dukat/particlestore.h>
 #include <dukat/perfcounter.h>
+#include <dukat/profiler.h>
 #include <dukat/shadercache.h>
 #include <dukat/sprite.h>
 #include <dukat/sysutil.h>
@@ -19,31 +25,157 @@ namespace dukat
 {
 	typedef Vertex2PSRC PVertex;
 
-	// module-global buffer for particle data used during rendering
-	static PVertex particle_data[Renderer2::max_particles];
+	// Uniforms of sprite programs
+	static constexpr ShaderVar uf_parallax = "u_parallax";
+	static constexpr ShaderVar uf_uvwh = "u_uvwh";
+	static constexpr ShaderVar uf_size = "u_size";
+	static constexpr ShaderVar uf_custom = "u_custom";
+
+	// Instanced sprite batching requires glVertexAttribDivisor
+#if (OPENGL_CORE >= 33) || (OPENGL_ES >= 30)
+#define DUKAT_SPRITE_BATCHING
+	// Per-instance attributes of batched sprite programs
+	static constexpr ShaderVar at_transform = "a_transform";
+	static constexpr ShaderVar at_rotation = "a_rotation";
+	static constexpr ShaderVar at_uvwh = "a_uvwh";
+	static constexpr ShaderVar at_custom = "a_custom";
+#endif
+
+	constexpr std::size_t RenderLayer2::parallel_cull_threshold;
+	constexpr float RenderLayer2::static_cell_size;
 
-	RenderLayer2::RenderLayer2(ShaderCache* shader_cache, VertexBuffer* sprite_buffer, VertexBuffer* particle_buffer,
-		const std::string& id, float priority, float parallax) : render_target(nullptr), composite_binder(nullptr),
-		sprite_buffer(sprite_buffer), particle_buffer(particle_buffer), id(id), parallax(parallax), priority(priority), 
-		render_flags(Visible | RenderFx | RenderSprites | RenderParticles | RenderText)
+	RenderLayer2::RenderLayer2(ShaderCache* shader_cache, VertexBuffer* sprite_buffer, StreamBuffer* sprite_instance_buffer, 
+		StreamBuffer* particle_buffer, const std::string& id, float priority, float parallax) : render_target(nullptr), composite_binder(nullptr),
+		sprite_buffer(sprite_buffer), sprite_instance_buffer(sprite_instance_buffer), particle_buffer(particle_buffer), 
+		sprites_changed(false), next_order(0), static_sprites(static_cell_size), texts_changed(false), id(id), 
+		parallax(parallax), priority(priority), render_flags(Visible | RenderFx | RenderSprites | RenderParticles | RenderText)
 	{
+#ifdef DUKAT_SPRITE_BATCHING
+		sprite_program = shader_cache->get_program("sc_sprite_batch.vsh", "sc_sprite_batch.fsh");
+#else
 		sprite_program = shader_cache->get_program("sc_sprite.vsh", "sc_sprite.fsh");
+#endif
 		particle_program = shader_cache->get_program("sc_particle.vsh", "sc_particle.fsh");
 		composite_program = shader_cache->get_program("fx_default.vsh", "fx_default.fsh");
 	}
 
 	RenderLayer2::~RenderLayer2(void) { }
 
+	// Appends a renderable to a layer list and records its slot.
+	template<typename T>
+	static void insert_slot(RenderLayer2* layer, std::vector<T*>& list, T* value, uint32_t order)
+	{
+		value->layer_slot.layer = layer;
+		value->layer_slot.index = static_cast<uint32_t>(list.size());
+		value->layer_slot.order = order;
+		list.push_back(value);
+	}
+
+	// Removes a renderable from a layer list by moving the last entry into its slot.
+	template<typename T>
+	static void erase_slot(std::vector<T*>& list, T* value)
+	{
+		const auto index = value->layer_slot.index;
+		if (index + 1 < list.size())
+		{
+			list[index] = list.back();
+			list[index]->layer_slot.index = index;
+		}
+		list.pop_back();
+		value->layer_slot.reset();
+	}
+
+	// Renderables can only be part of one layer, so adding one to another layer moves it.
+	static void warn_moved(const char* type, const std::string& from, const std::string& to)
+	{
+		log->warn("Moving {} from layer {} to layer {}.", type, from, to);
+	}
+
+	bool RenderLayer2::sprite_before(const Sprite* a, const Sprite* b)
+	{
+		const auto key_a = sprite_key(*a);
+		const auto key_b = sprite_key(*b);
+		return key_a < key_b || (key_a == key_b && a->layer_slot.order < b->layer_slot.order);
+	}
+
 	void RenderLayer2::add(Sprite* sprite)
 	{
-		if (std::find(sprites.begin(), sprites.end(), sprite) != sprites.end())
+		if (sprite->layer_slot.is_in(this))
 			return; // sprite already added to this layer
-		sprites.push_back(sprite);
+		if (sprite->layer_slot.layer != nullptr)
+		{
+			warn_moved("sprite", sprite->layer_slot.layer->id, id);
+			sprite->layer_slot.layer->remove(sprite);
+		}
+		insert_slot(this, sprites, sprite, next_order++);
+		sprites_changed = true;
+	}
+
+	void RenderLayer2::add(const std::vector<Sprite*>& list)
+	{
+		sprites.reserve(sprites.size() + list.size());
+		for (auto sprite : list)
+			add(sprite);
+	}
+
+	void RenderLayer2::add_static(Sprite* sprite)
+	{
+		// Sprites positioned relative to camera are always visible
+		if (check_flag(sprite->flags, Sprite::relative))
+		{
+			add(sprite);
+			return;
+		}
+
+		if (sprite->layer_slot.is_in(this) && sprite->layer_slot.index == LayerSlot::no_index)
+		{
+			update_static(sprite);
+			return; // sprite already added to this layer
+		}
+		if (sprite->layer_slot.layer != nullptr)
+		{
+			if (sprite->layer_slot.layer != this)
+				warn_moved("sprite", sprite->layer_slot.layer->id, id);
+			sprite->layer_slot.layer->remove(sprite);
+		}
+		// Static sprites are tracked by the spatial index instead of a list slot
+		sprite->layer_slot.layer = this;
+		sprite->layer_slot.order = next_order++;
+		static_sprites.insert(sprite, compute_sprite_bb(*sprite));
+	}
+
+	void RenderLayer2::add_static(const std::vector<Sprite*>& list)
+	{
+		for (auto sprite : list)
+			add_static(sprite);
+	}
+
+	void RenderLayer2::update_static(Sprite* sprite)
+	{
+		if (sprite->layer_slot.is_in(this) && sprite->layer_slot.index == LayerSlot::no_index)
+			static_sprites.insert(sprite, compute_sprite_bb(*sprite));
 	}
 
 	void RenderLayer2::remove(Sprite* sprite)
 	{
-		sprites.erase(std::remove(sprites.begin(), sprites.end(), sprite), sprites.end());
+		if (!sprite->layer_slot.is_in(this))
+			return; // sprite not part of this layer
+		if (sprite->layer_slot.index == LayerSlot::no_index)
+		{
+			static_sprites.remove(sprite);
+			sprite->layer_slot.reset();
+		}
+		else
+		{
+			erase_slot(sprites, sprite);
+			sprites_changed = true;
+		}
+	}
+
+	void RenderLayer2::remove(const std::vector<Sprite*>& list)
+	{
+		for (auto sprite : list)
+			remove(sprite);
 	}
 
 	Effect2* RenderLayer2::add(std::unique_ptr<Effect2> fx)
@@ -67,26 +199,82 @@ namespace dukat
 
 	void RenderLayer2::add(Particle* particle)
 	{
-		particles.push_front(particle);
+		if (particle->layer_slot.is_in(this))
+			return; // particle already added to this layer
+		if (particle->layer_slot.layer != nullptr)
+		{
+			warn_moved("particle", particle->layer_slot.layer->id, id);
+			particle->layer_slot.layer->remove(particle);
+		}
+		insert_slot(this, particles, particle, next_order++);
+	}
+
+	void RenderLayer2::add(const std::vector<Particle*>& list)
+	{
+		particles.reserve(particles.size() + list.size());
+		for (auto p : list)
+			add(p);
 	}
 
 	void RenderLayer2::remove(Particle* p)
 	{
-		particles.erase(std::remove(particles.begin(), particles.end(), p), particles.end());
+		if (p->layer_slot.is_in(this))
+			erase_slot(particles, p);
+	}
+
+	void RenderLayer2::remove(const std::vector<Particle*>& list)
+	{
+		for (auto p : list)
+			remove(p);
+	}
+
+	void RenderLayer2::add(ParticleStore* store)
+	{
+		if (std::find(particle_stores.begin(), particle_stores.end(), store) != particle_stores.end())
+			return; // store already attached to this layer
+		particle_stores.push_back(store);
+	}
+
+	void RenderLayer2::remove(ParticleStore* store)
+	{
+		particle_stores.erase(std::remove(particle_stores.begin(), particle_stores.end(), store), particle_stores.end());
+	}
+
+	bool RenderLayer2::has_particles(void) const
+	{
+		if (!particles.empty())
+			return true;
+		for (auto store : particle_stores)
+		{
+			if (!store->empty())
+				return true;
+		}
+		return false;
 	}
 
 	void RenderLayer2::add(TextMeshInstance* text)
 	{
-		texts.push_back(text);
+		if (text->layer_slot.is_in(this))
+			return; // text already added to this layer
+		if (text->layer_slot.layer != nullptr)
+		{
+			warn_moved("text", text->layer_slot.layer->id, id);
+			text->layer_slot.layer->remove(text);
+		}
+		insert_slot(this, texts, text, next_order++);
 	}
 
 	void RenderLayer2::remove(TextMeshInstance* text)
 	{
-		texts.erase(std::remove(texts.begin(), texts.end(), text), texts.end());
+		if (!text->layer_slot.is_in(this))
+			return; // text not part of this layer
+		erase_slot(texts, text);
+		texts_changed = true;
 	}
 
 	void RenderLayer2::render(Renderer2* renderer)
 	{
+		DUKAT_PROFILE_ZONE("RenderLayer2::render");
 		// Compute bounding box for current layer adjusted for parallax value
 		auto camera = renderer->get_camera();
 		const auto camera_bb = camera->get_bb(parallax);
@@ -103,54 +291,198 @@ namespace dukat
 
 	void RenderLayer2::clear(void)
 	{
+		for (auto sprite : sprites)
+			sprite->layer_slot.reset();
 		sprites.clear();
+		sorted_sprites.clear();
+		sprites_changed = true;
+		static_queue.clear();
+		static_sprites.collect(static_queue);
+		for (auto sprite : static_queue)
+			sprite->layer_slot.reset();
+		static_queue.clear();
+		static_sprites.clear();
 		effects.clear();
+		for (auto p : particles)
+			p->layer_slot.reset();
 		particles.clear();
+		particle_stores.clear();
+		for (auto text : texts)
+			text->layer_slot.reset();
 		texts.clear();
+		texts_changed = false;
 	}
 
-	void RenderLayer2::fill_sprite_queue(const AABB2& camera_bb, std::function<bool(Sprite*)> predicate,
-		std::priority_queue<Sprite*, std::deque<Sprite*>, SpriteComparator<Sprite*>>& queue)
+	bool RenderLayer2::is_sprite_visible(Sprite* sprite, const AABB2& camera_bb, const std::function<bool(Sprite*)>& predicate) const
 	{
-		// Fill queue with sprites ordered by priority from low to high
-		const auto layer_relative = check_flag(render_flags, Relative);
-		for (auto sprite : sprites)
+		if (predicate != nullptr && !predicate(sprite))
+			return false; // exclude sprites which fail predicate
+
+		if (check_flag(render_flags, Relative) || check_flag(sprite->flags, Sprite::relative))
 		{
-			if (predicate != nullptr && !predicate(sprite))
-				continue; // exclude sprites which fail predicate
+			// TODO: perform occlusion check against untranslated camera bounding box
+			return true;
+		}
+		else
+		{
+			const auto sprite_bb = compute_sprite_bb(*sprite);
+			return camera_bb.overlaps(sprite_bb);
+		}
+	}
 
-			if (layer_relative || check_flag(sprite->flags, Sprite::relative))
+	void RenderLayer2::cull_sprites(JobScheduler* scheduler, const std::vector<Sprite*>& source, const AABB2& camera_bb, 
+		const std::function<bool(Sprite*)>& predicate, std::vector<Sprite*>& queue)
+	{
+		if (scheduler != nullptr && source.size() >= parallel_cull_threshold)
+		{
+			// Cull in parallel, then queue visible sprites in their original order
+			sprite_visible.resize(source.size());
+			scheduler->parallel_for(0, source.size(), 256, [&](std::size_t begin, std::size_t end) {
+				for (auto i = begin; i < end; i++)
+					sprite_visible[i] = is_sprite_visible(source[i], camera_bb, predicate) ? 1 : 0;
+			});
+			for (auto i = 0u; i < source.size(); i++)
 			{
-				// TODO: perform occlusion check against untranslated camera bounding box
-				queue.push(sprite);
+				if (sprite_visible[i])
+					queue.push_back(source[i]);
 			}
-			else
+		}
+		else
+		{
+			for (auto sprite : source)
+			{
+				if (is_sprite_visible(sprite, camera_bb, predicate))
+					queue.push_back(sprite);
+			}
+		}
+	}
+
+	void RenderLayer2::update_sorted_sprites(void)
+	{
+		auto in_order = !sprites_changed;
+		for (auto i = 0u; in_order && i < sprite_keys.size(); i++)
+			in_order = sprite_keys[i].key == sprite_key(*sprite_keys[i].value);
+		if (in_order)
+			return;
+
+		sprite_keys.resize(sprites.size());
+		for (auto i = 0u; i < sprites.size(); i++)
+			sprite_keys[i] = SortItem<Sprite*>{ sprite_key(*sprites[i]), sprites[i] };
+		radix_sort(sprite_keys, sprite_scratch, sprite_order);
+		sorted_sprites.resize(sprite_keys.size());
+		for (auto i = 0u; i < sprite_keys.size(); i++)
+			sorted_sprites[i] = sprite_keys[i].value;
+		sprites_changed = false;
+	}
+
+	void RenderLayer2::sort_sprites(std::vector<Sprite*>& list)
+	{
+		visible_keys.resize(list.size());
+		for (auto i = 0u; i < list.size(); i++)
+			visible_keys[i] = SortItem<Sprite*>{ sprite_key(*list[i]), list[i] };
+		radix_sort(visible_keys, sprite_scratch, sprite_order);
+		for (auto i = 0u; i < list.size(); i++)
+			list[i] = visible_keys[i].value;
+	}
+
+	void RenderLayer2::query_static_sprites(const AABB2& camera_bb, const std::function<bool(Sprite*)>& predicate, std::vector<Sprite*>& queue)
+	{
+		const auto first = queue.size();
+		if (check_flag(render_flags, Relative))
+			static_sprites.collect(queue);
+		else
+			static_sprites.query(camera_bb, queue);
+		if (predicate != nullptr)
+			queue.erase(std::remove_if(queue.begin() + first, queue.end(), [&](Sprite* s) { return !predicate(s); }), queue.end());
+	}
+
+	void RenderLayer2::fill_sprite_queue(JobScheduler* scheduler, const AABB2& camera_bb, std::function<bool(Sprite*)> predicate,
+		std::vector<Sprite*>& queue)
+	{
+		DUKAT_PROFILE_ZONE("RenderLayer2::fill_sprite_queue");
+		queue.clear();
+		if (check_flag(render_flags, RetainOrder))
+		{
+			// Dynamic sprites are already in order, so culling preserves it
+			update_sorted_sprites();
+			cull_sprites(scheduler, sorted_sprites, camera_bb, predicate, queue);
+
+			static_queue.clear();
+			query_static_sprites(camera_bb, predicate, static_queue);
+			if (!static_queue.empty())
 			{
-				const auto sprite_bb = compute_sprite_bb(*sprite);
-				if (camera_bb.overlaps(sprite_bb))
-					queue.push(sprite);
+				sort_sprites(static_queue);
+				merged_queue.resize(queue.size() + static_queue.size());
+				std::merge(queue.begin(), queue.end(), static_queue.begin(), static_queue.end(), merged_queue.begin(), sprite_before);
+				queue.swap(merged_queue);
 			}
 		}
+		else
+		{
+			// Sort visible sprites by depth, then texture; ties keep the order in which sprites were added,
+			// regardless of their position in the sprite list
+			cull_sprites(scheduler, sprites, camera_bb, predicate, queue);
+			query_static_sprites(camera_bb, predicate, queue);
+			sort_sprites(queue);
+		}
 
 		perfc.inc(PerformanceCounter::SPRITES, queue.size());
-		perfc.inc(PerformanceCounter::SPRITES_TOTAL, sprites.size());
+		perfc.inc(PerformanceCounter::SPRITES_TOTAL, sprites.size() + static_sprites.size());
+	}
+
+	// Computes texture rect of a sprite, adjusted for flipping.
+	static inline void compute_uvwh(const Sprite& sprite, GLfloat* uvwh)
+	{
+		if ((sprite.flags & Sprite::flip_h) == 0)
+		{
+			uvwh[0] = sprite.tex[0];
+			uvwh[2] = sprite.tex[2];
+		}
+		else
+		{
+			uvwh[0] = sprite.tex[0] + sprite.tex[2];
+			uvwh[2] = -sprite.tex[2];
+		}
+
+		if ((sprite.flags & Sprite::flip_v) == 0)
+		{
+			uvwh[1] = sprite.tex[1];
+			uvwh[3] = sprite.tex[3];
+		}
+		else
+		{
+			uvwh[1] = sprite.tex[1] + sprite.tex[3];
+			uvwh[3] = -sprite.tex[3];
+		}
 	}
 
 	void RenderLayer2::render_sprites(Renderer2* renderer, const AABB2& camera_bb, std::function<bool(Sprite*)> predicate)
 	{
-		static std::priority_queue<Sprite*, std::deque<Sprite*>, SpriteComparator<Sprite*>> queue;
-		fill_sprite_queue(camera_bb, predicate, queue);
-		if (queue.empty())
+		DUKAT_PROFILE_ZONE("RenderLayer2::render_sprites");
+		fill_sprite_queue(renderer->get_scheduler(), camera_bb, predicate, sprite_queue);
+		if (sprite_queue.empty())
 			return; // nothing to render
 
 		renderer->switch_shader(sprite_program);
+#ifdef DUKAT_SPRITE_BATCHING
+		// Programs which declare instance attributes are drawn in batches
+		if (sprite_program->attr(at_transform) >= 0)
+		{
+			render_sprite_batches(renderer, sprite_queue);
+			return;
+		}
+#endif
+		render_sprite_list(renderer, sprite_queue);
+	}
 
+	void RenderLayer2::render_sprite_list(Renderer2* renderer, const std::vector<Sprite*>& queue)
+	{
 		// Get uniforms that will be set for each sprite
 		const auto pos_id = sprite_program->attr(Renderer::at_pos);
 		const auto uv_id = sprite_program->attr(Renderer::at_texcoord);
-		const auto uvwh_id = sprite_program->attr("u_uvwh");
-		const auto size_id = sprite_program->attr("u_size");
-		const auto custom_id = sprite_program->attr("u_custom");
+		const auto uvwh_id = sprite_program->attr(uf_uvwh);
+		const auto size_id = sprite_program->attr(uf_size);
+		const auto custom_id = sprite_program->attr(uf_custom);
 		const auto color_id = sprite_program->attr(Renderer::uf_color);
 		const auto model_id = sprite_program->attr(Renderer::uf_model);
 
@@ -164,53 +496,29 @@ namespace dukat
 		GLuint last_texture = -1;
 		Matrix4 mat_m;
 		GLfloat uvwh[4];
-		while (!queue.empty())
+		for (auto sprite : queue)
 		{
-			// get top element from queue
-			auto sprite = queue.top();
-			queue.pop();
-
 			// switch texture if necessary
 			if (last_texture != sprite->texture_id)
 			{
-				glActiveTexture(GL_TEXTURE0);
-				glBindTexture(GL_TEXTURE_2D, sprite->texture_id);
+				glstate.active_texture(0);
+				glstate.bind_texture(GL_TEXTURE_2D, sprite->texture_id);
 				last_texture = sprite->texture_id;
 				perfc.inc(PerformanceCounter::TEXTURES);
 			}
 
 			compute_model_matrix(*sprite, cam_pos, cam_mag, mat_m);
-			glUniformMatrix4fv(model_id, 1, false, &mat_m.m[0]);
-			glUniform4fv(color_id, 1, &sprite->color.r);
+			sprite_program->set_matrix4(model_id, mat_m.m);
+			sprite_program->set(color_id, &sprite->color.r);
 			if (size_id >= 0)
-				glUniform2f(size_id, static_cast<float>(sprite->w), static_cast<float>(sprite->h));
+				sprite_program->set(size_id, static_cast<float>(sprite->w), static_cast<float>(sprite->h));
 			if (custom_id >= 0)
-				glUniform2fv(custom_id, 1, sprite->custom);
+				sprite_program->set(custom_id, sprite->custom[0], sprite->custom[1]);
 
 			if (uvwh_id >= 0)
 			{
-				if ((sprite->flags & Sprite::flip_h) == 0)
-				{
-					uvwh[0] = sprite->tex[0];
-					uvwh[2] = sprite->tex[2];
-				}
-				else
-				{
-					uvwh[0] = sprite->tex[0] + sprite->tex[2];
-					uvwh[2] = -sprite->tex[2];
-				}
-
-				if ((sprite->flags & Sprite::flip_v) == 0)
-				{
-					uvwh[1] = sprite->tex[1];
-					uvwh[3] = sprite->tex[3];
-				}
-				else
-				{
-					uvwh[1] = sprite->tex[1] + sprite->tex[3];
-					uvwh[3] = -sprite->tex[3];
-				}
-				glUniform4fv(uvwh_id, 1, uvwh);
+				compute_uvwh(*sprite, uvwh);
+				sprite_program->set(uvwh_id, uvwh);
 			}
 
 			glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
@@ -219,15 +527,121 @@ namespace dukat
 		unbind_sprite_buffers(pos_id, uv_id);
 	}
 
+	void RenderLayer2::render_sprite_batches(Renderer2* renderer, const std::vector<Sprite*>& queue)
+	{
+#ifdef DUKAT_SPRITE_BATCHING
+		auto cam = renderer->get_camera();
+		const auto& cam_pos = cam->transform.position;
+		const auto cam_mag = cam->get_mag_factor();
+
+		// Write instances in render order and split them into runs sharing a texture
+		const auto count = static_cast<int>(queue.size());
+		auto instances = static_cast<SpriteInstance*>(sprite_instance_buffer->map(count));
+		if (instances == nullptr)
+			return;
+		sprite_runs.clear();
+		for (auto i = 0; i < count; i++)
+		{
+			auto sprite = queue[i];
+			compute_instance(*sprite, cam_pos, cam_mag, instances[i]);
+			if (sprite_runs.empty() || sprite_runs.back().texture_id != sprite->texture_id)
+				sprite_runs.push_back(SpriteRun{ sprite->texture_id, 0 });
+			sprite_runs.back().count++;
+		}
+		const auto first = sprite_instance_buffer->unmap(count);
+
+		// Set parallax value for this layer
+		sprite_program->set(uf_parallax, parallax);
+		// set texture unit 0 
+		sprite_program->set_int(Renderer::uf_tex0, 0);
+
+		// bind quad vertices
+		glstate.bind_vertex_array(sprite_instance_buffer->vao);
+		glstate.bind_buffer(GL_ARRAY_BUFFER, sprite_buffer->buffers[0]);
+		const auto pos_id = sprite_program->attr(Renderer::at_pos);
+		glEnableVertexAttribArray(pos_id);
+		glVertexAttribPointer(pos_id, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex2PT),
+			reinterpret_cast<const GLvoid*>(offsetof(Vertex2PT, px)));
+		const auto uv_id = sprite_program->attr(Renderer::at_texcoord);
+		glEnableVertexAttribArray(uv_id);
+		glVertexAttribPointer(uv_id, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex2PT),
+			reinterpret_cast<const GLvoid*>(offsetof(Vertex2PT, tu)));
+
+		// bind instance attributes; unused attributes may have been optimized out
+		struct InstanceAttribute
+		{
+			GLint id;
+			GLint size;
+			std::size_t offset;
+		};
+		const InstanceAttribute attributes[] = {
+			{ sprite_program->attr(at_transform), 4, offsetof(SpriteInstance, px) },
+			{ sprite_program->attr(at_rotation), 2, offsetof(SpriteInstance, rc) },
+			{ sprite_program->attr(at_uvwh), 4, offsetof(SpriteInstance, tu) },
+			{ sprite_program->attr(Renderer::at_color), 4, offsetof(SpriteInstance, cr) },
+			{ sprite_program->attr(at_custom), 2, offsetof(SpriteInstance, c0) }
+		};
+		glstate.bind_buffer(GL_ARRAY_BUFFER, sprite_instance_buffer->buffer);
+		for (const auto& a : attributes)
+		{
+			if (a.id < 0)
+				continue;
+			glEnableVertexAttribArray(a.id);
+			glVertexAttribDivisor(a.id, 1);
+		}
+
+		// Render runs in order
+		auto offset = static_cast<std::size_t>(first);
+		GLuint last_texture = -1;
+		for (const auto& run : sprite_runs)
+		{
+			if (last_texture != run.texture_id)
+			{
+				glstate.active_texture(0);
+				glstate.bind_texture(GL_TEXTURE_2D, run.texture_id);
+				last_texture = run.texture_id;
+				perfc.inc(PerformanceCounter::TEXTURES);
+			}
+
+			// Instanced draws cannot start at an arbitrary instance, so offset attributes instead
+			for (const auto& a : attributes)
+			{
+				if (a.id >= 0)
+					glVertexAttribPointer(a.id, a.size, GL_FLOAT, GL_FALSE, sizeof(SpriteInstance),
+						reinterpret_cast<const GLvoid*>(offset * sizeof(SpriteInstance) + a.offset));
+			}
+			glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, run.count);
+			offset += run.count;
+		}
+
+		// Reset divisors since the vertex array object is shared with other layers
+		for (const auto& a : attributes)
+		{
+			if (a.id >= 0)
+			{
+				glVertexAttribDivisor(a.id, 0);
+				glDisableVertexAttribArray(a.id);
+			}
+		}
+		glDisableVertexAttribArray(pos_id);
+		glDisableVertexAttribArray(uv_id);
+#ifdef _DEBUG
+		glstate.bind_buffer(GL_ARRAY_BUFFER, 0);
+		glstate.bind_vertex_array(0);
+		gl_check_error();
+#endif
+#endif
+	}
+
 	void RenderLayer2::bind_sprite_buffers(GLint pos_id, GLint uv_id)
 	{
 		// Set parallax value for this layer
-		glUniform1f(sprite_program->attr("u_parallax"), parallax);
+		sprite_program->set(uf_parallax, parallax);
 
 		// bind sprite vertex buffers
 #if OPENGL_VERSION >= 30
-		glBindVertexArray(sprite_buffer->vao);
-		glBindBuffer(GL_ARRAY_BUFFER, sprite_buffer->buffers[0]);
+		glstate.bind_vertex_array(sprite_buffer->vao);
+		glstate.bind_buffer(GL_ARRAY_BUFFER, sprite_buffer->buffers[0]);
 
 		// bind vertex position
 		glEnableVertexAttribArray(pos_id);
@@ -240,7 +654,7 @@ namespace dukat
 #else
 		glEnableClientState(GL_VERTEX_ARRAY);
 		glEnableClientState(GL_TEXTURE_COORD_ARRAY);
-		glBindBuffer(GL_ARRAY_BUFFER, sprite_buffer->buffers[0]);
+		glstate.bind_buffer(GL_ARRAY_BUFFER, sprite_buffer->buffers[0]);
 
 		// bind vertex position
 		glVertexPointer(2, GL_FLOAT, sizeof(Vertex2PT),
@@ -251,7 +665,7 @@ namespace dukat
 #endif
 
 		// set texture unit 0 
-		glUniform1i(sprite_program->attr(Renderer::uf_tex0), 0);
+		sprite_program->set_int(Renderer::uf_tex0, 0);
 	}
 
 	void RenderLayer2::unbind_sprite_buffers(GLint pos_id, GLint uv_id)
@@ -261,18 +675,18 @@ namespace dukat
 		// unbind buffers
 		glDisableVertexAttribArray(pos_id);
 		glDisableVertexAttribArray(uv_id);
-		glBindBuffer(GL_ARRAY_BUFFER, 0);
-		glBindVertexArray(0);
+		glstate.bind_buffer(GL_ARRAY_BUFFER, 0);
+		glstate.bind_vertex_array(0);
 #else
 		glDisableClientState(GL_VERTEX_ARRAY);
 		glDisableClientState(GL_TEXTURE_COORD_ARRAY);
-		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		glstate.bind_buffer(GL_ARRAY_BUFFER, 0);
 #endif
 		gl_check_error();
 #endif
 	}
 
-	void RenderLayer2::compute_model_matrix(const Sprite& sprite, const Vector2& camera_position, float camera_mag, Matrix4& mat_model)
+	Vector2 RenderLayer2::compute_sprite_position(const Sprite& sprite, const Vector2& camera_position) const
 	{
 		auto pos = sprite.p;
 
@@ -302,6 +716,12 @@ namespace dukat
 		// position by camera position.
 		if (check_flag(render_flags, Flags::Relative) || check_flag(sprite.flags, Sprite::relative))
 			pos += camera_position;
+		return pos;
+	}
+
+	void RenderLayer2::compute_model_matrix(const Sprite& sprite, const Vector2& camera_position, float camera_mag, Matrix4& mat_model)
+	{
+		const auto pos = compute_sprite_position(sprite, camera_position);
 
 		// scale * rotation * translation
 		static Matrix4 tmp;
@@ -315,7 +735,53 @@ namespace dukat
 		mat_model *= tmp;
 	}
 
-	std::size_t RenderLayer2::fill_particle_queue(Camera2* cam, const AABB2& camera_bb)
+	void RenderLayer2::compute_instance(const Sprite& sprite, const Vector2& camera_position, float camera_mag, SpriteInstance& instance)
+	{
+		const auto pos = compute_sprite_position(sprite, camera_position);
+		instance.px = pos.x * camera_mag;
+		instance.py = pos.y * camera_mag;
+		instance.sx = sprite.scale * sprite.w * camera_mag;
+		instance.sy = sprite.scale * sprite.h * camera_mag;
+		if (sprite.rot != 0.0f)
+		{
+			sin_cos(instance.rs, instance.rc, sprite.rot);
+		}
+		else
+		{
+			instance.rc = 1.0f;
+			instance.rs = 0.0f;
+		}
+		compute_uvwh(sprite, &instance.tu);
+		instance.cr = sprite.color.r;
+		instance.cg = sprite.color.g;
+		instance.cb = sprite.color.b;
+		instance.ca = sprite.color.a;
+		instance.c0 = sprite.custom[0];
+		instance.c1 = sprite.custom[1];
+	}
+
+	// Writes a single particle vertex.
+	static inline void fill_particle_vertex(PVertex& v, const Vector2& pos, float size, float ry, const Color& color)
+	{
+		v.px = pos.x;
+		v.py = pos.y;
+		v.size = size;
+		v.ry = ry;
+		v.cr = color.r;
+		v.cg = color.g;
+		v.cb = color.b;
+		v.ca = color.a;
+	}
+
+	std::size_t RenderLayer2::max_particle_count(void) const
+	{
+		auto res = particles.size();
+		for (auto store : particle_stores)
+			res += store->count();
+		return res;
+	}
+
+	std::size_t RenderLayer2::fill_particle_queue(Camera2* cam, const AABB2& camera_bb, PVertex* buffer)
 	{
 		// increase camera bb slightly to avoid culling particles with size > 1
 		// which fall just outside of screen rect; otherwise these will cause flickering
@@ -327,13 +793,13 @@ namespace dukat
 		const auto cam_mag = cam->get_mag_factor();
 
 		auto particle_count = 0u;
-		for (auto it = particles.begin(); it != particles.end(); )
+		for (auto i = 0u; i < particles.size(); )
 		{
-			auto p = (*it);
-			// remove dead particles
+			auto p = particles[i];
+			// remove dead particles; this moves the last particle into the current slot
 			if (p->ttl <= 0)
 			{
-				it = particles.erase(it);
+				erase_slot(particles, p);
 				continue;
 			}
 
@@ -341,45 +807,67 @@ namespace dukat
 			if (layer_relative || bb.contains(p->pos))
 			{
 				p->flags |= Particle::Rendered;
-				if (layer_relative)
-				{
-					particle_data[particle_count].px = p->pos.x + cam_pos.x;
-					particle_data[particle_count].py = p->pos.y + cam_pos.y;
-				}
-				else
-				{
-					particle_data[particle_count].px = p->pos.x;
-					particle_data[particle_count].py = p->pos.y;
-				}
-				particle_data[particle_count].size = p->size;
-				particle_data[particle_count].ry = p->ref.y;
-				particle_data[particle_count].cr = p->color.r;
-				particle_data[particle_count].cg = p->color.g;
-				particle_data[particle_count].cb = p->color.b;
-				particle_data[particle_count].ca = p->color.a;
+				fill_particle_vertex(buffer[particle_count], layer_relative ? p->pos + cam_pos : p->pos, 
+					p->size, p->ref.y, p->color);
 				particle_count++;
 			}
 			else
 			{
 				p->flags &= ~Particle::Rendered;
 			}
-			++it;
+			i++;
 		}
+
+		// Packed particles are owned and compacted by the particle manager, 
+		// so expired entries only need to be skipped here.
+		for (auto store : particle_stores)
+		{
+			const auto count = store->count();
+			for (auto i = 0u; i < count; i++)
+			{
+				if (store->ttl[i] <= 0)
+					continue;
+
+				const auto& pos = store->pos[i];
+				if (layer_relative || bb.contains(pos))
+				{
+					store->flags[i] |= Particle::Rendered;
+					fill_particle_vertex(buffer[particle_count], layer_relative ? pos + cam_pos : pos,
+						store->size[i], store->ref[i].y, store->color[i]);
+					particle_count++;
+				}
+				else
+				{
+					store->flags[i] &= ~Particle::Rendered;
+				}
+			}
+		}
+
 		perfc.inc(PerformanceCounter::PARTICLES, particle_count);
 		return particle_count;
 	}
 
 	void RenderLayer2::render_particles(Renderer2* renderer, const AABB2& camera_bb)
 	{
+		DUKAT_PROFILE_ZONE("RenderLayer2::render_particles");
+		const auto max_count = static_cast<int>(max_particle_count());
+		if (max_count == 0)
+			return;
+
+		// write visible particles straight into the shared stream buffer
 		auto cam = renderer->get_camera();
-		const auto particle_count = fill_particle_queue(cam, camera_bb);
-		if (particle_count == 0u)
+		auto buffer = static_cast<PVertex*>(particle_buffer->map(max_count));
+		if (buffer == nullptr)
+			return;
+		const auto particle_count = static_cast<int>(fill_particle_queue(cam, camera_bb, buffer));
+		const auto first = particle_buffer->unmap(particle_count);
+		if (particle_count == 0)
 			return; // no particles left to render
 
 		renderer->switch_shader(particle_program);
 
 		// Set parallax value for this layer
-		particle_program->set("u_parallax", parallax);
+		particle_program->set(uf_parallax, parallax);
 
 		// Bind model matrix
 		Matrix4 mat_m;
@@ -388,11 +876,8 @@ namespace dukat
 
 #if OPENGL_VERSION >= 30
 		// bind particle vertex buffers
-		glBindVertexArray(particle_buffer->vao);
-		glBindBuffer(GL_ARRAY_BUFFER, particle_buffer->buffers[0]);
-		// Orphan buffer to improve streaming performance
-		glBufferData(GL_ARRAY_BUFFER, Renderer2::max_particles * sizeof(PVertex), nullptr, GL_STREAM_DRAW);
-		glBufferSubData(GL_ARRAY_BUFFER, 0, particle_count * sizeof(PVertex), particle_data);
+		glstate.bind_vertex_array(particle_buffer->vao);
+		glstate.bind_buffer(GL_ARRAY_BUFFER, particle_buffer->buffer);
 		// bind vertex position
 		const auto pos_id = particle_program->attr(Renderer::at_pos);
 		glEnableVertexAttribArray(pos_id);
@@ -406,11 +891,7 @@ namespace dukat
 #else
 		glEnableClientState(GL_VERTEX_ARRAY);
 		glEnableClientState(GL_COLOR_ARRAY);
-		glBindBuffer(GL_ARRAY_BUFFER, particle_buffer->buffers[0]);
-
-		// Orphan buffer to improve streaming performance
-		glBufferData(GL_ARRAY_BUFFER, Renderer2::max_particles * sizeof(PVertex), NULL, GL_STREAM_DRAW);
-		glBufferSubData(GL_ARRAY_BUFFER, 0, particle_count * sizeof(PVertex), particle_data);
+		glstate.bind_buffer(GL_ARRAY_BUFFER, particle_buffer->buffer);
 
 		// bind vertex position
 		glVertexPointer(4, GL_FLOAT, sizeof(PVertex),
@@ -420,28 +901,39 @@ namespace dukat
 			reinterpret_cast<const GLvoid*>(offsetof(PVertex, cr)));
 #endif
 
-		glDrawArrays(GL_POINTS, 0, particle_count);
+		glDrawArrays(GL_POINTS, first, particle_count);
 
 #ifdef _DEBUG
 #if OPENGL_VERSION >= 30
 		glDisableVertexAttribArray(pos_id);
 		glDisableVertexAttribArray(color_id);
-		glBindVertexArray(0);
+		glstate.bind_vertex_array(0);
 #else
 		glDisableClientState(GL_VERTEX_ARRAY);
 		glDisableClientState(GL_COLOR_ARRAY);
 #endif
-		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		glstate.bind_buffer(GL_ARRAY_BUFFER, 0);
 		gl_check_error();
 #endif
 	}
 
 	void RenderLayer2::render_text(Renderer2* renderer, const AABB2& camera_bb)
 	{
+		DUKAT_PROFILE_ZONE("RenderLayer2::render_text");
 		// set up matrix once
 		Matrix4 mat_identity;
 		const auto camera_mag = renderer->get_camera()->get_mag_factor();
 		mat_identity.setup_scale(Vector3(camera_mag, camera_mag, 1.0f));
+		if (texts_changed)
+		{
+			// Removal moves texts around, so restore the order in which they were added
+			std::sort(texts.begin(), texts.end(), [](const TextMeshInstance* a, const TextMeshInstance* b) {
+				return a->layer_slot.order < b->layer_slot.order;
+			});
+			for (auto i = 0u; i < texts.size(); i++)
+				texts[i]->layer_slot.index = i;
+			texts_changed = false;
+		}
 		for (const auto& text : texts)
 		{
 			if (text->visible)
@@ -451,6 +943,7 @@ namespace dukat
 
 	void RenderLayer2::render_effects(Renderer2* renderer, const AABB2& camera_bb)
 	{
+		DUKAT_PROFILE_ZONE("RenderLayer2::render_effects");
 		for (const auto& fx : effects)
 			fx->render(renderer, camera_bb);
 	}
@@ -0,0 +1,303 @@
+#include "stdafx.h"
+#include <dukat/renderqueue3.h>
+#include <dukat/buffers.h>
+#include <dukat/camera3.h>
+#include <dukat/frustum.h>
+#include <dukat/glstate.h>
+#include <dukat/meshdata.h>
+#include <dukat/meshinstance.h>
+#include <dukat/perfcounter.h>
+#include <dukat/renderer3.h>
+#include <dukat/shaderprogram.h>
+
+namespace dukat
+{
+	// Instanced draws require glVertexAttribDivisor
+#if (OPENGL_CORE >= 33) || (OPENGL_ES >= 30)
+#define DUKAT_MESH_INSTANCING
+	static constexpr ShaderVar at_model = RenderQueue3::at_model;
+#endif
+	static constexpr ShaderVar uf_model = Renderer::uf_model;
+
+	constexpr int RenderQueue3::initial_instance_capacity;
+
+	// Layout of sort keys, from most to least significant bits:
+	// stage (1) | segment (10) | translucent (1) | program, textures, data, material, depth
+	// Opaque items are sorted by state first and depth last, translucent items by
+	// decreasing depth first.
+	static constexpr uint64_t overlay_bit = 1ull << 63;
+	static constexpr int segment_shift = 53;
+	static constexpr uint32_t max_segment = (1u << 10) - 1;
+	static constexpr uint64_t translucent_bit = 1ull << 52;
+	static constexpr uint32_t ordinal_mask = (1u << 10) - 1;
+	static constexpr uint32_t material_mask = (1u << 6) - 1;
+	static constexpr float max_depth = 65535.0f;
+
+	// Computes 64-bit FNV-1a hash of a block of memory.
+	static uint64_t hash_bytes(const void* data, std::size_t size)
+	{
+		auto bytes = static_cast<const uint8_t*>(data);
+		uint64_t hash = 0xcbf29ce484222325ull;
+		for (std::size_t i = 0; i < size; i++)
+			hash = (hash ^ bytes[i]) * 0x100000001b3ull;
+		return hash;
+	}
+
+	RenderQueue3::RenderQueue3(void) : camera(nullptr), segment(0)
+	{
+#ifdef DUKAT_MESH_INSTANCING
+		instance_buffer = std::make_unique<StreamBuffer>(sizeof(Matrix4), initial_instance_capacity);
+#endif
+	}
+
+	RenderQueue3::~RenderQueue3(void)
+	{
+	}
+
+	uint32_t RenderQueue3::ordinal(robin_hood::unordered_flat_map<uint64_t, uint32_t>& ordinals, uint64_t key)
+	{
+		// Ordinals wrap around once the key range is exhausted, which only affects how
+		// well items are grouped
+		auto it = ordinals.find(key);
+		if (it != ordinals.end())
+			return it->second;
+		const auto res = static_cast<uint32_t>(ordinals.size()) & ordinal_mask;
+		ordinals.emplace(key, res);
+		return res;
+	}
+
+	bool RenderQueue3::same_run(const MeshInstance* a, const MeshInstance* b)
+	{
+		if (a->get_mesh() != b->get_mesh() || a->get_program() != b->get_program())
+			return false;
+		for (auto i = 0; i < Renderer::max_texture_units; i++)
+		{
+			if (a->get_texture(i) != b->get_texture(i))
+				return false;
+		}
+		return std::memcmp(&a->get_material(), &b->get_material(), sizeof(Material)) == 0;
+	}
+
+	void RenderQueue3::clear(void)
+	{
+		items.clear();
+		bounds.clear();
+		bounded.clear();
+		programs.clear();
+		texture_sets.clear();
+		mesh_data.clear();
+		segment = 0;
+	}
+
+	void RenderQueue3::set_camera(const Camera3* camera)
+	{
+		this->camera = camera;
+		clip = camera->transform.mat_proj_pers * camera->transform.mat_view;
+	}
+
+	void RenderQueue3::get_frustum(const Matrix4& model, Frustum& frustum) const
+	{
+		frustum.extract(clip * model);
+	}
+
+	void RenderQueue3::add(Mesh* mesh)
+	{
+		if (mesh->enqueue(*this))
+			return;
+
+		// Meshes which render themselves get a segment of their own
+		segment = std::min(segment + 1, max_segment);
+		items.push_back(DrawItem{ mesh, nullptr, Matrix4{}, mesh->stage, segment, 0, 0, 0, 0, false });
+		segment = std::min(segment + 1, max_segment);
+	}
+
+	void RenderQueue3::add(MeshInstance* instance, const Matrix4& model, RenderStage stage, bool culled)
+	{
+		auto program = instance->get_program();
+		auto data = instance->get_mesh();
+		if (program == nullptr || data == nullptr)
+			return;
+
+		if (!culled && stage == RenderStage::Scene && !data->get_bounds().empty())
+		{
+			bounds.emplace_back();
+			bounds.back().set_to_transformed_box(data->get_bounds(), model);
+			bounded.push_back(static_cast<uint32_t>(items.size()));
+		}
+
+		Texture* textures[Renderer::max_texture_units];
+		for (auto i = 0; i < Renderer::max_texture_units; i++)
+			textures[i] = instance->get_texture(i);
+		const auto& material = instance->get_material();
+
+		items.push_back(DrawItem{ nullptr, instance, model, stage, segment,
+			ordinal(programs, reinterpret_cast<uint64_t>(program)),
+			ordinal(texture_sets, hash_bytes(textures, sizeof(textures))),
+			ordinal(mesh_data, reinterpret_cast<uint64_t>(data)),
+			static_cast<uint32_t>(hash_bytes(&material, sizeof(Material))) & material_mask,
+			material.diffuse.a < 1.0f });
+	}
+
+	uint64_t RenderQueue3::sort_key(const DrawItem& item, const Vector3& cam_pos, const Vector3& cam_dir, float far_clip) const
+	{
+		// Overlay items are rendered in the order they were added
+		if (item.stage == RenderStage::Overlay)
+			return overlay_bit;
+
+		auto key = static_cast<uint64_t>(item.segment) << segment_shift;
+		if (item.mesh != nullptr)
+			return key;
+
+		// Distance along view direction, quantized to 16 bits
+		const Vector3 offset{ item.model.m[12] - cam_pos.x, item.model.m[13] - cam_pos.y, item.model.m[14] - cam_pos.z };
+		const auto dist = offset.x * cam_dir.x + offset.y * cam_dir.y + offset.z * cam_dir.z;
+		const auto depth = static_cast<uint64_t>(std::min(std::max(dist / far_clip, 0.0f), 1.0f) * max_depth);
+
+		if (item.translucent)
+		{
+			return key | translucent_bit
+				| ((static_cast<uint64_t>(max_depth) - depth) << 36)
+				| (static_cast<uint64_t>(item.program) << 26)
+				| (static_cast<uint64_t>(item.textures) << 16)
+				| (static_cast<uint64_t>(item.data) << 6)
+				| item.material;
+		}
+		else
+		{
+			return key
+				| (static_cast<uint64_t>(item.program) << 42)
+				| (static_cast<uint64_t>(item.textures) << 32)
+				| (static_cast<uint64_t>(item.data) << 22)
+				| (static_cast<uint64_t>(item.material) << 16)
+				| depth;
+		}
+	}
+
+	void RenderQueue3::cull(void)
+	{
+		if (bounds.empty() || camera == nullptr)
+			return;
+
+		visible.resize(bounds.size());
+		const auto count = camera->get_frustum().cull(bounds.data(), bounds.size(), visible.data());
+		perfc.inc(PerformanceCounter::MESHES_CULLED, static_cast<int>(bounds.size() - count));
+		if (count == bounds.size())
+			return;
+
+		for (std::size_t i = 0; i < bounded.size(); i++)
+		{
+			if (visible[i] == 0)
+				items[bounded[i]].instance = nullptr;
+		}
+		items.erase(std::remove_if(items.begin(), items.end(), [](const DrawItem& item) {
+			return item.mesh == nullptr && item.instance == nullptr; }), items.end());
+	}
+
+	void RenderQueue3::sort(void)
+	{
+		cull();
+		perfc.inc(PerformanceCounter::MESHES_SUBMITTED, static_cast<int>(items.size()));
+
+		const auto& cam_pos = camera->transform.position;
+		const auto& cam_dir = camera->transform.dir;
+		const auto far_clip = camera->get_far_clip();
+
+		const auto count = items.size();
+		order.resize(count);
+		for (std::size_t i = 0; i < count; i++)
+		{
+			order[i].key = sort_key(items[i], cam_pos, cam_dir, far_clip);
+			order[i].value = static_cast<uint32_t>(i);
+		}
+		radix_sort(order, scratch);
+	}
+
+	void RenderQueue3::render(Renderer3* renderer, RenderStage stage)
+	{
+		// Items of the scene stage precede items of the overlay stage
+		const auto stage_bit = stage == RenderStage::Overlay ? overlay_bit : 0;
+		const auto count = order.size();
+		std::size_t first = 0;
+		while (first < count && (order[first].key & overlay_bit) != stage_bit)
+			first++;
+		auto last = first;
+		while (last < count && (order[last].key & overlay_bit) == stage_bit)
+			last++;
+
+		for (auto i = first; i < last; )
+		{
+			const auto& item = items[order[i].value];
+			if (item.mesh != nullptr)
+			{
+				item.mesh->render(renderer);
+				i++;
+				continue;
+			}
+
+			auto j = i + 1;
+			while (j < last && items[order[j].value].mesh == nullptr
+				&& same_run(item.instance, items[order[j].value].instance))
+				j++;
+			render_run(renderer, i, j);
+			i = j;
+		}
+	}
+
+	void RenderQueue3::render_run(Renderer3* renderer, std::size_t first, std::size_t last)
+	{
+		auto instance = items[order[first].value].instance;
+		instance->bind(renderer);
+		auto program = instance->get_program();
+		auto data = instance->get_mesh();
+
+#ifdef DUKAT_MESH_INSTANCING
+		const auto model_id = program->attr(at_model);
+		if (model_id >= 0)
+		{
+			const auto count = static_cast<int>(last - first);
+			auto matrices = static_cast<GLfloat*>(instance_buffer->map(count));
+			if (matrices == nullptr)
+				return;
+			for (auto i = first; i < last; i++)
+				std::memcpy(matrices + (i - first) * 16, items[order[i].value].model.m, 16 * sizeof(GLfloat));
+			const auto offset = static_cast<std::size_t>(instance_buffer->unmap(count)) * sizeof(Matrix4);
+
+			data->bind(program);
+			// Matrix attributes occupy one location per column
+			glstate.bind_buffer(GL_ARRAY_BUFFER, instance_buffer->buffer);
+			for (auto c = 0; c < 4; c++)
+			{
+				glEnableVertexAttribArray(model_id + c);
+				glVertexAttribPointer(model_id + c, 4, GL_FLOAT, GL_FALSE, sizeof(Matrix4),
+					reinterpret_cast<const GLvoid*>(offset + c * 4 * sizeof(GLfloat)));
+				glVertexAttribDivisor(model_id + c, 1);
+			}
+			data->draw(count);
+			// Reset divisors since the vertex array object belongs to the mesh
+			for (auto c = 0; c < 4; c++)
+			{
+				glVertexAttribDivisor(model_id + c, 0);
+				glDisableVertexAttribArray(model_id + c);
+			}
+			data->unbind(program);
+			return;
+		}
+#endif
+
+		data->bind(program);
+		for (auto i = first; i < last; i++)
+		{
+			program->set_matrix4(uf_model, items[order[i].value].model.m);
+			data->draw();
+		}
+		data->unbind(program);
+	}
+
+	void RenderQueue3::next_frame(void)
+	{
+#ifdef DUKAT_MESH_INSTANCING
+		// instance data written this frame stays untouched while the GPU may still read it
+		instance_buffer->next_frame();
+#endif
+	}
+}
\ No newline at end of file
@@ -163,7 +163,7 @@ namespace dukat
 			// erase existing program and replace with new version
 			auto sp = it.second.get();
 			glDeleteProgram(sp->id);
-			sp->id = build_program(sp->vertex_file, sp->fragment_file, sp->geometry_file);
+			sp->reset(build_program(sp->vertex_file, sp->fragment_file, sp->geometry_file));
 		}
 	}
 }
\ No newline at end of file
@@ -6,6 +6,42 @@
 
 namespace dukat
 {
+	constexpr GLint ShaderProgram::max_cached_location;
+
+	// Returns number of 32-bit words of a uniform type, or 0 if values of the type are not cached.
+	static uint32_t uniform_words(GLenum type)
+	{
+		switch (type)
+		{
+		case GL_FLOAT:
+		case GL_INT:
+		case GL_UNSIGNED_INT:
+		case GL_BOOL:
+		case GL_SAMPLER_2D:
+		case GL_SAMPLER_3D:
+		case GL_SAMPLER_CUBE:
+		case GL_SAMPLER_2D_SHADOW:
+		case GL_SAMPLER_2D_ARRAY:
+			return 1;
+		case GL_FLOAT_VEC2:
+		case GL_INT_VEC2:
+			return 2;
+		case GL_FLOAT_VEC3:
+		case GL_INT_VEC3:
+			return 3;
+		case GL_FLOAT_VEC4:
+		case GL_INT_VEC4:
+		case GL_FLOAT_MAT2:
+			return 4;
+		case GL_FLOAT_MAT3:
+			return 9;
+		case GL_FLOAT_MAT4:
+			return 16;
+		default:
+			return 0;
+		}
+	}
+
 	ShaderProgram::ShaderProgram(GLuint id, const std::string& vertex_file, const std::string& fragment_file, const std::string& geometry_file)
 		: id(id), vertex_file(vertex_file), fragment_file(fragment_file), geometry_file(geometry_file)
 	{
@@ -18,6 +54,22 @@ namespace dukat
 			glDeleteProgram(id);
 	}
 
+	void ShaderProgram::reset(GLuint id)
+	{
+		this->id = id;
+		locations.clear();
+		uniforms.clear();
+		cached.clear();
+		values.clear();
+		index_attributes();
+	}
+
+	void ShaderProgram::invalidate(void)
+	{
+		for (auto& v : cached)
+			v.valid = false;
+	}
+
 	void ShaderProgram::index_attributes(void)
 	{
 	    const auto buffer_size = 256;
@@ -32,8 +84,18 @@ namespace dukat
 			GLsizei length;
 			glGetActiveUniform(id, i, buffer_size, &length, &size, &type, buffer);
 			auto location = glGetUniformLocation(id, buffer);
-			if (location >= 0)
-				attributes.emplace(buffer, location);
+			if (location < 0)
+				continue;
+			add_location(buffer, location);
+
+			// reserve space for the value of non-array uniforms
+			const auto words = size == 1 ? uniform_words(type) : 0;
+			if (words == 0 || location > max_cached_location)
+				continue;
+			if (location >= static_cast<GLint>(cached.size()))
+				cached.resize(location + 1, UniformValue{ 0, 0, false });
+			cached[location] = UniformValue{ static_cast<uint32_t>(values.size()), words, false };
+			values.resize(values.size() + words);
 		}
 
 		// query and index attributes
@@ -46,7 +108,7 @@ namespace dukat
 			glGetActiveAttrib(id, i, buffer_size, &length, &size, &type, buffer);
 			auto location = glGetAttribLocation(id, buffer);
 			if (location >= 0)
-				attributes.emplace(buffer, location);
+				add_location(buffer, location);
 		}
 
 #ifdef _DEBUG
@@ -54,16 +116,15 @@ namespace dukat
 #endif
 	}
 
-	GLint ShaderProgram::attr(const std::string& name)
+	void ShaderProgram::add_location(const char* name, GLint location)
 	{
-		if (attributes.count(name) == 0)
-		{
-			return -1;
-		}
-		else
+		const auto hash = hash_shader_var(name);
+		if (locations.count(hash) > 0)
 		{
-			return attributes.at(name);
+			log->warn("Hash collision for shader variable: {}", name);
+			return;
 		}
+		locations.emplace(hash, location);
 	}
 
 	bool ShaderProgram::bind(const std::string& block_name, GLuint block_binding)
@@ -6,6 +6,10 @@
 
 namespace dukat
 {
+	// Uniforms of shadow program
+	static constexpr ShaderVar uf_alpha = "u_alpha";
+	static constexpr ShaderVar uf_radius = "u_radius";
+
 	void ShadowEffect2::render(Renderer2* renderer, const AABB2& camera_bb)
 	{
 		auto target_layer = renderer->get_layer(shadowed_layer);
@@ -20,8 +24,8 @@ namespace dukat
 		target_layer->set_sprite_program(sprite_program);
 		// force activation so parameter can be set
 		renderer->switch_shader(sprite_program);
-		sprite_program->set("u_alpha", alpha);
-		sprite_program->set("u_radius", radius);
+		sprite_program->set(uf_alpha, alpha);
+		sprite_program->set(uf_radius, radius);
 		target_layer->render_sprites(renderer, camera_bb, [](Sprite* s) { return (s->flags & Sprite::fx) != Sprite::fx; });
 		target_layer->set_sprite_program(sp);
 	}
@@ -1,13 +1,12 @@
 #include "stdafx.h"
 #include <dukat/surface.h>
-#include <dukat/bit.h>
 #include <dukat/log.h>
 #include <dukat/sdlutil.h>
+#include <robin_hood.h>
 
 namespace dukat
 {
-	// Struct for manipulating 24-bit surfaces
-	struct Uint24 { Uint8 c[3]; };
+	constexpr int Surface::tile_rows;
 
 	Surface::Surface(int width, int height, uint32_t format)
 	{
@@ -166,35 +165,43 @@ namespace dukat
 		return SDL_MapRGBA(surface->format, c.r, c.g, c.b, c.a);
 	}
 
-	void Surface::replace(const Color& src_color, const Color& dest_color)
+	void Surface::replace(const Color& src_color, const Color& dest_color, JobScheduler* scheduler)
 	{
-		const auto sc = raw_color(src_color);
-		const auto dc = raw_color(src_color);
-		auto ptr = static_cast<uint32_t*>(surface->pixels);
-		auto end = ptr + surface->w * surface->h;
-		while (ptr < end)
-		{
-			if (*ptr == sc)
-				*ptr = dc;
-			++ptr;
-		}
+		replace(std::vector<Color>{ src_color }, std::vector<Color>{ dest_color }, scheduler);
 	}
 
-	void Surface::replace(const std::vector<Color>& src_colors, const std::vector<Color>& dest_colors)
+	void Surface::replace(const std::vector<Color>& src_colors, const std::vector<Color>& dest_colors, JobScheduler* scheduler)
 	{
 		assert(src_colors.size() == dest_colors.size());
 
-		std::unordered_map<uint32_t, uint32_t> colors;
+		std::vector<uint32_t> src, dest;
 		for (auto i = 0u; i < src_colors.size(); i++)
-			colors.insert(std::make_pair(raw_color(src_colors[i]), raw_color(dest_colors[i])));
+		{
+			src.push_back(raw_color(src_colors[i]));
+			dest.push_back(raw_color(dest_colors[i]));
+		}
 
-		auto ptr = static_cast<uint32_t*>(surface->pixels);
-		auto end = ptr + surface->w * surface->h;
-		while (ptr < end)
+		if (src.size() <= static_cast<std::size_t>(max_replace_colors))
 		{
-			if (colors.count(*ptr))
-				*ptr = colors[*ptr];
-			++ptr;
+			const auto count = static_cast<int>(src.size());
+			apply_rows([&](int x, int y, uint32_t* row, int width) {
+				replace_row(row, width, src.data(), dest.data(), count);
+			}, scheduler);
+		}
+		else
+		{
+			// Look up colors of larger palettes
+			robin_hood::unordered_flat_map<uint32_t, uint32_t> colors;
+			for (auto i = 0u; i < src.size(); i++)
+				colors.insert(std::make_pair(src[i], dest[i]));
+			apply_rows([&colors](int x, int y, uint32_t* row, int width) {
+				for (auto i = 0; i < width; i++)
+				{
+					auto it = colors.find(row[i]);
+					if (it != colors.end())
+						row[i] = it->second;
+				}
+			}, scheduler);
 		}
 	}
 
@@ -260,49 +267,42 @@ namespace dukat
 
 	void Surface::flip_vertical(void)
 	{
-		const auto size = surface->w * surface->h;
-		switch (surface->format->BytesPerPixel)
-		{
-		case 1:
-			dukat::flip_vertical(static_cast<uint8_t*>(surface->pixels), static_cast<uint8_t*>(surface->pixels) + size, static_cast<size_t>(surface->w));
-			break;
-		case 2:
-			dukat::flip_vertical(static_cast<uint16_t*>(surface->pixels), static_cast<uint16_t*>(surface->pixels) + size, static_cast<size_t>(surface->w));
-			break;
-		case 3:
-			dukat::flip_vertical(static_cast<Uint24*>(surface->pixels), static_cast<Uint24*>(surface->pixels) + size, static_cast<size_t>(surface->w));
-			break;
-		case 4:
-			dukat::flip_vertical(static_cast<uint32_t*>(surface->pixels), static_cast<uint32_t*>(surface->pixels) + size, static_cast<size_t>(surface->w));
-			break;
-		}
-		}
+		const auto bytes = static_cast<std::size_t>(surface->w) * surface->format->BytesPerPixel;
+		auto top = static_cast<uint8_t*>(surface->pixels);
+		auto bottom = top + (surface->h - 1) * surface->pitch;
+		for (; top < bottom; top += surface->pitch, bottom -= surface->pitch)
+			swap_rows(top, bottom, bytes);
+	}
 
 	void Surface::flip_horizontal(void)
 	{
-		const auto size = surface->w * surface->h;
-		switch (surface->format->BytesPerPixel)
+		for (auto y = 0; y < surface->h; y++)
 		{
-		case 1:
-			dukat::flip_horizontal(static_cast<uint8_t*>(surface->pixels), static_cast<uint8_t*>(surface->pixels) + size, static_cast<size_t>(surface->w));
-			break;
-		case 2:
-			dukat::flip_horizontal(static_cast<uint16_t*>(surface->pixels), static_cast<uint16_t*>(surface->pixels) + size, static_cast<size_t>(surface->w));
-			break;
-		case 3:
-			dukat::flip_horizontal(static_cast<Uint24*>(surface->pixels), static_cast<Uint24*>(surface->pixels) + size, static_cast<size_t>(surface->w));
-			break;
-		case 4:
-			dukat::flip_horizontal(static_cast<uint32_t*>(surface->pixels), static_cast<uint32_t*>(surface->pixels) + size, static_cast<size_t>(surface->w));
-			break;
+			auto row = static_cast<uint8_t*>(surface->pixels) + y * surface->pitch;
+			switch (surface->format->BytesPerPixel)
+			{
+			case 1:
+				reverse_row(row, surface->w);
+				break;
+			case 2:
+				reverse_row(reinterpret_cast<uint16_t*>(row), surface->w);
+				break;
+			case 3:
+				reverse_row(reinterpret_cast<Uint24*>(row), surface->w);
+				break;
+			case 4:
+				reverse_row(reinterpret_cast<uint32_t*>(row), surface->w);
+				break;
+			}
 		}
 	}
 
 	void Surface::apply(const std::function<void(int x, int y, SDL_Surface* s, uint32_t& p)>& f)
 	{
-		auto ptr = static_cast<uint32_t*>(surface->pixels);
+		const auto rect = pixels<uint32_t>();
 		for (auto y = 0; y < surface->h; y++)
 		{
+			auto ptr = rect.row(y);
 			for (auto x = 0; x < surface->w; x++)
 			{
 				f(x, y, surface, *(ptr++));
@@ -1,5 +1,6 @@
 #include "stdafx.h"
 #include <dukat/texture.h>
+#include <dukat/glstate.h>
 #include <dukat/surface.h>
 #include <dukat/shaderprogram.h>
 #include <dukat/sysutil.h>
@@ -31,7 +32,7 @@ namespace dukat
 	{ 
 		if (id != 0) 
 		{
-			glDeleteTextures(1, &id); 
+			glstate.delete_texture(id); 
 		}
 	}
 
@@ -54,7 +55,7 @@ namespace dukat
 		{
 			glGenTextures(1, &id);
 		}
-		glBindTexture(target, id);
+		glstate.bind_texture(target, id);
 
 		bool generate_map = false;
 		switch (profile)
@@ -102,26 +103,28 @@ namespace dukat
 		}
 
 #ifdef _DEBUG
-		glBindTexture(target, 0);
+		glstate.bind_texture(target, 0);
 		gl_check_error();
 #endif
 	}
 
 	void Texture::bind(GLenum texture, ShaderProgram* program) const
 	{
-		static std::string program_id = "u_tex0";
-		glActiveTexture(GL_TEXTURE0 + texture);
-		glBindTexture(target, id);
+		static constexpr ShaderVar samplers[] = { Renderer::uf_tex0, Renderer::uf_tex1, Renderer::uf_tex2, Renderer::uf_tex3 };
+		glstate.active_texture(texture);
+		glstate.bind_texture(target, id);
 		if (program != nullptr)
 		{
-			program_id[5] = static_cast<char>(48 + texture);
-			glUniform1i(program->attr(program_id), texture);
+			if (texture < static_cast<GLenum>(Renderer::max_texture_units))
+				program->set_int(samplers[texture], static_cast<GLint>(texture));
+			else
+				program->set_int("u_tex" + std::to_string(texture), static_cast<GLint>(texture));
 		}
 	}
 
 	void Texture::unbind(void) const
 	{
-		glBindTexture(target, 0);
+		glstate.bind_texture(target, 0);
 	}
 
 	GLint Texture::get_internal_format(void) const
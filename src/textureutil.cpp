@@ -1,5 +1,6 @@
 #include "stdafx.h"
 #include <dukat/textureutil.h>
+#include <dukat/glstate.h>
 #include <dukat/texture.h>
 #include <dukat/rand.h>
 #include <dukat/sysutil.h>
@@ -49,7 +50,7 @@ namespace dukat
 	std::unique_ptr<Texture> TextureBuilder::build(void* data)
 	{
 		auto res = std::make_unique<Texture>(width, height, filter_profile);
-		glBindTexture(target, res->id);
+		glstate.bind_texture(target, res->id);
 
 		switch (filter_profile)
 		{
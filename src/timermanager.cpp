@@ -1,10 +1,11 @@
 #include "stdafx.h"
 #include <dukat/timermanager.h>
 #include <dukat/perfcounter.h>
+#include <dukat/profiler.h>
 
 namespace dukat
 {
-	MemoryPool<Timer> Timer::_pool(256);
+	MemoryPool<Timer> Timer::_pool(256, "timers");
 
 	Timer* TimerManager::create(float interval, std::function<void(void)> callback, bool recurring)
     {
@@ -34,6 +35,7 @@ namespace dukat
     
     void TimerManager::update(float delta)
     {
+		DUKAT_PROFILE_ZONE("TimerManager::update");
 		generation++;
 
 		for (auto it = timers.begin(); it != timers.end(); )
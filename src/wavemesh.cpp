@@ -2,6 +2,7 @@
 
 #include <dukat/blockbuilder.h>
 #include <dukat/game3.h>
+#include <dukat/glstate.h>
 #include <dukat/log.h>
 #include <dukat/meshbuilder2.h>
 #include <dukat/meshinstance.h>
@@ -13,6 +14,17 @@
 
 namespace dukat
 {
+	// Uniforms of wave programs
+	static constexpr ShaderVar uf_rescale = "u_rescale";
+	static constexpr ShaderVar uf_pass = "u_pass";
+	static constexpr ShaderVar uf_rtex_coord = "u_rtex_coord";
+	static constexpr ShaderVar uf_coef = "u_coef";
+	static constexpr ShaderVar uf_ws_water_tint = "u_ws.water_tint";
+	static constexpr ShaderVar uf_ws_depth_offset = "u_ws.depth_offset";
+	static constexpr ShaderVar uf_ws_spec_atten = "u_ws.spec_atten";
+	static constexpr ShaderVar uf_ws_env_adjust = "u_ws.env_adjust";
+	static constexpr ShaderVar uf_k = "u_k";
+
 	constexpr int WaveMesh::texture_size;
 	constexpr float WaveMesh::grav_constant;
 
@@ -29,7 +41,7 @@ namespace dukat
 		fb_quad = mb.build_textured_quad();
 		fbo = std::make_unique<FrameBuffer>(texture_size, texture_size, false, false);
 		fb_texture = std::make_unique<Texture>(texture_size, texture_size, ProfileLinear);
-		glBindTexture(GL_TEXTURE_2D, fb_texture->id);
+		glstate.bind_texture(GL_TEXTURE_2D, fb_texture->id);
 		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, texture_size, texture_size, 0, GL_RGB, GL_FLOAT, nullptr);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -62,7 +74,7 @@ namespace dukat
 		// Upload to texture
 		cos_texture = std::make_unique<Texture>(texture_size, 1, ProfileNearest);
 		cos_texture->target = GL_TEXTURE_1D;
-		glBindTexture(cos_texture->target, cos_texture->id);
+		glstate.bind_texture(cos_texture->target, cos_texture->id);
 		glTexParameteri(cos_texture->target, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
 		glTexParameteri(cos_texture->target, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 		glTexImage1D(cos_texture->target, 0, GL_RGBA8, texture_size, 0, GL_RGBA, GL_UNSIGNED_INT_8_8_8_8, cos_table.data());
@@ -234,7 +246,7 @@ namespace dukat
 		
 		// Used to scale normals to output format
 		auto s = 0.5f / (static_cast<float>(num_bump_per_pass) + tex_state.noise);
-		fb_program->set("u_rescale", s, s, 1.0f, 1.0f);
+		fb_program->set(uf_rescale, s, s, 1.0f, 1.0f);
 		
 		cos_texture->bind(0, fb_program); // consine lookup
 		noise_texture->bind(1, fb_program); // noise texture
@@ -244,7 +256,7 @@ namespace dukat
 		Matrix4 mat_model;
 		for (int i = 0; i < 4; i++) 
 		{
-			fb_program->set("u_pass", static_cast<float>(i));
+			fb_program->set(uf_pass, static_cast<float>(i));
 
 			// Set cUTransX
 			mat_model.m[0] = tex_waves[i * 4 + 0].rot_scale.x;
@@ -263,7 +275,7 @@ namespace dukat
 			mat_model.m[13] = tex_waves[i * 4 + 3].rot_scale.y;
 			mat_model.m[14] = 0.0f;
 			mat_model.m[15] = tex_waves[i * 4 + 3].phase;
-			fb_program->set_matrix4("u_rtex_coord", mat_model.m);
+			fb_program->set_matrix4(uf_rtex_coord, mat_model.m);
 
 			// Set cCoefX
 			auto norm_scale = tex_waves[i * 4 + 0].fade / (float)num_bump_passes;
@@ -282,7 +294,7 @@ namespace dukat
 			mat_model.m[12] = tex_waves[i * 4 + 3].dir.x * norm_scale;
 			mat_model.m[13] = tex_waves[i * 4 + 3].dir.y * norm_scale;
 			mat_model.m[14] = mat_model.m[15] = 1.0f;
-			fb_program->set_matrix4("u_coef", mat_model.m);
+			fb_program->set_matrix4(uf_coef, mat_model.m);
 			
         	fb_quad->render(fb_program);
 	        perfc.inc(PerformanceCounter::FRAME_BUFFERS);
@@ -290,18 +302,18 @@ namespace dukat
 		// end wave passes
 
 		// noise pass
-		fb_program->set("u_pass", 4.0f);
+		fb_program->set(uf_pass, 4.0f);
 		
 		// Repurpose u_rescale to store scale bias
 		auto scale_bias = 0.5f * tex_state.noise / (static_cast<float>(num_bump_passes) + tex_state.noise);
-		fb_program->set("u_rescale", scale_bias, scale_bias, 0.0f, 1.0f);
+		fb_program->set(uf_rescale, scale_bias, scale_bias, 0.0f, 1.0f);
 		// Repurpose cUTransX to send uvXform parameters
 		mat_model.m[0] = 20.0f; mat_model.m[4] = 0.0f; 		mat_model.m[8] = 20.0f; mat_model.m[12] = 0.0f;
 		mat_model.m[1] = 0.0f; 	mat_model.m[5] = 20.0f; 	mat_model.m[9] = 0.0f; 	mat_model.m[13] = 20.0f;
 		mat_model.m[2] = 		mat_model.m[6] = 			mat_model.m[10] = 		mat_model.m[14] = 0.0f;
 		mat_model.m[3] = 		mat_model.m[7] = 			mat_model.m[11] = 		mat_model.m[15] = 0.1f * game->get_time();
 
-		fb_program->set_matrix4("u_rtex_coord", mat_model.m);
+		fb_program->set_matrix4(uf_rtex_coord, mat_model.m);
 		
 		fb_quad->render(fb_program);
         perfc.inc(PerformanceCounter::FRAME_BUFFERS);
@@ -351,27 +363,27 @@ namespace dukat
 		grid_program->set_matrix4(Renderer::uf_model, mat_model);
 
 		// Bind geo state
-		grid_program->set("u_ws.water_tint", water_tint.r, water_tint.g, water_tint.b, water_tint.a);
-		grid_program->set("u_ws.depth_offset",
+		grid_program->set(uf_ws_water_tint, water_tint.r, water_tint.g, water_tint.b, water_tint.a);
+		grid_program->set(uf_ws_depth_offset,
 			geo_state.water_level + 1.0f, geo_state.water_level + 1.0f, 
 			geo_state.water_level, geo_state.water_level);
 		// grid_program->set("u_ws.fog_params", -200.0f, 1.0f / -100.0f, 0.0f, 1.0f);
 		// Specular attenuation
 		auto norm_scale = geo_state.spec_atten * tex_state.amp_over_len * two_pi;
 		norm_scale *= (static_cast<float>(num_bump_passes) + tex_state.noise) * (tex_state.chop + 1.0f);
-		grid_program->set("u_ws.spec_atten", geo_state.spec_end, 
+		grid_program->set(uf_ws_spec_atten, geo_state.spec_end, 
 			1.0f / geo_state.spec_trans, norm_scale, 1.0f / tex_state.ripple_scale);
 		// Env adjust
 		auto cam_to_center = cam->transform.position - cam_target;
 		auto g = cam_to_center.mag2() - geo_state.env_radius * geo_state.env_radius;
-		grid_program->set("u_ws.env_adjust", cam_to_center.x, cam_to_center.y, cam_to_center.z, g);
+		grid_program->set(uf_ws_env_adjust, cam_to_center.x, cam_to_center.y, cam_to_center.z, g);
 
 		auto k = 5.0f;
 		if (geo_state.amp_over_len > geo_state.chop / (two_pi * num_geo_waves * k))
 		{
 			k = geo_state.chop / (two_pi * geo_state.amp_over_len * num_geo_waves);
 		}
-		grid_program->set("u_k", k);
+		grid_program->set(uf_k, k);
 
 		// Bind geo waves to uniform buffer
 		renderer->bind_uniform(Renderer::UniformBuffer::User, num_geo_waves * sizeof(GeoWaveDesc), geo_waves.data());
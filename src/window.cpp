@@ -41,7 +41,7 @@ namespace dukat
 		}
 #endif
 
-#ifndef __ANDROID__
+#if !defined(__ANDROID__) && !defined(DUKAT_NULL_GL)
 		// init glew
 		glewExperimental = GL_TRUE;
 		auto res = glewInit();
@@ -141,6 +141,10 @@ namespace dukat
 			if (flags & Flags::Borderless)
 				window_flags |= SDL_WINDOW_BORDERLESS;
 		}
+#endif
+#ifdef DUKAT_NULL_GL
+		// Null backend does not need an OpenGL window
+		window_flags &= ~SDL_WINDOW_OPENGL;
 #endif
 		// Create the window with the requested resolution
 		window = SDL_CreateWindow(window_title, SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
@@ -173,6 +177,10 @@ namespace dukat
 
 	void Window::create_context(void)
 	{
+#ifdef DUKAT_NULL_GL
+		context = nullptr;
+		log->debug("Using null OpenGL backend.");
+#else
 		context = SDL_GL_CreateContext(window);
 		if (context == nullptr)
 			sdl_check_result(-1, "Create OpenGL Context");
@@ -180,6 +188,7 @@ namespace dukat
 		SDL_GL_GetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, &major);
 		SDL_GL_GetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, &minor);
 		log->debug("Created OpenGL context {}.{}", major, minor);
+#endif
 	}
 
 	void Window::change_mode(Mode wm, const SDL_DisplayMode& dm)
@@ -286,6 +295,8 @@ namespace dukat
 
 	void Window::present(void)
 	{
+#ifndef DUKAT_NULL_GL
 		SDL_GL_SwapWindow(window); 
+#endif
 	}
 }
\ No newline at end of file